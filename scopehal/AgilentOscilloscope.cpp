@@ -494,7 +494,7 @@ bool AgilentOscilloscope::AcquireData()
 {
 	//LogDebug("Acquiring data\n");
 
-	lock_guard<recursive_mutex> lock(m_mutex);
+	unique_lock<recursive_mutex> lock(m_mutex);
 	LogIndenter li;
 
 	unsigned int format;
@@ -528,7 +528,7 @@ bool AgilentOscilloscope::AcquireData()
 
 		//Set up the capture we're going to store our data into
 		//(no TDC data available on Agilent scopes?)
-		AnalogWaveform* cap = new AnalogWaveform;
+		AnalogWaveform* cap = g_waveformPool.Allocate<AnalogWaveform>(length);
 		cap->m_timescale = fs_per_sample;
 		cap->m_triggerPhase = 0;
 		cap->m_startTimestamp = time(NULL);
@@ -571,19 +571,16 @@ bool AgilentOscilloscope::AcquireData()
 	}
 
 	//Now that we have all of the pending waveforms, save them in sets across all channels
-	m_pendingWaveformsMutex.lock();
 	size_t num_pending = 1;	//TODO: segmented capture mode
+	vector<SequenceSet> sets(num_pending);
 	for(size_t i=0; i<num_pending; i++)
 	{
-		SequenceSet s;
 		for(size_t j=0; j<m_analogChannelCount; j++)
 		{
 			if(IsChannelEnabled(j))
-				s[m_channels[j]] = pending_waveforms[j][i];
+				sets[i][m_channels[j]] = pending_waveforms[j][i];
 		}
-		m_pendingWaveforms.push_back(s);
 	}
-	m_pendingWaveformsMutex.unlock();
 
 	//TODO: support digital channels
 
@@ -594,6 +591,11 @@ bool AgilentOscilloscope::AcquireData()
 		m_triggerArmed = true;
 	}
 
+	//Hand off the waveforms without holding the lock, since the queue may have to wait for the consumer
+	lock.unlock();
+	for(auto& s : sets)
+		m_pendingWaveforms.Push(s);
+
 	//LogDebug("Acquisition done\n");
 	return true;
 }
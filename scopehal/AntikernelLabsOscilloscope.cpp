@@ -375,7 +375,7 @@ bool AntikernelLabsOscilloscope::AcquireData()
 	LogIndenter li;
 
 	//1600 ps per sample for now, hard coded
-	AnalogWaveform* cap = new AnalogWaveform;
+	AnalogWaveform* cap = g_waveformPool.Allocate<AnalogWaveform>(depth);
 	cap->m_timescale = 1600;
 	cap->m_triggerPhase = 0;
 	double t = GetTime();
@@ -401,24 +401,26 @@ bool AntikernelLabsOscilloscope::AcquireData()
 	cap->m_triggerPhase = -trigfrac * cap->m_timescale;
 
 	//Done, update
-	lock_guard<recursive_mutex> lock(m_mutex);
+	unique_lock<recursive_mutex> lock(m_mutex);
 	map<int, vector<AnalogWaveform*> > pending_waveforms;
 	pending_waveforms[0].push_back(cap);
 
 	//Now that we have all of the pending waveforms, save them in sets across all channels
-	m_pendingWaveformsMutex.lock();
 	size_t num_pending = 1;	//single segment only for now
+	vector<SequenceSet> sets(num_pending);
 	for(size_t i=0; i<num_pending; i++)
 	{
-		SequenceSet s;
 		for(size_t j=0; j<m_analogChannelCount; j++)
 		{
 			if(IsChannelEnabled(j))
-				s[m_channels[j]] = pending_waveforms[j][i];
+				sets[i][m_channels[j]] = pending_waveforms[j][i];
 		}
-		m_pendingWaveforms.push_back(s);
 	}
-	m_pendingWaveformsMutex.unlock();
+
+	//Hand off the waveforms without holding the lock, since the queue may have to wait for the consumer
+	lock.unlock();
+	for(auto& s : sets)
+		m_pendingWaveforms.Push(s);
 
 	return true;
 }
@@ -297,7 +297,7 @@ Oscilloscope::TriggerMode AntikernelLogicAnalyzer::PollTrigger()
 
 bool AntikernelLogicAnalyzer::AcquireData()
 {
-	lock_guard<recursive_mutex> lock(m_mutex);
+	unique_lock<recursive_mutex> lock(m_mutex);
 
 	//LogDebug("Acquiring data...\n");
 	LogIndenter li;
@@ -322,7 +322,7 @@ bool AntikernelLogicAnalyzer::AcquireData()
 	double time = GetTime();
 	double fs = (time - floor(time)) * FS_PER_SECOND;
 	{
-		DigitalWaveform* cap = new DigitalWaveform;
+		DigitalWaveform* cap = g_waveformPool.Allocate<DigitalWaveform>(m_memoryDepth * 2);
 		cap->m_timescale = m_samplePeriod / 2;
 		cap->m_triggerPhase = 0;
 		cap->m_startTimestamp = time;
@@ -360,7 +360,7 @@ bool AntikernelLogicAnalyzer::AcquireData()
 			size_t nbit = nlow % 8;
 
 			//Create the channel
-			DigitalWaveform* cap = new DigitalWaveform;
+			DigitalWaveform* cap = g_waveformPool.Allocate<DigitalWaveform>(m_memoryDepth);
 			cap->m_timescale = m_samplePeriod;
 			cap->m_triggerPhase = 0;
 			cap->m_startTimestamp = time;
@@ -384,7 +384,7 @@ bool AntikernelLogicAnalyzer::AcquireData()
 		else
 		{
 			//Create the channel
-			DigitalBusWaveform* cap = new DigitalBusWaveform;
+			DigitalBusWaveform* cap = g_waveformPool.Allocate<DigitalBusWaveform>(m_memoryDepth);
 			cap->m_timescale = m_samplePeriod;
 			cap->m_triggerPhase = 0;
 			cap->m_startTimestamp = time;
@@ -413,9 +413,6 @@ bool AntikernelLogicAnalyzer::AcquireData()
 			pending_waveforms[chan] = cap;
 		}
 	}
-	m_pendingWaveformsMutex.lock();
-	m_pendingWaveforms.push_back(pending_waveforms);
-	m_pendingWaveformsMutex.unlock();
 
 	//Re-arm the trigger if not in one-shot mode
 	if(!m_triggerOneShot)
@@ -423,6 +420,10 @@ bool AntikernelLogicAnalyzer::AcquireData()
 	else
 		m_triggerArmed = false;
 
+	//Hand off the waveforms without holding the lock, since the queue may have to wait for the consumer
+	lock.unlock();
+	m_pendingWaveforms.Push(pending_waveforms);
+
 	return true;
 }
 
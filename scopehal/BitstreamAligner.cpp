@@ -0,0 +1,270 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of BitstreamAligner
+ */
+
+#include "scopehal.h"
+#include "BitstreamAligner.h"
+#include <omp.h>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pattern search
+
+/**
+	@brief Finds every position in a bit stream where one of a set of patterns starts
+
+	@param in			Input bit stream
+	@param patterns		Patterns to look for, LSB first
+	@param npatterns	Number of patterns
+	@param width		Width of every pattern, in bits (1 to 64)
+	@param matches		Output stream, with bit i set if any pattern starts at sample i of the input.
+						Positions too close to the end of the input to hold a full pattern never match.
+ */
+void BitstreamAligner::FindPatterns(
+	const PackedDigitalWaveform& in,
+	const uint64_t* patterns,
+	size_t npatterns,
+	size_t width,
+	PackedDigitalWaveform& matches)
+{
+	size_t len = in.size();
+	matches.Resize(len);
+	if( (len == 0) || (width == 0) || (width > 64) )
+	{
+		matches.Resize(0);
+		return;
+	}
+
+	size_t nwords = matches.m_words.size();
+	uint64_t* out = &matches.m_words[0];
+
+	#pragma omp parallel for
+	for(size_t w=0; w<nwords; w++)
+	{
+		//shifted[k] bit b is sample 64*w + b + k, so each bit lane of the AND below tests one start position
+		uint64_t shifted[64];
+		for(size_t k=0; k<width; k++)
+			shifted[k] = in.GetBits(w*64 + k);
+
+		uint64_t hits = 0;
+		for(size_t p=0; p<npatterns; p++)
+		{
+			uint64_t pattern = patterns[p];
+			uint64_t match = ~0ULL;
+			for(size_t k=0; k<width; k++)
+				match &= ( (pattern >> k) & 1 ) ? shifted[k] : ~shifted[k];
+			hits |= match;
+		}
+
+		//Clear anything that runs off the end of the input (including the unused tail of the last word)
+		size_t base = w*64;
+		size_t last = (len >= width) ? (len - width + 1) : 0;
+		if(last <= base)
+			hits = 0;
+		else if(last - base < 64)
+			hits &= (1ULL << (last - base)) - 1;
+
+		out[w] = hits;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Phase histograms
+
+/**
+	@brief Counts how many times each phase of a symbol period has a match bit set
+
+	@param matches		Match stream from FindPatterns()
+	@param period		Symbol length, in bits (1 to 128)
+	@param nsymbols		Number of symbols to consider. Phase r counts bits r, r + period, ... r + (nsymbols-1)*period.
+	@param counts		Output histogram, resized to period entries
+ */
+void BitstreamAligner::CountByPhase(
+	const PackedDigitalWaveform& matches,
+	size_t period,
+	size_t nsymbols,
+	vector<size_t>& counts)
+{
+	counts.assign(period, 0);
+	if( (period == 0) || (period > 128) )
+	{
+		LogError("BitstreamAligner::CountByPhase: period %zu not supported\n", period);
+		return;
+	}
+
+	//Split the capture into one block of symbols per thread, then merge the histograms
+	size_t nthreads = omp_get_max_threads();
+	size_t chunk = (nsymbols + nthreads - 1) / nthreads;
+	vector<vector<size_t>> partial(nthreads);
+
+	#pragma omp parallel for
+	for(size_t t=0; t<nthreads; t++)
+	{
+		size_t start = t*chunk;
+		size_t end = min(nsymbols, start + chunk);
+		partial[t].assign(period, 0);
+		if(start < end)
+			CountByPhaseRange(matches, period, start, end, partial[t]);
+	}
+
+	for(auto& p : partial)
+	{
+		for(size_t r=0; r<period; r++)
+			counts[r] += p[r];
+	}
+}
+
+/**
+	@brief Adds match counts for symbols [start, end) to a histogram
+
+	Each of the (up to 128) phases gets its own bit lane in a pair of words, and a stack of 16 such word pairs forms
+	a bit-sliced counter: plane b holds bit b of every lane's count. Adding one symbol's worth of match bits to all
+	lanes is then a ripple carry through the planes, which almost always stops after one or two steps. The planes
+	are flushed into the real histogram before they can overflow.
+ */
+void BitstreamAligner::CountByPhaseRange(
+	const PackedDigitalWaveform& matches,
+	size_t period,
+	size_t start,
+	size_t end,
+	vector<size_t>& counts)
+{
+	const size_t nplanes = 16;
+	const size_t maxadds = (1 << nplanes) - 1;
+
+	uint64_t lo[nplanes] = {0};
+	uint64_t hi[nplanes] = {0};
+	size_t adds = 0;
+
+	size_t lowidth = min(period, (size_t)64);
+	size_t hiwidth = period - lowidth;
+
+	for(size_t k=start; k<end; k++)
+	{
+		size_t base = k * period;
+
+		uint64_t carry = matches.GetBits(base, lowidth);
+		for(size_t b=0; carry && (b < nplanes); b++)
+		{
+			uint64_t next = lo[b] & carry;
+			lo[b] ^= carry;
+			carry = next;
+		}
+
+		if(hiwidth)
+		{
+			carry = matches.GetBits(base + 64, hiwidth);
+			for(size_t b=0; carry && (b < nplanes); b++)
+			{
+				uint64_t next = hi[b] & carry;
+				hi[b] ^= carry;
+				carry = next;
+			}
+		}
+
+		//Flush before the counters can wrap
+		adds ++;
+		if( (adds == maxadds) || (k+1 == end) )
+		{
+			for(size_t b=0; b<nplanes; b++)
+			{
+				for(size_t r=0; r<lowidth; r++)
+					counts[r] += ( (lo[b] >> r) & 1 ) << b;
+				for(size_t r=0; r<hiwidth; r++)
+					counts[r + 64] += ( (hi[b] >> r) & 1 ) << b;
+				lo[b] = 0;
+				hi[b] = 0;
+			}
+			adds = 0;
+		}
+	}
+}
+
+/**
+	@brief Finds the symbol phase with the most occurrences of any of a set of patterns
+
+	@param in			Input bit stream
+	@param patterns		Patterns to look for, LSB first
+	@param npatterns	Number of patterns
+	@param width		Width of every pattern, in bits
+	@param period		Symbol length, in bits
+	@param nsymbols		Number of symbols to consider
+
+	@return The phase (0 to period-1) with the highest count. Ties go to the lowest phase.
+ */
+size_t BitstreamAligner::FindBestPhase(
+	const PackedDigitalWaveform& in,
+	const uint64_t* patterns,
+	size_t npatterns,
+	size_t width,
+	size_t period,
+	size_t nsymbols)
+{
+	PackedDigitalWaveform matches;
+	FindPatterns(in, patterns, npatterns, width, matches);
+
+	vector<size_t> counts;
+	CountByPhase(matches, period, nsymbols, counts);
+
+	size_t best = 0;
+	for(size_t r=1; r<counts.size(); r++)
+	{
+		if(counts[r] > counts[best])
+			best = r;
+	}
+	return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+
+/**
+	@brief Reverses the order of the low count bits of a value
+
+	Used to turn LSB-first words from PackedDigitalWaveform::GetBits() into the MSB-first codes most line code tables
+	are written in.
+ */
+uint64_t BitstreamAligner::ReverseBits(uint64_t value, size_t count)
+{
+	if(count == 0)
+		return 0;
+
+	//Swap adjacent bits, then pairs, then nibbles, then bytes
+	value = ( (value >> 1) & 0x5555555555555555ULL ) | ( (value & 0x5555555555555555ULL) << 1 );
+	value = ( (value >> 2) & 0x3333333333333333ULL ) | ( (value & 0x3333333333333333ULL) << 2 );
+	value = ( (value >> 4) & 0x0f0f0f0f0f0f0f0fULL ) | ( (value & 0x0f0f0f0f0f0f0f0fULL) << 4 );
+	value = __builtin_bswap64(value);
+	return value >> (64 - count);
+}
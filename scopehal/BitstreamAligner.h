@@ -0,0 +1,89 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of BitstreamAligner
+ */
+
+#ifndef BitstreamAligner_h
+#define BitstreamAligner_h
+
+#include "PackedDigitalWaveform.h"
+
+/**
+	@brief Bit-parallel helpers for finding comma / sync patterns in a packed serial bit stream
+
+	Line code decoders (8b/10b, TMDS, 64b/66b) need to find which of the N possible symbol phases a sampled bit
+	stream is aligned to. Doing this one bit at a time means N passes over the capture with a branch per bit. Here
+	the stream is kept one bit per sample in a PackedDigitalWaveform, so:
+
+	* FindPatterns() tests 64 candidate start positions per word at once with shifts, ANDs and ORs.
+	* CountByPhase() adds up the match bits for all N phases of one symbol period at once, using a bank of bit-sliced
+	  counters so each symbol costs a handful of word operations regardless of N.
+
+	Patterns are given LSB first, i.e. bit k of the pattern is matched against sample (start + k).
+ */
+class BitstreamAligner
+{
+public:
+	static void FindPatterns(
+		const PackedDigitalWaveform& in,
+		const uint64_t* patterns,
+		size_t npatterns,
+		size_t width,
+		PackedDigitalWaveform& matches);
+
+	static void CountByPhase(
+		const PackedDigitalWaveform& matches,
+		size_t period,
+		size_t nsymbols,
+		std::vector<size_t>& counts);
+
+	static size_t FindBestPhase(
+		const PackedDigitalWaveform& in,
+		const uint64_t* patterns,
+		size_t npatterns,
+		size_t width,
+		size_t period,
+		size_t nsymbols);
+
+	static uint64_t ReverseBits(uint64_t value, size_t count);
+
+protected:
+	static void CountByPhaseRange(
+		const PackedDigitalWaveform& matches,
+		size_t period,
+		size_t start,
+		size_t end,
+		std::vector<size_t>& counts);
+};
+
+#endif
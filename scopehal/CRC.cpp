@@ -0,0 +1,231 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of CRC helpers
+ */
+
+#include "scopehal.h"
+#include <immintrin.h>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Carryless multiply folding for CRC32
+
+#ifdef __x86_64__
+
+/**
+	@brief Folds a multiple of 16 bytes (at least 64) into the Ethernet CRC32 register using PCLMULQDQ
+
+	See "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction" (Intel, 2009). All constants are
+	for the bit reflected 0x04c11db7 polynomial.
+ */
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t CRC32EthernetFoldPCLMUL(uint32_t crc, const uint8_t* buf, size_t len)
+{
+	//x^(4*128+64) mod P, x^(4*128) mod P: fold by 4 blocks
+	const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+
+	//x^(128+64) mod P, x^128 mod P: fold by 1 block
+	const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+
+	//x^64 mod P: 128 to 64 bit reduction
+	const __m128i k5 = _mm_set_epi64x(0, 0x0163cd6124);
+
+	//P(x) and mu for the final Barrett reduction
+	const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+
+	__m128i x1 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+	__m128i x2 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+	__m128i x3 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+	__m128i x4 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+	buf += 64;
+	len -= 64;
+
+	//Fold four blocks at a time
+	while(len >= 64)
+	{
+		__m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+		__m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+		__m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+		__m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+
+		x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(buf + 0x00)));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(buf + 0x10)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(buf + 0x20)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(buf + 0x30)));
+
+		buf += 64;
+		len -= 64;
+	}
+
+	//Fold the four accumulators down to one
+	__m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+	//Then fold in any remaining single blocks
+	while(len >= 16)
+	{
+		x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i*)buf)), x5);
+
+		buf += 16;
+		len -= 16;
+	}
+
+	//Reduce 128 bits to 64
+	const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+	x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask32);
+	x1 = _mm_clmulepi64_si128(x1, k5, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	//Barrett reduction to 32 bits
+	x2 = _mm_and_si128(x1, mask32);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+	x2 = _mm_and_si128(x2, mask32);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	return _mm_extract_epi32(x1, 1);
+}
+
+#endif
+
+/**
+	@brief Runs as much of a buffer as it can through the hardware CRC32 path, if we have one
+
+	On return, data and len point to whatever is left for the table driven code (possibly all of it).
+ */
+uint32_t CRC32EthernetFold(uint32_t state, const uint8_t*& data, size_t& len)
+{
+#ifdef __x86_64__
+	if(g_hasPCLMULQDQ && (len >= 64) )
+	{
+		size_t blocklen = len & ~(size_t)15;
+		state = CRC32EthernetFoldPCLMUL(state, data, blocklen);
+		data += blocklen;
+		len -= blocklen;
+	}
+#endif
+
+	return state;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Self test and benchmarking
+
+/**
+	@brief Checks one CRC against a bit-serial reference (and its published check value, if nonzero), then measures
+	its throughput
+ */
+template<class T>
+static void BenchmarkCRC(const char* name, uint32_t check, const vector<uint8_t>& buf)
+{
+	const uint8_t testvec[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+	uint32_t actual = T::Calculate(testvec, sizeof(testvec));
+
+	//Reference: the same message one bit at a time, over enough bytes to exercise the wide paths too
+	size_t reflen = 4096 + 13;
+	uint32_t ref = T::Start();
+	for(size_t i=0; i<reflen; i++)
+	{
+		for(int bit=0; bit<8; bit++)
+			ref = T::UpdateBit(ref, (buf[i] >> (T::IsReflected() ? bit : 7-bit)) & 1);
+	}
+	bool ok =
+		(T::Finish(ref) == T::Calculate(&buf[0], reflen)) &&
+		( (check == 0) || (actual == check) );
+
+	//Run for at least 100ms
+	double start = GetTime();
+	double dt = 0;
+	size_t bytes = 0;
+	uint32_t sink = 0;
+	do
+	{
+		sink ^= T::Calculate(&buf[0], buf.size());
+		bytes += buf.size();
+		dt = GetTime() - start;
+	} while(dt < 0.1);
+
+	LogNotice("%-16s check %08x %-4s %8.1f MB/s (%08x)\n",
+		name,
+		actual,
+		ok ? "OK" : "FAIL",
+		bytes / (dt * 1e6),
+		sink);
+}
+
+/**
+	@brief Verifies each CRC used by the protocol decoders and logs its throughput
+ */
+void LogCRCBenchmarks()
+{
+	LogNotice("CRC engine benchmarks%s:\n", g_hasPCLMULQDQ ? " (PCLMULQDQ available)" : "");
+	LogIndenter li;
+
+	vector<uint8_t> buf(1024*1024);
+	uint32_t x = 1;
+	for(auto& b : buf)
+	{
+		x = x*1103515245 + 12345;
+		b = x >> 24;
+	}
+
+	BenchmarkCRC<CRC32Ethernet>("CRC32Ethernet", 0xcbf43926, buf);
+	BenchmarkCRC<CRC16USB>("CRC16USB", 0xb4c8, buf);
+	BenchmarkCRC<CRC5USB>("CRC5USB", 0x19, buf);
+	BenchmarkCRC<CRC16DSI>("CRC16DSI", 0x6f91, buf);
+	BenchmarkCRC<CRC16PCIeDLLP>("CRC16PCIeDLLP", 0, buf);
+	BenchmarkCRC<CRC8ESPI>("CRC8ESPI", 0xf4, buf);
+	BenchmarkCRC<CRC15CAN>("CRC15CAN", 0x059e, buf);
+}
@@ -0,0 +1,246 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Shared CRC engine for protocol decoders
+ */
+
+#ifndef CRC_h
+#define CRC_h
+
+/**
+	@brief Lookup tables for a table driven CRC, generated at compile time
+
+	m_table[0] is the classic one-byte-at-a-time table. m_table[1...7] extend it to process eight bytes per step
+	("slice-by-8"): m_table[k][i] is the effect of byte i followed by k zero bytes.
+
+	Reflected (LSB first) algorithms keep the register right aligned. Non-reflected (MSB first) algorithms keep it
+	left aligned in 32 bits, so any width up to 32 can use the same byte-oriented update.
+ */
+template<unsigned Width, uint32_t Poly, bool Reflected>
+class CRCTables
+{
+public:
+	constexpr CRCTables()
+		: m_table()
+	{
+		for(uint32_t i=0; i<256; i++)
+		{
+			uint32_t c = Reflected ? i : (i << 24);
+			for(int bit=0; bit<8; bit++)
+			{
+				if(Reflected)
+					c = (c & 1) ? ( (c >> 1) ^ GetReflectedPoly() ) : (c >> 1);
+				else
+					c = (c & 0x80000000) ? ( (c << 1) ^ GetAlignedPoly() ) : (c << 1);
+			}
+			m_table[0][i] = c;
+		}
+
+		for(int k=1; k<8; k++)
+		{
+			for(uint32_t i=0; i<256; i++)
+			{
+				uint32_t prev = m_table[k-1][i];
+				if(Reflected)
+					m_table[k][i] = (prev >> 8) ^ m_table[0][prev & 0xff];
+				else
+					m_table[k][i] = (prev << 8) ^ m_table[0][prev >> 24];
+			}
+		}
+	}
+
+	///@brief The polynomial bit reversed within its width, for LSB-first shifting
+	static constexpr uint32_t GetReflectedPoly()
+	{
+		uint32_t r = 0;
+		for(unsigned i=0; i<Width; i++)
+		{
+			if(Poly & (1UL << i))
+				r |= 1UL << (Width - 1 - i);
+		}
+		return r;
+	}
+
+	///@brief The polynomial shifted up so its top bit is bit 31, for MSB-first shifting
+	static constexpr uint32_t GetAlignedPoly()
+	{ return Poly << (32 - Width); }
+
+	uint32_t m_table[8][256];
+};
+
+uint32_t CRC32EthernetFold(uint32_t state, const uint8_t*& data, size_t& len);
+
+/**
+	@brief A CRC algorithm of up to 32 bits, described by the usual (Rocksoft) parameters
+
+	Poly is given in normal (MSB first) form without the implicit top bit, e.g. 0x04c11db7 for Ethernet.
+	Reflected selects LSB-first processing of both input and output. Init is the initial register value and XorOut
+	is applied by Finish().
+
+	Most users just call Calculate(). Decoders that see data a byte or bit at a time can carry the register value
+	themselves with Start() / UpdateByte() / UpdateBit() / Finish().
+ */
+template<unsigned Width, uint32_t Poly, uint32_t Init, bool Reflected, uint32_t XorOut>
+class CRC
+{
+public:
+	static constexpr uint32_t GetMask()
+	{ return (Width == 32) ? 0xffffffff : ( (1UL << Width) - 1); }
+
+	static constexpr bool IsReflected()
+	{ return Reflected; }
+
+	static constexpr uint32_t Start()
+	{ return Init; }
+
+	static uint32_t Finish(uint32_t reg)
+	{ return (reg ^ XorOut) & GetMask(); }
+
+	static uint32_t Calculate(const uint8_t* data, size_t len)
+	{ return Finish(Update(Start(), data, len)); }
+
+	static uint32_t Calculate(const std::vector<uint8_t>& data)
+	{ return data.empty() ? Finish(Start()) : Calculate(&data[0], data.size()); }
+
+	/**
+		@brief Feeds a block of bytes through the CRC register
+	 */
+	static uint32_t Update(uint32_t reg, const uint8_t* data, size_t len)
+	{
+		const auto& t = m_tables.m_table;
+
+		if(Reflected)
+		{
+			uint32_t s = reg;
+
+			//Ethernet CRC32 is common enough to get a carryless-multiply folding path for long blocks
+			if( (Width == 32) && (Poly == 0x04c11db7) )
+				s = CRC32EthernetFold(s, data, len);
+
+			while(len >= 8)
+			{
+				uint32_t one = s ^ ReadLE32(data);
+				uint32_t two = ReadLE32(data + 4);
+				s =	t[7][one & 0xff] ^ t[6][(one >> 8) & 0xff] ^ t[5][(one >> 16) & 0xff] ^ t[4][one >> 24] ^
+					t[3][two & 0xff] ^ t[2][(two >> 8) & 0xff] ^ t[1][(two >> 16) & 0xff] ^ t[0][two >> 24];
+				data += 8;
+				len -= 8;
+			}
+
+			for(size_t i=0; i<len; i++)
+				s = (s >> 8) ^ t[0][(s ^ data[i]) & 0xff];
+			return s;
+		}
+		else
+		{
+			uint32_t s = reg << (32 - Width);
+
+			while(len >= 8)
+			{
+				uint32_t one = s ^ ReadBE32(data);
+				uint32_t two = ReadBE32(data + 4);
+				s =	t[7][one >> 24] ^ t[6][(one >> 16) & 0xff] ^ t[5][(one >> 8) & 0xff] ^ t[4][one & 0xff] ^
+					t[3][two >> 24] ^ t[2][(two >> 16) & 0xff] ^ t[1][(two >> 8) & 0xff] ^ t[0][two & 0xff];
+				data += 8;
+				len -= 8;
+			}
+
+			for(size_t i=0; i<len; i++)
+				s = (s << 8) ^ t[0][(s >> 24) ^ data[i]];
+			return s >> (32 - Width);
+		}
+	}
+
+	static uint32_t UpdateByte(uint32_t reg, uint8_t data)
+	{ return Update(reg, &data, 1); }
+
+	/**
+		@brief Feeds a single bit through the CRC register, for protocols that aren't byte aligned
+	 */
+	static uint32_t UpdateBit(uint32_t reg, bool bit)
+	{
+		if(Reflected)
+		{
+			bool feedback = (reg ^ bit) & 1;
+			reg >>= 1;
+			if(feedback)
+				reg ^= m_tables.GetReflectedPoly();
+			return reg;
+		}
+		else
+		{
+			bool feedback = ( (reg >> (Width - 1)) ^ bit) & 1;
+			reg = (reg << 1) & GetMask();
+			if(feedback)
+				reg ^= Poly;
+			return reg;
+		}
+	}
+
+protected:
+	static uint32_t ReadLE32(const uint8_t* p)
+	{ return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+	static uint32_t ReadBE32(const uint8_t* p)
+	{ return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+
+	static constexpr CRCTables<Width, Poly, Reflected> m_tables = CRCTables<Width, Poly, Reflected>();
+};
+
+//Out of line definition, since m_tables is odr-used and this isn't implicit for static constexpr members until C++17
+template<unsigned Width, uint32_t Poly, uint32_t Init, bool Reflected, uint32_t XorOut>
+constexpr CRCTables<Width, Poly, Reflected> CRC<Width, Poly, Init, Reflected, XorOut>::m_tables;
+
+///@brief IEEE 802.3 FCS, also used for PCIe LCRC and ECRC
+typedef CRC<32, 0x04c11db7, 0xffffffff, true, 0xffffffff> CRC32Ethernet;
+
+///@brief USB 2.0 data packet CRC
+typedef CRC<16, 0x8005, 0xffff, true, 0xffff> CRC16USB;
+
+///@brief USB 2.0 token CRC
+typedef CRC<5, 0x05, 0x1f, true, 0x1f> CRC5USB;
+
+///@brief MIPI DSI packet footer (CRC-16-CCITT, LSB first, aka CRC-16/MCRF4XX)
+typedef CRC<16, 0x1021, 0xffff, true, 0x0000> CRC16DSI;
+
+///@brief PCIe DLLP CRC
+typedef CRC<16, 0x100b, 0xffff, true, 0xffff> CRC16PCIeDLLP;
+
+///@brief eSPI command/response CRC (aka CRC-8/SMBUS)
+typedef CRC<8, 0x07, 0x00, false, 0x00> CRC8ESPI;
+
+///@brief CAN 2.0 frame CRC
+typedef CRC<15, 0x4599, 0x0000, false, 0x0000> CRC15CAN;
+
+void LogCRCBenchmarks();
+
+#endif
@@ -0,0 +1,210 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of DecoderState
+ */
+
+#include "scopehal.h"
+#include "DecoderState.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Accessors
+
+void DecoderState::clear()
+{
+	m_ints.clear();
+	m_bytes.clear();
+	m_times.clear();
+}
+
+int64_t DecoderState::GetInt(const string& name, int64_t defaultValue) const
+{
+	auto it = m_ints.find(name);
+	if(it == m_ints.end())
+		return defaultValue;
+	return it->second;
+}
+
+/**
+	@brief Gets a byte string (empty if it doesn't exist)
+ */
+const vector<uint8_t>& DecoderState::GetBytes(const string& name) const
+{
+	static const vector<uint8_t> empty;
+
+	auto it = m_bytes.find(name);
+	if(it == m_bytes.end())
+		return empty;
+	return it->second;
+}
+
+string DecoderState::GetString(const string& name) const
+{
+	auto& bytes = GetBytes(name);
+	return string(bytes.begin(), bytes.end());
+}
+
+/**
+	@brief Saves a point in time
+
+	@param name		Name of the timestamp
+	@param wfm		Waveform the offset is relative to
+	@param offset	Femtoseconds from the start of the waveform
+ */
+void DecoderState::SetTime(const string& name, WaveformBase* wfm, int64_t offset)
+{
+	int64_t sec = wfm->m_startTimestamp;
+	int64_t fs = wfm->m_startFemtoseconds + offset;
+	sec += fs / FS_PER_SECOND;
+	fs %= (int64_t)FS_PER_SECOND;
+	if(fs < 0)
+	{
+		sec --;
+		fs += FS_PER_SECOND;
+	}
+	m_times[name] = pair<int64_t, int64_t>(sec, fs);
+}
+
+/**
+	@brief Gets a saved point in time, relative to the start of a (possibly different) waveform
+
+	@param name		Name of the timestamp
+	@param wfm		Waveform the offset should be relative to
+	@param offset	Femtoseconds from the start of the waveform (negative if before the waveform started)
+
+	@return False if the timestamp doesn't exist, or is too far from the waveform for the offset to fit in 64 bits
+ */
+bool DecoderState::GetTime(const string& name, WaveformBase* wfm, int64_t& offset) const
+{
+	auto it = m_times.find(name);
+	if(it == m_times.end())
+		return false;
+
+	//int64_t femtoseconds overflow after about 2.5 hours
+	int64_t dsec = it->second.first - (int64_t)wfm->m_startTimestamp;
+	if( (dsec > 3600) || (dsec < -3600) )
+		return false;
+
+	offset = dsec * FS_PER_SECOND + it->second.second - wfm->m_startFemtoseconds;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Serialization
+
+/**
+	@brief Serializes the state as a YAML block
+
+	@param indent	Number of spaces to indent each line
+ */
+string DecoderState::Serialize(size_t indent) const
+{
+	string pad(indent, ' ');
+	string config;
+	char tmp[256];
+
+	if(!m_ints.empty())
+	{
+		config += pad + "ints:\n";
+		for(auto& it : m_ints)
+		{
+			snprintf(tmp, sizeof(tmp), "    \"%s\": %lld\n", it.first.c_str(), (long long)it.second);
+			config += pad + tmp;
+		}
+	}
+
+	//Byte strings are stored as hex so arbitrary binary data survives
+	if(!m_bytes.empty())
+	{
+		config += pad + "bytes:\n";
+		for(auto& it : m_bytes)
+		{
+			string hex;
+			for(auto b : it.second)
+			{
+				snprintf(tmp, sizeof(tmp), "%02x", b);
+				hex += tmp;
+			}
+			config += pad + "    \"" + it.first + "\": \"" + hex + "\"\n";
+		}
+	}
+
+	if(!m_times.empty())
+	{
+		config += pad + "times:\n";
+		for(auto& it : m_times)
+		{
+			snprintf(tmp, sizeof(tmp), "    \"%s\": [%lld, %lld]\n",
+				it.first.c_str(), (long long)it.second.first, (long long)it.second.second);
+			config += pad + tmp;
+		}
+	}
+
+	return config;
+}
+
+/**
+	@brief Loads state previously created by Serialize()
+ */
+void DecoderState::Load(const YAML::Node& node)
+{
+	clear();
+
+	if(node["ints"])
+	{
+		for(auto it : node["ints"])
+			m_ints[it.first.as<string>()] = it.second.as<int64_t>();
+	}
+
+	if(node["bytes"])
+	{
+		for(auto it : node["bytes"])
+		{
+			auto hex = it.second.as<string>();
+			vector<uint8_t> bytes;
+			for(size_t i=0; i+1 < hex.length(); i += 2)
+				bytes.push_back(strtol(hex.substr(i, 2).c_str(), NULL, 16));
+			m_bytes[it.first.as<string>()] = bytes;
+		}
+	}
+
+	if(node["times"])
+	{
+		for(auto it : node["times"])
+		{
+			m_times[it.first.as<string>()] =
+				pair<int64_t, int64_t>(it.second[0].as<int64_t>(), it.second[1].as<int64_t>());
+		}
+	}
+}
@@ -0,0 +1,101 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of DecoderState
+ */
+
+#ifndef DecoderState_h
+#define DecoderState_h
+
+#include <map>
+#include <yaml-cpp/yaml.h>
+
+class WaveformBase;
+
+/**
+	@brief Snapshot of a protocol decoder's internal state at the end of a waveform
+
+	Decoders which support continuous decoding (see Filter::TakeCarriedState()) save whatever they need to pick up
+	where they left off - state machine position, partial bytes, a packet in progress - and restore it at the start of
+	the next waveform, so a frame straddling two back-to-back acquisitions decodes correctly.
+
+	Values are stored by name as integers, byte strings, or absolute timestamps. Timestamps are kept as seconds plus
+	femtoseconds since the epoch, so they can be converted to an offset within a waveform with a different start time
+	and timescale. Everything round trips through YAML so the snapshot can be saved with the session.
+ */
+class DecoderState
+{
+public:
+	void clear();
+
+	bool empty() const
+	{ return m_ints.empty() && m_bytes.empty() && m_times.empty(); }
+
+	//Integers
+	void SetInt(const std::string& name, int64_t value)
+	{ m_ints[name] = value; }
+
+	int64_t GetInt(const std::string& name, int64_t defaultValue = 0) const;
+
+	bool HasInt(const std::string& name) const
+	{ return m_ints.find(name) != m_ints.end(); }
+
+	//Byte strings
+	void SetBytes(const std::string& name, const uint8_t* data, size_t len)
+	{ m_bytes[name] = std::vector<uint8_t>(data, data + len); }
+
+	void SetBytes(const std::string& name, const std::vector<uint8_t>& data)
+	{ m_bytes[name] = data; }
+
+	void SetString(const std::string& name, const std::string& value)
+	{ m_bytes[name] = std::vector<uint8_t>(value.begin(), value.end()); }
+
+	const std::vector<uint8_t>& GetBytes(const std::string& name) const;
+	std::string GetString(const std::string& name) const;
+
+	//Timestamps
+	void SetTime(const std::string& name, WaveformBase* wfm, int64_t offset);
+	bool GetTime(const std::string& name, WaveformBase* wfm, int64_t& offset) const;
+
+	//Serialization
+	std::string Serialize(size_t indent) const;
+	void Load(const YAML::Node& node);
+
+protected:
+	std::map<std::string, int64_t> m_ints;
+	std::map<std::string, std::vector<uint8_t> > m_bytes;
+
+	///Absolute timestamps (seconds since the epoch, femtoseconds)
+	std::map<std::string, std::pair<int64_t, int64_t> > m_times;
+};
+
+#endif
@@ -533,9 +533,7 @@ bool DemoOscilloscope::AcquireData()
 		wfm->m_densePacked = true;
 	}
 
-	m_pendingWaveformsMutex.lock();
-	m_pendingWaveforms.push_back(s);
-	m_pendingWaveformsMutex.unlock();
+	m_pendingWaveforms.Push(s);
 
 	if(m_triggerOneShot)
 		m_triggerArmed = false;
@@ -35,14 +35,18 @@
 
 #include "scopehal.h"
 #include "Filter.h"
+#include <immintrin.h>
+#include <omp.h>
 
 using namespace std;
 
 Filter::CreateMapType Filter::m_createprocs;
 set<Filter*> Filter::m_filters;
 
-mutex Filter::m_cacheMutex;
-map<pair<WaveformBase*, float>, vector<int64_t> > Filter::m_zeroCrossingCache;
+ZeroCrossingCache Filter::m_zeroCrossingCache;
+
+bool Filter::m_implicitTimestampOutput = false;
+mutex Filter::m_materializeMutex;
 
 Gdk::Color Filter::m_standardColors[STANDARD_COLOR_COUNT] =
 {
@@ -188,11 +192,34 @@ void Filter::RefreshIfDirty()
 	if(m_dirty)
 	{
 		RefreshInputsIfDirty();
+		if(!SupportsImplicitTimestamps())
+			MaterializeInputTimestamps();
 		Refresh();
 		m_dirty = false;
 	}
 }
 
+/**
+	@brief Creates real offset/duration arrays for any input waveforms which have implicit timestamps.
+
+	Inputs may be shared with other filters refreshing in parallel, so this is serialized by a global mutex. Filters
+	which support implicit timestamps never touch the arrays so it's safe for them to run concurrently.
+ */
+void Filter::MaterializeInputTimestamps()
+{
+	for(auto c : m_inputs)
+	{
+		if(!c.m_channel)
+			continue;
+		auto data = c.GetData();
+		if(!data)
+			continue;
+
+		lock_guard<mutex> lock(m_materializeMutex);
+		data->MaterializeTimestamps();
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Enumeration
 
@@ -234,7 +261,7 @@ bool Filter::VerifyInputOK(size_t i, bool allowEmpty)
 
 	if(!allowEmpty)
 	{
-		if(data->m_offsets.size() == 0)
+		if(data->size() == 0)
 			return false;
 	}
 
@@ -268,7 +295,7 @@ bool Filter::VerifyAllInputsOKAndAnalog()
 		auto data = p.m_channel->GetData(p.m_stream);
 		if(data == NULL)
 			return false;
-		if(data->m_offsets.size() == 0)
+		if(data->size() == 0)
 			return false;
 
 		auto adata = dynamic_cast<AnalogWaveform*>(data);
@@ -328,6 +355,62 @@ void Filter::SampleOnRisingEdges(DigitalWaveform* data, DigitalWaveform* clock,
 	}
 }
 
+/**
+	@brief Samples a packed digital waveform on the rising edges of a packed clock
+
+	Same semantics as the DigitalWaveform version, but clock edges are found 64 samples at a time and the data index
+	is computed directly from the clock timestamp (both inputs are always dense packed) rather than by scanning.
+
+	@param data		The data signal to sample
+	@param clock	The clock signal to use
+	@param samples	Output waveform
+ */
+void Filter::SampleOnRisingEdges(PackedDigitalWaveform* data, PackedDigitalWaveform* clock, DigitalWaveform& samples)
+{
+	samples.clear();
+
+	size_t dlen = data->size();
+	if(dlen == 0)
+		return;
+
+	vector<size_t> clockEdges;
+	clock->FindEdges(true, false, 1, clockEdges);
+
+	size_t len = clockEdges.size();
+	samples.m_offsets.reserve(len);
+	samples.m_durations.reserve(len);
+	samples.m_samples.reserve(len);
+
+	int64_t dts = data->m_timescale;
+	int64_t dtp = data->m_triggerPhase;
+	size_t ndata = 0;
+	for(size_t i=0; i<len; i++)
+	{
+		int64_t clkstart = clockEdges[i] * clock->m_timescale + clock->m_triggerPhase;
+
+		//Find the last data sample starting before the clock edge
+		int64_t delta = clkstart - dtp;
+		if( (delta > 0) && (dts > 0) )
+		{
+			size_t target = min( (size_t)((delta - 1) / dts), dlen - 1);
+			ndata = max(ndata, target);
+		}
+
+		//Extend the previous sample's duration (if any) to our start
+		size_t ssize = samples.m_samples.size();
+		if(ssize)
+		{
+			size_t last = ssize - 1;
+			samples.m_durations[last] = clkstart - samples.m_offsets[last];
+		}
+
+		//Add the new sample
+		samples.m_offsets.push_back(clkstart);
+		samples.m_durations.push_back(1);
+		samples.m_samples.push_back(data->GetSample(ndata));
+	}
+}
+
 /**
 	@brief Samples a digital bus waveform on the rising edges of a clock
 
@@ -517,149 +600,208 @@ void Filter::SampleOnAnyEdges(DigitalBusWaveform* data, DigitalWaveform* clock,
  */
 void Filter::FindRisingEdges(AnalogWaveform* data, float threshold, vector<int64_t>& edges)
 {
-	//Find times of the zero crossings
-	bool first = true;
-	bool last = false;
-	int64_t phoff = data->m_triggerPhase;
+	FindEdges(data, threshold, true, edges);
+}
+
+/**
+	@brief Find zero crossings in a waveform, interpolating as necessary
+
+	Results are cached until the next call to ClearAnalysisCache(), so multiple filters looking at the same
+	waveform only pay for the search once.
+ */
+void Filter::FindZeroCrossings(AnalogWaveform* data, float threshold, vector<int64_t>& edges)
+{
+	m_zeroCrossingCache.Lookup(data, threshold, edges, FindZeroCrossingsUncached);
+}
+
+/**
+	@brief Find zero crossings in a waveform, interpolating as necessary, bypassing the cache
+ */
+void Filter::FindZeroCrossingsUncached(AnalogWaveform* data, float threshold, vector<int64_t>& edges)
+{
+	FindEdges(data, threshold, false, edges);
+}
+
+/**
+	@brief Finds threshold crossings in an analog waveform
+
+	A crossing is reported between samples i-1 and i if one is above the threshold and the other is not. As has always
+	been the case, a crossing between samples 0 and 1 is not reported.
+
+	Large waveforms are split into blocks and searched in parallel. Since each crossing only depends on the two
+	samples either side of it, each block simply starts one sample early and no other state carries across the seams.
+
+	@param data			The waveform to search
+	@param threshold	Threshold voltage
+	@param risingOnly	True to only report rising edges, false to report all crossings
+	@param edges		Timestamps of the crossings are appended to this vector
+ */
+void Filter::FindEdges(AnalogWaveform* data, float threshold, bool risingOnly, vector<int64_t>& edges)
+{
 	size_t len = data->m_samples.size();
-	float fscale = data->m_timescale;
+	if(len < 3)
+		return;
 
-	if(data->m_densePacked)
+	size_t istart = 2;
+	size_t count = len - istart;
+
+	//Divide large waveforms (>1M points) into blocks and multithread them.
+	//Below that, one thread gets through the 4 MB of samples in well under a millisecond, so the time taken to start
+	//the threads and stitch the blocks back together would eat most of the gain. This is the same cutoff as sample
+	//conversion uses (see Oscilloscope::SplitSampleConversionJobs()).
+	if(count > 1000000)
 	{
-		for(size_t i=1; i<len; i++)
+		//Round blocks to multiples of 64 samples for clean vectorization
+		size_t numblocks = omp_get_max_threads();
+		size_t lastblock = numblocks - 1;
+		size_t blocksize = count / numblocks;
+		blocksize = blocksize - (blocksize % 64);
+
+		vector< vector<int64_t> > blockEdges(numblocks);
+
+		#pragma omp parallel for
+		for(size_t i=0; i<numblocks; i++)
 		{
-			bool value = data->m_samples[i] > threshold;
+			//Last block gets any extra that didn't divide evenly
+			size_t bstart = istart + i*blocksize;
+			size_t bend = bstart + blocksize;
+			if(i == lastblock)
+				bend = len;
 
-			//Save the last value
-			if(first)
-			{
-				last = value;
-				first = false;
-				continue;
-			}
-			if(!value)
-				last = false;
-
-			//Skip samples with no rising edge
-			if(!value || last)
-				continue;
-
-			//Midpoint of the sample, plus the zero crossing
-			int64_t tfrac = fscale * InterpolateTime(data, i-1, threshold);
-			int64_t t = phoff + data->m_timescale*(i-1) + tfrac;
-			edges.push_back(t);
-			last = true;
+			FindEdgesBlock(data, threshold, risingOnly, bstart, bend, blockEdges[i]);
 		}
+
+		//Stitch the blocks back together
+		size_t total = edges.size();
+		for(auto& b : blockEdges)
+			total += b.size();
+		edges.reserve(total);
+		for(auto& b : blockEdges)
+			edges.insert(edges.end(), b.begin(), b.end());
 	}
+
+	//Small waveforms get done single threaded to avoid overhead
 	else
-	{
-		for(size_t i=1; i<len; i++)
-		{
-			bool value = data->m_samples[i] > threshold;
+		FindEdgesBlock(data, threshold, risingOnly, istart, len, edges);
+}
 
-			//Save the last value
-			if(first)
-			{
-				last = value;
-				first = false;
-				continue;
-			}
+/**
+	@brief Finds threshold crossings in samples [istart, iend) of a waveform, using the best available kernel
+ */
+void Filter::FindEdgesBlock(
+	AnalogWaveform* data, float threshold, bool risingOnly, size_t istart, size_t iend, vector<int64_t>& edges)
+{
+	if(g_hasAvx512F)
+		FindEdgesAVX512F(data, threshold, risingOnly, istart, iend, edges);
+	else if(g_hasAvx2)
+		FindEdgesAVX2(data, threshold, risingOnly, istart, iend, edges);
+	else
+		FindEdgesGeneric(data, threshold, risingOnly, istart, iend, edges);
+}
 
-			if(!value)
-				last = false;
+/**
+	@brief Generic backend for FindEdges()
+ */
+void Filter::FindEdgesGeneric(
+	AnalogWaveform* data, float threshold, bool risingOnly, size_t istart, size_t iend, vector<int64_t>& edges)
+{
+	float* samples = (float*)&data->m_samples[0];
+	for(size_t i=istart; i<iend; i++)
+	{
+		bool last = samples[i-1] > threshold;
+		bool value = samples[i] > threshold;
 
-			//Skip samples with no rising edge
-			if(!value || last)
-				continue;
+		//Skip samples with no transition
+		if(last == value)
+			continue;
+		if(risingOnly && !value)
+			continue;
 
-			//Midpoint of the sample, plus the zero crossing
-			int64_t tfrac = fscale * InterpolateTime(data, i-1, threshold);
-			int64_t t = phoff + data->m_timescale * data->m_offsets[i-1] + tfrac;
-			edges.push_back(t);
-			last = true;
-		}
+		edges.push_back(GetEdgeTimestamp(data, i, threshold));
 	}
 }
 
 /**
-	@brief Find zero crossings in a waveform, interpolating as necessary
+	@brief Optimized version of FindEdges()
+
+	Compares 8 samples against the threshold at once, then walks the bitmask of crossings.
  */
-void Filter::FindZeroCrossings(AnalogWaveform* data, float threshold, vector<int64_t>& edges)
+__attribute__((target("avx2")))
+void Filter::FindEdgesAVX2(
+	AnalogWaveform* data, float threshold, bool risingOnly, size_t istart, size_t iend, vector<int64_t>& edges)
 {
-	pair<WaveformBase*, float> cachekey(data, threshold);
+	float* samples = (float*)&data->m_samples[0];
+	size_t end = iend - ((iend - istart) % 8);
+
+	__m256 thresholds = _mm256_set1_ps(threshold);
 
-	//Check cache
+	for(size_t i=istart; i<end; i += 8)
 	{
-		lock_guard<mutex> lock(m_cacheMutex);
-		auto it = m_zeroCrossingCache.find(cachekey);
-		if(it != m_zeroCrossingCache.end())
+		//Compare each sample, and the one before it, against the threshold
+		__m256 cur = _mm256_loadu_ps(samples + i);
+		__m256 prev = _mm256_loadu_ps(samples + i - 1);
+		unsigned int curmask = _mm256_movemask_ps(_mm256_cmp_ps(cur, thresholds, _CMP_GT_OQ));
+		unsigned int prevmask = _mm256_movemask_ps(_mm256_cmp_ps(prev, thresholds, _CMP_GT_OQ));
+
+		unsigned int mask;
+		if(risingOnly)
+			mask = curmask & ~prevmask;
+		else
+			mask = curmask ^ prevmask;
+
+		//Interpolate each crossing we found
+		while(mask)
 		{
-			edges = it->second;
-			return;
+			size_t j = __builtin_ctz(mask);
+			mask &= mask - 1;
+			edges.push_back(GetEdgeTimestamp(data, i + j, threshold));
 		}
 	}
 
-	//Find times of the zero crossings
-	bool first = true;
-	bool last = false;
-	int64_t phoff = data->m_triggerPhase;
-	size_t len = data->m_samples.size();
-	float fscale = data->m_timescale;
+	//Get any extras we didn't get in the SIMD loop
+	FindEdgesGeneric(data, threshold, risingOnly, end, iend, edges);
+}
 
-	if(data->m_densePacked)
-	{
-		for(size_t i=1; i<len; i++)
-		{
-			bool value = data->m_samples[i] > threshold;
+/**
+	@brief Optimized version of FindEdges()
 
-			//Save the last value
-			if(first)
-			{
-				last = value;
-				first = false;
-				continue;
-			}
+	Compares 16 samples against the threshold at once, then walks the bitmask of crossings.
+ */
+__attribute__((target("avx512f")))
+void Filter::FindEdgesAVX512F(
+	AnalogWaveform* data, float threshold, bool risingOnly, size_t istart, size_t iend, vector<int64_t>& edges)
+{
+	float* samples = (float*)&data->m_samples[0];
+	size_t end = iend - ((iend - istart) % 16);
 
-			//Skip samples with no transition
-			if(last == value)
-				continue;
+	__m512 thresholds = _mm512_set1_ps(threshold);
 
-			//Midpoint of the sample, plus the zero crossing
-			int64_t tfrac = fscale * InterpolateTime(data, i-1, threshold);
-			int64_t t = phoff + data->m_timescale*(i-1) + tfrac;
-			edges.push_back(t);
-			last = value;
-		}
-	}
-	else
+	for(size_t i=istart; i<end; i += 16)
 	{
-		for(size_t i=1; i<len; i++)
-		{
-			bool value = data->m_samples[i] > threshold;
-
-			//Save the last value
-			if(first)
-			{
-				last = value;
-				first = false;
-				continue;
-			}
-
-			//Skip samples with no transition
-			if(last == value)
-				continue;
+		//Compare each sample, and the one before it, against the threshold
+		__m512 cur = _mm512_loadu_ps(samples + i);
+		__m512 prev = _mm512_loadu_ps(samples + i - 1);
+		unsigned int curmask = _mm512_cmp_ps_mask(cur, thresholds, _CMP_GT_OQ);
+		unsigned int prevmask = _mm512_cmp_ps_mask(prev, thresholds, _CMP_GT_OQ);
+
+		unsigned int mask;
+		if(risingOnly)
+			mask = curmask & ~prevmask;
+		else
+			mask = curmask ^ prevmask;
+		mask &= 0xffff;
 
-			//Midpoint of the sample, plus the zero crossing
-			int64_t tfrac = fscale * InterpolateTime(data, i-1, threshold);
-			int64_t t = phoff + data->m_timescale * data->m_offsets[i-1] + tfrac;
-			edges.push_back(t);
-			last = value;
+		//Interpolate each crossing we found
+		while(mask)
+		{
+			size_t j = __builtin_ctz(mask);
+			mask &= mask - 1;
+			edges.push_back(GetEdgeTimestamp(data, i + j, threshold));
 		}
 	}
 
-	//Add to cache
-	lock_guard<mutex> lock(m_cacheMutex);
-	m_zeroCrossingCache[cachekey] = edges;
+	//Get any extras we didn't get in the SIMD loop
+	FindEdgesGeneric(data, threshold, risingOnly, end, iend, edges);
 }
 
 /**
@@ -753,6 +895,47 @@ void Filter::FindFallingEdges(DigitalWaveform* data, vector<int64_t>& edges)
 	}
 }
 
+/**
+	@brief Converts edge indexes from a packed waveform to timestamps, skipping the first sample like the
+	DigitalWaveform versions do
+ */
+static void PackedEdgesToTimestamps(PackedDigitalWaveform* data, bool rising, bool falling, vector<int64_t>& edges)
+{
+	vector<size_t> indexes;
+	data->FindEdges(rising, falling, 2, indexes);
+
+	int64_t phoff = data->m_timescale/2 + data->m_triggerPhase;
+	size_t base = edges.size();
+	size_t len = indexes.size();
+	edges.resize(base + len);
+	for(size_t i=0; i<len; i++)
+		edges[base + i] = phoff + data->m_timescale * (int64_t)indexes[i];
+}
+
+/**
+	@brief Find zero crossings in a packed waveform
+ */
+void Filter::FindZeroCrossings(PackedDigitalWaveform* data, vector<int64_t>& edges)
+{
+	PackedEdgesToTimestamps(data, true, true, edges);
+}
+
+/**
+	@brief Find rising edges in a packed waveform
+ */
+void Filter::FindRisingEdges(PackedDigitalWaveform* data, vector<int64_t>& edges)
+{
+	PackedEdgesToTimestamps(data, true, false, edges);
+}
+
+/**
+	@brief Find falling edges in a packed waveform
+ */
+void Filter::FindFallingEdges(PackedDigitalWaveform* data, vector<int64_t>& edges)
+{
+	PackedEdgesToTimestamps(data, false, true, edges);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Serialization
 
@@ -785,6 +968,13 @@ string Filter::SerializeConfiguration(IDTable& table, size_t /*indent*/)
 	snprintf(tmp, sizeof(tmp), "        offset:          %f\n", GetOffset());
 	config += tmp;
 
+	//Save any partially decoded data so a continuous decode can resume where it left off
+	if(!m_carriedState.empty())
+	{
+		config += "        decoderstate:\n";
+		config += m_carriedState.Serialize(12);
+	}
+
 	return config;
 }
 
@@ -800,6 +990,123 @@ void Filter::LoadParameters(const YAML::Node& node, IDTable& table)
 		SetVoltageRange(node["vrange"].as<double>());
 	if(node["offset"])
 		SetOffset(node["offset"].as<double>());
+
+	if(node["decoderstate"])
+		m_carriedState.Load(node["decoderstate"]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Continuous decoding
+
+/**
+	@brief Adds the "Continuous Decode" parameter
+
+	Decoders which can carry state from one waveform to the next call this from their constructor. When the parameter
+	is set, each Refresh() starts by calling TakeCarriedState() and ends by calling CarryState(), so a frame which
+	straddles two back-to-back acquisitions is decoded once, in the acquisition where it ends. The cost of each
+	Refresh() depends only on the new waveform, not on how much data has been decoded before it.
+ */
+void Filter::CreateStateCarryParameter()
+{
+	m_stateCarryName = "Continuous Decode";
+	m_parameters[m_stateCarryName] = FilterParameter(FilterParameter::TYPE_BOOL, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_stateCarryName].SetBoolVal(false);
+}
+
+bool Filter::IsStateCarryEnabled()
+{
+	if(m_stateCarryName.empty())
+		return false;
+	return m_parameters[m_stateCarryName].GetBoolVal();
+}
+
+void Filter::SetStateCarryEnabled(bool enabled)
+{
+	if(m_stateCarryName.empty())
+		return;
+
+	m_parameters[m_stateCarryName].SetBoolVal(enabled);
+	if(!enabled)
+		m_carriedState.clear();
+}
+
+/**
+	@brief Gets the state saved at the end of the previous waveform, if it can be applied to this one
+
+	The state is consumed whether or not it's returned. It's discarded if continuous decoding is off, or if the new
+	waveform doesn't pick up where the last one ended: a gap of more than maxGap (so data was lost), or any overlap
+	(typically the same waveform being decoded again after a parameter change).
+
+	@param wfm		The input waveform about to be decoded
+	@param maxGap	Largest allowable dead time between the two waveforms, in femtoseconds. Decoders which carry an
+					absolute deadline (e.g. the next UART sample point) can pass INT64_MAX and check it themselves.
+
+	@return The carried state, or an empty state if the decode should start from scratch
+ */
+DecoderState Filter::TakeCarriedState(WaveformBase* wfm, int64_t maxGap)
+{
+	DecoderState state = m_carriedState;
+	m_carriedState.clear();
+
+	if(!IsStateCarryEnabled() || state.empty())
+		return DecoderState();
+
+	//Allow a sample of slop either way for rounding
+	int64_t gap;
+	if(!GetCarriedGap(state, wfm, gap))
+		return DecoderState();
+	int64_t slop = wfm->m_timescale;
+	if( (gap < -slop) || ( (gap - slop) > maxGap) )
+		return DecoderState();
+
+	return state;
+}
+
+/**
+	@brief Gets the dead time between the end of the waveform a state was carried from and the start of a new one
+
+	Decoders which accept a long gap from TakeCarriedState() can use this to apply a tighter limit to some states.
+
+	@param state	State returned by TakeCarriedState()
+	@param wfm		The input waveform about to be decoded
+	@param gap		Dead time in femtoseconds (negative if the waveforms overlap)
+
+	@return False if the state has no end time
+ */
+bool Filter::GetCarriedGap(const DecoderState& state, WaveformBase* wfm, int64_t& gap)
+{
+	int64_t prevEnd;
+	if(!state.GetTime("_end", wfm, prevEnd))
+		return false;
+	gap = -prevEnd;
+	return true;
+}
+
+/**
+	@brief Saves decoder state at the end of a waveform for the next Refresh() to pick up
+
+	@param wfm		The input waveform which was just decoded
+	@param state	Whatever the decoder needs to resume. Pass an empty state if there's nothing in progress.
+ */
+void Filter::CarryState(WaveformBase* wfm, DecoderState& state)
+{
+	m_carriedState.clear();
+	if(!IsStateCarryEnabled() || state.empty())
+		return;
+
+	state.SetTime("_end", wfm, GetEndTime(wfm));
+	m_carriedState = state;
+}
+
+/**
+	@brief Gets the end of the last sample in a waveform, in femtoseconds from the start of the waveform
+ */
+int64_t Filter::GetEndTime(WaveformBase* wfm)
+{
+	size_t len = wfm->size();
+	if(len == 0)
+		return 0;
+	return (wfm->GetOffset(len-1) + wfm->GetDuration(len-1)) * wfm->m_timescale;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -897,7 +1204,7 @@ float Filter::InterpolateTime(AnalogWaveform* p, AnalogWaveform* n, size_t a, fl
  */
 float Filter::InterpolateValue(AnalogWaveform* cap, size_t index, float frac_ticks)
 {
-	float frac = frac_ticks / (cap->m_offsets[index+1] - cap->m_offsets[index]);
+	float frac = frac_ticks / (cap->GetOffset(index+1) - cap->GetOffset(index));
 	float v1 = cap->m_samples[index];
 	float v2 = cap->m_samples[index+1];
 	return v1 + (v2-v1)*frac;
@@ -1038,8 +1345,7 @@ float Filter::GetTopVoltage(AnalogWaveform* cap)
 
 void Filter::ClearAnalysisCache()
 {
-	lock_guard<mutex> lock(m_cacheMutex);
-	m_zeroCrossingCache.clear();
+	m_zeroCrossingCache.Clear();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1062,7 +1368,7 @@ AnalogWaveform* Filter::SetupEmptyOutputWaveform(WaveformBase* din, size_t strea
 	AnalogWaveform* cap = dynamic_cast<AnalogWaveform*>(GetData(stream));
 	if(cap == NULL)
 	{
-		cap = new AnalogWaveform;
+		cap = g_waveformPool.Allocate<AnalogWaveform>(din->size());
 		SetData(cap, stream);
 	}
 
@@ -1073,6 +1379,7 @@ AnalogWaveform* Filter::SetupEmptyOutputWaveform(WaveformBase* din, size_t strea
 	//Clear output
 	if(clear)
 	{
+		cap->m_implicitTimestamps = false;
 		cap->m_samples.clear();
 		cap->m_offsets.clear();
 		cap->m_durations.clear();
@@ -1097,7 +1404,7 @@ DigitalWaveform* Filter::SetupEmptyDigitalOutputWaveform(WaveformBase* din, size
 	DigitalWaveform* cap = dynamic_cast<DigitalWaveform*>(GetData(stream));
 	if(cap == NULL)
 	{
-		cap = new DigitalWaveform;
+		cap = g_waveformPool.Allocate<DigitalWaveform>(din->size());
 		SetData(cap, stream);
 	}
 
@@ -1133,9 +1440,24 @@ AnalogWaveform* Filter::SetupOutputWaveform(WaveformBase* din, size_t stream, si
 	cap->m_timescale 			= din->m_timescale;
 	cap->m_triggerPhase			= din->m_triggerPhase;
 
-	size_t len = din->m_offsets.size() - (skipstart + skipend);
-	size_t curlen = cap->m_offsets.size();
+	size_t len = din->size() - (skipstart + skipend);
+
+	//Dense packed input and we're allowed to skip the timestamps entirely? Just size the samples.
+	if(din->m_densePacked && UseImplicitTimestampOutput())
+	{
+		cap->SetImplicitTimestamps();
+		cap->Resize(len);
+		return cap;
+	}
 
+	//Switching back from implicit timestamps, treat as not dense packed so we fill everything
+	if(cap->m_implicitTimestamps)
+	{
+		cap->m_implicitTimestamps = false;
+		cap->m_densePacked = false;
+	}
+
+	size_t curlen = cap->m_offsets.size();
 	cap->Resize(len);
 
 	//If the input waveform is NOT dense packed, no optimizations possible.
@@ -1148,22 +1470,17 @@ AnalogWaveform* Filter::SetupOutputWaveform(WaveformBase* din, size_t stream, si
 
 	//Input waveform is dense packed, but output is not.
 	//Need to clear some old stuff but we can produce a dense packed output.
-	//Note that we copy from zero regardless of skipstart to produce a dense packed output.
-	//TODO: AVX2 optimizations here so we don't need to read data we already know the value of
+	//Note that we start from zero regardless of skipstart to produce a dense packed output.
+	//We already know what the timestamps are, so there's no need to read them from the input.
 	else if(!cap->m_densePacked)
 	{
-		memcpy(&cap->m_offsets[0], &din->m_offsets[0], len*sizeof(int64_t));
-		memcpy(&cap->m_durations[0], &din->m_durations[0], len*sizeof(int64_t));
+		cap->FillDenseTimestamps(0, len);
 		cap->m_densePacked = true;
 	}
 
-	//Both waveforms are dense packed, but new size is bigger. Need to copy the additional data.
+	//Both waveforms are dense packed, but new size is bigger. Need to fill the additional data.
 	else if(len > curlen)
-	{
-		size_t increase = len - curlen;
-		memcpy(&cap->m_offsets[curlen], &din->m_offsets[curlen], increase*sizeof(int64_t));
-		memcpy(&cap->m_durations[curlen], &din->m_durations[curlen], increase*sizeof(int64_t));
-	}
+		cap->FillDenseTimestamps(curlen, len);
 
 	//Both waveforms are dense packed, new size is smaller or the same.
 	//This is what we want: no work needed at all!
@@ -1193,7 +1510,7 @@ DigitalWaveform* Filter::SetupDigitalOutputWaveform(WaveformBase* din, size_t st
 	DigitalWaveform* cap = dynamic_cast<DigitalWaveform*>(GetData(stream));
 	if(cap == NULL)
 	{
-		cap = new DigitalWaveform;
+		cap = g_waveformPool.Allocate<DigitalWaveform>(din->size());
 		SetData(cap, stream);
 	}
 
@@ -1203,7 +1520,7 @@ DigitalWaveform* Filter::SetupDigitalOutputWaveform(WaveformBase* din, size_t st
 	cap->m_startFemtoseconds	= din->m_startFemtoseconds;
 	cap->m_triggerPhase			= din->m_triggerPhase;
 
-	size_t len = din->m_offsets.size() - (skipstart + skipend);
+	size_t len = din->size() - (skipstart + skipend);
 	size_t curlen = cap->m_offsets.size();
 
 	cap->Resize(len);
@@ -1218,22 +1535,17 @@ DigitalWaveform* Filter::SetupDigitalOutputWaveform(WaveformBase* din, size_t st
 
 	//Input waveform is dense packed, but output is not.
 	//Need to clear some old stuff but we can produce a dense packed output.
-	//Note that we copy from zero regardless of skipstart to produce a dense packed output.
-	//TODO: AVX2 optimizations here so we don't need to read data we already know the value of
+	//Note that we start from zero regardless of skipstart to produce a dense packed output.
+	//We already know what the timestamps are, so there's no need to read them from the input.
 	else if(!cap->m_densePacked)
 	{
-		memcpy(&cap->m_offsets[0], &din->m_offsets[0], len*sizeof(int64_t));
-		memcpy(&cap->m_durations[0], &din->m_durations[0], len*sizeof(int64_t));
+		cap->FillDenseTimestamps(0, len);
 		cap->m_densePacked = true;
 	}
 
-	//Both waveforms are dense packed, but new size is bigger. Need to copy the additional data.
+	//Both waveforms are dense packed, but new size is bigger. Need to fill the additional data.
 	else if(len > curlen)
-	{
-		size_t increase = len - curlen;
-		memcpy(&cap->m_offsets[curlen], &din->m_offsets[curlen], increase*sizeof(int64_t));
-		memcpy(&cap->m_durations[curlen], &din->m_durations[curlen], increase*sizeof(int64_t));
-	}
+		cap->FillDenseTimestamps(curlen, len);
 
 	//Both waveforms are dense packed, new size is smaller or the same.
 	//This is what we want: no work needed at all!
@@ -1249,20 +1561,19 @@ DigitalWaveform* Filter::SetupDigitalOutputWaveform(WaveformBase* din, size_t st
  */
 uint32_t Filter::CRC32(vector<uint8_t>& bytes, size_t start, size_t end)
 {
-	uint32_t poly = 0xedb88320;
+	if(end < start)
+		return CRC32(NULL, 0);
+	return CRC32(&bytes[start], end - start + 1);
+}
 
-	uint32_t crc = 0xffffffff;
-	for(size_t n=start; n <= end; n++)
-	{
-		uint8_t d = bytes[n];
-		for(int i=0; i<8; i++)
-		{
-			bool b = ( crc ^ (d >> i) ) & 1;
-			crc >>= 1;
-			if(b)
-				crc ^= poly;
-		}
-	}
+/**
+	@brief Calculates a CRC32 checksum using the standard Ethernet polynomial
+ */
+uint32_t Filter::CRC32(const uint8_t* bytes, size_t len)
+{
+	uint32_t crc = CRC32Ethernet::Start();
+	if(len)
+		crc = CRC32Ethernet::Update(crc, bytes, len);
 
 	return ~(	((crc & 0x000000ff) << 24) |
 				((crc & 0x0000ff00) << 8) |
@@ -38,6 +38,7 @@
 
 #include "OscilloscopeChannel.h"
 #include "FlowGraphNode.h"
+#include "ZeroCrossingCache.h"
 
 /**
 	@brief Abstract base class for all filters and protocol decoders
@@ -132,6 +133,44 @@ public:
 	void SetDirty()
 	{ m_dirty = true; }
 
+	//Continuous decoding across consecutive waveforms
+	bool SupportsStateCarry()
+	{ return !m_stateCarryName.empty(); }
+
+	bool IsStateCarryEnabled();
+	void SetStateCarryEnabled(bool enabled);
+
+	///Gets the state saved at the end of the last waveform (empty if there was nothing to carry)
+	const DecoderState& GetCarriedState() const
+	{ return m_carriedState; }
+
+	///Replaces the carried state (e.g. to resume a decode from a saved snapshot)
+	void SetCarriedState(const DecoderState& state)
+	{ m_carriedState = state; }
+
+	bool IsDirty()
+	{ return m_dirty; }
+
+	/**
+		@brief Return true (override) if this filter only accesses input timestamps via WaveformBase::GetOffset() and
+		GetDuration(), and can therefore accept waveforms with implicit timestamps.
+
+		Inputs with implicit timestamps are materialized before calling Refresh() on filters returning false (default).
+	 */
+	virtual bool SupportsImplicitTimestamps()
+	{ return false; }
+
+	/**
+		@brief Enables filters which support implicit timestamps to create outputs without offset/duration arrays.
+
+		Off by default since not every consumer of filter outputs uses the timestamp accessors.
+	 */
+	static void SetImplicitTimestampOutputEnabled(bool enabled)
+	{ m_implicitTimestampOutput = enabled; }
+
+	static bool IsImplicitTimestampOutputEnabled()
+	{ return m_implicitTimestampOutput; }
+
 	/**
 		@brief Gets the display name of this protocol (for use in menus, save files, etc). Must be unique.
 	 */
@@ -184,7 +223,7 @@ protected:
 	int64_t GetNextEventTimestamp(WaveformBase* wfm, size_t i, size_t len, int64_t timestamp)
 	{
 		if(i+1 < len)
-			return wfm->m_offsets[i+1];
+			return wfm->GetOffset(i+1);
 		else
 			return timestamp;
 	}
@@ -192,7 +231,7 @@ protected:
 	///Advance the waveform to a given timestamp
 	void AdvanceToTimestamp(WaveformBase* wfm, size_t& i, size_t len, int64_t timestamp)
 	{
-		while( ((i+1) < len) && (wfm->m_offsets[i+1] <= timestamp) )
+		while( ((i+1) < len) && (wfm->GetOffset(i+1) <= timestamp) )
 			i ++;
 	}
 
@@ -201,6 +240,24 @@ protected:
 	AnalogWaveform* SetupOutputWaveform(WaveformBase* din, size_t stream, size_t skipstart, size_t skipend);
 	DigitalWaveform* SetupDigitalOutputWaveform(WaveformBase* din, size_t stream, size_t skipstart, size_t skipend);
 
+	///Returns true if newly created outputs of this filter should have implicit timestamps
+	bool UseImplicitTimestampOutput()
+	{ return m_implicitTimestampOutput && SupportsImplicitTimestamps(); }
+
+	void MaterializeInputTimestamps();
+
+	void CreateStateCarryParameter();
+	DecoderState TakeCarriedState(WaveformBase* wfm, int64_t maxGap = 0);
+	void CarryState(WaveformBase* wfm, DecoderState& state);
+	static int64_t GetEndTime(WaveformBase* wfm);
+	static bool GetCarriedGap(const DecoderState& state, WaveformBase* wfm, int64_t& gap);
+
+	///Name of the "continuous decode" parameter, or empty if the filter doesn't support carrying state
+	std::string m_stateCarryName;
+
+	///Decoder state saved at the end of the previous waveform, to be picked up by the next Refresh()
+	DecoderState m_carriedState;
+
 public:
 	//Text formatting for CHANNEL_TYPE_COMPLEX decodes
 	virtual Gdk::Color GetColor(int i);
@@ -226,23 +283,55 @@ public:
 	static void SampleOnAnyEdges(DigitalBusWaveform* data, DigitalWaveform* clock, DigitalBusWaveform& samples);
 	static void SampleOnRisingEdges(DigitalWaveform* data, DigitalWaveform* clock, DigitalWaveform& samples);
 	static void SampleOnRisingEdges(DigitalBusWaveform* data, DigitalWaveform* clock, DigitalBusWaveform& samples);
+	static void SampleOnRisingEdges(PackedDigitalWaveform* data, PackedDigitalWaveform* clock, DigitalWaveform& samples);
 	static void SampleOnFallingEdges(DigitalWaveform* data, DigitalWaveform* clock, DigitalWaveform& samples);
 
 	//Find interpolated zero crossings of a signal
 	static void FindRisingEdges(AnalogWaveform* data, float threshold, std::vector<int64_t>& edges);
 	static void FindZeroCrossings(AnalogWaveform* data, float threshold, std::vector<int64_t>& edges);
+	static void FindZeroCrossingsUncached(AnalogWaveform* data, float threshold, std::vector<int64_t>& edges);
 
 	//Find edges in a signal (discarding repeated samples)
 	static void FindZeroCrossings(DigitalWaveform* data, std::vector<int64_t>& edges);
 	static void FindRisingEdges(DigitalWaveform* data, std::vector<int64_t>& edges);
 	static void FindFallingEdges(DigitalWaveform* data, std::vector<int64_t>& edges);
+	static void FindZeroCrossings(PackedDigitalWaveform* data, std::vector<int64_t>& edges);
+	static void FindRisingEdges(PackedDigitalWaveform* data, std::vector<int64_t>& edges);
+	static void FindFallingEdges(PackedDigitalWaveform* data, std::vector<int64_t>& edges);
 
 	static void ClearAnalysisCache();
 
+	///Gets the cache used by FindZeroCrossings() (for statistics or to change the memory budget)
+	static ZeroCrossingCache& GetZeroCrossingCache()
+	{ return m_zeroCrossingCache; }
+
 	//Checksum helpers
 	static uint32_t CRC32(std::vector<uint8_t>& bytes, size_t start, size_t end);
+	static uint32_t CRC32(const uint8_t* bytes, size_t len);
 
 protected:
+	//Threshold crossing search backends
+	static void FindEdges(AnalogWaveform* data, float threshold, bool risingOnly, std::vector<int64_t>& edges);
+	static void FindEdgesBlock(
+		AnalogWaveform* data, float threshold, bool risingOnly, size_t istart, size_t iend, std::vector<int64_t>& edges);
+	static void FindEdgesGeneric(
+		AnalogWaveform* data, float threshold, bool risingOnly, size_t istart, size_t iend, std::vector<int64_t>& edges);
+	static void FindEdgesAVX2(
+		AnalogWaveform* data, float threshold, bool risingOnly, size_t istart, size_t iend, std::vector<int64_t>& edges);
+	static void FindEdgesAVX512F(
+		AnalogWaveform* data, float threshold, bool risingOnly, size_t istart, size_t iend, std::vector<int64_t>& edges);
+
+	///Gets the interpolated timestamp of a threshold crossing between samples i-1 and i
+	static int64_t GetEdgeTimestamp(AnalogWaveform* data, size_t i, float threshold)
+	{
+		float fscale = data->m_timescale;
+		int64_t tfrac = fscale * InterpolateTime(data, i-1, threshold);
+		if(data->m_densePacked)
+			return data->m_triggerPhase + data->m_timescale*(i-1) + tfrac;
+		else
+			return data->m_triggerPhase + data->m_timescale * data->m_offsets[i-1] + tfrac;
+	}
+
 	//Common text formatting
 	virtual std::string GetTextForAsciiChannel(int i, size_t stream);
 
@@ -270,8 +359,11 @@ protected:
 	static std::set<Filter*> m_filters;
 
 	//Caching
-	static std::mutex m_cacheMutex;
-	static std::map<std::pair<WaveformBase*, float>, std::vector<int64_t> > m_zeroCrossingCache;
+	static ZeroCrossingCache m_zeroCrossingCache;
+
+	//Implicit timestamp support
+	static bool m_implicitTimestampOutput;
+	static std::mutex m_materializeMutex;
 };
 
 #define PROTOCOL_DECODER_INITPROC(T) \
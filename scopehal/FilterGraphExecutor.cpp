@@ -0,0 +1,328 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of FilterGraphExecutor
+ */
+
+#include "scopehal.h"
+#include "FilterGraphExecutor.h"
+#include <omp.h>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+FilterGraphExecutor::FilterGraphExecutor()
+	: m_runStart(0)
+	, m_lastRunTime(0)
+{
+}
+
+FilterGraphExecutor::~FilterGraphExecutor()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Graph construction
+
+/**
+	@brief Builds the dependency graph for a set of filters
+
+	Any dirty filters upstream of the requested set are pulled in as well, since they have to be refreshed first.
+	Filters which are not dirty are ignored entirely.
+
+	@return False if the graph contains a cycle and cannot be scheduled
+ */
+bool FilterGraphExecutor::BuildGraph(const set<Filter*>& filters)
+{
+	m_nodes.clear();
+	m_downstream.clear();
+	m_pendingInputs.clear();
+	m_timings.clear();
+
+	//Find every dirty filter in the request, or upstream of it
+	set<Filter*> dirty;
+	vector<Filter*> work;
+	for(auto f : filters)
+	{
+		if(f->IsDirty() && (dirty.find(f) == dirty.end()) )
+		{
+			dirty.emplace(f);
+			work.push_back(f);
+		}
+	}
+	while(!work.empty())
+	{
+		auto f = work.back();
+		work.pop_back();
+
+		for(size_t i=0; i<f->GetInputCount(); i++)
+		{
+			auto in = dynamic_cast<Filter*>(f->GetInput(i).m_channel);
+			if(in && in->IsDirty() && (dirty.find(in) == dirty.end()) )
+			{
+				dirty.emplace(in);
+				work.push_back(in);
+			}
+		}
+	}
+
+	//Find edges between dirty filters. A filter may use the same input more than once, so dedup them.
+	map<Filter*, set<Filter*> > upstream;
+	map<Filter*, set<Filter*> > downstream;
+	for(auto f : dirty)
+	{
+		upstream[f];
+		for(size_t i=0; i<f->GetInputCount(); i++)
+		{
+			auto in = dynamic_cast<Filter*>(f->GetInput(i).m_channel);
+			if(dirty.find(in) == dirty.end())
+				continue;
+			upstream[f].emplace(in);
+			downstream[in].emplace(f);
+		}
+	}
+
+	//Topological sort (Kahn's algorithm)
+	map<Filter*, size_t> indegree;
+	vector<Filter*> ready;
+	for(auto f : dirty)
+	{
+		indegree[f] = upstream[f].size();
+		if(indegree[f] == 0)
+			ready.push_back(f);
+	}
+	while(!ready.empty())
+	{
+		auto f = ready.back();
+		ready.pop_back();
+		m_nodes.push_back(f);
+
+		for(auto g : downstream[f])
+		{
+			indegree[g] --;
+			if(indegree[g] == 0)
+				ready.push_back(g);
+		}
+	}
+
+	if(m_nodes.size() != dirty.size())
+	{
+		LogError("FilterGraphExecutor: filter graph contains a cycle, cannot schedule\n");
+		m_nodes.clear();
+		return false;
+	}
+
+	//Convert to indexes
+	map<Filter*, size_t> indexes;
+	for(size_t i=0; i<m_nodes.size(); i++)
+		indexes[m_nodes[i]] = i;
+
+	m_downstream.resize(m_nodes.size());
+	m_pendingInputs.resize(m_nodes.size());
+	for(size_t i=0; i<m_nodes.size(); i++)
+	{
+		auto f = m_nodes[i];
+		m_pendingInputs[i] = upstream[f].size();
+		for(auto g : downstream[f])
+			m_downstream[i].push_back(indexes[g]);
+		m_timings.push_back(FilterTiming(f));
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Execution
+
+/**
+	@brief Refreshes every dirty filter that exists
+ */
+void FilterGraphExecutor::RunBlocking()
+{
+	RunBlocking(Filter::GetAllInstances());
+}
+
+/**
+	@brief Refreshes a set of filters (and any dirty filters upstream of them), blocking until all are complete
+ */
+void FilterGraphExecutor::RunBlocking(const set<Filter*>& filters)
+{
+	m_runStart = GetTime();
+
+	//If we can't schedule the graph, fall back to the recursive refresh
+	if(!BuildGraph(filters))
+	{
+		for(auto f : filters)
+			f->RefreshIfDirty();
+		m_lastRunTime = GetTime() - m_runStart;
+		return;
+	}
+
+	//Find the depth of each node. If there's never more than one filter at a given depth the graph is a simple
+	//chain, and there's nothing to gain from running it as tasks. Refresh it inline so each filter keeps the whole
+	//OpenMP thread team for its own inner loops.
+	vector<size_t> depth(m_nodes.size(), 0);
+	for(size_t i=0; i<m_nodes.size(); i++)
+	{
+		for(auto j : m_downstream[i])
+			depth[j] = max(depth[j], depth[i] + 1);
+	}
+	vector<size_t> width(m_nodes.size(), 0);
+	bool parallel = false;
+	for(auto d : depth)
+	{
+		width[d] ++;
+		if(width[d] > 1)
+			parallel = true;
+	}
+
+	if(!parallel)
+	{
+		for(size_t i=0; i<m_nodes.size(); i++)
+			RunNode(i, false);
+	}
+
+	else
+	{
+		//Snapshot the roots before starting, since m_pendingInputs changes as soon as the first task completes
+		vector<size_t> roots;
+		for(size_t i=0; i<m_nodes.size(); i++)
+		{
+			if(m_pendingInputs[i] == 0)
+				roots.push_back(i);
+		}
+
+		#pragma omp parallel
+		{
+			#pragma omp single
+			{
+				for(auto i : roots)
+				{
+					#pragma omp task firstprivate(i)
+					RunNode(i, true);
+				}
+			}
+		}
+	}
+
+	m_lastRunTime = GetTime() - m_runStart;
+}
+
+/**
+	@brief Refreshes a single filter, then schedules any downstream filters which are now ready to run
+
+	@param i		Index of the node to run
+	@param spawn	True if the graph is being run as OpenMP tasks and newly ready nodes should be spawned as tasks.
+					If false, the caller is walking the nodes in topological order.
+ */
+void FilterGraphExecutor::RunNode(size_t i, bool spawn)
+{
+	auto& timing = m_timings[i];
+	timing.m_thread = omp_get_thread_num();
+	timing.m_start = GetTime() - m_runStart;
+
+	//All of our dirty inputs are done by now, so this won't recurse into anything
+	m_nodes[i]->RefreshIfDirty();
+
+	timing.m_end = GetTime() - m_runStart;
+
+	//Figure out which of our downstream filters have no more pending inputs
+	vector<size_t> ready;
+	#pragma omp critical(FilterGraphExecutor)
+	{
+		for(auto j : m_downstream[i])
+		{
+			m_pendingInputs[j] --;
+			if(m_pendingInputs[j] == 0)
+				ready.push_back(j);
+		}
+	}
+
+	if(!spawn)
+		return;
+
+	for(auto j : ready)
+	{
+		#pragma omp task firstprivate(j)
+		RunNode(j, true);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Timing
+
+/**
+	@brief Gets the time, in seconds, the last run would have taken if every filter was refreshed serially
+ */
+double FilterGraphExecutor::GetSerialRunTime()
+{
+	double sum = 0;
+	for(auto& t : m_timings)
+		sum += t.GetDuration();
+	return sum;
+}
+
+/**
+	@brief Prints timing for the last run to the debug log, slowest filters first
+ */
+void FilterGraphExecutor::LogTimingReport()
+{
+	double serial = GetSerialRunTime();
+	double speedup = 1;
+	if(m_lastRunTime > 0)
+		speedup = serial / m_lastRunTime;
+
+	LogDebug("Refreshed %zu filters in %.3f ms (%.3f ms serial, %.2fx speedup)\n",
+		m_timings.size(),
+		m_lastRunTime * 1e3,
+		serial * 1e3,
+		speedup);
+	LogIndenter li;
+
+	vector<FilterTiming> sorted = m_timings;
+	sort(sorted.begin(), sorted.end(),
+		[](const FilterTiming& a, const FilterTiming& b)
+		{ return a.GetDuration() > b.GetDuration(); }
+	);
+
+	for(auto& t : sorted)
+	{
+		LogDebug("%-30s %10.3f ms (%10.3f - %10.3f ms, thread %d)\n",
+			t.m_filter->GetDisplayName().c_str(),
+			t.GetDuration() * 1e3,
+			t.m_start * 1e3,
+			t.m_end * 1e3,
+			t.m_thread);
+	}
+}
@@ -0,0 +1,124 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of FilterGraphExecutor
+ */
+
+#ifndef FilterGraphExecutor_h
+#define FilterGraphExecutor_h
+
+class Filter;
+
+/**
+	@brief Refreshes a set of dirty filters in dependency order, running independent branches of the graph in parallel
+
+	The filter graph (as described by each filter's m_inputs) is topologically sorted, then every filter whose inputs
+	are all up to date is handed off as an OpenMP task. As soon as a filter finishes, any downstream filters which have
+	no remaining dirty inputs are scheduled. Idle threads in the OpenMP team pick up pending tasks, so e.g. an eye
+	pattern and a PCIe decode hanging off the same capture can run concurrently.
+
+	Timing for every filter refreshed during the most recent run is retained and can be printed with LogTimingReport().
+ */
+class FilterGraphExecutor
+{
+public:
+	FilterGraphExecutor();
+	virtual ~FilterGraphExecutor();
+
+	void RunBlocking(const std::set<Filter*>& filters);
+	void RunBlocking();
+
+	/**
+		@brief Timing information for a single filter refreshed during the last run
+	 */
+	class FilterTiming
+	{
+	public:
+		FilterTiming(Filter* f = NULL)
+		: m_filter(f)
+		, m_start(0)
+		, m_end(0)
+		, m_thread(0)
+		{}
+
+		///The filter that was refreshed
+		Filter* m_filter;
+
+		///Start time, in seconds, relative to the start of the run
+		double m_start;
+
+		///End time, in seconds, relative to the start of the run
+		double m_end;
+
+		///Index of the OpenMP thread which ran the filter
+		int m_thread;
+
+		double GetDuration() const
+		{ return m_end - m_start; }
+	};
+
+	///Gets timing for every filter refreshed during the last run, in topological order
+	const std::vector<FilterTiming>& GetTimings()
+	{ return m_timings; }
+
+	///Gets the wall clock time, in seconds, taken by the last run
+	double GetLastRunTime()
+	{ return m_lastRunTime; }
+
+	double GetSerialRunTime();
+
+	void LogTimingReport();
+
+protected:
+	bool BuildGraph(const std::set<Filter*>& filters);
+	void RunNode(size_t i, bool spawn);
+
+	///Dirty filters to refresh, in topological order
+	std::vector<Filter*> m_nodes;
+
+	///Indexes (in m_nodes) of the dirty filters directly downstream of each node
+	std::vector< std::vector<size_t> > m_downstream;
+
+	///Number of dirty inputs of each node which have not yet been refreshed
+	std::vector<size_t> m_pendingInputs;
+
+	///Timing for each node, indexed in parallel with m_nodes
+	std::vector<FilterTiming> m_timings;
+
+	///Time at which the current run started
+	double m_runStart;
+
+	///Wall clock time of the last run
+	double m_lastRunTime;
+};
+
+#endif
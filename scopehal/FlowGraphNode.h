@@ -149,9 +149,23 @@ protected:
 	AnalogWaveform* GetAnalogInputWaveform(size_t i)
 	{ return dynamic_cast<AnalogWaveform*>(GetInputWaveform(i)); }
 
-	///Gets the digital waveform attached to the specified input
+	/**
+		@brief Gets the digital waveform attached to the specified input
+
+		Packed waveforms are transparently expanded so filters which don't know about them keep working.
+	 */
 	DigitalWaveform* GetDigitalInputWaveform(size_t i)
-	{ return dynamic_cast<DigitalWaveform*>(GetInputWaveform(i)); }
+	{
+		auto data = GetInputWaveform(i);
+		auto packed = dynamic_cast<PackedDigitalWaveform*>(data);
+		if(packed)
+			return packed->GetUnpacked();
+		return dynamic_cast<DigitalWaveform*>(data);
+	}
+
+	///Gets the packed digital waveform attached to the specified input, or NULL if it's not packed
+	PackedDigitalWaveform* GetPackedDigitalInputWaveform(size_t i)
+	{ return dynamic_cast<PackedDigitalWaveform*>(GetInputWaveform(i)); }
 
 	///Gets the digital bus waveform attached to the specified input
 	DigitalBusWaveform* GetDigitalBusInputWaveform(size_t i)
@@ -324,7 +324,7 @@ AnalogWaveform* IBISModel::SimulatePRBS(
 	uint32_t prbs = seed;
 
 	//Create the output waveform
-	auto ret = new AnalogWaveform;
+	auto ret = g_waveformPool.Allocate<AnalogWaveform>(length);
 	ret->m_timescale = timescale;
 	float now = GetTime();
 	float tfrac = fmodf(now, 1);
@@ -2295,7 +2295,9 @@ vector<WaveformBase*> LeCroyOscilloscope::ProcessAnalogWaveform(
 	uint32_t num_sequences,
 	time_t ttime,
 	double basetime,
-	double* wavetime)
+	double* wavetime,
+	vector< SampleConversionJob<int8_t> >& jobs8,
+	vector< SampleConversionJob<int16_t> >& jobs16)
 {
 	vector<WaveformBase*> ret;
 
@@ -2332,7 +2334,7 @@ vector<WaveformBase*> LeCroyOscilloscope::ProcessAnalogWaveform(
 	for(size_t j=0; j<num_sequences; j++)
 	{
 		//Set up the capture we're going to store our data into
-		AnalogWaveform* cap = new AnalogWaveform;
+		AnalogWaveform* cap = g_waveformPool.Allocate<AnalogWaveform>(num_per_segment);
 		cap->m_timescale = round(interval);
 
 		cap->m_triggerPhase = h_off_frac;
@@ -2345,33 +2347,12 @@ vector<WaveformBase*> LeCroyOscilloscope::ProcessAnalogWaveform(
 		else
 			cap->m_startFemtoseconds = static_cast<int64_t>(basetime * FS_PER_SECOND);
 
-		cap->Resize(num_per_segment);
-
-		//Convert raw ADC samples to volts
+		//Queue up conversion of raw ADC samples to volts.
+		//This is done by the caller once all channels are ready so the whole acquisition is converted in parallel.
 		if(m_highDefinition)
-		{
-			Convert16BitSamples(
-				(int64_t*)&cap->m_offsets[0],
-				(int64_t*)&cap->m_durations[0],
-				(float*)&cap->m_samples[0],
-				wdata + j*num_per_segment,
-				v_gain,
-				v_off,
-				num_per_segment,
-				0);
-		}
+			jobs16.push_back(SampleConversionJob<int16_t>(cap, wdata + j*num_per_segment, v_gain, v_off, num_per_segment));
 		else
-		{
-			Convert8BitSamples(
-				(int64_t*)&cap->m_offsets[0],
-				(int64_t*)&cap->m_durations[0],
-				(float*)&cap->m_samples[0],
-				bdata + j*num_per_segment,
-				v_gain,
-				v_off,
-				num_per_segment,
-				0);
-		}
+			jobs8.push_back(SampleConversionJob<int8_t>(cap, bdata + j*num_per_segment, v_gain, v_off, num_per_segment));
 
 		ret.push_back(cap);
 	}
@@ -2379,43 +2360,53 @@ vector<WaveformBase*> LeCroyOscilloscope::ProcessAnalogWaveform(
 	return ret;
 }
 
-map<int, DigitalWaveform*> LeCroyOscilloscope::ProcessDigitalWaveform(string& data, int64_t analog_hoff)
+/**
+	@brief Finds the start of a tag's contents in the digital waveform XML
+
+	@return Pointer to the first character after the tag, or NULL if not found
+ */
+static const char* FindXmlTag(const string& data, const char* tag)
 {
-	//DEBUG
-	FILE* fp = fopen("/tmp/waveform.xml", "w");
-	fwrite(data.c_str(), data.length(), 1, fp);
-	fclose(fp);
+	size_t pos = data.find(tag);
+	if(pos == string::npos)
+		return NULL;
+	return data.c_str() + pos + strlen(tag);
+}
 
-	map<int, DigitalWaveform*> ret;
+map<int, WaveformBase*> LeCroyOscilloscope::ProcessDigitalWaveform(string& data, int64_t analog_hoff)
+{
+	map<int, WaveformBase*> ret;
+
+	//Quick and dirty string searching. We only care about a small fraction of the XML
+	//so no sense bringing in a full parser. Values are parsed in place, atof() etc stop at the closing tag.
+	const char* lines = FindXmlTag(data, "SelectedLines=");
+	const char* perstep = FindXmlTag(data, "<HorPerStep>");
+	const char* start = FindXmlTag(data, "<HorStart>");
+	const char* nsamples = FindXmlTag(data, "<NumSamples>");
+	const char* eventtime = FindXmlTag(data, "<FirstEventTime>");
+	const char* binstart = FindXmlTag(data, "<BinaryData>");
+	if(!lines || !perstep || !start || !nsamples || !eventtime || !binstart)
+		return ret;
+	const char* binend = strstr(binstart, "</BinaryData>");
+	if(!binend)
+		return ret;
 
 	//See what channels are enabled
-	string tmp = data.substr(data.find("SelectedLines=") + 14);
-	tmp = tmp.substr(0, 16);
-	bool enabledChannels[16];
-	for(int i=0; i<16; i++)
-		enabledChannels[i] = (tmp[i] == '1');
+	bool enabledChannels[16] = {false};
+	for(int i=0; i<16 && lines[i]; i++)
+		enabledChannels[i] = (lines[i] == '1');
 
-	//Quick and dirty string searching. We only care about a small fraction of the XML
-	//so no sense bringing in a full parser.
-	tmp = data.substr(data.find("<HorPerStep>") + 12);
-	tmp = tmp.substr(0, tmp.find("</HorPerStep>"));
-	float interval = atof(tmp.c_str()) * FS_PER_SECOND;
+	float interval = atof(perstep) * FS_PER_SECOND;
 	//LogDebug("Sample interval: %.2f fs\n", interval);
 
-	tmp = data.substr(data.find("<HorStart>") + 10);
-	tmp = tmp.substr(0, tmp.find("</HorStart>"));
-	float horstart = atof(tmp.c_str()) * FS_PER_SECOND;
+	float horstart = atof(start) * FS_PER_SECOND;
 
-	tmp = data.substr(data.find("<NumSamples>") + 12);
-	tmp = tmp.substr(0, tmp.find("</NumSamples>"));
-	size_t num_samples = atoi(tmp.c_str());
+	size_t num_samples = atoi(nsamples);
 	//LogDebug("Expecting %d samples\n", num_samples);
 
 	//Extract the raw trigger timestamp (nanoseconds since Jan 1 2000)
-	tmp = data.substr(data.find("<FirstEventTime>") + 16);
-	tmp = tmp.substr(0, tmp.find("</FirstEventTime>"));
 	int64_t timestamp;
-	if(1 != sscanf(tmp.c_str(), "%ld", &timestamp))
+	if(1 != sscanf(eventtime, "%ld", &timestamp))
 		return ret;
 
 	//Get the client's local time.
@@ -2452,92 +2443,60 @@ map<int, DigitalWaveform*> LeCroyOscilloscope::ProcessDigitalWaveform(string& da
 	if(analog_hoff != 0)
 		trigger_phase = horstart - analog_hoff;
 
-	//Pull out the actual binary data (Base64 coded)
-	tmp = data.substr(data.find("<BinaryData>") + 12);
-	tmp = tmp.substr(0, tmp.find("</BinaryData>"));
-
-	//Decode the base64
+	//Decode the base64 in place, overwriting the XML (nothing after the payload is needed)
+	char* bin = &data[binstart - data.c_str()];
 	base64_decodestate bstate;
 	base64_init_decodestate(&bstate);
-	unsigned char* block = new unsigned char[tmp.length()];	//base64 is smaller than plaintext, leave room
-	base64_decode_block(tmp.c_str(), tmp.length(), (char*)block, &bstate);
+	size_t blocklen = base64_decode_inplace(bin, binend - binstart, &bstate);
+	const uint8_t* block = reinterpret_cast<const uint8_t*>(bin);
 
 	//We have each channel's data from start to finish before the next (no interleaving).
-	//TODO: Multithread across waveforms
-	unsigned int icapchan = 0;
+	vector<unsigned int> channels;
 	for(unsigned int i=0; i<m_digitalChannelCount; i++)
 	{
 		if(enabledChannels[i])
-		{
-			DigitalWaveform* cap = new DigitalWaveform;
-			cap->m_timescale = interval;
-			cap->m_densePacked = true;
-
-			//Capture timestamp
-			cap->m_startTimestamp = start_time;
-			cap->m_startFemtoseconds = start_fs;
-			cap->m_triggerPhase = trigger_phase;
-
-			//Preallocate memory assuming no deduplication possible
-			cap->Resize(num_samples);
-
-			//Save the first sample (can't merge with sample -1 because that doesn't exist)
-			size_t base = icapchan*num_samples;
-			size_t k = 0;
-			cap->m_offsets[0] = 0;
-			cap->m_durations[0] = 1;
-			cap->m_samples[0] = block[base];
-
-			//Read and de-duplicate the other samples
-			//TODO: can we vectorize this somehow?
-			bool last = block[base];
-			for(size_t j=1; j<num_samples; j++)
-			{
-				bool sample = block[base + j];
-
-				//Deduplicate consecutive samples with same value
-				//FIXME: temporary workaround for rendering bugs
-				//if(last == sample)
-				if( (last == sample) && ((j+3) < num_samples) )
-					cap->m_durations[k] ++;
-
-				//Nope, it toggled - store the new value
-				else
-				{
-					k++;
-					cap->m_offsets[k] = j;
-					cap->m_durations[k] = 1;
-					cap->m_samples[k] = sample;
-					last = sample;
-				}
-
-			}
+			channels.push_back(i);
+	}
+	if(blocklen < channels.size() * num_samples)
+	{
+		LogWarning("LeCroyOscilloscope: digital waveform is truncated\n");
+		return ret;
+	}
 
-			//Done, shrink any unused space
-			cap->Resize(k);
-			cap->m_offsets.shrink_to_fit();
-			cap->m_durations.shrink_to_fit();
-			cap->m_samples.shrink_to_fit();
-
-			//See how much space we saved
-			/*
-			LogDebug("%s: %zu samples deduplicated to %zu (%.1f %%)\n",
-				m_digitalChannels[i]->GetDisplayName().c_str(),
-				num_samples,
-				k,
-				(k * 100.0f) / num_samples);
-			*/
-
-			//Done, save data and go on to next
-			ret[m_digitalChannels[i]->GetIndex()] = cap;
-			icapchan ++;
+	//Process each channel on its own thread
+	vector<WaveformBase*> caps(channels.size());
+	#pragma omp parallel for
+	for(size_t icapchan=0; icapchan<channels.size(); icapchan++)
+	{
+		//Pack the samples one bit each, then expand to run-length encoded form if the user didn't want packed data
+		PackedDigitalWaveform* packed = g_waveformPool.Allocate<PackedDigitalWaveform>(num_samples);
+		packed->m_timescale = interval;
+		packed->m_startTimestamp = start_time;
+		packed->m_startFemtoseconds = start_fs;
+		packed->m_triggerPhase = trigger_phase;
+		packed->PackBytes(block + icapchan*num_samples, num_samples);
+
+		if(m_packDigitalWaveforms)
+			caps[icapchan] = packed;
+		else
+		{
+			//FIXME: temporary workaround for rendering bugs, never merge the last three samples
+			DigitalWaveform* cap = g_waveformPool.Allocate<DigitalWaveform>();
+			packed->UnpackDeduplicated(cap, 3);
+			g_waveformPool.Release(packed);
+			caps[icapchan] = cap;
 		}
+	}
 
-		//No data here for us!
-		else
+	//Done, save data. Disabled channels get no data.
+	for(unsigned int i=0; i<m_digitalChannelCount; i++)
+	{
+		if(!enabledChannels[i])
 			ret[m_digitalChannels[i]->GetIndex()] = NULL;
 	}
-	delete[] block;
+	for(size_t icapchan=0; icapchan<channels.size(); icapchan++)
+		ret[m_digitalChannels[channels[icapchan]]->GetIndex()] = caps[icapchan];
+
 	return ret;
 }
 
@@ -2659,6 +2618,8 @@ bool LeCroyOscilloscope::AcquireData()
 
 	//Process analog waveforms
 	vector< vector<WaveformBase*> > waveforms;
+	vector< SampleConversionJob<int8_t> > jobs8;
+	vector< SampleConversionJob<int16_t> > jobs16;
 	waveforms.resize(m_analogChannelCount);
 	for(unsigned int i=0; i<m_analogChannelCount; i++)
 	{
@@ -2676,10 +2637,16 @@ bool LeCroyOscilloscope::AcquireData()
 				num_sequences,
 				ttime,
 				basetime,
-				pwtime);
+				pwtime,
+				jobs8,
+				jobs16);
 		}
 	}
 
+	//Convert samples for every channel at once
+	Convert8BitSamples(jobs8);
+	Convert16BitSamples(jobs16);
+
 	//Save analog waveform data
 	for(unsigned int i=0; i<m_analogChannelCount; i++)
 	{
@@ -2696,7 +2663,7 @@ bool LeCroyOscilloscope::AcquireData()
 	if(denabled)
 	{
 		//This is a weird XML-y format but I can't find any other way to get it :(
-		map<int, DigitalWaveform*> digwaves = ProcessDigitalWaveform(digitalWaveformData, analog_hoff);
+		map<int, WaveformBase*> digwaves = ProcessDigitalWaveform(digitalWaveformData, analog_hoff);
 
 		//Done, update the data
 		for(auto it : digwaves)
@@ -2704,7 +2671,6 @@ bool LeCroyOscilloscope::AcquireData()
 	}
 
 	//Now that we have all of the pending waveforms, save them in sets across all channels
-	m_pendingWaveformsMutex.lock();
 	for(size_t i=0; i<num_sequences; i++)
 	{
 		SequenceSet s;
@@ -2713,9 +2679,8 @@ bool LeCroyOscilloscope::AcquireData()
 			if(pending_waveforms.find(j) != pending_waveforms.end())
 				s[m_channels[j]] = pending_waveforms[j][i];
 		}
-		m_pendingWaveforms.push_back(s);
+		m_pendingWaveforms.Push(s);
 	}
-	m_pendingWaveformsMutex.unlock();
 
 	double dt = GetTime() - start;
 	LogTrace("Waveform download and processing took %.3f ms\n", dt * 1000);
@@ -279,9 +279,11 @@ protected:
 		uint32_t num_sequences,
 		time_t ttime,
 		double basetime,
-		double* wavetime
+		double* wavetime,
+		std::vector< SampleConversionJob<int8_t> >& jobs8,
+		std::vector< SampleConversionJob<int16_t> >& jobs16
 		);
-	std::map<int, DigitalWaveform*> ProcessDigitalWaveform(std::string& data, int64_t analog_hoff);
+	std::map<int, WaveformBase*> ProcessDigitalWaveform(std::string& data, int64_t analog_hoff);
 
 	//hardware analog channel count, independent of LA option etc
 	unsigned int m_analogChannelCount;
@@ -0,0 +1,206 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of MappedFile
+ */
+
+#include "scopehal.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+MappedFile::MappedFile()
+	: m_data(NULL)
+	, m_size(0)
+#ifdef _WIN32
+	, m_file(INVALID_HANDLE_VALUE)
+	, m_mapping(NULL)
+#endif
+{
+}
+
+MappedFile::MappedFile(const string& path)
+	: MappedFile()
+{
+	Open(path);
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Mapping
+
+/**
+	@brief Maps a file into memory, read only.
+
+	Zero-length files open successfully but have a NULL data pointer, so IsOpen() returns false for them. Callers
+	should check GetSize() against the minimum they need before touching GetData().
+
+	@return True on success, false if the file could not be opened or mapped
+ */
+bool MappedFile::Open(const string& path)
+{
+	Close();
+
+#ifdef _WIN32
+
+	HANDLE hfile = CreateFileA(
+		path.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		NULL,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+		NULL);
+	if(hfile == INVALID_HANDLE_VALUE)
+	{
+		LogError("MappedFile: could not open \"%s\"\n", path.c_str());
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(hfile, &size))
+	{
+		LogError("MappedFile: could not get size of \"%s\"\n", path.c_str());
+		CloseHandle(hfile);
+		return false;
+	}
+	m_file = hfile;
+	m_size = size.QuadPart;
+	if(m_size == 0)
+		return true;
+
+	HANDLE hmap = CreateFileMappingA(hfile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(hmap == NULL)
+	{
+		LogError("MappedFile: could not map \"%s\"\n", path.c_str());
+		Close();
+		return false;
+	}
+	m_mapping = hmap;
+
+	m_data = reinterpret_cast<const uint8_t*>(MapViewOfFile(hmap, FILE_MAP_READ, 0, 0, 0));
+	if(m_data == NULL)
+	{
+		LogError("MappedFile: could not map \"%s\"\n", path.c_str());
+		Close();
+		return false;
+	}
+
+#else
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+	{
+		LogError("MappedFile: could not open \"%s\"\n", path.c_str());
+		return false;
+	}
+
+	struct stat st;
+	if(0 != fstat(fd, &st))
+	{
+		LogError("MappedFile: could not get size of \"%s\"\n", path.c_str());
+		close(fd);
+		return false;
+	}
+	m_size = st.st_size;
+	if(m_size == 0)
+	{
+		close(fd);
+		return true;
+	}
+
+	void* ptr = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	//The mapping holds its own reference to the file, we don't need the descriptor any more
+	close(fd);
+
+	if(ptr == MAP_FAILED)
+	{
+		LogError("MappedFile: could not map \"%s\"\n", path.c_str());
+		m_size = 0;
+		return false;
+	}
+	m_data = reinterpret_cast<const uint8_t*>(ptr);
+
+#endif
+
+	return true;
+}
+
+/**
+	@brief Unmaps the file, if one is open
+ */
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if(m_data)
+		UnmapViewOfFile(m_data);
+	if(m_mapping)
+		CloseHandle(m_mapping);
+	if(m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+	m_mapping = NULL;
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if(m_data)
+		munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+
+	m_data = NULL;
+	m_size = 0;
+}
+
+/**
+	@brief Hints to the kernel that the file will be read front to back, so it can read ahead aggressively
+ */
+void MappedFile::AdviseSequential()
+{
+#ifndef _WIN32
+	if(m_data)
+		madvise(const_cast<uint8_t*>(m_data), m_size, MADV_SEQUENTIAL);
+#endif
+}
@@ -0,0 +1,86 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of MappedFile
+ */
+
+#ifndef MappedFile_h
+#define MappedFile_h
+
+/**
+	@brief A read-only memory mapping of an entire file.
+
+	Used by file importers so that multi-GB captures can be converted straight from the page cache into waveform
+	storage, without first copying the whole file into a heap buffer.
+ */
+class MappedFile
+{
+public:
+	MappedFile();
+	MappedFile(const std::string& path);
+	virtual ~MappedFile();
+
+	bool Open(const std::string& path);
+	void Close();
+
+	bool IsOpen() const
+	{ return m_data != NULL; }
+
+	///Pointer to the first byte of the file (NULL if not open, or if the file is empty)
+	const uint8_t* GetData() const
+	{ return m_data; }
+
+	///Size of the file, in bytes
+	size_t GetSize() const
+	{ return m_size; }
+
+	///Pointer one past the last byte of the file
+	const uint8_t* GetEnd() const
+	{ return m_data + m_size; }
+
+	void AdviseSequential();
+
+protected:
+	const uint8_t* m_data;
+	size_t m_size;
+
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#endif
+
+	//not copyable
+	MappedFile(const MappedFile&) =delete;
+	MappedFile& operator=(const MappedFile&) =delete;
+};
+
+#endif
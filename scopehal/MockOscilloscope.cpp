@@ -36,6 +36,7 @@
 #include "scopehal.h"
 #include "OscilloscopeChannel.h"
 #include "MockOscilloscope.h"
+#include <omp.h>
 
 using namespace std;
 
@@ -47,12 +48,13 @@ MockOscilloscope::MockOscilloscope(const string& name, const string& vendor, con
 	, m_vendor(vendor)
 	, m_serial(serial)
 	, m_extTrigger(NULL)
+	, m_archive(NULL)
 {
 }
 
 MockOscilloscope::~MockOscilloscope()
 {
-
+	delete m_archive;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -381,26 +383,21 @@ bool MockOscilloscope::LoadComplexUnknownFormat(const string& path, int64_t samp
 	LogDebug("Importing complex file \"%s\" (unknown format)\n", path.c_str());
 	LogIndenter li;
 
-	size_t numBytesToTest = 1024;
-
-	//Read test buffer
-	FILE* fp = fopen(path.c_str(), "r");
-	if(!fp)
+	//Map the file and only look at the first few samples
+	MappedFile file;
+	if(!file.Open(path))
 	{
 		LogError("Failed to open file\n");
 		return false;
 	}
-	fseek(fp, 0, SEEK_END);
-	size_t len = ftell(fp);
-	fseek(fp, 0, SEEK_SET);
-	numBytesToTest = min(numBytesToTest, len);
-	uint8_t* buf = new uint8_t[numBytesToTest];
-	if(numBytesToTest != fread(buf, 1, numBytesToTest, fp))
+	size_t len = file.GetSize();
+	size_t numBytesToTest = min((size_t)1024, len);
+	if(numBytesToTest < 16)
 	{
-		LogError("Failed to read file\n");
+		LogError("File is too small to contain complex samples\n");
 		return false;
 	}
-	fclose(fp);
+	const uint8_t* buf = file.GetData();
 
 	//Prepare to cast the buffer to each format and see what makes sense
 	float score_int8 = FLT_MAX;
@@ -413,7 +410,7 @@ bool MockOscilloscope::LoadComplexUnknownFormat(const string& path, int64_t samp
 		LogIndenter li2;
 
 		size_t numSamples = numBytesToTest / 2;
-		int8_t* tbuf = reinterpret_cast<int8_t*>(buf);
+		const int8_t* tbuf = reinterpret_cast<const int8_t*>(buf);
 		float sum_i = 0;
 		float sum_q = 0;
 		float scale = 1.0f / 127;
@@ -435,7 +432,7 @@ bool MockOscilloscope::LoadComplexUnknownFormat(const string& path, int64_t samp
 		if((len % 4) == 0)
 		{
 			size_t numSamples = numBytesToTest / 4;
-			int16_t* tbuf = reinterpret_cast<int16_t*>(buf);
+			const int16_t* tbuf = reinterpret_cast<const int16_t*>(buf);
 			float sum_i = 0;
 			float sum_q = 0;
 			float scale = 1.0f / 32767;
@@ -458,7 +455,7 @@ bool MockOscilloscope::LoadComplexUnknownFormat(const string& path, int64_t samp
 		if((len % 8) == 0)
 		{
 			size_t numSamples = numBytesToTest / 8;
-			float* tbuf = reinterpret_cast<float*>(buf);
+			const float* tbuf = reinterpret_cast<const float*>(buf);
 			float sum_i = 0;
 			float sum_q = 0;
 			float max_i = 0;
@@ -492,7 +489,7 @@ bool MockOscilloscope::LoadComplexUnknownFormat(const string& path, int64_t samp
 		if((len % 16) == 0)
 		{
 			size_t numSamples = numBytesToTest / 16;
-			double* tbuf = reinterpret_cast<double*>(buf);
+			const double* tbuf = reinterpret_cast<const double*>(buf);
 			float sum_i = 0;
 			float sum_q = 0;
 			float max_i = 0;
@@ -519,8 +516,7 @@ bool MockOscilloscope::LoadComplexUnknownFormat(const string& path, int64_t samp
 		}
 	}
 
-	//Clean up
-	delete[] buf;
+	file.Close();
 
 	//Find the minimum score of all
 	float minScore = min(score_int8, score_int16);
@@ -576,7 +572,7 @@ void MockOscilloscope::LoadComplexCommon(
 	chan->SetOffset(0);
 
 	//Create the waveforms for each of the two complex streams
-	iwfm = new AnalogWaveform;
+	iwfm = g_waveformPool.Allocate<AnalogWaveform>(numSamples);
 	iwfm->m_timescale = fs_per_sample;
 	iwfm->m_startTimestamp = timestamp;
 	iwfm->m_startFemtoseconds = fs;
@@ -585,7 +581,7 @@ void MockOscilloscope::LoadComplexCommon(
 	iwfm->m_densePacked = true;
 	chan->SetData(iwfm, 0);
 
-	qwfm = new AnalogWaveform;
+	qwfm = g_waveformPool.Allocate<AnalogWaveform>(numSamples);
 	qwfm->m_timescale = fs_per_sample;
 	qwfm->m_startTimestamp = timestamp;
 	qwfm->m_startFemtoseconds = fs;
@@ -596,219 +592,387 @@ void MockOscilloscope::LoadComplexCommon(
 }
 
 /**
-	@brief Imports a waveform from a complex file containing signed 8-bit samples in IQIQ order.
+	@brief Imports a waveform from a complex file containing samples of type T in IQIQ order.
+
+	Samples are converted straight out of the memory mapped file into the waveform buffers, without staging the
+	whole file in RAM first.
+
+	@param path			Path of the file
+	@param samplerate	Sample rate, in Hz
+	@param scale		Multiplier applied to each raw sample to normalize it
  */
-bool MockOscilloscope::LoadComplexInt8(const string& path, int64_t samplerate)
+template<class T>
+bool MockOscilloscope::LoadComplexMapped(const string& path, int64_t samplerate, float scale)
 {
-	FILE* fp = fopen(path.c_str(), "r");
-	if(!fp)
+	MappedFile file;
+	if(!file.Open(path))
 	{
 		LogError("Failed to open file\n");
 		return false;
 	}
+	file.AdviseSequential();
 
-	//Figure out length of the file in complex samples (2x int8 per sample)
-	fseek(fp, 0, SEEK_END);
-	size_t len = ftell(fp);
-	fseek(fp, 0, SEEK_SET);
-	size_t numSamples = len/2;
-
-	//Read sample data
-	int8_t* temp = new int8_t[numSamples * 2];
-	if(numSamples*2 != fread(temp, sizeof(int8_t), numSamples*2, fp))
+	//Figure out length of the file in complex samples (2x T per sample)
+	size_t numSamples = file.GetSize() / (2 * sizeof(T));
+	if(numSamples == 0)
 	{
-		LogError("Failed to read file\n");
+		LogError("File is too small to contain complex samples\n");
 		return false;
 	}
+	auto in = reinterpret_cast<const T*>(file.GetData());
 
 	AnalogWaveform* iwfm;
 	AnalogWaveform* qwfm;
 	LoadComplexCommon(path, iwfm, qwfm, samplerate, numSamples);
 
-	//Copy sample data
-	//TODO: vectorize
-	float scale = 1.0f / 127.0f;
-	for(size_t i=0; i<numSamples; i++)
+	int64_t* ioffs = (int64_t*)&iwfm->m_offsets[0];
+	int64_t* qoffs = (int64_t*)&qwfm->m_offsets[0];
+	int64_t* idurs = (int64_t*)&iwfm->m_durations[0];
+	int64_t* qdurs = (int64_t*)&qwfm->m_durations[0];
+	float* isamps = (float*)&iwfm->m_samples[0];
+	float* qsamps = (float*)&qwfm->m_samples[0];
+
+	//Convert in blocks so we can report progress between them
+	const size_t blocksize = 1024 * 1024;
+	for(size_t base=0; base<numSamples; base += blocksize)
 	{
-		iwfm->m_offsets[i] = i;
-		qwfm->m_offsets[i] = i;
+		size_t end = min(base + blocksize, numSamples);
+
+		#pragma omp parallel for
+		for(size_t i=base; i<end; i++)
+		{
+			ioffs[i] = i;
+			qoffs[i] = i;
+
+			idurs[i] = 1;
+			qdurs[i] = 1;
 
-		iwfm->m_durations[i] = 1;
-		qwfm->m_durations[i] = 1;
+			isamps[i] = in[i*2] * scale;
+			qsamps[i] = in[i*2 + 1] * scale;
+		}
 
-		iwfm->m_samples[i] = temp[i*2] * scale;
-		qwfm->m_samples[i] = temp[i*2 + 1] * scale;
+		ReportImportProgress(end * 1.0f / numSamples);
 	}
 
-	delete[] temp;
-	fclose(fp);
 	return true;
 }
 
+/**
+	@brief Imports a waveform from a complex file containing signed 8-bit samples in IQIQ order.
+ */
+bool MockOscilloscope::LoadComplexInt8(const string& path, int64_t samplerate)
+{
+	return LoadComplexMapped<int8_t>(path, samplerate, 1.0f / 127.0f);
+}
+
 /**
 	@brief Imports a waveform from a complex file containing signed 16-bit samples in IQIQ order.
  */
 bool MockOscilloscope::LoadComplexInt16(const string& path, int64_t samplerate)
 {
-	FILE* fp = fopen(path.c_str(), "r");
-	if(!fp)
+	return LoadComplexMapped<int16_t>(path, samplerate, 1.0f / 32767.0f);
+}
+
+/**
+	@brief Imports a waveform from a complex file containing normalized 32-bit floating point samples in IQIQ order.
+ */
+bool MockOscilloscope::LoadComplexFloat32(const string& path, int64_t samplerate)
+{
+	return LoadComplexMapped<float>(path, samplerate, 1.0f);
+}
+
+/**
+	@brief Imports a waveform from a complex file containing normalized 64-bit floating point samples in IQIQ order.
+ */
+bool MockOscilloscope::LoadComplexFloat64(const string& path, int64_t samplerate)
+{
+	return LoadComplexMapped<double>(path, samplerate, 1.0f);
+}
+
+/**
+	@brief Parses a decimal floating point number from a CSV cell.
+
+	Handles the plain and scientific notation emitted by every scope and spreadsheet we've seen without the locale
+	and buffering overhead of sscanf. Anything the fast path doesn't fully consume (nan, inf, hex, units suffixes)
+	falls back to strtod. Leading whitespace and trailing garbage are ignored. Empty or non-numeric cells parse as zero.
+ */
+static double ParseCSVNumberSlow(const char* p, const char* end)
+{
+	char tmp[64];
+	size_t len = min((size_t)(end - p), sizeof(tmp) - 1);
+	memcpy(tmp, p, len);
+	tmp[len] = '\0';
+	return strtod(tmp, NULL);
+}
+
+static double ParseCSVNumber(const char* p, const char* end)
+{
+	static const double pow10[] =
 	{
-		LogError("Failed to open file\n");
-		return false;
-	}
+		1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
 
-	//Figure out length of the file in complex samples (2x int16 per sample)
-	fseek(fp, 0, SEEK_END);
-	size_t len = ftell(fp);
-	fseek(fp, 0, SEEK_SET);
-	size_t numSamples = len/4;
+	const char* first = p;
 
-	//Read sample data
-	int16_t* temp = new int16_t[numSamples * 2];
-	if(numSamples*2 != fread(temp, sizeof(int16_t), numSamples*2, fp))
+	while( (p < end) && ( (*p == ' ') || (*p == '\t') ) )
+		p++;
+
+	bool negative = false;
+	if( (p < end) && ( (*p == '-') || (*p == '+') ) )
 	{
-		LogError("Failed to read file\n");
-		return false;
+		negative = (*p == '-');
+		p++;
 	}
 
-	AnalogWaveform* iwfm;
-	AnalogWaveform* qwfm;
-	LoadComplexCommon(path, iwfm, qwfm, samplerate, numSamples);
+	//Keep up to 19 significant digits (fits in a uint64), just track the exponent for the rest
+	uint64_t mantissa = 0;
+	int ndigits = 0;
+	int exp10 = 0;
+	bool any = false;
+	for(; (p < end) && isdigit(*p); p++)
+	{
+		any = true;
+		if(ndigits < 19)
+		{
+			mantissa = mantissa*10 + (*p - '0');
+			if(mantissa)
+				ndigits ++;
+		}
+		else
+			exp10 ++;
+	}
+	if( (p < end) && (*p == '.') )
+	{
+		p++;
+		for(; (p < end) && isdigit(*p); p++)
+		{
+			any = true;
+			if(ndigits < 19)
+			{
+				mantissa = mantissa*10 + (*p - '0');
+				if(mantissa)
+					ndigits ++;
+				exp10 --;
+			}
+		}
+	}
+
+	//Not a plain number, let the C library figure it out
+	if(!any)
+		return ParseCSVNumberSlow(first, end);
 
-	//Copy sample data
-	//TODO: vectorize
-	float scale = 1.0f / 32767.0f;
-	for(size_t i=0; i<numSamples; i++)
+	if( (p < end) && ( (*p == 'e') || (*p == 'E') ) )
 	{
-		iwfm->m_offsets[i] = i;
-		qwfm->m_offsets[i] = i;
+		p++;
+		bool eneg = false;
+		if( (p < end) && ( (*p == '-') || (*p == '+') ) )
+		{
+			eneg = (*p == '-');
+			p++;
+		}
+		int e = 0;
+		for(; (p < end) && isdigit(*p); p++)
+			e = min(e*10 + (*p - '0'), 10000);
+		exp10 += eneg ? -e : e;
+	}
 
-		iwfm->m_durations[i] = 1;
-		qwfm->m_durations[i] = 1;
+	//Stopped at something other than the end of the cell (e.g. the "x" of a hex value), so it wasn't plain decimal
+	while( (p < end) && ( (*p == ' ') || (*p == '\t') ) )
+		p++;
+	if(p < end)
+		return ParseCSVNumberSlow(first, end);
 
-		iwfm->m_samples[i] = temp[i*2] * scale;
-		qwfm->m_samples[i] = temp[i*2 + 1] * scale;
+	//Exact for up to 15 significant digits and |exp10| <= 22, which covers essentially every real CSV file
+	double v = mantissa;
+	if(exp10 < 0)
+	{
+		if(exp10 >= -22)
+			v /= pow10[-exp10];
+		else
+			v *= pow(10.0, exp10);
+	}
+	else if(exp10 > 0)
+	{
+		if(exp10 <= 22)
+			v *= pow10[exp10];
+		else
+			v *= pow(10.0, exp10);
 	}
 
-	delete[] temp;
-	fclose(fp);
-	return true;
+	return negative ? -v : v;
 }
 
 /**
-	@brief Imports a waveform from a complex file containing normalized 32-bit floating point samples in IQIQ order.
+	@brief Handles a comment line in a CSV file, extracting instrument metadata if we recognize the format
  */
-bool MockOscilloscope::LoadComplexFloat32(const string& path, int64_t samplerate)
+void MockOscilloscope::ParseCSVComment(const string& s, bool& digilentFormat, time_t& timestamp, int64_t& fs)
 {
-	FILE* fp = fopen(path.c_str(), "r");
-	if(!fp)
+	if(s == "#Digilent WaveForms Oscilloscope Acquisition")
 	{
-		LogError("Failed to open file\n");
-		return false;
+		digilentFormat = true;
+		m_vendor = "Digilent";
 	}
 
-	//Figure out length of the file in complex samples (2x float32 per sample)
-	fseek(fp, 0, SEEK_END);
-	size_t len = ftell(fp);
-	fseek(fp, 0, SEEK_SET);
-	size_t numSamples = len/8;
-
-	//Read sample data
-	float* temp = new float[numSamples * 2];
-	if(numSamples*2 != fread(temp, sizeof(float), numSamples*2, fp))
+	else if(digilentFormat)
 	{
-		LogError("Failed to read file\n");
-		return false;
-	}
-
-	AnalogWaveform* iwfm;
-	AnalogWaveform* qwfm;
-	LoadComplexCommon(path, iwfm, qwfm, samplerate, numSamples);
+		if(s.find("#Device Name: ") == 0)
+			m_name = s.substr(14);
+		if(s.find("#Serial Number: ") == 0)
+			m_serial = s.substr(16);
+		if(s.find("#Date Time: ") == 0)
+		{
+			//yyyy-mm-dd hh:mm:ss.ms.us.ns
+			//No time zone information provided. For now, assume current time zone.
+			string stimestamp = s.substr(12);
+
+			tm now;
+			time_t tnow;
+			time(&tnow);
+			localtime_r(&tnow, &now);
+
+			tm stamp;
+			int ms;
+			int us;
+			int ns;
+			if(9 == sscanf(stimestamp.c_str(), "%d-%d-%d %d:%d:%d.%d.%d.%d",
+				&stamp.tm_year, &stamp.tm_mon, &stamp.tm_mday,
+				&stamp.tm_hour, &stamp.tm_min, &stamp.tm_sec,
+				&ms, &us, &ns))
+			{
+				//tm_year isn't absolute year, it's offset from 1900
+				stamp.tm_year -= 1900;
 
-	//Copy sample data
-	//TODO: vectorize
-	for(size_t i=0; i<numSamples; i++)
-	{
-		iwfm->m_offsets[i] = i;
-		qwfm->m_offsets[i] = i;
+				//TODO: figure out if this day/month/year was DST or not.
+				//For now, assume same as current. This is going to be off by an hour for half the year!
+				stamp.tm_isdst = now.tm_isdst;
 
-		iwfm->m_durations[i] = 1;
-		qwfm->m_durations[i] = 1;
+				//We can finally get the actual time_t
+				timestamp = mktime(&stamp);
 
-		iwfm->m_samples[i] = temp[i*2];
-		qwfm->m_samples[i] = temp[i*2 + 1];
+				//Convert to femtoseconds for internal scopehal format
+				fs = ms * 1000;
+				fs = (fs + us) * 1000;
+				fs = (fs + ns) * 1000;
+				fs *= 1000;
+			}
+		}
 	}
-
-	delete[] temp;
-	fclose(fp);
-	return true;
 }
 
 /**
-	@brief Imports a waveform from a complex file containing normalized 64-bit floating point samples in IQIQ order.
+	@brief Parses the data rows in one slice of a CSV file.
+
+	The slice must begin at the start of a line. Runs on an OpenMP worker; only the calling thread reports progress.
  */
-bool MockOscilloscope::LoadComplexFloat64(const string& path, int64_t samplerate)
+void MockOscilloscope::ParseCSVChunk(
+	const char* start,
+	const char* end,
+	size_t ncols,
+	CSVChunk& chunk,
+	atomic<size_t>& bytesDone,
+	size_t bytesTotal)
 {
-	FILE* fp = fopen(path.c_str(), "r");
-	if(!fp)
-	{
-		LogError("Failed to open file\n");
-		return false;
-	}
-
-	//Figure out length of the file in complex samples (2x float64 per sample)
-	fseek(fp, 0, SEEK_END);
-	size_t len = ftell(fp);
-	fseek(fp, 0, SEEK_SET);
-	size_t numSamples = len/16;
-
-	//Read sample data
-	double* temp = new double[numSamples * 2];
-	if(numSamples*2 != fread(temp, sizeof(double), numSamples*2, fp))
+	//Guess capacity from the length of the first line so we don't reallocate much
+	const char* firstEol = reinterpret_cast<const char*>(memchr(start, '\n', end - start));
+	if(firstEol && (firstEol > start))
 	{
-		LogError("Failed to read file\n");
-		return false;
+		size_t rowsGuess = (end - start) / (firstEol - start + 1) + 1;
+		chunk.m_offsets.reserve(rowsGuess);
+		chunk.m_samples.reserve(rowsGuess * ncols);
 	}
 
-	AnalogWaveform* iwfm;
-	AnalogWaveform* qwfm;
-	LoadComplexCommon(path, iwfm, qwfm, samplerate, numSamples);
+	const size_t progressInterval = 1024 * 1024;
+	const char* lastProgress = start;
+	bool reporter = (omp_get_thread_num() == 0);
 
-	//Copy sample data
-	//TODO: vectorize
-	for(size_t i=0; i<numSamples; i++)
+	const char* p = start;
+	while(p < end)
 	{
-		iwfm->m_offsets[i] = i;
-		qwfm->m_offsets[i] = i;
+		auto eol = reinterpret_cast<const char*>(memchr(p, '\n', end - p));
+		if(!eol)
+			eol = end;
+		const char* next = (eol < end) ? eol+1 : end;
+
+		//Trim leading/trailing whitespace (including the \r of DOS line endings)
+		const char* a = p;
+		const char* b = eol;
+		while( (a < b) && isspace(*a) )
+			a++;
+		while( (b > a) && isspace(b[-1]) )
+			b--;
+		p = next;
+
+		//Discard blank lines and comments
+		if( (a == b) || (*a == '#') )
+			continue;
 
-		iwfm->m_durations[i] = 1;
-		qwfm->m_durations[i] = 1;
+		//First column is always timestamp in seconds
+		auto comma = reinterpret_cast<const char*>(memchr(a, ',', b - a));
+		if(!comma)
+		{
+			chunk.m_error = string("Malformed file (line \"") + string(a, b) + "\") contains no Y-axis data\n";
+			return;
+		}
+		chunk.m_offsets.push_back(ParseCSVNumber(a, comma) * FS_PER_SECOND);
+
+		//Then one column per channel. Extra columns are ignored, missing ones are noted for the merge.
+		size_t row = chunk.m_offsets.size() - 1;
+		size_t base = chunk.m_samples.size();
+		chunk.m_samples.resize(base + ncols);
+		float* samples = &chunk.m_samples[base];
+		const char* cell = comma + 1;
+		size_t ncells = 0;
+		while(ncells < ncols)
+		{
+			auto cellEnd = reinterpret_cast<const char*>(memchr(cell, ',', b - cell));
+			if(!cellEnd)
+				cellEnd = b;
+			samples[ncells++] = ParseCSVNumber(cell, cellEnd);
+			if(cellEnd == b)
+				break;
+			cell = cellEnd + 1;
+		}
+		if(ncells < ncols)
+		{
+			chunk.m_shortRows.push_back(pair<size_t, size_t>(row, ncells));
+			for(size_t i=ncells; i<ncols; i++)
+				samples[i] = 0;
+		}
 
-		iwfm->m_samples[i] = temp[i*2];
-		qwfm->m_samples[i] = temp[i*2 + 1];
+		//Update progress every so often
+		if( (size_t)(p - lastProgress) >= progressInterval)
+		{
+			size_t done = bytesDone.fetch_add(p - lastProgress) + (p - lastProgress);
+			lastProgress = p;
+			if(reporter)
+				ReportImportProgress(done * 1.0f / bytesTotal);
+		}
 	}
 
-	delete[] temp;
-	fclose(fp);
-	return true;
+	bytesDone.fetch_add(p - lastProgress);
 }
 
 /**
 	@brief Imports waveforms from Comma Separated Value files
+
+	The file is memory mapped. The header is parsed serially, then the data rows are split into line-aligned slices
+	which are parsed in parallel and concatenated.
  */
 bool MockOscilloscope::LoadCSV(const string& path)
 {
 	LogTrace("Importing CSV file \"%s\"\n", path.c_str());
 	LogIndenter li;
 
-	FILE* fp = fopen(path.c_str(), "r");
-	if(!fp)
+	MappedFile file;
+	if(!file.Open(path))
 	{
 		LogError("Failed to open file\n");
 		return false;
 	}
-
-	vector<AnalogWaveform*> waveforms;
+	file.AdviseSequential();
+	auto start = reinterpret_cast<const char*>(file.GetData());
+	auto end = start + file.GetSize();
 
 	bool digilentFormat = false;
 
@@ -816,233 +980,243 @@ bool MockOscilloscope::LoadCSV(const string& path)
 	int64_t fs = 0;
 	GetTimestampOfFile(path, timestamp, fs);
 
-	char line[1024];
-	size_t nrow = 0;
+	//Walk comments and metadata up to the first row, which might be a header with the channel names
+	const char* pdata = start;
 	size_t ncols = 0;
 	vector<string> channel_names;
-	while(!feof(fp))
+	while(pdata < end)
 	{
-		if(!fgets(line, sizeof(line), fp))
-			break;
+		auto eol = reinterpret_cast<const char*>(memchr(pdata, '\n', end - pdata));
+		if(!eol)
+			eol = end;
+		const char* next = (eol < end) ? eol+1 : end;
 
 		//Discard blank lines
-		string s = Trim(line);
+		string s = Trim(string(pdata, eol));
 		if(s.empty())
+		{
+			pdata = next;
 			continue;
+		}
 
 		//If the line starts with a #, it's a comment. Discard it.
 		if(s[0] == '#')
 		{
-			if(s == "#Digilent WaveForms Oscilloscope Acquisition")
-			{
-				digilentFormat = true;
-				m_vendor = "Digilent";
-			}
-
-			else if(digilentFormat)
-			{
-				if(s.find("#Device Name: ") == 0)
-					m_name = s.substr(14);
-				if(s.find("#Serial Number: ") == 0)
-					m_serial = s.substr(16);
-				if(s.find("#Date Time: ") == 0)
-				{
-					//yyyy-mm-dd hh:mm:ss.ms.us.ns
-					//No time zone information provided. For now, assume current time zone.
-					string stimestamp = s.substr(12);
-
-					tm now;
-					time_t tnow;
-					time(&tnow);
-					localtime_r(&tnow, &now);
-
-					tm stamp;
-					int ms;
-					int us;
-					int ns;
-					if(9 == sscanf(stimestamp.c_str(), "%d-%d-%d %d:%d:%d.%d.%d.%d",
-						&stamp.tm_year, &stamp.tm_mon, &stamp.tm_mday,
-						&stamp.tm_hour, &stamp.tm_min, &stamp.tm_sec,
-						&ms, &us, &ns))
-					{
-						//tm_year isn't absolute year, it's offset from 1900
-						stamp.tm_year -= 1900;
-
-						//TODO: figure out if this day/month/year was DST or not.
-						//For now, assume same as current. This is going to be off by an hour for half the year!
-						stamp.tm_isdst = now.tm_isdst;
-
-						//We can finally get the actual time_t
-						timestamp = mktime(&stamp);
-
-						//Convert to femtoseconds for internal scopehal format
-						fs = ms * 1000;
-						fs = (fs + us) * 1000;
-						fs = (fs + ns) * 1000;
-						fs *= 1000;
-					}
-				}
-			}
+			ParseCSVComment(s, digilentFormat, timestamp, fs);
+			pdata = next;
 			continue;
 		}
 
-		nrow ++;
-
-		//Parse the samples for each row
-		//TODO: be more efficient about this
-		vector<float> row;
-		string tmp;
-		for(size_t i=0; i < sizeof(line); i++)
+		//Figure out how many columns we have.
+		//First column is always timestamp in seconds.
+		//TODO: support timestamp in abstract sample units instead
+		vector<string> fields;
+		size_t cellStart = 0;
+		while(true)
 		{
-			if(line[i] == '\0' || line[i] == ',')
-			{
-				float f;
-				sscanf(tmp.c_str(), "%f", &f);
-				row.push_back(f);
-
-				if(line[i] == '\0')
-					break;
-				else
-					tmp = "";
-			}
-			else
-				tmp += line[i];
+			size_t comma = s.find(',', cellStart);
+			fields.push_back(s.substr(cellStart, comma - cellStart));
+			if(comma == string::npos)
+				break;
+			cellStart = comma + 1;
 		}
-
-		if(row.size() <= 1)
+		if(fields.size() <= 1)
 		{
 			LogError("Malformed file (line \"%s\") contains no Y-axis data\n", s.c_str());
 			return false;
 		}
+		ncols = fields.size() - 1;
 
-		//If this is the first line, figure out how many columns we have.
-		//First column is always timestamp in seconds.
-		//TODO: support timestamp in abstract sample units instead
-		if(nrow == 1)
+		//See if the first row is numeric
+		bool numeric = true;
+		for(auto c : s)
 		{
-			ncols = row.size() - 1;
-
-			//See if the first row is numeric
-			bool numeric = true;
-			for(size_t i=0; (i<sizeof(line)) && (line[i] != '\0'); i++)
+			if(!isdigit(c) && !isspace(c) && (c != ',') && (c != '.') && (c != '-') )
 			{
-				if(!isdigit(line[i]) && !isspace(line[i]) && (line[i] != ',') && (line[i] != '.') && (line[i] != '-') )
-				{
-					numeric = false;
-					break;
-				}
+				numeric = false;
+				break;
 			}
+		}
 
-			if(!numeric)
-			{
-				LogTrace("Found %zu signal columns, with header row\n", ncols);
+		if(!numeric)
+		{
+			LogTrace("Found %zu signal columns, with header row\n", ncols);
 
-				//Extract names of the headers
-				tmp = "";
-				for(size_t i=0; i < sizeof(line); i++)
-				{
-					if(line[i] == '\0' || line[i] == ',')
-					{
-						channel_names.push_back(tmp);
+			//Extract names of the headers, discarding name of timestamp column
+			for(size_t i=1; i<fields.size(); i++)
+				channel_names.push_back(Trim(fields[i]));
 
-						if(line[i] == '\0')
-							break;
-						else
-							tmp = "";
-					}
-					else if(line[i] != '\n')
-						tmp += line[i];
-				}
+			pdata = next;
+		}
 
-				//Discard name of timestamp column
-				channel_names.erase(channel_names.begin());
+		else
+		{
+			for(size_t i=0; i<ncols; i++)
+				channel_names.push_back(string("CH") + to_string(i+1));
 
-				continue;
-			}
+			LogTrace("Found %zu signal columns, no header row\n", ncols);
+		}
 
-			else
-			{
-				for(size_t i=0; i<ncols; i++)
-					channel_names.push_back(string("CH") + to_string(i+1));
+		break;
+	}
 
-				LogTrace("Found %zu signal columns, no header row\n", ncols);
-			}
+	//Split the data rows into one slice per thread, moving each boundary forward to the start of the next line
+	size_t bytesTotal = end - pdata;
+	size_t nthreads = omp_get_max_threads();
+	if(bytesTotal < 1024 * 1024)
+		nthreads = 1;
+	vector<const char*> bounds(nthreads + 1);
+	bounds[0] = pdata;
+	bounds[nthreads] = end;
+	for(size_t i=1; i<nthreads; i++)
+	{
+		const char* p = max(pdata + bytesTotal*i/nthreads, bounds[i-1]);
+		auto eol = reinterpret_cast<const char*>(memchr(p, '\n', end - p));
+		bounds[i] = eol ? eol+1 : end;
+	}
+
+	//Parse the slices
+	vector<CSVChunk> chunks(nthreads);
+	atomic<size_t> bytesDone(0);
+	if(ncols != 0)
+	{
+		#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+		for(size_t i=0; i<nthreads; i++)
+			ParseCSVChunk(bounds[i], bounds[i+1], ncols, chunks[i], bytesDone, bytesTotal);
+	}
+
+	//Report the first error in the file, if any
+	size_t nrows = 0;
+	bool ragged = false;
+	for(auto& c : chunks)
+	{
+		if(!c.m_error.empty())
+		{
+			LogError("%s", c.m_error.c_str());
+			return false;
 		}
+		nrows += c.m_offsets.size();
+		if(!c.m_shortRows.empty())
+			ragged = true;
+	}
+	if(nrows == 0)
+	{
+		LogError("No samples found in file\n");
+		return false;
+	}
+
+	//If we don't have any channels, create them
+	if(GetChannelCount() == 0)
+	{
+		LogTrace("Creating channels\n");
 
-		//If we don't have any channels, create them
-		if(GetChannelCount() == 0)
+		//Create the columns
+		for(size_t i=0; i<ncols; i++)
 		{
-			LogTrace("Creating channels\n");
+			//Create the channel
+			auto chan = new OscilloscopeChannel(
+				this,
+				channel_names[i],
+				OscilloscopeChannel::CHANNEL_TYPE_ANALOG,
+				GetDefaultChannelColor(i),
+				1,
+				i,
+				true);
+			AddChannel(chan);
+			chan->SetDefaultDisplayName();
+		}
+	}
 
-			//Create the columns
-			for(size_t i=0; i<ncols; i++)
+	//Create the waveforms
+	LogTrace("Creating waveforms\n");
+	vector<AnalogWaveform*> waveforms;
+	for(size_t i=0; i<ncols; i++)
+	{
+		//Create the waveform for the channel
+		auto wfm = g_waveformPool.Allocate<AnalogWaveform>(nrows);
+		wfm->m_timescale = 1;
+		wfm->m_startTimestamp = timestamp;
+		wfm->m_startFemtoseconds = fs;
+		wfm->m_triggerPhase = 0;
+		waveforms.push_back(wfm);
+		GetChannel(i)->SetData(wfm, 0);
+	}
+
+	//Common case: every row has every column, so all channels share one timebase and we can copy in parallel
+	if(!ragged)
+	{
+		vector<size_t> rowBase(nthreads);
+		for(size_t i=1; i<nthreads; i++)
+			rowBase[i] = rowBase[i-1] + chunks[i-1].m_offsets.size();
+		for(auto w : waveforms)
+			w->Resize(nrows);
+
+		#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+		for(size_t i=0; i<nthreads; i++)
+		{
+			auto& c = chunks[i];
+			size_t len = c.m_offsets.size();
+			if(len == 0)
+				continue;
+			for(size_t j=0; j<ncols; j++)
 			{
-				//Create the channel
-				auto chan = new OscilloscopeChannel(
-					this,
-					channel_names[i],
-					OscilloscopeChannel::CHANNEL_TYPE_ANALOG,
-					GetDefaultChannelColor(i),
-					1,
-					i,
-					true);
-				AddChannel(chan);
-				chan->SetDefaultDisplayName();
+				auto w = waveforms[j];
+				memcpy((int64_t*)&w->m_offsets[rowBase[i]], &c.m_offsets[0], len * sizeof(int64_t));
+				for(size_t k=0; k<len; k++)
+					w->m_samples[rowBase[i] + k] = c.m_samples[k*ncols + j];
 			}
 		}
+	}
 
-		//Create waveforms if needed
-		if(waveforms.empty())
+	//Rows with missing cells only contribute samples to the columns they have
+	else
+	{
+		for(size_t j=0; j<ncols; j++)
 		{
-			LogTrace("Creating waveforms\n");
-
-			for(size_t i=0; i<ncols; i++)
+			auto w = waveforms[j];
+			for(auto& c : chunks)
 			{
-				//Create the waveform for the channel
-				auto wfm = new AnalogWaveform;
-				wfm->m_timescale = 1;
-				wfm->m_startTimestamp = timestamp;
-				wfm->m_startFemtoseconds = fs;
-				wfm->m_triggerPhase = 0;
-				waveforms.push_back(wfm);
-				GetChannel(i)->SetData(wfm, 0);
+				size_t nshort = 0;
+				for(size_t k=0; k<c.m_offsets.size(); k++)
+				{
+					if( (nshort < c.m_shortRows.size()) && (c.m_shortRows[nshort].first == k) )
+					{
+						if(j >= c.m_shortRows[nshort++].second)
+							continue;
+					}
+
+					w->m_offsets.push_back(c.m_offsets[k]);
+					w->m_samples.push_back(c.m_samples[k*ncols + j]);
+				}
 			}
+			w->m_durations.resize(w->m_offsets.size());
 		}
+	}
+	chunks.clear();
 
-		int64_t offset = row[0] * FS_PER_SECOND;
-		for(size_t i=0; i<ncols; i++)
+	//Each sample lasts until the next one starts
+	for(auto w : waveforms)
+	{
+		size_t len = w->m_offsets.size();
+		if(len == 0)
+			continue;
+		for(size_t k=0; k+1<len; k++)
 		{
-			if(i+1 >= row.size())
-				break;
-
-			auto w = waveforms[i];
-			w->m_offsets.push_back(offset);
-			w->m_samples.push_back(row[i+1]);
+			w->m_durations[k] = w->m_offsets[k+1] - w->m_offsets[k];
 
-			//Extend last sample
-			if(!w->m_durations.empty())
+			//Sanity check: duration must not be negative
+			if(w->m_durations[k] < 0)
 			{
-				size_t last = w->m_durations.size() - 1;
-				w->m_durations[last] = offset - w->m_offsets[last];
-
-				//Sanity check: duration must not be negative
-				if(w->m_durations[last] < 0)
-				{
-					Unit xunit(Unit::UNIT_FS);
-					LogError("Malformed file - sample %zu has a negative duration (%s)\n",
-						w->m_samples.size(),
-						xunit.PrettyPrint(w->m_durations[last]).c_str());
-					return false;
-				}
+				Unit xunit(Unit::UNIT_FS);
+				LogError("Malformed file - sample %zu has a negative duration (%s)\n",
+					k+2,
+					xunit.PrettyPrint(w->m_durations[k]).c_str());
+				return false;
 			}
-
-			//Add duration for this sample
-			w->m_durations.push_back(1);
 		}
+		w->m_durations[len-1] = 1;
 	}
 
-	fclose(fp);
-
 	//Calculate gain/offset for each channel
 	for(size_t i=0; i<ncols; i++)
 	{
@@ -1066,6 +1240,7 @@ bool MockOscilloscope::LoadCSV(const string& path)
 
 	NormalizeTimebases();
 
+	ReportImportProgress(1);
 	return true;
 }
 
@@ -1137,11 +1312,21 @@ bool MockOscilloscope::LoadBIN(const string& path)
 	LogTrace("Importing BIN file \"%s\"\n", path.c_str());
 	LogIndenter li_f;
 
-	string f = ReadFile(path);
-	uint32_t fpos = 0;
+	MappedFile f;
+	if(!f.Open(path))
+		return false;
+	f.AdviseSequential();
+	const uint8_t* data = f.GetData();
+	size_t flen = f.GetSize();
+	size_t fpos = 0;
 
 	FileHeader fh;
-	f.copy((char*)&fh, sizeof(FileHeader), fpos);
+	if(flen < sizeof(FileHeader))
+	{
+		LogError("File is too small to be a BIN capture\n");
+		return false;
+	}
+	memcpy(&fh, data + fpos, sizeof(FileHeader));
 	fpos += sizeof(FileHeader);
 
 	//Get vendor from file signature
@@ -1172,7 +1357,12 @@ bool MockOscilloscope::LoadBIN(const string& path)
 
 		//Parse waveform header
 		WaveHeader wh;
-		f.copy((char*)&wh, sizeof(WaveHeader), fpos);
+		if(fpos + sizeof(WaveHeader) > flen)
+		{
+			LogError("Truncated file (waveform header)\n");
+			return false;
+		}
+		memcpy(&wh, data + fpos, sizeof(WaveHeader));
 		fpos += sizeof(WaveHeader);
 
 		// Only set name/serial on first waveform
@@ -1222,7 +1412,7 @@ bool MockOscilloscope::LoadBIN(const string& path)
 		chan->SetDefaultDisplayName();
 
 		//Create new waveform for channel
-		auto wfm = new AnalogWaveform;
+		auto wfm = g_waveformPool.Allocate<AnalogWaveform>((size_t)wh.samples * wh.buffers);
 		wfm->m_timescale = wh.interval * 1e15;
 		wfm->m_startTimestamp = 0;
 		wfm->m_startFemtoseconds = 0;
@@ -1239,57 +1429,60 @@ bool MockOscilloscope::LoadBIN(const string& path)
 
 			//Parse waveform data header
 			DataHeader dh;
-			f.copy((char*)&dh, sizeof(DataHeader), fpos);
+			if(fpos + sizeof(DataHeader) > flen)
+			{
+				LogError("Truncated file (buffer header)\n");
+				return false;
+			}
+			memcpy(&dh, data + fpos, sizeof(DataHeader));
 			fpos += sizeof(DataHeader);
 
     		LogDebug("Data Type:      %i\n", dh.type);
     		LogDebug("Sample depth:   %i bits\n", dh.depth*8);
     		LogDebug("Buffer length:  %i KB\n\n\n", dh.length/1024);
 
-			//Loop through waveform samples
-			float sample = 0;
-			if (dh.type == 6)
+			size_t nsamples = wh.samples;
+			size_t stride = dh.depth;
+			bool integer = (dh.type == 6);
+			size_t lastSampleSize = integer ? 1 : sizeof(float);
+			if( (nsamples > 0) && ( (stride == 0) || (fpos + (nsamples-1)*stride + lastSampleSize > flen) ) )
 			{
-				//Integer samples (digital waveforms)
-				uint8_t* sample_i = nullptr;
-				for(size_t k=0; k<wh.samples; k++)
-				{
-					sample_i = (uint8_t*)(f.c_str() + fpos);
-					sample = (float)*sample_i;
+				LogError("Truncated file (sample data)\n");
+				return false;
+			}
 
-					//Push sample to waveform
-					wfm->m_offsets.push_back(k);
-					wfm->m_samples.push_back(sample);
-					wfm->m_durations.push_back(1);
+			//Append this buffer to the waveform, converting straight out of the mapping
+			size_t base = wfm->m_samples.size();
+			wfm->Resize(base + nsamples);
+			const uint8_t* in = data + fpos;
+			#pragma omp parallel for
+			for(size_t k=0; k<nsamples; k++)
+			{
+				float sample;
 
-					//Update voltage min/max values
-					vmax = max(vmax, sample);
-					vmin = min(vmin, sample);
+				//Integer samples (digital waveforms)
+				if(integer)
+					sample = in[k*stride];
 
-					fpos += dh.depth;
-				}
-			}
-			else
-			{
 				//Float samples (analog waveforms)
-				float* sample_f = nullptr;
-				for(size_t k=0; k<wh.samples; k++)
-				{
-					sample_f = (float*)(f.c_str() + fpos);
-					sample = *sample_f;
-
-					//Push sample to waveform
-					wfm->m_offsets.push_back(k);
-					wfm->m_samples.push_back(sample);
-					wfm->m_durations.push_back(1);
+				else
+					memcpy(&sample, in + k*stride, sizeof(float));
 
-					//Update voltage min/max values
-					vmax = max(vmax, sample);
-					vmin = min(vmin, sample);
+				wfm->m_offsets[base + k] = k;
+				wfm->m_samples[base + k] = sample;
+				wfm->m_durations[base + k] = 1;
+			}
+			fpos = min(fpos + nsamples*stride, flen);
 
-					fpos += dh.depth;
-				}
+			//Update voltage min/max values
+			for(size_t k=0; k<nsamples; k++)
+			{
+				float sample = wfm->m_samples[base + k];
+				vmax = max(vmax, sample);
+				vmin = min(vmin, sample);
 			}
+
+			ReportImportProgress(fpos * 1.0f / flen);
 		}
 
 		//Calculate offset and range
@@ -1491,9 +1684,9 @@ bool MockOscilloscope::LoadVCD(const string& path)
 					//Create the waveform
 					WaveformBase* wfm;
 					if(width == 1)
-						wfm = new DigitalWaveform;
+						wfm = g_waveformPool.Allocate<DigitalWaveform>();
 					else
-						wfm = new DigitalBusWaveform;
+						wfm = g_waveformPool.Allocate<DigitalBusWaveform>();
 
 					wfm->m_timescale = timescale;
 					wfm->m_startTimestamp = timestamp;
@@ -1621,63 +1814,66 @@ bool MockOscilloscope::LoadVCD(const string& path)
  */
 bool MockOscilloscope::LoadWAV(const string& path)
 {
-	FILE* fp = fopen(path.c_str(), "rb");
-	if(!fp)
+	MappedFile file;
+	if(!file.Open(path))
 	{
 		LogError("Couldn't open WAV file \"%s\"\n", path.c_str());
 		return false;
 	}
+	file.AdviseSequential();
+	const uint8_t* data = file.GetData();
+	size_t flen = file.GetSize();
+	size_t fpos = 0;
 
 	//Read the RIFF tag, should be "RIFF", uint32 len, "WAVE", then data
 	uint32_t header[3];
-	if(3 != fread(header, sizeof(uint32_t), 3, fp))
+	if(flen < sizeof(header))
 	{
 		LogError("Failed to read RIFF header\n");
-		fclose(fp);
 		return false;
 	}
+	memcpy(header, data, sizeof(header));
+	fpos += sizeof(header);
 	if(header[0] != 0x46464952)	// "RIFF"
 	{
 		LogError("Bad top level chunk type (not a RIFF file)\n");
-		fclose(fp);
 		return false;
 	}
 	if(header[2] != 0x45564157)	// "WAVE"
 	{
 		LogError("Bad WAVE data type (not a WAV file)\n");
-		fclose(fp);
 		return false;
 	}
 	//Ignore RIFF length, it should encompass the entire file
 
 	//Read the format chunk header
-	if(2 != fread(header, sizeof(uint32_t), 2, fp))
+	if(fpos + 2*sizeof(uint32_t) > flen)
 	{
 		LogError("Failed to read format header\n");
-		fclose(fp);
 		return false;
 	}
+	memcpy(header, data + fpos, 2*sizeof(uint32_t));
+	fpos += 2*sizeof(uint32_t);
 	if(header[0] != 0x20746d66)	// "FMT "
 	{
 		LogError("Bad WAV format chunk type (not FMT)\n");
-		fclose(fp);
 		return false;
 	}
 	if( (header[1] < 16) || (header[1] > 128) )
 	{
 		LogError("Bad WAV format length (expected >= 16 and <= 128)\n");
-		fclose(fp);
 		return false;
 	}
 
 	//Read the format
 	uint8_t format[128];
-	if(header[1] != fread(format, 1, header[1], fp))
+	if(fpos + header[1] > flen)
 	{
 		LogError("Failed to read format\n");
-		fclose(fp);
 		return false;
 	}
+	memcpy(format, data + fpos, header[1]);
+	fpos += header[1];
 	uint16_t afmt = *(uint16_t*)(format);
 	uint16_t nchans = *(uint16_t*)(format + 2);
 	uint32_t srate = *(uint32_t*)(format + 4);
@@ -1693,7 +1889,6 @@ bool MockOscilloscope::LoadWAV(const string& path)
 			LogError(
 				"Integer PCM (fmt=1) must be 8 or 16 bit resolution, got %d instead\n",
 				nbits);
-			fclose(fp);
 			return false;
 		}
 	}
@@ -1705,7 +1900,6 @@ bool MockOscilloscope::LoadWAV(const string& path)
 			LogError(
 				"Floating point PCM (fmt=3) must be 32 bit resolution, got %d instead\n",
 				nbits);
-			fclose(fp);
 			return false;
 		}
 	}
@@ -1715,39 +1909,40 @@ bool MockOscilloscope::LoadWAV(const string& path)
 			"Importing compressed WAVs (format %d) is not supported. "
 			"Try re-encoding as uncompressed integer or floating point PCM\n",
 			afmt);
-		fclose(fp);
+		return false;
+	}
+	if( (nchans == 0) || (srate == 0) )
+	{
+		LogError("Bad WAV format (%d channels at %d Hz)\n", nchans, srate);
 		return false;
 	}
 
-	//Read and discard chunks until we see the data header
+	//Skip chunks until we see the data header
 	while(true)
 	{
-		if(2 != fread(header, sizeof(uint32_t), 2, fp))
+		if(fpos + 2*sizeof(uint32_t) > flen)
 		{
 			LogError("Failed to read chunk header\n");
-			fclose(fp);
 			return false;
 		}
+		memcpy(header, data + fpos, 2*sizeof(uint32_t));
+		fpos += 2*sizeof(uint32_t);
 		if(header[0] == 0x61746164)	//"data"
 			break;
-		fseek(fp, header[1], SEEK_CUR);
+		fpos += header[1];
 	}
 
 	//Get timestamp of the file if no header timestamp
-	//TODO: Add Windows equivalent
-	int64_t timestamp = 0;
+	time_t timestamp = 0;
 	int64_t fs = 0;
-	#ifndef _WIN32
-		struct stat st;
-		if(0 == stat(path.c_str(), &st))
-		{
-			timestamp = st.st_mtim.tv_sec;
-			fs = st.st_mtim.tv_nsec * 1000L * 1000L;
-		}
-	#endif
+	GetTimestampOfFile(path, timestamp, fs);
+
+	//Streaming recorders often leave the data length as zero or 0xffffffff, so never trust it past end of file
+	size_t datalen = min((size_t)header[1], flen - fpos);
+	if(datalen == 0)
+		datalen = flen - fpos;
 
 	//Create our channels
-	size_t datalen = header[1];
 	size_t bytes_per_sample = nbits / 8;
 	size_t bytes_per_row = bytes_per_sample * nchans;
 	size_t nsamples = datalen / bytes_per_row;
@@ -1772,7 +1967,7 @@ bool MockOscilloscope::LoadWAV(const string& path)
 		chan->SetOffset(0);
 
 		//Create new waveform for channel
-		auto wfm = new AnalogWaveform;
+		auto wfm = g_waveformPool.Allocate<AnalogWaveform>(nsamples);
 		wfm->m_timescale = interval;
 		wfm->m_startTimestamp = timestamp;
 		wfm->m_startFemtoseconds = fs;
@@ -1783,58 +1978,159 @@ bool MockOscilloscope::LoadWAV(const string& path)
 		chan->SetData(wfm, 0);
 	}
 
-	//Read the entire file into a buffer rather than doing a whole bunch of tiny fread's
-	uint8_t* buf = new uint8_t[datalen];
-	if(datalen != fread(buf, 1, datalen, fp))
+	//Crunch the samples straight out of the mapping, one channel at a time so each output is written sequentially
+	const uint8_t* buf = data + fpos;
+	const size_t blocksize = 1024 * 1024;
+	for(size_t base=0; base<nsamples; base += blocksize)
 	{
-		LogError("Failed to read WAV data\n");
-		fclose(fp);
-		return false;
-	}
-	fclose(fp);
-	fp = NULL;
+		size_t end = min(base + blocksize, nsamples);
 
-	//TODO: vectorized offset/duration fill if possible
-	//TODO: vectorized shuffling for the common case of 2 channel?
-
-	//Crunch the samples
-	size_t off = 0;
-	for(size_t i=0; i<nsamples; i++)
-	{
 		for(size_t j=0; j<nchans; j++)
 		{
-			auto wfm = wfms[j];
-			wfm->m_offsets[i] = i;
-			wfm->m_durations[i] = 0;
+			int64_t* offs = (int64_t*)&wfms[j]->m_offsets[0];
+			int64_t* durs = (int64_t*)&wfms[j]->m_durations[0];
+			float* samps = (float*)&wfms[j]->m_samples[0];
+			const uint8_t* in = buf + j*bytes_per_sample;
 
 			//Floating point samples can be read as is
 			if(afmt == 3)
 			{
-				wfm->m_samples[i] = *(float*)(buf + off);
-				off += 4;
+				#pragma omp parallel for
+				for(size_t i=base; i<end; i++)
+				{
+					offs[i] = i;
+					durs[i] = 0;
+					memcpy(&samps[i], in + i*bytes_per_row, sizeof(float));
+				}
 			}
 
 			//Integer samples get normalized
-			else
+			//16 bit is signed
+			else if(nbits == 16)
 			{
-				//16 bit is signed
-				if(nbits == 16)
+				#pragma omp parallel for
+				for(size_t i=base; i<end; i++)
 				{
-					wfm->m_samples[i] = *(int16_t*)(buf + off) / 32768.0f;
-					off += 2;
+					int16_t v;
+					memcpy(&v, in + i*bytes_per_row, sizeof(int16_t));
+					offs[i] = i;
+					durs[i] = 0;
+					samps[i] = v / 32768.0f;
 				}
+			}
 
-				//8 bit is unsigned
-				else
+			//8 bit is unsigned
+			else
+			{
+				#pragma omp parallel for
+				for(size_t i=base; i<end; i++)
 				{
-					wfm->m_samples[i] = (*(uint8_t*)(buf + off) - 127) / 127.0f;
-					off ++;
+					offs[i] = i;
+					durs[i] = 0;
+					samps[i] = (in[i*bytes_per_row] - 127) / 127.0f;
 				}
 			}
 		}
+
+		ReportImportProgress(end * 1.0f / nsamples);
+	}
+
+	return true;
+}
+
+/**
+	@brief Opens a native waveform archive (see WaveformArchiveWriter) and loads its first trigger.
+
+	Only the index is read up front. Other triggers are paged in on request by LoadArchiveTrigger().
+ */
+bool MockOscilloscope::LoadArchive(const string& path)
+{
+	LogTrace("Importing waveform archive \"%s\"\n", path.c_str());
+	LogIndenter li;
+
+	auto archive = new WaveformArchiveReader;
+	if(!archive->Open(path))
+	{
+		delete archive;
+		return false;
+	}
+	delete m_archive;
+	m_archive = archive;
+
+	//Create our channels
+	auto& channels = m_archive->GetChannels();
+	for(size_t i=0; i<channels.size(); i++)
+	{
+		auto& ac = channels[i];
+		auto chan = new OscilloscopeChannel(
+			this,
+			ac.m_hwname,
+			static_cast<OscilloscopeChannel::ChannelType>(ac.m_type),
+			ac.m_color,
+			Unit(static_cast<Unit::UnitType>(ac.m_xunit)),
+			Unit(static_cast<Unit::UnitType>(ac.m_yunit)),
+			ac.m_width,
+			i,
+			true);
+		chan->ClearStreams();
+		for(auto& name : ac.m_streamNames)
+			chan->AddStream(name);
+		AddChannel(chan);
+		chan->SetDefaultDisplayName();
+	}
+
+	if(m_archive->GetTriggerCount() == 0)
+	{
+		LogWarning("Archive contains no waveforms\n");
+		return true;
+	}
+	return LoadArchiveTrigger(0);
+}
+
+/**
+	@brief Replaces the waveforms on every channel with those from one trigger of the archive opened by LoadArchive()
+ */
+bool MockOscilloscope::LoadArchiveTrigger(size_t trigger)
+{
+	if(!m_archive || (trigger >= m_archive->GetTriggerCount()) )
+		return false;
+
+	//Decode every stream in parallel, then attach them
+	vector< pair<size_t, size_t> > streams;
+	size_t nchans = min(GetChannelCount(), m_archive->GetChannels().size());
+	for(size_t i=0; i<nchans; i++)
+	{
+		for(size_t j=0; j<GetChannel(i)->GetStreamCount(); j++)
+			streams.push_back(pair<size_t, size_t>(i, j));
+	}
+
+	vector<WaveformBase*> wfms(streams.size());
+	#pragma omp parallel for
+	for(size_t i=0; i<streams.size(); i++)
+		wfms[i] = m_archive->LoadWaveform(trigger, streams[i].first, streams[i].second);
+
+	for(size_t i=0; i<streams.size(); i++)
+	{
+		auto chan = GetChannel(streams[i].first);
+		chan->SetData(wfms[i], streams[i].second);
+
+		//Scale analog channels to fit
+		auto awfm = dynamic_cast<AnalogWaveform*>(wfms[i]);
+		if(awfm && !awfm->m_samples.empty() && (streams[i].second == 0) )
+		{
+			float vmin = FLT_MAX;
+			float vmax = -FLT_MAX;
+			for(auto v : awfm->m_samples)
+			{
+				vmax = max(vmax, (float)v);
+				vmin = min(vmin, (float)v);
+			}
+
+			float vrange = max(vmax - vmin, 0.001f);
+			chan->SetVoltageRange(vrange);
+			chan->SetOffset(-(vmin + vrange/2));
+		}
 	}
 
-	//Done, clean up
-	delete[] buf;
 	return true;
 }
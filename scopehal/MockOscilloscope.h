@@ -36,6 +36,9 @@
 #ifndef MockOscilloscope_h
 #define MockOscilloscope_h
 
+#include <functional>
+#include <atomic>
+
 class MockOscilloscope : public Oscilloscope
 {
 public:
@@ -52,6 +55,23 @@ public:
 	bool LoadBIN(const std::string& path);
 	bool LoadVCD(const std::string& path);
 	bool LoadWAV(const std::string& path);
+	bool LoadArchive(const std::string& path);
+
+	bool LoadArchiveTrigger(size_t trigger);
+
+	///Gets the number of triggers in the archive opened by LoadArchive()
+	size_t GetArchiveTriggerCount()
+	{ return m_archive ? m_archive->GetTriggerCount() : 0; }
+
+	/**
+		@brief Callback invoked periodically while importing a file, with the fraction (0 to 1) completed so far.
+
+		Always called from the thread which called the Load*() function.
+	 */
+	typedef std::function<void(float)> ImportProgressCallback;
+
+	void SetImportProgressCallback(ImportProgressCallback callback)
+	{ m_importProgressCallback = callback; }
 
 	//Agilent/Keysight/Rigol binary capture structs
 	#pragma pack(push, 1)
@@ -174,6 +194,44 @@ protected:
 		int64_t samplerate,
 		size_t numSamples);
 
+	void ReportImportProgress(float fraction)
+	{
+		if(m_importProgressCallback)
+			m_importProgressCallback(fraction);
+	}
+
+	template<class T>
+	bool LoadComplexMapped(const std::string& path, int64_t samplerate, float scale);
+
+	void ParseCSVComment(const std::string& s, bool& digilentFormat, time_t& timestamp, int64_t& fs);
+
+	///Samples parsed from one line-aligned slice of a CSV file
+	class CSVChunk
+	{
+	public:
+		///Timestamp of each row
+		std::vector<int64_t> m_offsets;
+
+		///Row-major sample data, one sample per column per row
+		std::vector<float> m_samples;
+
+		///(row, number of columns present) for each row with fewer cells than the header
+		std::vector< std::pair<size_t, size_t> > m_shortRows;
+
+		///Description of the first parse error, if any
+		std::string m_error;
+	};
+
+	void ParseCSVChunk(
+		const char* start,
+		const char* end,
+		size_t ncols,
+		CSVChunk& chunk,
+		std::atomic<size_t>& bytesDone,
+		size_t bytesTotal);
+
+	ImportProgressCallback m_importProgressCallback;
+
 	void ArmTrigger();
 
 	//standard *IDN? fields
@@ -184,6 +242,9 @@ protected:
 
 	OscilloscopeChannel* m_extTrigger;
 
+	///Archive opened by LoadArchive(), kept open so triggers can be paged in on demand
+	WaveformArchiveReader* m_archive;
+
 	std::map<size_t, bool> m_channelsEnabled;
 	std::map<size_t, OscilloscopeChannel::CouplingType> m_channelCoupling;
 	std::map<size_t, double> m_channelAttenuation;
@@ -57,6 +57,7 @@ Oscilloscope::CreateMapType Oscilloscope::m_createprocs;
 Oscilloscope::Oscilloscope()
 {
 	m_trigger = NULL;
+	m_packDigitalWaveforms = false;
 }
 
 Oscilloscope::~Oscilloscope()
@@ -72,12 +73,7 @@ Oscilloscope::~Oscilloscope()
 		delete m_channels[i];
 	m_channels.clear();
 
-	for(auto set : m_pendingWaveforms)
-	{
-		for(auto it : set)
-			delete it.second;
-	}
-	m_pendingWaveforms.clear();
+	m_pendingWaveforms.Clear();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -169,14 +165,12 @@ bool Oscilloscope::WaitForTrigger(int timeout)
 
 size_t Oscilloscope::GetPendingWaveformCount()
 {
-	lock_guard<mutex> lock(m_pendingWaveformsMutex);
 	return m_pendingWaveforms.size();
 }
 
 bool Oscilloscope::HasPendingWaveforms()
 {
-	lock_guard<mutex> lock(m_pendingWaveformsMutex);
-	return (m_pendingWaveforms.size() != 0);
+	return !m_pendingWaveforms.empty();
 }
 
 /**
@@ -184,14 +178,7 @@ bool Oscilloscope::HasPendingWaveforms()
  */
 void Oscilloscope::ClearPendingWaveforms()
 {
-	lock_guard<mutex> lock(m_pendingWaveformsMutex);
-	while(!m_pendingWaveforms.empty())
-	{
-		SequenceSet set = *m_pendingWaveforms.begin();
-		for(auto it : set)
-			delete it.second;
-		m_pendingWaveforms.pop_front();
-	}
+	m_pendingWaveforms.Clear();
 }
 
 /**
@@ -199,16 +186,13 @@ void Oscilloscope::ClearPendingWaveforms()
  */
 bool Oscilloscope::PopPendingWaveform()
 {
-	lock_guard<mutex> lock(m_pendingWaveformsMutex);
-	if(m_pendingWaveforms.size())
-	{
-		SequenceSet set = *m_pendingWaveforms.begin();
-		for(auto it : set)
-			it.first->SetData(it.second, 0);	//assume stream 0
-		m_pendingWaveforms.pop_front();
-		return true;
-	}
-	return false;
+	SequenceSet set;
+	if(!m_pendingWaveforms.Pop(set))
+		return false;
+
+	for(auto it : set)
+		it.first->SetData(it.second, 0);	//assume stream 0
+	return true;
 }
 
 
@@ -722,67 +706,100 @@ bool Oscilloscope::HasFrequencyControls()
 // Helpers for converting raw 8-bit ADC samples to fp32 waveforms
 
 /**
-	@brief Converts 8-bit ADC samples to floating point
+	@brief Splits a batch of sample conversions into chunks for multithreading
+
+	@param counts	Number of samples in each job
+	@param chunks	Chunks to process
+
+	@return True if the chunks should be processed in parallel
  */
-void Oscilloscope::Convert8BitSamples(
-	int64_t* offs, int64_t* durs, float* pout, int8_t* pin, float gain, float offset, size_t count, int64_t ibase)
+bool Oscilloscope::SplitSampleConversionJobs(const vector<size_t>& counts, vector<SampleConversionChunk>& chunks)
 {
-	//Divide large waveforms (>1M points) into blocks and multithread them
+	size_t total = 0;
+	for(auto c : counts)
+		total += c;
+
+	//Small batches (<1M points total) get done single threaded to avoid overhead
 	//TODO: tune split
-	if(count > 1000000)
+	if(total <= 1000000)
 	{
-		//Round blocks to multiples of 32 samples for clean vectorization
-		size_t numblocks = omp_get_max_threads();
-		size_t lastblock = numblocks - 1;
-		size_t blocksize = count / numblocks;
-		blocksize = blocksize - (blocksize % 32);
-
-		#pragma omp parallel for
-		for(size_t i=0; i<numblocks; i++)
+		for(size_t i=0; i<counts.size(); i++)
 		{
-			//Last block gets any extra that didn't divide evenly
-			size_t nsamp = blocksize;
-			if(i == lastblock)
-				nsamp = count - i*blocksize;
-
-			size_t off = i*blocksize;
-			if(g_hasAvx2)
-			{
-				Convert8BitSamplesAVX2(
-					offs + off,
-					durs + off,
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp,
-					ibase + off);
-			}
-			else
-			{
-				Convert8BitSamplesGeneric(
-					offs + off,
-					durs + off,
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp,
-					ibase + off);
-			}
+			if(counts[i])
+				chunks.push_back(SampleConversionChunk(i, 0, counts[i]));
 		}
+		return false;
 	}
 
-	//Small waveforms get done single threaded to avoid overhead
-	else
+	//Divide into a few chunks per thread so uneven channels still balance well.
+	//Round chunks to multiples of 64 samples for clean vectorization and so every chunk stays aligned.
+	size_t chunksize = max(total / (omp_get_max_threads() * 4), (size_t)65536);
+	chunksize = (chunksize + 63) & ~(size_t)63;
+
+	for(size_t i=0; i<counts.size(); i++)
 	{
-		if(g_hasAvx2)
-			Convert8BitSamplesAVX2(offs, durs, pout, pin, gain, offset, count, ibase);
-		else
-			Convert8BitSamplesGeneric(offs, durs, pout, pin, gain, offset, count, ibase);
+		for(size_t start=0; start<counts[i]; start += chunksize)
+			chunks.push_back(SampleConversionChunk(i, start, min(chunksize, counts[i] - start)));
+	}
+	return true;
+}
+
+/**
+	@brief Converts 8-bit ADC samples to floating point
+ */
+void Oscilloscope::Convert8BitSamples(
+	int64_t* offs, int64_t* durs, float* pout, int8_t* pin, float gain, float offset, size_t count, int64_t ibase)
+{
+	vector< SampleConversionJob<int8_t> > jobs;
+	jobs.push_back(SampleConversionJob<int8_t>(offs, durs, pout, pin, gain, offset, count, ibase));
+	Convert8BitSamples(jobs);
+}
+
+/**
+	@brief Converts several blocks of 8-bit ADC samples (typically one per channel) to floating point
+
+	Large batches are split into chunks across both samples and channels, and processed on all cores at once.
+ */
+void Oscilloscope::Convert8BitSamples(vector< SampleConversionJob<int8_t> >& jobs)
+{
+	vector<size_t> counts;
+	for(auto& j : jobs)
+		counts.push_back(j.m_count);
+
+	vector<SampleConversionChunk> chunks;
+	bool parallel = SplitSampleConversionJobs(counts, chunks);
+
+	#pragma omp parallel for schedule(dynamic) if(parallel)
+	for(size_t i=0; i<chunks.size(); i++)
+	{
+		auto& c = chunks[i];
+		auto& j = jobs[c.m_job];
+		Convert8BitSamplesBlock(
+			j.m_offs + c.m_start,
+			j.m_durs + c.m_start,
+			j.m_pout + c.m_start,
+			j.m_pin + c.m_start,
+			j.m_gain,
+			j.m_offset,
+			c.m_count,
+			j.m_ibase + c.m_start);
 	}
 }
 
+/**
+	@brief Converts a single block of 8-bit ADC samples on the current thread, using the best available backend
+ */
+void Oscilloscope::Convert8BitSamplesBlock(
+	int64_t* offs, int64_t* durs, float* pout, int8_t* pin, float gain, float offset, size_t count, int64_t ibase)
+{
+	if(g_hasAvx512F)
+		Convert8BitSamplesAVX512F(offs, durs, pout, pin, gain, offset, count, ibase);
+	else if(g_hasAvx2)
+		Convert8BitSamplesAVX2(offs, durs, pout, pin, gain, offset, count, ibase);
+	else
+		Convert8BitSamplesGeneric(offs, durs, pout, pin, gain, offset, count, ibase);
+}
+
 /**
 	@brief Generic backend for Convert8BitSamples()
  */
@@ -906,89 +923,126 @@ void Oscilloscope::Convert8BitSamplesAVX2(
 	}
 }
 
+/**
+	@brief AVX-512 version of Convert8BitSamples()
+ */
+__attribute__((target("avx512f")))
+void Oscilloscope::Convert8BitSamplesAVX512F(
+	int64_t* offs, int64_t* durs, float* pout, int8_t* pin, float gain, float offset, size_t count, int64_t ibase)
+{
+	size_t end = count - (count % 64);
+
+	__m512i all_ones	= _mm512_set1_epi64(1);
+	__m512i all_eights	= _mm512_set1_epi64(8);
+	__m512i counts		= _mm512_add_epi64(_mm512_set1_epi64(ibase), _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0));
+
+	__m512 gains = _mm512_set1_ps(gain);
+	__m512 offsets = _mm512_set1_ps(offset);
+
+	for(size_t k=0; k<end; k += 64)
+	{
+		//Load all 64 raw ADC samples, 16 at a time, then sign extend directly to 32 bit and convert to fp32
+		__m512 block0_float = _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(
+			_mm_loadu_si128(reinterpret_cast<__m128i*>(pin + k))));
+		__m512 block1_float = _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(
+			_mm_loadu_si128(reinterpret_cast<__m128i*>(pin + k + 16))));
+		__m512 block2_float = _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(
+			_mm_loadu_si128(reinterpret_cast<__m128i*>(pin + k + 32))));
+		__m512 block3_float = _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(
+			_mm_loadu_si128(reinterpret_cast<__m128i*>(pin + k + 48))));
+
+		//Scale and offset
+		block0_float = _mm512_fmsub_ps(block0_float, gains, offsets);
+		block1_float = _mm512_fmsub_ps(block1_float, gains, offsets);
+		block2_float = _mm512_fmsub_ps(block2_float, gains, offsets);
+		block3_float = _mm512_fmsub_ps(block3_float, gains, offsets);
+
+		//Store back to the output buffer
+		_mm512_storeu_ps(pout + k,		block0_float);
+		_mm512_storeu_ps(pout + k + 16,	block1_float);
+		_mm512_storeu_ps(pout + k + 32,	block2_float);
+		_mm512_storeu_ps(pout + k + 48,	block3_float);
+
+		//Fill offset and duration, 8 samples per store
+		for(size_t j=0; j<64; j += 8)
+		{
+			_mm512_storeu_si512(reinterpret_cast<__m512i*>(offs + k + j), counts);
+			_mm512_storeu_si512(reinterpret_cast<__m512i*>(durs + k + j), all_ones);
+			counts = _mm512_add_epi64(counts, all_eights);
+		}
+	}
+
+	//Get any extras we didn't get in the SIMD loop
+	for(size_t k=end; k<count; k++)
+	{
+		offs[k] = ibase + k;
+		durs[k] = 1;
+		pout[k] = pin[k] * gain - offset;
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Helpers for converting raw 16-bit ADC samples to fp32 waveforms
 
 /**
-	@brief Converts 8-bit ADC samples to floating point
+	@brief Converts 16-bit ADC samples to floating point
  */
 void Oscilloscope::Convert16BitSamples(
 	int64_t* offs, int64_t* durs, float* pout, int16_t* pin, float gain, float offset, size_t count, int64_t ibase)
 {
-	//Divide large waveforms (>1M points) into blocks and multithread them
-	//TODO: tune split
-	if(count > 1000000)
-	{
-		//Round blocks to multiples of 32 samples for clean vectorization
-		size_t numblocks = omp_get_max_threads();
-		size_t lastblock = numblocks - 1;
-		size_t blocksize = count / numblocks;
-		blocksize = blocksize - (blocksize % 32);
-
-		#pragma omp parallel for
-		for(size_t i=0; i<numblocks; i++)
-		{
-			//Last block gets any extra that didn't divide evenly
-			size_t nsamp = blocksize;
-			if(i == lastblock)
-				nsamp = count - i*blocksize;
+	vector< SampleConversionJob<int16_t> > jobs;
+	jobs.push_back(SampleConversionJob<int16_t>(offs, durs, pout, pin, gain, offset, count, ibase));
+	Convert16BitSamples(jobs);
+}
 
-			size_t off = i*blocksize;
-			if(g_hasAvx2)
-			{
-				if(g_hasFMA)
-				{
-					Convert16BitSamplesFMA(
-						offs + off,
-						durs + off,
-						pout + off,
-						pin + off,
-						gain,
-						offset,
-						nsamp,
-						ibase + off);
-				}
-				else
-				{
-					Convert16BitSamplesAVX2(
-						offs + off,
-						durs + off,
-						pout + off,
-						pin + off,
-						gain,
-						offset,
-						nsamp,
-						ibase + off);
-				}
-			}
-			else
-			{
-				Convert16BitSamplesGeneric(
-					offs + off,
-					durs + off,
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp,
-					ibase + off);
-			}
-		}
+/**
+	@brief Converts several blocks of 16-bit ADC samples (typically one per channel) to floating point
+
+	Large batches are split into chunks across both samples and channels, and processed on all cores at once.
+ */
+void Oscilloscope::Convert16BitSamples(vector< SampleConversionJob<int16_t> >& jobs)
+{
+	vector<size_t> counts;
+	for(auto& j : jobs)
+		counts.push_back(j.m_count);
+
+	vector<SampleConversionChunk> chunks;
+	bool parallel = SplitSampleConversionJobs(counts, chunks);
+
+	#pragma omp parallel for schedule(dynamic) if(parallel)
+	for(size_t i=0; i<chunks.size(); i++)
+	{
+		auto& c = chunks[i];
+		auto& j = jobs[c.m_job];
+		Convert16BitSamplesBlock(
+			j.m_offs + c.m_start,
+			j.m_durs + c.m_start,
+			j.m_pout + c.m_start,
+			j.m_pin + c.m_start,
+			j.m_gain,
+			j.m_offset,
+			c.m_count,
+			j.m_ibase + c.m_start);
 	}
+}
 
-	//Small waveforms get done single threaded to avoid overhead
-	else
+/**
+	@brief Converts a single block of 16-bit ADC samples on the current thread, using the best available backend
+ */
+void Oscilloscope::Convert16BitSamplesBlock(
+	int64_t* offs, int64_t* durs, float* pout, int16_t* pin, float gain, float offset, size_t count, int64_t ibase)
+{
+	if(g_hasAvx512F)
+		Convert16BitSamplesAVX512F(offs, durs, pout, pin, gain, offset, count, ibase);
+	else if(g_hasAvx2)
 	{
-		if(g_hasAvx2)
-		{
-			if(g_hasFMA)
-				Convert16BitSamplesFMA(offs, durs, pout, pin, gain, offset, count, ibase);
-			else
-				Convert16BitSamplesAVX2(offs, durs, pout, pin, gain, offset, count, ibase);
-		}
+		if(g_hasFMA)
+			Convert16BitSamplesFMA(offs, durs, pout, pin, gain, offset, count, ibase);
 		else
-			Convert16BitSamplesGeneric(offs, durs, pout, pin, gain, offset, count, ibase);
+			Convert16BitSamplesAVX2(offs, durs, pout, pin, gain, offset, count, ibase);
 	}
+	else
+		Convert16BitSamplesGeneric(offs, durs, pout, pin, gain, offset, count, ibase);
 }
 
 /**
@@ -1252,3 +1306,172 @@ void Oscilloscope::Convert16BitSamplesFMA(
 		pout[k] = pin[k] * gain - offset;
 	}
 }
+
+/**
+	@brief AVX-512 version of Convert16BitSamples()
+ */
+__attribute__((target("avx512f")))
+void Oscilloscope::Convert16BitSamplesAVX512F(
+		int64_t* offs, int64_t* durs, float* pout, int16_t* pin, float gain, float offset, size_t count, int64_t ibase)
+{
+	size_t end = count - (count % 64);
+
+	__m512i all_ones	= _mm512_set1_epi64(1);
+	__m512i all_eights	= _mm512_set1_epi64(8);
+	__m512i counts		= _mm512_add_epi64(_mm512_set1_epi64(ibase), _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0));
+
+	__m512 gains = _mm512_set1_ps(gain);
+	__m512 offsets = _mm512_set1_ps(offset);
+
+	for(size_t k=0; k<end; k += 64)
+	{
+		//Load all 64 raw ADC samples, 16 at a time, then sign extend directly to 32 bit and convert to fp32
+		__m512 block0_float = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(
+			_mm256_loadu_si256(reinterpret_cast<__m256i*>(pin + k))));
+		__m512 block1_float = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(
+			_mm256_loadu_si256(reinterpret_cast<__m256i*>(pin + k + 16))));
+		__m512 block2_float = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(
+			_mm256_loadu_si256(reinterpret_cast<__m256i*>(pin + k + 32))));
+		__m512 block3_float = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(
+			_mm256_loadu_si256(reinterpret_cast<__m256i*>(pin + k + 48))));
+
+		//Scale and offset
+		block0_float = _mm512_fmsub_ps(block0_float, gains, offsets);
+		block1_float = _mm512_fmsub_ps(block1_float, gains, offsets);
+		block2_float = _mm512_fmsub_ps(block2_float, gains, offsets);
+		block3_float = _mm512_fmsub_ps(block3_float, gains, offsets);
+
+		//Store back to the output buffer
+		_mm512_storeu_ps(pout + k,		block0_float);
+		_mm512_storeu_ps(pout + k + 16,	block1_float);
+		_mm512_storeu_ps(pout + k + 32,	block2_float);
+		_mm512_storeu_ps(pout + k + 48,	block3_float);
+
+		//Fill offset and duration, 8 samples per store
+		for(size_t j=0; j<64; j += 8)
+		{
+			_mm512_storeu_si512(reinterpret_cast<__m512i*>(offs + k + j), counts);
+			_mm512_storeu_si512(reinterpret_cast<__m512i*>(durs + k + j), all_ones);
+			counts = _mm512_add_epi64(counts, all_eights);
+		}
+	}
+
+	//Get any extras we didn't get in the SIMD loop
+	for(size_t k=end; k<count; k++)
+	{
+		offs[k] = ibase + k;
+		durs[k] = 1;
+		pout[k] = pin[k] * gain - offset;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Benchmarking
+
+static void LogConversionThroughput(const char* name, double dt, size_t total)
+{
+	LogNotice("%-22s %9.2f ms  (%8.1f MSa/s)\n", name, dt * 1000, total * 1e-6 / dt);
+}
+
+/**
+	@brief Measures the throughput of every sample conversion backend available on this CPU and logs the results
+
+	The single threaded backends convert one channel at a time on the calling thread. "Per channel" makes one
+	multithreaded call per channel (the way drivers used to work), and "batched" converts every channel in one call.
+
+	@param count	Number of samples per channel
+	@param channels	Number of channels
+ */
+void Oscilloscope::BenchmarkSampleConversion(size_t count, size_t channels)
+{
+	size_t total = count * channels;
+
+	//Synthetic ADC data (a ramp is fine, we only care about speed)
+	vector<int8_t> raw8(total);
+	vector<int16_t> raw16(total);
+	for(size_t i=0; i<total; i++)
+	{
+		raw8[i] = i & 0xff;
+		raw16[i] = i & 0xffff;
+	}
+
+	vector<AnalogWaveform> wfms(channels);
+	vector< SampleConversionJob<int8_t> > jobs8;
+	vector< SampleConversionJob<int16_t> > jobs16;
+	for(size_t i=0; i<channels; i++)
+	{
+		jobs8.push_back(SampleConversionJob<int8_t>(&wfms[i], &raw8[i*count], 0.01, 0.5, count));
+		jobs16.push_back(SampleConversionJob<int16_t>(&wfms[i], &raw16[i*count], 0.01, 0.5, count));
+	}
+
+	//Touch every page once so we're not measuring page faults
+	Convert8BitSamples(jobs8);
+
+	typedef void (*Convert8Proc)(int64_t*, int64_t*, float*, int8_t*, float, float, size_t, int64_t);
+	typedef void (*Convert16Proc)(int64_t*, int64_t*, float*, int16_t*, float, float, size_t, int64_t);
+
+	LogNotice("Sample conversion benchmark (%zu channels x %zu samples)\n", channels, count);
+	LogIndenter li;
+
+	LogNotice("8-bit:\n");
+	{
+		LogIndenter li2;
+
+		const char* names[] = { "Generic", "AVX2", "AVX512F" };
+		Convert8Proc procs[] = { Convert8BitSamplesGeneric, Convert8BitSamplesAVX2, Convert8BitSamplesAVX512F };
+		bool enabled[] = { true, g_hasAvx2, g_hasAvx512F };
+		for(size_t n=0; n<3; n++)
+		{
+			if(!enabled[n])
+				continue;
+
+			double start = GetTime();
+			for(auto& j : jobs8)
+				procs[n](j.m_offs, j.m_durs, j.m_pout, j.m_pin, j.m_gain, j.m_offset, j.m_count, j.m_ibase);
+			LogConversionThroughput(names[n], GetTime() - start, total);
+		}
+
+		double start = GetTime();
+		for(auto& j : jobs8)
+			Convert8BitSamples(j.m_offs, j.m_durs, j.m_pout, j.m_pin, j.m_gain, j.m_offset, j.m_count, j.m_ibase);
+		LogConversionThroughput("Threaded, per channel", GetTime() - start, total);
+
+		start = GetTime();
+		Convert8BitSamples(jobs8);
+		LogConversionThroughput("Threaded, batched", GetTime() - start, total);
+	}
+
+	LogNotice("16-bit:\n");
+	{
+		LogIndenter li2;
+
+		const char* names[] = { "Generic", "AVX2", "AVX2 + FMA", "AVX512F" };
+		Convert16Proc procs[] =
+		{
+			Convert16BitSamplesGeneric,
+			Convert16BitSamplesAVX2,
+			Convert16BitSamplesFMA,
+			Convert16BitSamplesAVX512F
+		};
+		bool enabled[] = { true, g_hasAvx2, g_hasAvx2 && g_hasFMA, g_hasAvx512F };
+		for(size_t n=0; n<4; n++)
+		{
+			if(!enabled[n])
+				continue;
+
+			double start = GetTime();
+			for(auto& j : jobs16)
+				procs[n](j.m_offs, j.m_durs, j.m_pout, j.m_pin, j.m_gain, j.m_offset, j.m_count, j.m_ibase);
+			LogConversionThroughput(names[n], GetTime() - start, total);
+		}
+
+		double start = GetTime();
+		for(auto& j : jobs16)
+			Convert16BitSamples(j.m_offs, j.m_durs, j.m_pout, j.m_pin, j.m_gain, j.m_offset, j.m_count, j.m_ibase);
+		LogConversionThroughput("Threaded, per channel", GetTime() - start, total);
+
+		start = GetTime();
+		Convert16BitSamples(jobs16);
+		LogConversionThroughput("Threaded, batched", GetTime() - start, total);
+	}
+}
@@ -812,22 +812,121 @@ public:
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Sample format conversion
+public:
+
+	/**
+		@brief A block of raw ADC samples to be converted to floating point by the batched Convert*BitSamples()
+
+		Converting every channel of an acquisition in one batch lets the work be split across all cores at once, rather
+		than one channel at a time.
+	 */
+	template<class T>
+	class SampleConversionJob
+	{
+	public:
+		SampleConversionJob(
+			int64_t* offs, int64_t* durs, float* pout, T* pin, float gain, float offset, size_t count, int64_t ibase)
+		: m_offs(offs)
+		, m_durs(durs)
+		, m_pout(pout)
+		, m_pin(pin)
+		, m_gain(gain)
+		, m_offset(offset)
+		, m_count(count)
+		, m_ibase(ibase)
+		{}
+
+		///Resizes the waveform to fit the samples and converts straight into its buffers
+		SampleConversionJob(AnalogWaveform* cap, T* pin, float gain, float offset, size_t count)
+		: m_pin(pin)
+		, m_gain(gain)
+		, m_offset(offset)
+		, m_count(count)
+		, m_ibase(0)
+		{
+			//Use data() rather than &v[0], which is undefined when count is zero
+			cap->Resize(count);
+			m_offs = reinterpret_cast<int64_t*>(cap->m_offsets.data());
+			m_durs = reinterpret_cast<int64_t*>(cap->m_durations.data());
+			m_pout = reinterpret_cast<float*>(cap->m_samples.data());
+		}
+
+		int64_t* m_offs;
+		int64_t* m_durs;
+		float* m_pout;
+		T* m_pin;
+		float m_gain;
+		float m_offset;
+		size_t m_count;
+		int64_t m_ibase;
+	};
+
+	static void BenchmarkSampleConversion(size_t count = 64*1024*1024, size_t channels = 4);
+
 protected:
-	void Convert8BitSamples(
+	static void Convert8BitSamples(
+		int64_t* offs, int64_t* durs, float* pout, int8_t* pin, float gain, float offset, size_t count, int64_t ibase);
+	static void Convert8BitSamples(std::vector< SampleConversionJob<int8_t> >& jobs);
+	static void Convert8BitSamplesBlock(
+		int64_t* offs, int64_t* durs, float* pout, int8_t* pin, float gain, float offset, size_t count, int64_t ibase);
+	static void Convert8BitSamplesGeneric(
 		int64_t* offs, int64_t* durs, float* pout, int8_t* pin, float gain, float offset, size_t count, int64_t ibase);
-	void Convert8BitSamplesGeneric(
+	static void Convert8BitSamplesAVX2(
 		int64_t* offs, int64_t* durs, float* pout, int8_t* pin, float gain, float offset, size_t count, int64_t ibase);
-	void Convert8BitSamplesAVX2(
+	static void Convert8BitSamplesAVX512F(
 		int64_t* offs, int64_t* durs, float* pout, int8_t* pin, float gain, float offset, size_t count, int64_t ibase);
 
-	void Convert16BitSamples(
+	static void Convert16BitSamples(
 		int64_t* offs, int64_t* durs, float* pout, int16_t* pin, float gain, float offset, size_t count, int64_t ibase);
-	void Convert16BitSamplesGeneric(
+	static void Convert16BitSamples(std::vector< SampleConversionJob<int16_t> >& jobs);
+	static void Convert16BitSamplesBlock(
 		int64_t* offs, int64_t* durs, float* pout, int16_t* pin, float gain, float offset, size_t count, int64_t ibase);
-	void Convert16BitSamplesAVX2(
+	static void Convert16BitSamplesGeneric(
 		int64_t* offs, int64_t* durs, float* pout, int16_t* pin, float gain, float offset, size_t count, int64_t ibase);
-	void Convert16BitSamplesFMA(
+	static void Convert16BitSamplesAVX2(
 		int64_t* offs, int64_t* durs, float* pout, int16_t* pin, float gain, float offset, size_t count, int64_t ibase);
+	static void Convert16BitSamplesFMA(
+		int64_t* offs, int64_t* durs, float* pout, int16_t* pin, float gain, float offset, size_t count, int64_t ibase);
+	static void Convert16BitSamplesAVX512F(
+		int64_t* offs, int64_t* durs, float* pout, int16_t* pin, float gain, float offset, size_t count, int64_t ibase);
+
+	/**
+		@brief A contiguous range of one SampleConversionJob, processed by a single thread
+	 */
+	class SampleConversionChunk
+	{
+	public:
+		SampleConversionChunk(size_t job, size_t start, size_t count)
+		: m_job(job)
+		, m_start(start)
+		, m_count(count)
+		{}
+
+		size_t m_job;
+		size_t m_start;
+		size_t m_count;
+	};
+
+	static bool SplitSampleConversionJobs(
+		const std::vector<size_t>& counts, std::vector<SampleConversionChunk>& chunks);
+
+public:
+	/**
+		@brief Selects whether digital channels are delivered as PackedDigitalWaveform (one bit per sample) rather
+		than DigitalWaveform.
+
+		Off by default since not all consumers understand packed waveforms. Only affects drivers which support it.
+	 */
+	void SetDigitalWaveformPacking(bool pack)
+	{ m_packDigitalWaveforms = pack; }
+
+	///Checks if digital waveform packing is enabled
+	bool IsDigitalWaveformPackingEnabled()
+	{ return m_packDigitalWaveforms; }
+
+protected:
+	///True if digital channels should be delivered as PackedDigitalWaveform
+	bool m_packDigitalWaveforms;
 
 public:
 	bool HasPendingWaveforms();
@@ -835,10 +934,45 @@ public:
 	size_t GetPendingWaveformCount();
 	virtual bool PopPendingWaveform();
 
+	/**
+		@brief Sets what happens to new waveforms when the pending waveform queue is full
+
+		The default is POLICY_BLOCK, which never loses a waveform. Live views which would rather show the newest data
+		can opt into POLICY_DROP_OLDEST.
+
+		@param policy		The overflow policy
+		@param decimation	For POLICY_DECIMATE, keep one out of every this many waveforms
+	 */
+	void SetPendingWaveformPolicy(PendingWaveformQueue::Policy policy, size_t decimation = 1)
+	{ m_pendingWaveforms.SetPolicy(policy, decimation); }
+
+	PendingWaveformQueue::Policy GetPendingWaveformPolicy()
+	{ return m_pendingWaveforms.GetPolicy(); }
+
+	/**
+		@brief Sets the maximum number of waveforms which can be pending at once
+
+		Discards any pending waveforms. Must not be called while the acquisition thread is running.
+	 */
+	void SetPendingWaveformCapacity(size_t capacity)
+	{ m_pendingWaveforms.SetCapacity(capacity); }
+
+	size_t GetPendingWaveformCapacity()
+	{ return m_pendingWaveforms.GetCapacity(); }
+
+	///Gets depth, drop and latency counters for the pending waveform queue
+	PendingWaveformStatistics GetPendingWaveformStatistics()
+	{ return m_pendingWaveforms.GetStatistics(); }
+
+	void ResetPendingWaveformStatistics()
+	{ m_pendingWaveforms.ResetStatistics(); }
+
 protected:
-	typedef std::map<OscilloscopeChannel*, WaveformBase*> SequenceSet;
-	std::list<SequenceSet> m_pendingWaveforms;
-	std::mutex m_pendingWaveformsMutex;
+	typedef PendingWaveformQueue::SequenceSet SequenceSet;
+
+	///Waveforms which have been acquired but not yet consumed
+	PendingWaveformQueue m_pendingWaveforms;
+
 	std::recursive_mutex m_mutex;
 
 protected:
@@ -347,7 +347,8 @@ void OscilloscopeChannel::SetData(WaveformBase* pNew, size_t stream)
 	if(m_streamData[stream] == pNew)
 		return;
 
+	//Hand the old waveform back to the pool so its buffers can be reused
 	if(m_streamData[stream] != NULL)
-		delete m_streamData[stream];
+		g_waveformPool.Release(m_streamData[stream]);
 	m_streamData[stream] = pNew;
 }
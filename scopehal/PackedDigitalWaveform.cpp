@@ -0,0 +1,475 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PackedDigitalWaveform
+ */
+
+#include "scopehal.h"
+#include "PackedDigitalWaveform.h"
+#include <immintrin.h>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+PackedDigitalWaveform::PackedDigitalWaveform()
+	: m_size(0)
+	, m_unpacked(NULL)
+{
+	m_densePacked = true;
+}
+
+PackedDigitalWaveform::~PackedDigitalWaveform()
+{
+	delete m_unpacked;
+	m_unpacked = NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Sizing
+
+/**
+	@brief Changes the number of samples in the waveform
+
+	Any newly added samples are zero. Invalidates the unpacked copy, if there is one, so this must not be called once
+	the waveform has been handed to consumers.
+ */
+void PackedDigitalWaveform::Resize(size_t size)
+{
+	m_size = size;
+	m_words.resize((size + 63) / 64, 0);
+
+	//Keep the unused bits at the end of the last word cleared
+	if(size & 63)
+		m_words.back() &= (1ULL << (size & 63)) - 1;
+
+	delete m_unpacked;
+	m_unpacked = NULL;
+}
+
+void PackedDigitalWaveform::clear()
+{
+	Resize(0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Packing
+
+/**
+	@brief Loads the waveform from an array of samples stored one per byte (any nonzero value is a 1)
+
+	@param samples	Input samples
+	@param count	Number of samples
+ */
+void PackedDigitalWaveform::PackBytes(const uint8_t* samples, size_t count)
+{
+	Resize(count);
+
+	if(g_hasAvx2)
+		PackBytesAVX2(samples, count);
+	else
+		PackBytesGeneric(samples, count);
+}
+
+/**
+	@brief Generic backend for PackBytes()
+ */
+void PackedDigitalWaveform::PackBytesGeneric(const uint8_t* samples, size_t count)
+{
+	size_t nwords = m_words.size();
+	for(size_t w=0; w<nwords; w++)
+	{
+		size_t base = w*64;
+		size_t n = min((size_t)64, count - base);
+
+		uint64_t word = 0;
+		for(size_t b=0; b<n; b++)
+		{
+			if(samples[base + b])
+				word |= (1ULL << b);
+		}
+		m_words[w] = word;
+	}
+}
+
+/**
+	@brief Optimized version of PackBytes()
+
+	Compares 32 bytes against zero at once and uses movemask to pull out one bit per byte.
+ */
+__attribute__((target("avx2")))
+void PackedDigitalWaveform::PackBytesAVX2(const uint8_t* samples, size_t count)
+{
+	size_t fullwords = count / 64;
+	__m256i zero = _mm256_setzero_si256();
+
+	for(size_t w=0; w<fullwords; w++)
+	{
+		__m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + w*64));
+		__m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + w*64 + 32));
+
+		//movemask gives us a 1 for each byte that IS zero, so invert
+		uint32_t lozero = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, zero));
+		uint32_t hizero = _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, zero));
+		m_words[w] = ~( (uint64_t)lozero | ((uint64_t)hizero << 32) );
+	}
+
+	//Get any extras we didn't get in the SIMD loop
+	if(fullwords < m_words.size())
+	{
+		size_t base = fullwords*64;
+		uint64_t word = 0;
+		for(size_t b=0; base+b < count; b++)
+		{
+			if(samples[base + b])
+				word |= (1ULL << b);
+		}
+		m_words[fullwords] = word;
+	}
+}
+
+/**
+	@brief Loads the waveform from one bit of an array of 16-bit samples (e.g. one line of a logic analyzer pod)
+
+	@param samples	Input samples
+	@param count	Number of samples
+	@param bit		Index of the bit to extract from each sample
+ */
+void PackedDigitalWaveform::PackBits(const uint16_t* samples, size_t count, size_t bit)
+{
+	Resize(count);
+
+	size_t nwords = m_words.size();
+	for(size_t w=0; w<nwords; w++)
+	{
+		size_t base = w*64;
+		size_t n = min((size_t)64, count - base);
+
+		uint64_t word = 0;
+		for(size_t b=0; b<n; b++)
+			word |= (uint64_t)((samples[base + b] >> bit) & 1) << b;
+		m_words[w] = word;
+	}
+}
+
+/**
+	@brief Loads eight waveforms at once from the low eight bits of an array of 16-bit samples
+
+	This is much faster than eight calls to PackBits() since the input is only read once.
+
+	@param samples	Input samples
+	@param count	Number of samples
+	@param wfms		Array of eight waveforms. Bit j of each sample goes to wfms[j].
+ */
+void PackedDigitalWaveform::PackPod(const uint16_t* samples, size_t count, PackedDigitalWaveform** wfms)
+{
+	for(size_t j=0; j<8; j++)
+		wfms[j]->Resize(count);
+	if(count == 0)
+		return;
+
+	uint64_t* words[8];
+	for(size_t j=0; j<8; j++)
+		words[j] = &wfms[j]->m_words[0];
+
+	size_t start = 0;
+	if(g_hasAvx2)
+	{
+		size_t nwords = count / 64;
+		PackPodAVX2(samples, nwords, words);
+		start = nwords * 64;
+	}
+	PackPodGeneric(samples, start, count, words);
+}
+
+/**
+	@brief Generic backend for PackPod(), packs samples [start, count). Start must be a multiple of 64.
+ */
+void PackedDigitalWaveform::PackPodGeneric(const uint16_t* samples, size_t start, size_t count, uint64_t** words)
+{
+	for(size_t base=start; base<count; base += 64)
+	{
+		size_t n = min((size_t)64, count - base);
+
+		uint64_t w[8] = {0};
+		for(size_t b=0; b<n; b++)
+		{
+			uint16_t s = samples[base + b];
+			for(size_t j=0; j<8; j++)
+				w[j] |= (uint64_t)((s >> j) & 1) << b;
+		}
+
+		for(size_t j=0; j<8; j++)
+			words[j][base / 64] = w[j];
+	}
+}
+
+/**
+	@brief AVX2 backend for PackPod(), packs the first nwords*64 samples
+ */
+__attribute__((target("avx2")))
+void PackedDigitalWaveform::PackPodAVX2(const uint16_t* samples, size_t nwords, uint64_t** words)
+{
+	__m256i lowbyte = _mm256_set1_epi16(0x00ff);
+	for(size_t w=0; w<nwords; w++)
+	{
+		const __m256i* p = reinterpret_cast<const __m256i*>(samples + w*64);
+
+		//Squash 64 samples down to one byte each
+		__m256i a = _mm256_and_si256(_mm256_loadu_si256(p), lowbyte);
+		__m256i b = _mm256_and_si256(_mm256_loadu_si256(p + 1), lowbyte);
+		__m256i c = _mm256_and_si256(_mm256_loadu_si256(p + 2), lowbyte);
+		__m256i d = _mm256_and_si256(_mm256_loadu_si256(p + 3), lowbyte);
+
+		//Pack works within 128-bit lanes, so fix up the order afterwards
+		__m256i lo = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+		__m256i hi = _mm256_permute4x64_epi64(_mm256_packus_epi16(c, d), 0xd8);
+
+		//Shift each bit in turn up to the MSB of its byte and grab it
+		for(int j=0; j<8; j++)
+		{
+			__m128i shift = _mm_cvtsi32_si128(7 - j);
+			uint32_t mlo = _mm256_movemask_epi8(_mm256_sll_epi16(lo, shift));
+			uint32_t mhi = _mm256_movemask_epi8(_mm256_sll_epi16(hi, shift));
+			words[j][w] = mlo | ((uint64_t)mhi << 32);
+		}
+	}
+}
+
+/**
+	@brief Sets samples [start, end) to 1
+ */
+static void SetBitRange(uint64_t* words, size_t start, size_t end)
+{
+	if(start >= end)
+		return;
+
+	size_t wstart = start / 64;
+	size_t wend = (end - 1) / 64;
+	uint64_t startmask = ~0ULL << (start & 63);
+	uint64_t endmask = ~0ULL >> (63 - ((end - 1) & 63));
+
+	if(wstart == wend)
+	{
+		words[wstart] |= (startmask & endmask);
+		return;
+	}
+
+	words[wstart] |= startmask;
+	for(size_t w=wstart+1; w<wend; w++)
+		words[w] = ~0ULL;
+	words[wend] |= endmask;
+}
+
+/**
+	@brief Loads the waveform from a conventional digital waveform
+
+	Sparse waveforms are expanded to one bit per timebase unit.
+ */
+void PackedDigitalWaveform::Pack(DigitalWaveform* wfm)
+{
+	m_timescale = wfm->m_timescale;
+	m_startTimestamp = wfm->m_startTimestamp;
+	m_startFemtoseconds = wfm->m_startFemtoseconds;
+	m_triggerPhase = wfm->m_triggerPhase;
+
+	size_t len = wfm->m_samples.size();
+	if(wfm->m_densePacked)
+	{
+		PackBytes(reinterpret_cast<const uint8_t*>(&wfm->m_samples[0]), len);
+		return;
+	}
+
+	if(len == 0)
+	{
+		Resize(0);
+		return;
+	}
+
+	Resize(wfm->m_offsets[len-1] + wfm->m_durations[len-1]);
+	uint64_t* words = &m_words[0];
+	for(size_t i=0; i<len; i++)
+	{
+		if(wfm->m_samples[i])
+			SetBitRange(words, wfm->m_offsets[i], wfm->m_offsets[i] + wfm->m_durations[i]);
+	}
+}
+
+/**
+	@brief Expands the waveform into a conventional (dense packed) digital waveform
+ */
+void PackedDigitalWaveform::Unpack(DigitalWaveform* wfm)
+{
+	wfm->m_timescale = m_timescale;
+	wfm->m_startTimestamp = m_startTimestamp;
+	wfm->m_startFemtoseconds = m_startFemtoseconds;
+	wfm->m_triggerPhase = m_triggerPhase;
+	wfm->m_densePacked = true;
+
+	wfm->Resize(m_size);
+	for(size_t i=0; i<m_size; i++)
+	{
+		wfm->m_offsets[i] = i;
+		wfm->m_durations[i] = 1;
+		wfm->m_samples[i] = GetSample(i);
+	}
+}
+
+/**
+	@brief Expands the waveform into a conventional digital waveform, merging runs of identical samples
+
+	@param wfm		Output waveform
+	@param keepTail	Number of samples at the end of the waveform which are never merged
+ */
+void PackedDigitalWaveform::UnpackDeduplicated(DigitalWaveform* wfm, size_t keepTail)
+{
+	wfm->m_timescale = m_timescale;
+	wfm->m_startTimestamp = m_startTimestamp;
+	wfm->m_startFemtoseconds = m_startFemtoseconds;
+	wfm->m_triggerPhase = m_triggerPhase;
+	wfm->m_densePacked = false;
+
+	if(m_size == 0)
+	{
+		wfm->clear();
+		return;
+	}
+
+	//Bit i of starts is set if sample i begins a new run
+	size_t nwords = m_words.size();
+	vector<uint64_t> starts(nwords);
+	uint64_t carry = 0;
+	for(size_t w=0; w<nwords; w++)
+	{
+		uint64_t word = m_words[w];
+		starts[w] = word ^ ((word << 1) | carry);
+		carry = word >> 63;
+	}
+	starts[0] |= 1;
+	for(size_t i = (m_size > keepTail) ? m_size - keepTail : 1; i < m_size; i++)
+		starts[i / 64] |= (1ULL << (i & 63));
+	if(m_size & 63)
+		starts.back() &= (1ULL << (m_size & 63)) - 1;
+
+	//Size the output exactly, then fill it
+	size_t len = 0;
+	for(auto w : starts)
+		len += __builtin_popcountll(w);
+	wfm->Resize(len);
+
+	int64_t* offs = reinterpret_cast<int64_t*>(&wfm->m_offsets[0]);
+	int64_t* durs = reinterpret_cast<int64_t*>(&wfm->m_durations[0]);
+	bool* out = reinterpret_cast<bool*>(&wfm->m_samples[0]);
+	size_t k = 0;
+	for(size_t w=0; w<nwords; w++)
+	{
+		uint64_t word = starts[w];
+		while(word)
+		{
+			size_t i = w*64 + __builtin_ctzll(word);
+			word &= word - 1;
+
+			offs[k] = i;
+			out[k] = GetSample(i);
+			if(k > 0)
+				durs[k-1] = i - offs[k-1];
+			k ++;
+		}
+	}
+	durs[len-1] = m_size - offs[len-1];
+}
+
+/**
+	@brief Gets a conventional DigitalWaveform with the same contents as this one
+
+	The expanded waveform is created on first use and owned by this object. Safe to call from multiple threads.
+ */
+DigitalWaveform* PackedDigitalWaveform::GetUnpacked()
+{
+	lock_guard<mutex> lock(m_unpackedMutex);
+	if(m_unpacked == NULL)
+	{
+		m_unpacked = new DigitalWaveform;
+		Unpack(m_unpacked);
+	}
+	return m_unpacked;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Edge finding
+
+/**
+	@brief Finds the indexes of edges in the waveform, processing 64 samples at a time
+
+	An edge at index i means sample i differs from sample i-1.
+
+	@param rising	Report rising edges
+	@param falling	Report falling edges
+	@param istart	Index of the first sample to consider
+	@param indexes	Indexes of the edges are appended to this vector
+ */
+void PackedDigitalWaveform::FindEdges(bool rising, bool falling, size_t istart, vector<size_t>& indexes)
+{
+	size_t nwords = m_words.size();
+	if(nwords == 0)
+		return;
+
+	for(size_t w=istart / 64; w<nwords; w++)
+	{
+		//Shift in the last sample of the previous word so bit b of prev is sample b-1.
+		//Sample -1 doesn't exist, so treat it as equal to sample 0 (no edge at index 0).
+		uint64_t cur = m_words[w];
+		uint64_t carry = (w > 0) ? (m_words[w-1] >> 63) : (cur & 1);
+		uint64_t prev = (cur << 1) | carry;
+
+		uint64_t mask = 0;
+		if(rising)
+			mask |= cur & ~prev;
+		if(falling)
+			mask |= ~cur & prev;
+
+		//Trim anything before the start or past the end of the waveform
+		size_t base = w*64;
+		if(istart > base)
+			mask &= ~0ULL << (istart - base);
+		if(m_size - base < 64)
+			mask &= (1ULL << (m_size - base)) - 1;
+
+		while(mask)
+		{
+			size_t b = __builtin_ctzll(mask);
+			mask &= mask - 1;
+			indexes.push_back(base + b);
+		}
+	}
+}
@@ -0,0 +1,134 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PackedDigitalWaveform
+ */
+
+#ifndef PackedDigitalWaveform_h
+#define PackedDigitalWaveform_h
+
+#include <mutex>
+#include "Waveform.h"
+
+/**
+	@brief A dense packed digital waveform stored one bit per sample
+
+	Sample i is bit (i % 64) of m_words[i / 64]. Unused bits at the end of the last word are always zero.
+
+	Timestamps are implicit: the waveform is always dense packed and m_offsets / m_durations are left empty, so a
+	100M point capture takes 12.5 MB rather than the 1.7 GB needed by a DigitalWaveform with full timestamps.
+
+	Filters which know how to handle packed data can work on the words directly (see FindEdges()). For everything
+	else, GetUnpacked() expands the waveform to a conventional DigitalWaveform on first use.
+ */
+class PackedDigitalWaveform : public WaveformBase
+{
+public:
+	PackedDigitalWaveform();
+	virtual ~PackedDigitalWaveform();
+
+	///@brief Sample data, 64 samples per word, LSB first
+	std::vector<uint64_t, AlignedAllocator<uint64_t, 64> > m_words;
+
+	virtual size_t size() const
+	{ return m_size; }
+
+	virtual size_t capacity() const
+	{ return m_words.capacity() * 64; }
+
+	virtual size_t GetAllocatedBytes() const
+	{ return WaveformBase::GetAllocatedBytes() + m_words.capacity() * sizeof(uint64_t); }
+
+	virtual void Resize(size_t size);
+	virtual void clear();
+
+	///Gets the value of a single sample
+	bool GetSample(size_t i) const
+	{ return (m_words[i >> 6] >> (i & 63)) & 1; }
+
+	///Sets the value of a single sample
+	void SetSample(size_t i, bool value)
+	{
+		uint64_t bit = 1ULL << (i & 63);
+		if(value)
+			m_words[i >> 6] |= bit;
+		else
+			m_words[i >> 6] &= ~bit;
+	}
+
+	/**
+		@brief Gets up to 64 consecutive samples starting at sample i, with sample i in bit 0
+
+		Samples past the end of the waveform read as zero.
+	 */
+	uint64_t GetBits(size_t i, size_t count = 64) const
+	{
+		size_t w = i >> 6;
+		size_t shift = i & 63;
+		size_t nwords = m_words.size();
+
+		uint64_t ret = (w < nwords) ? (m_words[w] >> shift) : 0;
+		if(shift && (w+1 < nwords) )
+			ret |= m_words[w+1] << (64 - shift);
+		if(count < 64)
+			ret &= (1ULL << count) - 1;
+		return ret;
+	}
+
+	void PackBytes(const uint8_t* samples, size_t count);
+	void PackBits(const uint16_t* samples, size_t count, size_t bit);
+	static void PackPod(const uint16_t* samples, size_t count, PackedDigitalWaveform** wfms);
+
+	void Pack(DigitalWaveform* wfm);
+	void Unpack(DigitalWaveform* wfm);
+	void UnpackDeduplicated(DigitalWaveform* wfm, size_t keepTail = 0);
+	DigitalWaveform* GetUnpacked();
+
+	void FindEdges(bool rising, bool falling, size_t istart, std::vector<size_t>& indexes);
+
+protected:
+	void PackBytesGeneric(const uint8_t* samples, size_t count);
+	void PackBytesAVX2(const uint8_t* samples, size_t count);
+	static void PackPodGeneric(const uint16_t* samples, size_t start, size_t count, uint64_t** words);
+	static void PackPodAVX2(const uint16_t* samples, size_t nwords, uint64_t** words);
+
+	///@brief Number of samples in the waveform
+	size_t m_size;
+
+	///@brief Lazily expanded copy of the waveform for code which can't use packed data
+	DigitalWaveform* m_unpacked;
+
+	///@brief Mutex protecting m_unpacked
+	std::mutex m_unpackedMutex;
+};
+
+#endif
@@ -30,6 +30,8 @@
 #include "scopehal.h"
 #include "PacketDecoder.h"
 
+using namespace std;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Color schemes
 
@@ -59,24 +61,496 @@ Packet::~Packet()
 {
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PacketTable
+
+PacketTable::PacketTable()
+{
+	Clear();
+}
+
+/**
+	@brief Removes all rows, keeping the column definitions
+ */
+void PacketTable::Clear()
+{
+	for(auto& c : m_cells)
+		c.clear();
+
+	m_offsets.clear();
+	m_lengths.clear();
+	m_foregroundColors.clear();
+	m_backgroundColors.clear();
+	m_arena.clear();
+	m_dataStarts.clear();
+	m_dataLengths.clear();
+	m_strings.clear();
+	m_stringIDs.clear();
+
+	//Palette entries 0 and 1 are the defaults used by Packet
+	m_palette.clear();
+	m_paletteIDs.clear();
+	InternColor(PacketDecoder::m_backgroundColors[PacketDecoder::PROTO_COLOR_DEFAULT]);
+	InternColor(Gdk::Color("#ffffff"));
+}
+
+/**
+	@brief Replaces the column definitions. Must only be called when the table is empty.
+ */
+void PacketTable::SetColumns(const vector<string>& names)
+{
+	m_columnNames.clear();
+	m_columnIDs.clear();
+	m_cells.clear();
+
+	for(auto& name : names)
+		GetColumn(name);
+}
+
+/**
+	@brief Gets the ID of a header column, adding it if it doesn't exist yet
+ */
+size_t PacketTable::GetColumn(const string& name)
+{
+	auto it = m_columnIDs.find(name);
+	if(it != m_columnIDs.end())
+		return it->second;
+
+	size_t id = m_columnNames.size();
+	m_columnNames.push_back(name);
+	m_columnIDs[name] = id;
+
+	Cell empty = {0, FORMAT_EMPTY, 0};
+	m_cells.push_back(vector<Cell>(GetRowCount(), empty));
+	return id;
+}
+
+/**
+	@brief Appends a new row with no headers or data and default colors
+
+	@param offset	Start of the packet (femtoseconds from the start of the capture)
+
+	@return Index of the new row
+ */
+size_t PacketTable::AddRow(int64_t offset)
+{
+	size_t row = m_offsets.size();
+
+	m_offsets.push_back(offset);
+	m_lengths.push_back(0);
+	m_backgroundColors.push_back(0);
+	m_foregroundColors.push_back(1);
+	m_dataStarts.push_back(m_arena.size());
+	m_dataLengths.push_back(0);
+
+	Cell empty = {0, FORMAT_EMPTY, 0};
+	for(auto& c : m_cells)
+		c.push_back(empty);
+
+	return row;
+}
+
+/**
+	@brief Discards the most recently added row (for example a packet which turned out to be malformed)
+ */
+void PacketTable::RemoveLastRow()
+{
+	size_t row = m_offsets.size() - 1;
+
+	//Give the row's bytes back to the arena if nothing was stored after them
+	if(m_dataStarts[row] + m_dataLengths[row] == m_arena.size())
+		m_arena.resize(m_dataStarts[row]);
+
+	m_offsets.pop_back();
+	m_lengths.pop_back();
+	m_backgroundColors.pop_back();
+	m_foregroundColors.pop_back();
+	m_dataStarts.pop_back();
+	m_dataLengths.pop_back();
+
+	for(auto& c : m_cells)
+		c.pop_back();
+}
+
+void PacketTable::SetMAC(size_t row, size_t col, const uint8_t* mac)
+{
+	uint64_t value = 0;
+	for(int i=0; i<6; i++)
+		value = (value << 8) | mac[i];
+	SetCell(row, col, value, FORMAT_MAC, 0);
+}
+
+/**
+	@brief Converts a cell to the text shown in the protocol analyzer
+ */
+string PacketTable::FormatCell(size_t row, size_t col) const
+{
+	auto& cell = m_cells[col][row];
+
+	char tmp[32];
+	switch(cell.m_format)
+	{
+		case FORMAT_TEXT:
+			return m_strings[cell.m_value];
+
+		case FORMAT_DECIMAL:
+			snprintf(tmp, sizeof(tmp), "%llu", (unsigned long long)cell.m_value);
+			return tmp;
+
+		case FORMAT_HEX:
+			snprintf(tmp, sizeof(tmp), "%0*llx", cell.m_width, (unsigned long long)cell.m_value);
+			return tmp;
+
+		case FORMAT_HEX_UPPER:
+			snprintf(tmp, sizeof(tmp), "%0*llX", cell.m_width, (unsigned long long)cell.m_value);
+			return tmp;
+
+		case FORMAT_MAC:
+			snprintf(tmp, sizeof(tmp), "%02x:%02x:%02x:%02x:%02x:%02x",
+				(int)(cell.m_value >> 40) & 0xff,
+				(int)(cell.m_value >> 32) & 0xff,
+				(int)(cell.m_value >> 24) & 0xff,
+				(int)(cell.m_value >> 16) & 0xff,
+				(int)(cell.m_value >> 8) & 0xff,
+				(int)cell.m_value & 0xff);
+			return tmp;
+
+		case FORMAT_HEXDUMP:
+			{
+				string ret;
+				auto data = GetData(row);
+				for(size_t i=0; i<m_dataLengths[row]; i++)
+				{
+					snprintf(tmp, sizeof(tmp), "%02x ", data[i]);
+					ret += tmp;
+				}
+				return ret + m_strings[cell.m_value];
+			}
+
+		default:
+			return "";
+	}
+}
+
+void PacketTable::AppendData(size_t row, const uint8_t* data, size_t len)
+{
+	if(m_dataStarts[row] + m_dataLengths[row] != m_arena.size())
+		MoveDataToEnd(row);
+	m_arena.insert(m_arena.end(), data, data + len);
+	m_dataLengths[row] += len;
+}
+
+/**
+	@brief Shortens the data of a row (for example to strip a trailing checksum)
+ */
+void PacketTable::TruncateData(size_t row, size_t len)
+{
+	if(len >= m_dataLengths[row])
+		return;
+
+	if(m_dataStarts[row] + m_dataLengths[row] == m_arena.size())
+		m_arena.resize(m_dataStarts[row] + len);
+	m_dataLengths[row] = len;
+}
+
+/**
+	@brief Moves the bytes of a row to the end of the arena so more can be appended.
+
+	Decoders normally fill one packet at a time, so this is only needed when data is added to an older row after a
+	newer one has already stored bytes.
+ */
+void PacketTable::MoveDataToEnd(size_t row)
+{
+	size_t start = m_arena.size();
+	size_t len = m_dataLengths[row];
+	m_arena.resize(start + len);
+	memcpy(&m_arena[start], &m_arena[m_dataStarts[row]], len);
+	m_dataStarts[row] = start;
+}
+
+uint32_t PacketTable::InternString(const string& text)
+{
+	auto it = m_stringIDs.find(text);
+	if(it != m_stringIDs.end())
+		return it->second;
+
+	uint32_t id = m_strings.size();
+	m_strings.push_back(text);
+	m_stringIDs[text] = id;
+	return id;
+}
+
+uint16_t PacketTable::InternColor(const Gdk::Color& color)
+{
+	uint64_t key =
+		((uint64_t)color.get_red() << 32) |
+		((uint64_t)color.get_green() << 16) |
+		color.get_blue();
+
+	auto it = m_paletteIDs.find(key);
+	if(it != m_paletteIDs.end())
+		return it->second;
+
+	uint16_t id = m_palette.size();
+	m_palette.push_back(color);
+	m_paletteIDs[key] = id;
+	return id;
+}
+
+/**
+	@brief Saves the headers, colors, and data of a row which is still being decoded
+
+	Values go in state under "row.*" names so they don't collide with the decoder's own state. The row's timing isn't
+	saved since the packet will get a new start time in the next waveform.
+ */
+void PacketTable::SaveRow(size_t row, DecoderState& state) const
+{
+	state.SetInt("row", 1);
+
+	for(size_t col=0; col<m_columnNames.size(); col++)
+	{
+		auto& cell = m_cells[col][row];
+		if(cell.m_format == FORMAT_EMPTY)
+			continue;
+
+		string prefix = "row." + m_columnNames[col];
+		state.SetInt(prefix + ".format", cell.m_format);
+		state.SetInt(prefix + ".width", cell.m_width);
+		if( (cell.m_format == FORMAT_TEXT) || (cell.m_format == FORMAT_HEXDUMP) )
+			state.SetString(prefix + ".text", m_strings[cell.m_value]);
+		else
+			state.SetInt(prefix + ".value", cell.m_value);
+	}
+
+	state.SetString("row.fg", GetForegroundColor(row).to_string());
+	state.SetString("row.bg", GetBackgroundColor(row).to_string());
+	state.SetBytes("row.data", GetData(row), GetDataSize(row));
+}
+
+/**
+	@brief Appends a row saved by SaveRow()
+
+	@param state	Carried decoder state
+	@param offset	Start of the row in the new waveform (femtoseconds)
+
+	@return Index of the new row
+ */
+size_t PacketTable::RestoreRow(const DecoderState& state, int64_t offset)
+{
+	size_t row = AddRow(offset);
+
+	for(size_t col=0; col<m_columnNames.size(); col++)
+	{
+		string prefix = "row." + m_columnNames[col];
+		if(!state.HasInt(prefix + ".format"))
+			continue;
+
+		auto format = static_cast<CellFormat>(state.GetInt(prefix + ".format"));
+		uint8_t width = state.GetInt(prefix + ".width");
+		if( (format == FORMAT_TEXT) || (format == FORMAT_HEXDUMP) )
+			SetCell(row, col, InternString(state.GetString(prefix + ".text")), format, width);
+		else
+			SetCell(row, col, state.GetInt(prefix + ".value"), format, width);
+	}
+
+	SetForegroundColor(row, Gdk::Color(state.GetString("row.fg")));
+	SetBackgroundColor(row, Gdk::Color(state.GetString("row.bg")));
+
+	auto& data = state.GetBytes("row.data");
+	if(!data.empty())
+		AppendData(row, &data[0], data.size());
+
+	return row;
+}
+
+/**
+	@brief Creates a standalone Packet object with the content of a row
+ */
+Packet* PacketTable::CreatePacket(size_t row) const
+{
+	auto pack = new Packet;
+	pack->m_offset = m_offsets[row];
+	pack->m_len = m_lengths[row];
+	pack->m_displayForegroundColor = GetForegroundColor(row);
+	pack->m_displayBackgroundColor = GetBackgroundColor(row);
+
+	for(size_t col=0; col<m_cells.size(); col++)
+	{
+		if(HasCell(row, col))
+			pack->m_headers[m_columnNames[col]] = FormatCell(row, col);
+	}
+
+	auto data = GetData(row);
+	pack->m_data.assign(data, data + m_dataLengths[row]);
+	return pack;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
 PacketDecoder::PacketDecoder(OscilloscopeChannel::ChannelType type, const std::string& color, Category cat)
 	: Filter(type, color, cat)
+	, m_materializedRows(0)
+	, m_exportLinkType(0)
+	, m_cachedExportRotate(0)
+	, m_exportWriter(NULL)
 {
 }
 
 PacketDecoder::~PacketDecoder()
 {
-	ClearPackets();
+	delete m_exportWriter;
+	m_exportWriter = NULL;
+
+	for(auto p : m_packets)
+		delete p;
+	for(size_t row=m_materializedRows; row<m_rowPackets.size(); row++)
+		delete m_rowPackets[row];
 }
 
+/**
+	@brief Removes all packets from the previous decode
+ */
 void PacketDecoder::ClearPackets()
 {
+	//Rows which were materialized are in both lists, so only delete them once
 	for(auto p : m_packets)
 		delete p;
 	m_packets.clear();
+	for(size_t row=m_materializedRows; row<m_rowPackets.size(); row++)
+		delete m_rowPackets[row];
+	m_rowPackets.clear();
+
+	m_table.Clear();
+	m_materializedRows = 0;
+
+	//Pick up any change to the export file even if this decode doesn't produce any packets
+	UpdateExport();
+
+	//Set up the header columns the first time through (can't be done in the constructor since GetHeaders() is virtual)
+	if(m_table.GetColumnCount() == 0)
+		m_table.SetColumns(GetHeaders());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Capture export
+
+/**
+	@brief Adds parameters for exporting decoded packets to a pcapng file
+
+	Call from the constructor of decoders whose packets map onto a standard link type, then call ExportPacket() for
+	each packet as it's decoded. File I/O happens on a background thread (see PcapngWriter).
+
+	@param linktype		Link type of the exported packets (see PcapngWriter::LinkType)
+ */
+void PacketDecoder::CreateExportParameters(uint16_t linktype)
+{
+	m_exportLinkType = linktype;
+
+	m_exportFileName = "PCAP Output";
+	m_parameters[m_exportFileName] = FilterParameter(FilterParameter::TYPE_FILENAME, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_exportFileName].m_fileFilterMask = "*.pcapng";
+	m_parameters[m_exportFileName].m_fileFilterName = "PCAPNG files (*.pcapng)";
+	m_parameters[m_exportFileName].m_fileIsOutput = true;
+
+	m_exportRotateName = "PCAP Rotate Size (MB)";
+	m_parameters[m_exportRotateName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_exportRotateName].SetIntVal(0);
+}
+
+/**
+	@brief Opens, reopens, or closes the export file if the export parameters have changed
+ */
+void PacketDecoder::UpdateExport()
+{
+	if(m_exportLinkType == 0)
+		return;
+
+	auto path = m_parameters[m_exportFileName].GetFileName();
+	auto rotate = m_parameters[m_exportRotateName].GetIntVal();
+	if( (path == m_cachedExportPath) && (rotate == m_cachedExportRotate) )
+		return;
+	m_cachedExportPath = path;
+	m_cachedExportRotate = rotate;
+
+	delete m_exportWriter;
+	m_exportWriter = NULL;
+	if(path.empty())
+		return;
+
+	m_exportWriter = new PcapngWriter;
+	uint64_t rotateBytes = (rotate > 0) ? (rotate * 1024 * 1024) : 0;
+	if(!m_exportWriter->Open(path, m_exportLinkType, GetDisplayName(), rotateBytes))
+	{
+		delete m_exportWriter;
+		m_exportWriter = NULL;
+	}
+}
+
+/**
+	@brief Queues a decoded packet for export, if an export file is configured
+
+	Changes to the export parameters are picked up by ClearPackets(), which must be called earlier in the same decode.
+
+	@param cap		The waveform being decoded (for the capture timestamp)
+	@param offset	Start of the packet, in femtoseconds from the start of the capture
+	@param data		Packet contents, in the format required by the link type
+	@param len		Length of the packet
+ */
+void PacketDecoder::ExportPacket(const WaveformBase* cap, int64_t offset, const uint8_t* data, size_t len)
+{
+	if(!m_exportWriter)
+		return;
+
+	time_t sec = cap->m_startTimestamp;
+	int64_t fs = cap->m_startFemtoseconds + offset;
+	sec += fs / FS_PER_SECOND;
+	fs %= (int64_t)FS_PER_SECOND;
+	if(fs < 0)
+	{
+		sec --;
+		fs += FS_PER_SECOND;
+	}
+
+	m_exportWriter->WritePacket(sec, fs, data, len);
+}
+
+/**
+	@brief Creates Packet objects in m_packets for any rows of m_table which don't have one yet
+ */
+void PacketDecoder::MaterializePackets()
+{
+	size_t rows = m_table.GetRowCount();
+	for(; m_materializedRows < rows; m_materializedRows ++)
+		m_packets.push_back(GetRowPacket(m_materializedRows));
+}
+
+/**
+	@brief Gets a single packet as a Packet object, converting only that row of the packet table if needed
+
+	Packets created directly by the decoder come first, followed by the rows of the packet table. The index is the
+	same as the one into GetPackets().
+
+	The returned object is owned by the decoder and is valid until the next decode.
+ */
+Packet* PacketDecoder::GetPacket(size_t i)
+{
+	size_t ndirect = m_packets.size() - m_materializedRows;
+	if(i < ndirect)
+		return m_packets[i];
+	return GetRowPacket(i - ndirect);
+}
+
+/**
+	@brief Gets the Packet object for a row of m_table, creating it the first time
+ */
+Packet* PacketDecoder::GetRowPacket(size_t row)
+{
+	if(m_rowPackets.size() <= row)
+		m_rowPackets.resize(m_table.GetRowCount(), NULL);
+	if(m_rowPackets[row] == NULL)
+		m_rowPackets[row] = m_table.CreatePacket(row);
+	return m_rowPackets[row];
 }
 
 bool PacketDecoder::GetShowDataColumn()
@@ -111,7 +585,7 @@ bool PacketDecoder::CanMerge(Packet* /*first*/, Packet* /*cur*/, Packet* /*next*
 	@brief Creates a summary packet for one or more merged packets
 
 	@param pack		The first packet in the merge string
-	@param i		Index of pack within m_packets
+	@param i		Index of pack (see GetPacket())
  */
 Packet* PacketDecoder::CreateMergedHeader(Packet* /*pack*/, size_t /*i*/)
 {
@@ -61,6 +61,176 @@ public:
 	Gdk::Color m_displayBackgroundColor;
 };
 
+/**
+	@class
+	@brief Columnar storage for decoded packets
+
+	Each header column holds typed cells which are only converted to strings when displayed, colors are indexes into
+	a small palette, and the bytes of every packet live in a single arena. Displays should read the table directly
+	(FormatCell(), GetData()) rather than converting rows to Packet objects. PacketDecoder::GetPacket() converts a
+	single row on demand, and PacketDecoder::GetPackets() converts all of them for code which still needs that.
+ */
+class PacketTable
+{
+public:
+	PacketTable();
+
+	///Format of a single header cell
+	enum CellFormat : uint8_t
+	{
+		FORMAT_EMPTY,		//No value
+		FORMAT_TEXT,		//Index into the interned string pool
+		FORMAT_DECIMAL,		//Unsigned decimal
+		FORMAT_HEX,			//Lowercase hex, zero padded to m_width digits
+		FORMAT_HEX_UPPER,	//Uppercase hex, zero padded to m_width digits
+		FORMAT_MAC,			//48-bit MAC address, colon separated
+		FORMAT_HEXDUMP		//Packet bytes in hex, followed by the interned string m_value
+	};
+
+	struct Cell
+	{
+		uint64_t m_value;
+		CellFormat m_format;
+		uint8_t m_width;
+	};
+
+	void Clear();
+
+	//Columns
+	void SetColumns(const std::vector<std::string>& names);
+	size_t GetColumn(const std::string& name);
+
+	size_t GetColumnCount() const
+	{ return m_columnNames.size(); }
+
+	const std::string& GetColumnName(size_t col) const
+	{ return m_columnNames[col]; }
+
+	//Rows
+	size_t AddRow(int64_t offset);
+	void RemoveLastRow();
+
+	size_t GetRowCount() const
+	{ return m_offsets.size(); }
+
+	int64_t GetOffset(size_t row) const
+	{ return m_offsets[row]; }
+
+	void SetOffset(size_t row, int64_t offset)
+	{ m_offsets[row] = offset; }
+
+	int64_t GetLength(size_t row) const
+	{ return m_lengths[row]; }
+
+	void SetLength(size_t row, int64_t len)
+	{ m_lengths[row] = len; }
+
+	void SetEnd(size_t row, int64_t end)
+	{ m_lengths[row] = end - m_offsets[row]; }
+
+	void SetBackgroundColor(size_t row, const Gdk::Color& color)
+	{ m_backgroundColors[row] = InternColor(color); }
+
+	void SetForegroundColor(size_t row, const Gdk::Color& color)
+	{ m_foregroundColors[row] = InternColor(color); }
+
+	const Gdk::Color& GetBackgroundColor(size_t row) const
+	{ return m_palette[m_backgroundColors[row]]; }
+
+	const Gdk::Color& GetForegroundColor(size_t row) const
+	{ return m_palette[m_foregroundColors[row]]; }
+
+	//Header cells
+	void SetText(size_t row, size_t col, const std::string& text)
+	{ SetCell(row, col, InternString(text), FORMAT_TEXT, 0); }
+
+	void SetDecimal(size_t row, size_t col, uint64_t value)
+	{ SetCell(row, col, value, FORMAT_DECIMAL, 0); }
+
+	void SetHex(size_t row, size_t col, uint64_t value, uint8_t digits, bool upper = false)
+	{ SetCell(row, col, value, upper ? FORMAT_HEX_UPPER : FORMAT_HEX, digits); }
+
+	void SetMAC(size_t row, size_t col, const uint8_t* mac);
+
+	void SetHexDump(size_t row, size_t col, const std::string& suffix = "")
+	{ SetCell(row, col, InternString(suffix), FORMAT_HEXDUMP, 0); }
+
+	bool HasCell(size_t row, size_t col) const
+	{ return m_cells[col][row].m_format != FORMAT_EMPTY; }
+
+	const Cell& GetCell(size_t row, size_t col) const
+	{ return m_cells[col][row]; }
+
+	std::string FormatCell(size_t row, size_t col) const;
+
+	//Packet bytes
+	void AppendData(size_t row, uint8_t data)
+	{
+		//Fast path: the row owns the end of the arena
+		if(m_dataStarts[row] + m_dataLengths[row] != m_arena.size())
+			MoveDataToEnd(row);
+		m_arena.push_back(data);
+		m_dataLengths[row] ++;
+	}
+
+	void AppendData(size_t row, const uint8_t* data, size_t len);
+	void TruncateData(size_t row, size_t len);
+
+	size_t GetDataSize(size_t row) const
+	{ return m_dataLengths[row]; }
+
+	const uint8_t* GetData(size_t row) const
+	{ return m_arena.data() + m_dataStarts[row]; }
+
+	uint8_t GetDataByte(size_t row, size_t i) const
+	{ return m_arena[m_dataStarts[row] + i]; }
+
+	Packet* CreatePacket(size_t row) const;
+
+	//Carrying a packet in progress over to the next waveform
+	void SaveRow(size_t row, DecoderState& state) const;
+	size_t RestoreRow(const DecoderState& state, int64_t offset);
+
+protected:
+	void SetCell(size_t row, size_t col, uint64_t value, CellFormat format, uint8_t width)
+	{
+		auto& cell = m_cells[col][row];
+		cell.m_value = value;
+		cell.m_format = format;
+		cell.m_width = width;
+	}
+
+	uint32_t InternString(const std::string& text);
+	uint16_t InternColor(const Gdk::Color& color);
+	void MoveDataToEnd(size_t row);
+
+	///Header column names, and the column ID of each
+	std::vector<std::string> m_columnNames;
+	std::map<std::string, size_t> m_columnIDs;
+
+	///Per-column cells, indexed by row
+	std::vector< std::vector<Cell> > m_cells;
+
+	///Per-row timing (femtoseconds)
+	std::vector<int64_t> m_offsets;
+	std::vector<int64_t> m_lengths;
+
+	///Per-row colors, as indexes into m_palette
+	std::vector<uint16_t> m_foregroundColors;
+	std::vector<uint16_t> m_backgroundColors;
+	std::vector<Gdk::Color> m_palette;
+	std::map<uint64_t, uint16_t> m_paletteIDs;
+
+	///Interned strings for FORMAT_TEXT cells
+	std::vector<std::string> m_strings;
+	std::map<std::string, uint32_t> m_stringIDs;
+
+	///Packet bytes for all rows
+	std::vector<uint8_t> m_arena;
+	std::vector<size_t> m_dataStarts;
+	std::vector<size_t> m_dataLengths;
+};
+
 /**
 	@class
 	@brief A protocol decoder that outputs packetized data
@@ -71,8 +241,27 @@ public:
 	PacketDecoder(OscilloscopeChannel::ChannelType type, const std::string& color, Filter::Category cat);
 	virtual ~PacketDecoder();
 
+	/**
+		@brief Gets every packet as a Packet object
+
+		This converts every row of the packet table, which is expensive for large captures. Code which only looks at
+		some of the packets (e.g. the rows on screen, or candidates for CanMerge() / CreateMergedHeader()) should use
+		GetPacketCount() and GetPacket() instead, or read GetPacketTable() directly.
+	 */
 	const std::vector<Packet*>& GetPackets()
-	{ return m_packets; }
+	{
+		MaterializePackets();
+		return m_packets;
+	}
+
+	///Gets the number of packets from the last decode
+	size_t GetPacketCount() const
+	{ return m_packets.size() - m_materializedRows + m_table.GetRowCount(); }
+
+	Packet* GetPacket(size_t i);
+
+	const PacketTable& GetPacketTable() const
+	{ return m_table; }
 
 	virtual std::vector<std::string> GetHeaders() =0;
 
@@ -104,8 +293,38 @@ public:
 
 protected:
 	void ClearPackets();
+	void MaterializePackets();
+	Packet* GetRowPacket(size_t row);
 
+	void CreateExportParameters(uint16_t linktype);
+	void ExportPacket(const WaveformBase* cap, int64_t offset, const uint8_t* data, size_t len);
+	void UpdateExport();
+
+	///Packet objects, either created directly by the decoder or materialized from m_table
 	std::vector<Packet*> m_packets;
+
+	///Compact packet storage, converted to Packet objects in m_packets on demand
+	PacketTable m_table;
+
+	///Number of rows of m_table which have been appended to m_packets
+	size_t m_materializedRows;
+
+	///Packet objects for individual rows of m_table, created by GetPacket() (NULL if not created yet)
+	std::vector<Packet*> m_rowPackets;
+
+	///Link type for pcapng export, or zero if the decoder doesn't support export
+	uint16_t m_exportLinkType;
+
+	///Names of the export parameters
+	std::string m_exportFileName;
+	std::string m_exportRotateName;
+
+	///Path and rotation size the current writer was opened with
+	std::string m_cachedExportPath;
+	int64_t m_cachedExportRotate;
+
+	///Background writer for exported packets (NULL if not exporting)
+	PcapngWriter* m_exportWriter;
 };
 
 #endif
@@ -0,0 +1,438 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PcapngWriter
+ */
+
+#include "scopehal.h"
+#include "PcapngWriter.h"
+
+using namespace std;
+
+//pcapng block types and option codes (draft-ietf-opsawg-pcapng)
+enum
+{
+	BLOCK_SECTION_HEADER		= 0x0a0d0d0a,
+	BLOCK_INTERFACE_DESCRIPTION	= 0x00000001,
+	BLOCK_ENHANCED_PACKET		= 0x00000006,
+
+	OPT_ENDOFOPT				= 0,
+	OPT_SHB_USERAPPL			= 4,
+	OPT_IF_NAME					= 2,
+	OPT_IF_TSRESOL				= 9
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+PcapngWriter::PcapngWriter()
+	: m_open(false)
+	, m_rotateBytes(0)
+	, m_fp(NULL)
+	, m_fileIndex(0)
+	, m_fileBytes(0)
+	, m_current(NULL)
+	, m_writing(false)
+	, m_terminating(false)
+	, m_droppedPackets(0)
+{
+}
+
+PcapngWriter::~PcapngWriter()
+{
+	Close();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Opening and closing
+
+/**
+	@brief Creates a new capture file and starts the writer thread
+
+	@param path			Path of the first file
+	@param linktype		Link type of every packet in the capture (see LinkType)
+	@param ifname		Interface name to show in the capture (typically the filter's display name)
+	@param rotateBytes	Start a new file once the current one would exceed this size (zero to never rotate)
+
+	@return True on success, false if the file couldn't be created
+ */
+bool PcapngWriter::Open(const string& path, uint16_t linktype, const string& ifname, uint64_t rotateBytes)
+{
+	Close();
+
+	m_path = path;
+	m_rotateBytes = rotateBytes;
+	m_fileIndex = 0;
+	m_droppedPackets = 0;
+
+	//Section header block, with unknown section length since we're streaming
+	m_header.clear();
+	AppendU32(m_header, BLOCK_SECTION_HEADER);
+	AppendU32(m_header, 0);
+	AppendU32(m_header, 0x1a2b3c4d);
+	AppendU16(m_header, 1);
+	AppendU16(m_header, 0);
+	AppendU32(m_header, 0xffffffff);
+	AppendU32(m_header, 0xffffffff);
+	const char* appname = "libscopehal";
+	AppendOption(m_header, OPT_SHB_USERAPPL, appname, strlen(appname));
+	AppendOption(m_header, OPT_ENDOFOPT, NULL, 0);
+	FinishBlock(m_header, 0);
+
+	//Interface description block. Snap length of zero means no limit.
+	//Timestamps are in nanoseconds (10^-9), the finest resolution most tools handle.
+	size_t start = m_header.size();
+	AppendU32(m_header, BLOCK_INTERFACE_DESCRIPTION);
+	AppendU32(m_header, 0);
+	AppendU16(m_header, linktype);
+	AppendU16(m_header, 0);
+	AppendU32(m_header, 0);
+	AppendOption(m_header, OPT_IF_NAME, ifname.c_str(), ifname.length());
+	uint8_t tsresol = 9;
+	AppendOption(m_header, OPT_IF_TSRESOL, &tsresol, 1);
+	AppendOption(m_header, OPT_ENDOFOPT, NULL, 0);
+	FinishBlock(m_header, start);
+
+	if(!OpenFile())
+		return false;
+
+	m_current = AllocateBlock();
+	m_writing = false;
+	m_terminating = false;
+	m_open = true;
+
+	m_thread = thread(&PcapngWriter::WriterThread, this);
+	return true;
+}
+
+/**
+	@brief Writes out any buffered packets, stops the writer thread, and closes the file
+ */
+void PcapngWriter::Close()
+{
+	if(!m_open)
+		return;
+
+	//Hand off the last partial block and let the writer thread drain the queue
+	{
+		lock_guard<mutex> lock(m_mutex);
+		if(!m_current->empty())
+		{
+			m_pending.push_back(m_current);
+			m_current = new vector<uint8_t>;
+		}
+		m_terminating = true;
+	}
+	m_queueEvent.notify_one();
+	m_thread.join();
+
+	if(m_fp)
+		fclose(m_fp);
+	m_fp = NULL;
+
+	delete m_current;
+	m_current = NULL;
+	for(auto b : m_freeBlocks)
+		delete b;
+	m_freeBlocks.clear();
+
+	if(m_droppedPackets)
+	{
+		LogWarning("PcapngWriter: dropped %llu packets writing %s (disk too slow)\n",
+			(unsigned long long)m_droppedPackets, m_path.c_str());
+	}
+
+	m_open = false;
+}
+
+/**
+	@brief Opens file number m_fileIndex and writes the section and interface headers to it
+ */
+bool PcapngWriter::OpenFile()
+{
+	//Even if the open fails, pretend the headers went out so rotation still makes forward progress
+	m_fileBytes = m_header.size();
+
+	auto path = GetFilePath(m_fileIndex);
+	m_fp = fopen(path.c_str(), "wb");
+	if(!m_fp)
+	{
+		LogError("PcapngWriter: couldn't open %s\n", path.c_str());
+		return false;
+	}
+
+	if(fwrite(&m_header[0], 1, m_header.size(), m_fp) != m_header.size())
+		LogError("PcapngWriter: write to %s failed\n", path.c_str());
+	return true;
+}
+
+/**
+	@brief Gets the path of a rotated file: the base path for the first one, then base_00001.ext, base_00002.ext...
+ */
+string PcapngWriter::GetFilePath(size_t index)
+{
+	if(index == 0)
+		return m_path;
+
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), "_%05zu", index);
+
+	//Insert before the extension, if there is one in the last path component
+	size_t dot = m_path.rfind('.');
+	size_t slash = m_path.find_last_of("/\\");
+	if( (dot == string::npos) || ( (slash != string::npos) && (dot < slash) ) )
+		return m_path + suffix;
+	return m_path.substr(0, dot) + suffix + m_path.substr(dot);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Packet output
+
+/**
+	@brief Queues one packet for writing
+
+	@param sec	Start of the packet, in seconds since the epoch
+	@param fs	Femtoseconds after sec (0 to FS_PER_SECOND-1)
+	@param data	Packet contents
+	@param len	Length of the packet
+ */
+void PcapngWriter::WritePacket(time_t sec, int64_t fs, const uint8_t* data, size_t len)
+{
+	if(!m_open)
+		return;
+
+	uint64_t ts = (uint64_t)sec * 1000000000ULL + (fs / 1000000);
+
+	lock_guard<mutex> lock(m_mutex);
+
+	//Don't buffer without limit if the disk can't keep up
+	if(m_pending.size() >= MAX_PENDING_BLOCKS)
+	{
+		if(m_droppedPackets == 0)
+			LogWarning("PcapngWriter: write queue full, dropping packets\n");
+		m_droppedPackets ++;
+		return;
+	}
+
+	//Enhanced packet block (always interface 0, never truncated)
+	auto& buf = *m_current;
+	size_t start = buf.size();
+	AppendU32(buf, BLOCK_ENHANCED_PACKET);
+	AppendU32(buf, 0);
+	AppendU32(buf, 0);
+	AppendU32(buf, ts >> 32);
+	AppendU32(buf, ts & 0xffffffff);
+	AppendU32(buf, len);
+	AppendU32(buf, len);
+	buf.insert(buf.end(), data, data + len);
+	FinishBlock(buf, start);
+
+	if(buf.size() >= BLOCK_SIZE)
+	{
+		m_pending.push_back(m_current);
+		m_current = AllocateBlock();
+		m_queueEvent.notify_one();
+	}
+}
+
+/**
+	@brief Blocks until every packet written so far is on disk
+ */
+void PcapngWriter::Flush()
+{
+	if(!m_open)
+		return;
+
+	unique_lock<mutex> lock(m_mutex);
+	if(!m_current->empty())
+	{
+		m_pending.push_back(m_current);
+		m_current = AllocateBlock();
+	}
+	m_queueEvent.notify_one();
+	m_drainEvent.wait(lock, [&]{ return m_pending.empty() && !m_writing; });
+}
+
+/**
+	@brief Gets an empty buffer, reusing a previously written one if possible. Must be called with m_mutex held.
+ */
+vector<uint8_t>* PcapngWriter::AllocateBlock()
+{
+	if(m_freeBlocks.empty())
+	{
+		auto block = new vector<uint8_t>;
+		block->reserve(BLOCK_SIZE + 65536);
+		return block;
+	}
+
+	auto block = m_freeBlocks.back();
+	m_freeBlocks.pop_back();
+	return block;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Writer thread
+
+void PcapngWriter::WriterThread()
+{
+	unique_lock<mutex> lock(m_mutex);
+	while(true)
+	{
+		//Wait for a full block. If nothing shows up for a while, take whatever has been buffered so a capture which
+		//has gone quiet still ends up on disk promptly.
+		if(m_pending.empty() && !m_terminating)
+		{
+			m_queueEvent.wait_for(lock, chrono::milliseconds(250));
+			if(m_pending.empty() && !m_current->empty())
+			{
+				m_pending.push_back(m_current);
+				m_current = AllocateBlock();
+			}
+		}
+
+		if(m_pending.empty())
+		{
+			if(m_terminating)
+				break;
+			continue;
+		}
+
+		//Do the actual I/O with the lock released so the decoder can keep going
+		auto block = m_pending.front();
+		m_pending.pop_front();
+		m_writing = true;
+		lock.unlock();
+
+		WriteBlock(*block);
+		block->clear();
+
+		lock.lock();
+		m_writing = false;
+		m_freeBlocks.push_back(block);
+		if(m_pending.empty())
+			m_drainEvent.notify_all();
+	}
+}
+
+/**
+	@brief Writes a block of packets to disk, starting new files as needed
+ */
+void PcapngWriter::WriteBlock(const vector<uint8_t>& block)
+{
+	size_t pos = 0;
+	size_t size = block.size();
+	while(pos < size)
+	{
+		//See how many whole packets fit in the current file.
+		//Always allow at least one packet per file, even if it's bigger than the limit on its own.
+		size_t end = size;
+		if(m_rotateBytes != 0)
+		{
+			end = pos;
+			while(end < size)
+			{
+				uint32_t blocklen;
+				memcpy(&blocklen, &block[end + 4], sizeof(blocklen));
+
+				bool empty = (end == pos) && (m_fileBytes == m_header.size());
+				if(!empty && (m_fileBytes + (end - pos) + blocklen > m_rotateBytes) )
+					break;
+				end += blocklen;
+			}
+		}
+
+		//Current file is full, move on to the next
+		if(end == pos)
+		{
+			if(m_fp)
+				fclose(m_fp);
+			m_fileIndex ++;
+			OpenFile();
+			continue;
+		}
+
+		if(m_fp)
+		{
+			if(fwrite(&block[pos], 1, end - pos, m_fp) != end - pos)
+				LogError("PcapngWriter: write to %s failed\n", GetFilePath(m_fileIndex).c_str());
+		}
+		m_fileBytes += end - pos;
+		pos = end;
+	}
+
+	if(m_fp)
+		fflush(m_fp);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Serialization helpers (pcapng files are written in host byte order)
+
+void PcapngWriter::AppendU16(vector<uint8_t>& buf, uint16_t value)
+{
+	auto p = reinterpret_cast<const uint8_t*>(&value);
+	buf.insert(buf.end(), p, p + sizeof(value));
+}
+
+void PcapngWriter::AppendU32(vector<uint8_t>& buf, uint32_t value)
+{
+	auto p = reinterpret_cast<const uint8_t*>(&value);
+	buf.insert(buf.end(), p, p + sizeof(value));
+}
+
+/**
+	@brief Appends an option (code, length, value, padding to 32 bits)
+ */
+void PcapngWriter::AppendOption(vector<uint8_t>& buf, uint16_t code, const void* value, size_t len)
+{
+	AppendU16(buf, code);
+	AppendU16(buf, len);
+	if(len)
+	{
+		auto p = reinterpret_cast<const uint8_t*>(value);
+		buf.insert(buf.end(), p, p + len);
+	}
+	while(buf.size() % 4)
+		buf.push_back(0);
+}
+
+/**
+	@brief Pads the block starting at start to 32 bits, then fills in the length at both ends
+ */
+void PcapngWriter::FinishBlock(vector<uint8_t>& buf, size_t start)
+{
+	while( (buf.size() - start) % 4)
+		buf.push_back(0);
+
+	uint32_t len = buf.size() - start + 4;
+	AppendU32(buf, len);
+	memcpy(&buf[start + 4], &len, sizeof(len));
+}
@@ -0,0 +1,150 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PcapngWriter
+ */
+
+#ifndef PcapngWriter_h
+#define PcapngWriter_h
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+/**
+	@brief Asynchronous writer for pcapng capture files
+
+	Packets are serialized into Enhanced Packet Blocks in a large in-memory buffer on the calling (decode) thread.
+	Full buffers, and partial buffers which have been idle for a short time, are handed to a background thread which
+	does the actual file I/O, so a slow disk never stalls the filter graph. If the disk falls too far behind, new
+	packets are dropped and counted rather than buffered without limit.
+
+	Each file has a single interface with nanosecond timestamp resolution. If a rotation size is given, a new file
+	is started (with its own section and interface headers) whenever the current one would exceed it: capture.pcapng,
+	capture_00001.pcapng, capture_00002.pcapng, etc.
+ */
+class PcapngWriter
+{
+public:
+	PcapngWriter();
+	virtual ~PcapngWriter();
+
+	/**
+		@brief Common link types (see https://www.tcpdump.org/linktypes.html)
+	 */
+	enum LinkType
+	{
+		LINKTYPE_ETHERNET		= 1,
+		LINKTYPE_CAN_SOCKETCAN	= 227,
+		LINKTYPE_USB_2_0		= 288
+	};
+
+	bool Open(const std::string& path, uint16_t linktype, const std::string& ifname, uint64_t rotateBytes = 0);
+	void Close();
+
+	bool IsOpen() const
+	{ return m_open; }
+
+	void WritePacket(time_t sec, int64_t fs, const uint8_t* data, size_t len);
+	void Flush();
+
+	///Gets the number of packets dropped because the disk couldn't keep up
+	uint64_t GetDroppedPacketCount()
+	{ return m_droppedPackets; }
+
+protected:
+	void WriterThread();
+	void WriteBlock(const std::vector<uint8_t>& block);
+	bool OpenFile();
+	std::string GetFilePath(size_t index);
+	std::vector<uint8_t>* AllocateBlock();
+
+	static void AppendU16(std::vector<uint8_t>& buf, uint16_t value);
+	static void AppendU32(std::vector<uint8_t>& buf, uint32_t value);
+	static void AppendOption(std::vector<uint8_t>& buf, uint16_t code, const void* value, size_t len);
+	static void FinishBlock(std::vector<uint8_t>& buf, size_t start);
+
+	///@brief Size at which the current buffer is handed off to the writer thread
+	static const size_t BLOCK_SIZE = 1024 * 1024;
+
+	///@brief Maximum number of full buffers waiting to be written before packets are dropped
+	static const size_t MAX_PENDING_BLOCKS = 64;
+
+	bool m_open;
+
+	///@brief Base path of the capture (before any rotation suffix)
+	std::string m_path;
+
+	///@brief Maximum size of each file, or zero for no rotation
+	uint64_t m_rotateBytes;
+
+	///@brief Section header and interface description blocks, written at the start of every file
+	std::vector<uint8_t> m_header;
+
+	//Writer thread state (only touched by the writer thread while it's running)
+	FILE* m_fp;
+	size_t m_fileIndex;
+	uint64_t m_fileBytes;
+
+	///@brief Protects everything below
+	std::mutex m_mutex;
+
+	///@brief Signaled when a block is queued, on flush requests, and on shutdown
+	std::condition_variable m_queueEvent;
+
+	///@brief Signaled by the writer thread when the queue has been drained
+	std::condition_variable m_drainEvent;
+
+	///@brief Buffer currently being filled by WritePacket()
+	std::vector<uint8_t>* m_current;
+
+	///@brief Blocks waiting to be written
+	std::deque<std::vector<uint8_t>*> m_pending;
+
+	///@brief Empty blocks available for reuse
+	std::vector<std::vector<uint8_t>*> m_freeBlocks;
+
+	///@brief True while the writer thread is busy with a block it has taken off the queue
+	bool m_writing;
+
+	bool m_terminating;
+	uint64_t m_droppedPackets;
+
+	std::thread m_thread;
+
+	//not copyable
+	PcapngWriter(const PcapngWriter&) =delete;
+	PcapngWriter& operator=(const PcapngWriter&) =delete;
+};
+
+#endif
@@ -0,0 +1,312 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PendingWaveformQueue
+ */
+
+#include "scopehal.h"
+#include "PendingWaveformQueue.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+PendingWaveformQueue::PendingWaveformQueue(size_t capacity)
+	: m_slots(NULL)
+	, m_capacity(0)
+	, m_mask(0)
+	, m_enqueuePos(0)
+	, m_dequeuePos(0)
+	, m_policy(POLICY_BLOCK)
+	, m_decimation(1)
+	, m_decimationCount(0)
+{
+	SetCapacity(capacity);
+	ResetStatistics();
+}
+
+PendingWaveformQueue::~PendingWaveformQueue()
+{
+	Clear();
+	delete[] m_slots;
+}
+
+/**
+	@brief Changes the size of the queue
+
+	The capacity is rounded up to a power of two. Any queued waveforms are discarded, and this must not be called while
+	anything else is using the queue.
+ */
+void PendingWaveformQueue::SetCapacity(size_t capacity)
+{
+	Clear();
+	delete[] m_slots;
+
+	if(capacity < 2)
+		capacity = 2;
+	m_capacity = next_pow2(capacity);
+	m_mask = m_capacity - 1;
+
+	m_slots = new Slot[m_capacity];
+	for(size_t i=0; i<m_capacity; i++)
+		m_slots[i].m_sequence.store(i, memory_order_relaxed);
+
+	m_enqueuePos.store(0);
+	m_dequeuePos.store(0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Ring buffer
+
+/**
+	@brief Tries to add a set to the end of the queue
+
+	@return False if the queue is full
+ */
+bool PendingWaveformQueue::TryPush(const SequenceSet& set, double now)
+{
+	//Claim a slot
+	size_t pos = m_enqueuePos.load(memory_order_relaxed);
+	Slot* slot;
+	while(true)
+	{
+		slot = &m_slots[pos & m_mask];
+		size_t seq = slot->m_sequence.load(memory_order_acquire);
+		intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+
+		//Slot is free, try to grab it
+		if(dif == 0)
+		{
+			if(m_enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+				break;
+		}
+
+		//Slot still holds data from the last time around the ring
+		else if(dif < 0)
+			return false;
+
+		//Somebody else got there first
+		else
+			pos = m_enqueuePos.load(memory_order_relaxed);
+	}
+
+	//Fill it and publish to the consumer
+	slot->m_set = set;
+	slot->m_pushTime = now;
+	slot->m_sequence.store(pos + 1, memory_order_release);
+	return true;
+}
+
+/**
+	@brief Tries to remove a set from the front of the queue
+
+	@return False if the queue is empty
+ */
+bool PendingWaveformQueue::TryPop(SequenceSet& set, double& pushTime)
+{
+	size_t pos = m_dequeuePos.load(memory_order_relaxed);
+	Slot* slot;
+	while(true)
+	{
+		slot = &m_slots[pos & m_mask];
+		size_t seq = slot->m_sequence.load(memory_order_acquire);
+		intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+
+		if(dif == 0)
+		{
+			if(m_dequeuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+				break;
+		}
+		else if(dif < 0)
+			return false;
+		else
+			pos = m_dequeuePos.load(memory_order_relaxed);
+	}
+
+	//Take the data, then hand the slot back to the producer
+	set = move(slot->m_set);
+	slot->m_set.clear();
+	pushTime = slot->m_pushTime;
+	slot->m_sequence.store(pos + m_mask + 1, memory_order_release);
+	return true;
+}
+
+/**
+	@brief Adds a set of waveforms to the queue, applying the overflow policy if it's full
+
+	Ownership of the waveforms passes to the queue, even if they end up being dropped.
+ */
+void PendingWaveformQueue::Push(const SequenceSet& set)
+{
+	double start = GetTime();
+	bool pushed = false;
+
+	switch(m_policy.load())
+	{
+		//Spin briefly in case the consumer is about to catch up, then back off
+		case POLICY_BLOCK:
+			for(size_t i=0; !TryPush(set, GetTime()); i++)
+			{
+				if(i < 64)
+					this_thread::yield();
+				else
+					this_thread::sleep_for(chrono::milliseconds(1));
+			}
+			pushed = true;
+			break;
+
+		case POLICY_DROP_OLDEST:
+			while(!TryPush(set, GetTime()))
+			{
+				SequenceSet old;
+				double t;
+				if(TryPop(old, t))
+				{
+					ReleaseSet(old);
+					m_dropped ++;
+				}
+			}
+			pushed = true;
+			break;
+
+		case POLICY_DROP_NEWEST:
+			pushed = TryPush(set, start);
+			break;
+
+		case POLICY_DECIMATE:
+			if(size() >= m_capacity / 2)
+			{
+				if( (m_decimationCount++ % m_decimation.load()) == 0)
+					pushed = TryPush(set, start);
+			}
+			else
+			{
+				m_decimationCount = 0;
+				pushed = TryPush(set, start);
+			}
+			break;
+	}
+
+	if(pushed)
+	{
+		m_pushed ++;
+		UpdateMax(m_maxDepth, size());
+	}
+	else
+	{
+		ReleaseSet(set);
+		m_dropped ++;
+	}
+
+	uint64_t dt = (GetTime() - start) * 1e9;
+	m_producerLatencyTotal += dt;
+	UpdateMax(m_producerLatencyMax, dt);
+}
+
+/**
+	@brief Removes the oldest set of waveforms from the queue
+
+	@return False if the queue is empty
+ */
+bool PendingWaveformQueue::Pop(SequenceSet& set)
+{
+	double pushTime;
+	if(!TryPop(set, pushTime))
+		return false;
+
+	m_popped ++;
+	uint64_t dt = (GetTime() - pushTime) * 1e9;
+	m_consumerLatencyTotal += dt;
+	UpdateMax(m_consumerLatencyMax, dt);
+	return true;
+}
+
+/**
+	@brief Discards everything in the queue
+ */
+void PendingWaveformQueue::Clear()
+{
+	if(m_slots == NULL)
+		return;
+
+	SequenceSet set;
+	double t;
+	while(TryPop(set, t))
+		ReleaseSet(set);
+}
+
+void PendingWaveformQueue::ReleaseSet(const SequenceSet& set)
+{
+	for(auto it : set)
+		g_waveformPool.Release(it.second);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Statistics
+
+void PendingWaveformQueue::UpdateMax(atomic<uint64_t>& value, uint64_t sample)
+{
+	uint64_t old = value.load(memory_order_relaxed);
+	while( (sample > old) && !value.compare_exchange_weak(old, sample, memory_order_relaxed) )
+	{}
+}
+
+PendingWaveformStatistics PendingWaveformQueue::GetStatistics() const
+{
+	PendingWaveformStatistics stats;
+	stats.m_depth = size();
+	stats.m_capacity = m_capacity;
+	stats.m_maxDepth = m_maxDepth;
+	stats.m_pushed = m_pushed;
+	stats.m_popped = m_popped;
+	stats.m_dropped = m_dropped;
+
+	uint64_t offered = stats.m_pushed + stats.m_dropped;
+	stats.m_meanProducerLatency = offered ? (m_producerLatencyTotal * 1e-9 / offered) : 0;
+	stats.m_maxProducerLatency = m_producerLatencyMax * 1e-9;
+	stats.m_meanConsumerLatency = stats.m_popped ? (m_consumerLatencyTotal * 1e-9 / stats.m_popped) : 0;
+	stats.m_maxConsumerLatency = m_consumerLatencyMax * 1e-9;
+	return stats;
+}
+
+void PendingWaveformQueue::ResetStatistics()
+{
+	m_pushed = 0;
+	m_popped = 0;
+	m_dropped = 0;
+	m_maxDepth = 0;
+	m_producerLatencyTotal = 0;
+	m_producerLatencyMax = 0;
+	m_consumerLatencyTotal = 0;
+	m_consumerLatencyMax = 0;
+}
@@ -0,0 +1,205 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PendingWaveformQueue
+ */
+
+#ifndef PendingWaveformQueue_h
+#define PendingWaveformQueue_h
+
+#include <map>
+#include <atomic>
+
+class OscilloscopeChannel;
+class WaveformBase;
+
+/**
+	@brief Snapshot of the state of a PendingWaveformQueue
+ */
+class PendingWaveformStatistics
+{
+public:
+	///Number of waveform sets currently queued
+	size_t m_depth;
+
+	///Maximum number of waveform sets which can be queued
+	size_t m_capacity;
+
+	///Highest depth seen since the last reset
+	size_t m_maxDepth;
+
+	///Number of waveform sets accepted into the queue
+	uint64_t m_pushed;
+
+	///Number of waveform sets handed to the consumer
+	uint64_t m_popped;
+
+	///Number of waveform sets discarded by the overflow policy
+	uint64_t m_dropped;
+
+	///Time the acquisition thread spent in Push() (seconds), including time spent blocked on a full queue
+	double m_meanProducerLatency;
+	double m_maxProducerLatency;
+
+	///Time from Push() to Pop() (seconds)
+	double m_meanConsumerLatency;
+	double m_maxConsumerLatency;
+};
+
+/**
+	@brief Bounded lock-free queue of waveform sets waiting to be consumed from an oscilloscope
+
+	This is a ring buffer with a per-slot sequence number (Vyukov's bounded queue), so the acquisition thread and the
+	consumer never take a lock. It's safe with any number of producers and consumers, but is intended for one of
+	each.
+
+	When the queue is full, what happens to new waveforms depends on the overflow policy:
+	* POLICY_BLOCK (default): the producer waits until the consumer makes room, so no waveforms are ever lost.
+	  Drivers must not hold their own locks while calling Push().
+	* POLICY_DROP_OLDEST: the oldest queued set is discarded to make room, so a live display stays current
+	* POLICY_DROP_NEWEST: the incoming set is discarded
+	* POLICY_DECIMATE: once the queue is half full, only every Nth incoming set is kept, and the rest are discarded.
+	  Incoming sets are also discarded if the queue is completely full.
+
+	Discarded waveforms are returned to g_waveformPool.
+ */
+class PendingWaveformQueue
+{
+public:
+	typedef std::map<OscilloscopeChannel*, WaveformBase*> SequenceSet;
+
+	enum Policy
+	{
+		POLICY_BLOCK,
+		POLICY_DROP_OLDEST,
+		POLICY_DROP_NEWEST,
+		POLICY_DECIMATE
+	};
+
+	PendingWaveformQueue(size_t capacity = 256);
+	virtual ~PendingWaveformQueue();
+
+	//not copyable or assignable
+	PendingWaveformQueue(const PendingWaveformQueue& rhs) =delete;
+	PendingWaveformQueue& operator=(const PendingWaveformQueue& rhs) =delete;
+
+	void Push(const SequenceSet& set);
+	bool Pop(SequenceSet& set);
+	void Clear();
+
+	///Gets the approximate number of waveform sets in the queue
+	size_t size() const
+	{
+		//Read the consumer position first so we can't see it get ahead of the producer
+		size_t head = m_dequeuePos.load();
+		return m_enqueuePos.load() - head;
+	}
+
+	bool empty() const
+	{ return size() == 0; }
+
+	void SetCapacity(size_t capacity);
+
+	///Gets the maximum number of waveform sets which can be queued
+	size_t GetCapacity() const
+	{ return m_capacity; }
+
+	/**
+		@brief Sets the overflow policy
+
+		@param policy		The new policy
+		@param decimation	For POLICY_DECIMATE, keep one out of every this many sets
+	 */
+	void SetPolicy(Policy policy, size_t decimation = 1)
+	{
+		m_decimation.store((decimation < 1) ? 1 : decimation);
+		m_policy.store(policy);
+	}
+
+	Policy GetPolicy() const
+	{ return m_policy.load(); }
+
+	size_t GetDecimation() const
+	{ return m_decimation.load(); }
+
+	PendingWaveformStatistics GetStatistics() const;
+	void ResetStatistics();
+
+protected:
+	bool TryPush(const SequenceSet& set, double now);
+	bool TryPop(SequenceSet& set, double& pushTime);
+	static void ReleaseSet(const SequenceSet& set);
+
+	static void UpdateMax(std::atomic<uint64_t>& value, uint64_t sample);
+
+	/**
+		@brief A single slot in the ring
+	 */
+	class Slot
+	{
+	public:
+		///@brief Sequence number indicating whether the slot is free or full for a given ring position
+		std::atomic<size_t> m_sequence;
+
+		SequenceSet m_set;
+
+		///@brief Time the set was pushed, for latency measurement
+		double m_pushTime;
+	};
+
+	Slot* m_slots;
+	size_t m_capacity;
+	size_t m_mask;
+
+	//Producer and consumer positions are on separate cache lines to avoid false sharing
+	alignas(64) std::atomic<size_t> m_enqueuePos;
+	alignas(64) std::atomic<size_t> m_dequeuePos;
+
+	//Policy may be changed from the UI thread while the acquisition thread is pushing
+	std::atomic<Policy> m_policy;
+	std::atomic<size_t> m_decimation;
+
+	///@brief Number of sets offered to the queue while over the decimation threshold
+	size_t m_decimationCount;
+
+	//Statistics. Latencies are in nanoseconds.
+	alignas(64) std::atomic<uint64_t> m_pushed;
+	std::atomic<uint64_t> m_popped;
+	std::atomic<uint64_t> m_dropped;
+	std::atomic<uint64_t> m_maxDepth;
+	std::atomic<uint64_t> m_producerLatencyTotal;
+	std::atomic<uint64_t> m_producerLatencyMax;
+	std::atomic<uint64_t> m_consumerLatencyTotal;
+	std::atomic<uint64_t> m_consumerLatencyMax;
+};
+
+#endif
@@ -50,6 +50,10 @@ using namespace std;
 PicoOscilloscope::PicoOscilloscope(SCPITransport* transport)
 	: SCPIOscilloscope(transport)
 	, m_triggerArmed(false)
+	, m_rxWritePos(0)
+	, m_rxReadPos(0)
+	, m_rxError(false)
+	, m_rxExit(false)
 {
 	//Set up initial cache configuration as "not valid" and let it populate as we go
 
@@ -143,6 +147,9 @@ PicoOscilloscope::PicoOscilloscope(SCPITransport* transport)
 	m_dataSocket = new Socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
 	m_dataSocket->Connect(csock->GetHostname(), csock->GetPort() + 1);
 	m_dataSocket->DisableNagle();
+
+	//Start pulling waveforms off the socket
+	m_rxThread = thread(&PicoOscilloscope::ReceiveThread, this);
 }
 
 /**
@@ -227,6 +234,19 @@ void PicoOscilloscope::IdentifyHardware()
 
 PicoOscilloscope::~PicoOscilloscope()
 {
+	//Shut down the receive thread. Shutting down the socket kicks it out of any blocking reads.
+	{
+		lock_guard<mutex> lock(m_rxMutex);
+		m_rxExit = true;
+	}
+	m_rxEvent.notify_all();
+#ifdef _WIN32
+	shutdown(*m_dataSocket, SD_BOTH);
+#else
+	shutdown(*m_dataSocket, SHUT_RDWR);
+#endif
+	m_rxThread.join();
+
 	delete m_dataSocket;
 }
 
@@ -431,7 +451,48 @@ Oscilloscope::TriggerMode PicoOscilloscope::PollTrigger()
 	return TRIGGER_MODE_TRIGGERED;
 }
 
-bool PicoOscilloscope::AcquireData()
+/**
+	@brief Receives waveforms from the data plane socket into m_rxRing
+
+	Runs on its own thread so the next capture can be coming off the wire while AcquireData() is still converting the
+	previous one. If AcquireData() falls behind and the ring fills up, we stop reading and let TCP flow control push
+	back on the bridge.
+ */
+void PicoOscilloscope::ReceiveThread()
+{
+	while(true)
+	{
+		//Wait for a free buffer
+		RawCapture* cap;
+		{
+			unique_lock<mutex> lock(m_rxMutex);
+			m_rxEvent.wait(lock, [&]{ return m_rxExit || (m_rxWritePos - m_rxReadPos < RX_RING_SIZE); });
+			if(m_rxExit)
+				break;
+			cap = &m_rxRing[m_rxWritePos % RX_RING_SIZE];
+		}
+
+		bool ok = ReceiveCapture(*cap);
+
+		//Hand it off
+		{
+			lock_guard<mutex> lock(m_rxMutex);
+			if(ok)
+				m_rxWritePos ++;
+			else
+				m_rxError = true;
+		}
+		m_rxEvent.notify_all();
+
+		if(!ok)
+			break;
+	}
+}
+
+/**
+	@brief Reads one complete capture from the data plane socket
+ */
+bool PicoOscilloscope::ReceiveCapture(RawCapture& cap)
 {
 	//Read the number of channels in the current waveform
 	uint16_t numChannels;
@@ -440,62 +501,85 @@ bool PicoOscilloscope::AcquireData()
 
 	//Get the sample interval.
 	//May be different from m_srate if we changed the rate after the trigger was armed
-	int64_t fs_per_sample;
-	if(!m_dataSocket->RecvLooped((uint8_t*)&fs_per_sample, sizeof(fs_per_sample)))
+	if(!m_dataSocket->RecvLooped((uint8_t*)&cap.m_fsPerSample, sizeof(cap.m_fsPerSample)))
 		return false;
 
-	//Acquire data for each channel
-	size_t chnum;
-	size_t memdepth;
-	float config[3];
-	SequenceSet s;
+	//TODO: stream timestamp from the server
 	double t = GetTime();
-	int64_t fs = (t - floor(t)) * FS_PER_SECOND;
+	cap.m_timestamp = time(NULL);
+	cap.m_femtoseconds = (t - floor(t)) * FS_PER_SECOND;
 
-	//Analog channels get processed separately
-	vector<int16_t*> abufs;
-	vector<AnalogWaveform*> awfms;
-	vector<float> scales;
-	vector<float> offsets;
+	//Only ever grow the channel list so we keep the old buffers around
+	cap.m_numChannels = numChannels;
+	if(cap.m_channels.size() < numChannels)
+		cap.m_channels.resize(numChannels);
 
 	for(size_t i=0; i<numChannels; i++)
 	{
+		auto& chan = cap.m_channels[i];
+
 		//Get channel ID and memory depth (samples, not bytes)
-		if(!m_dataSocket->RecvLooped((uint8_t*)&chnum, sizeof(chnum)))
+		size_t memdepth;
+		if(!m_dataSocket->RecvLooped((uint8_t*)&chan.m_chnum, sizeof(chan.m_chnum)))
 			return false;
 		if(!m_dataSocket->RecvLooped((uint8_t*)&memdepth, sizeof(memdepth)))
 			return false;
-		int16_t* buf = new int16_t[memdepth];
+
+		//Analog channels: scale and offset are sent in the header since they might have changed since the capture
+		//began. Digital pods only have the trigger phase.
+		size_t configlen = (chan.m_chnum < m_analogChannelCount) ? 3*sizeof(float) : sizeof(float);
+		if(!m_dataSocket->RecvLooped((uint8_t*)chan.m_config, configlen))
+			return false;
+
+		chan.m_samples.resize(memdepth);
+		if(!m_dataSocket->RecvLooped((uint8_t*)chan.m_samples.data(), memdepth * sizeof(int16_t)))
+			return false;
+	}
+
+	return true;
+}
+
+bool PicoOscilloscope::AcquireData()
+{
+	//Wait for the receive thread to hand us a capture
+	RawCapture* raw;
+	{
+		unique_lock<mutex> lock(m_rxMutex);
+		m_rxEvent.wait(lock, [&]{ return m_rxError || (m_rxWritePos != m_rxReadPos); });
+		if(m_rxWritePos == m_rxReadPos)
+			return false;
+		raw = &m_rxRing[m_rxReadPos % RX_RING_SIZE];
+	}
+
+	int64_t fs_per_sample = raw->m_fsPerSample;
+	SequenceSet s;
+
+	//Analog channels get processed separately
+	vector< SampleConversionJob<int16_t> > jobs;
+
+	for(size_t i=0; i<raw->m_numChannels; i++)
+	{
+		auto& chan = raw->m_channels[i];
+		size_t chnum = chan.m_chnum;
+		size_t memdepth = chan.m_samples.size();
+		int16_t* buf = chan.m_samples.data();
 
 		//Analog channels
 		if(chnum < m_analogChannelCount)
 		{
-			abufs.push_back(buf);
-
-			//Scale and offset are sent in the header since they might have changed since the capture began
-			if(!m_dataSocket->RecvLooped((uint8_t*)&config, sizeof(config)))
-				return false;
-			float scale = config[0];
-			float offset = config[1];
-			float trigphase = -config[2] * fs_per_sample;
+			float scale = chan.m_config[0];
+			float offset = chan.m_config[1];
+			float trigphase = -chan.m_config[2] * fs_per_sample;
 			scale *= GetChannelAttenuation(chnum);
 
-			//TODO: stream timestamp from the server
-
-			if(!m_dataSocket->RecvLooped((uint8_t*)buf, memdepth * sizeof(int16_t)))
-				return false;
-
-			//Create our waveform
-			AnalogWaveform* cap = new AnalogWaveform;
+			//Create our waveform, converting straight out of the receive buffer
+			AnalogWaveform* cap = g_waveformPool.Allocate<AnalogWaveform>(memdepth);
 			cap->m_timescale = fs_per_sample;
 			cap->m_triggerPhase = trigphase;
-			cap->m_startTimestamp = time(NULL);
+			cap->m_startTimestamp = raw->m_timestamp;
 			cap->m_densePacked = true;
-			cap->m_startFemtoseconds = fs;
-			cap->Resize(memdepth);
-			awfms.push_back(cap);
-			scales.push_back(scale);
-			offsets.push_back(offset);
+			cap->m_startFemtoseconds = raw->m_femtoseconds;
+			jobs.push_back(SampleConversionJob<int16_t>(cap, buf, scale, -offset, memdepth));
 
 			s[m_channels[chnum]] = cap;
 		}
@@ -503,97 +587,60 @@ bool PicoOscilloscope::AcquireData()
 		//Digital pod
 		else
 		{
-			float trigphase;
-			if(!m_dataSocket->RecvLooped((uint8_t*)&trigphase, sizeof(trigphase)))
-				return false;
-			trigphase = -trigphase * fs_per_sample;
-			if(!m_dataSocket->RecvLooped((uint8_t*)buf, memdepth * sizeof(int16_t)))
-				return false;
-
+			float trigphase = -chan.m_config[0] * fs_per_sample;
 			size_t podnum = chnum - m_analogChannelCount;
 
-			//Now that we have the waveform data, unpack it into individual channels
+			//Unpack all eight lanes of the pod in one pass
+			PackedDigitalWaveform* packed[8];
 			for(size_t j=0; j<8; j++)
 			{
-				//Bitmask for this digital channel
-				int16_t mask = (1 << j);
-
-				//Create the waveform
-				DigitalWaveform* cap = new DigitalWaveform;
-				cap->m_timescale = fs_per_sample;
-				cap->m_triggerPhase = trigphase;
-				cap->m_startTimestamp = time(NULL);
-				cap->m_densePacked = false;
-				cap->m_startFemtoseconds = fs;
-
-				//Preallocate memory assuming no deduplication possible
-				cap->Resize(memdepth);
-
-				//First sample never gets deduplicated
-				bool last = (buf[0] & mask) ? true : false;
-				size_t k = 0;
-				cap->m_offsets[0] = 0;
-				cap->m_durations[0] = 1;
-				cap->m_samples[0] = last;
-
-				//Read and de-duplicate the other samples
-				//TODO: can we vectorize this somehow?
-				for(size_t m=1; m<memdepth; m++)
-				{
-					bool sample = (buf[m] & mask) ? true : false;
-
-					//Deduplicate consecutive samples with same value
-					//FIXME: temporary workaround for rendering bugs
-					//if(last == sample)
-					if( (last == sample) && ((m+3) < memdepth) )
-						cap->m_durations[k] ++;
-
-					//Nope, it toggled - store the new value
-					else
-					{
-						k++;
-						cap->m_offsets[k] = m;
-						cap->m_durations[k] = 1;
-						cap->m_samples[k] = sample;
-						last = sample;
-					}
-				}
-
-				//Free space reclaimed by deduplication
-				cap->Resize(k);
-				cap->m_offsets.shrink_to_fit();
-				cap->m_durations.shrink_to_fit();
-				cap->m_samples.shrink_to_fit();
+				packed[j] = g_waveformPool.Allocate<PackedDigitalWaveform>(memdepth);
+				packed[j]->m_timescale = fs_per_sample;
+				packed[j]->m_triggerPhase = trigphase;
+				packed[j]->m_startTimestamp = raw->m_timestamp;
+				packed[j]->m_startFemtoseconds = raw->m_femtoseconds;
+			}
+			PackedDigitalWaveform::PackPod(reinterpret_cast<uint16_t*>(buf), memdepth, packed);
 
-				//Done
-				s[m_channels[m_digitalChannelBase + 8*podnum + j] ] = cap;
+			//Packed waveforms are stored as-is, no deduplication
+			if(m_packDigitalWaveforms)
+			{
+				for(size_t j=0; j<8; j++)
+					s[m_channels[m_digitalChannelBase + 8*podnum + j] ] = packed[j];
 			}
 
-			delete[] buf;
+			else
+			{
+				DigitalWaveform* caps[8];
+				for(size_t j=0; j<8; j++)
+					caps[j] = g_waveformPool.Allocate<DigitalWaveform>();
+
+				//FIXME: temporary workaround for rendering bugs, never merge the last three samples
+				#pragma omp parallel for
+				for(size_t j=0; j<8; j++)
+					packed[j]->UnpackDeduplicated(caps[j], 3);
+
+				for(size_t j=0; j<8; j++)
+				{
+					s[m_channels[m_digitalChannelBase + 8*podnum + j] ] = caps[j];
+					g_waveformPool.Release(packed[j]);
+				}
+			}
 		}
 	}
 
-	//Process analog captures in parallel
-	#pragma omp parallel for
-	for(size_t i=0; i<awfms.size(); i++)
+	//Process analog captures in parallel (across both channels and samples)
+	Convert16BitSamples(jobs);
+
+	//Done with the raw data, give the buffer back to the receive thread
 	{
-		auto cap = awfms[i];
-		Convert16BitSamples(
-			(int64_t*)&cap->m_offsets[0],
-			(int64_t*)&cap->m_durations[0],
-			(float*)&cap->m_samples[0],
-			abufs[i],
-			scales[i],
-			-offsets[i],
-			cap->m_offsets.size(),
-			0);
-		delete[] abufs[i];
+		lock_guard<mutex> lock(m_rxMutex);
+		m_rxReadPos ++;
 	}
+	m_rxEvent.notify_all();
 
 	//Save the waveforms to our queue
-	m_pendingWaveformsMutex.lock();
-	m_pendingWaveforms.push_back(s);
-	m_pendingWaveformsMutex.unlock();
+	m_pendingWaveforms.Push(s);
 
 	//If this was a one-shot trigger we're no longer armed
 	if(m_triggerOneShot)
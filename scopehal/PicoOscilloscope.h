@@ -30,6 +30,8 @@
 #ifndef PicoOscilloscope_h
 #define PicoOscilloscope_h
 
+#include <condition_variable>
+
 class EdgeTrigger;
 
 /**
@@ -203,6 +205,59 @@ protected:
 
 	Series m_series;
 
+	/**
+		@brief Raw data for one capture, exactly as it came off the data plane socket
+
+		Buffers are reused from one capture to the next, so they only get reallocated when the memory depth grows.
+	 */
+	class RawCapture
+	{
+	public:
+
+		///@brief Data for one analog channel or digital pod
+		class Channel
+		{
+		public:
+			size_t m_chnum;
+
+			///@brief Scale, offset and trigger phase for analog channels, trigger phase only for digital pods
+			float m_config[3];
+
+			std::vector<int16_t, AlignedAllocator<int16_t, 64> > m_samples;
+		};
+
+		int64_t m_fsPerSample;
+		time_t m_timestamp;
+		int64_t m_femtoseconds;
+
+		///@brief Number of entries in m_channels used by this capture (the rest are kept around for their buffers)
+		size_t m_numChannels;
+		std::vector<Channel> m_channels;
+	};
+
+	bool ReceiveCapture(RawCapture& cap);
+	void ReceiveThread();
+
+	///@brief Number of captures which can be buffered between the receive thread and AcquireData()
+	enum { RX_RING_SIZE = 3 };
+
+	///@brief Ring of capture buffers filled by the receive thread
+	RawCapture m_rxRing[RX_RING_SIZE];
+
+	///@brief Number of captures written to / read from m_rxRing since startup
+	size_t m_rxWritePos;
+	size_t m_rxReadPos;
+
+	///@brief Set if the data plane socket has failed
+	bool m_rxError;
+
+	///@brief Set to make the receive thread exit
+	bool m_rxExit;
+
+	std::mutex m_rxMutex;
+	std::condition_variable m_rxEvent;
+	std::thread m_rxThread;
+
 public:
 
 	static std::string GetDriverNameInternal();
@@ -690,7 +690,7 @@ bool RigolOscilloscope::AcquireData()
 	//TODO
 	bool enabled[4] = {true, true, true, true};
 
-	lock_guard<recursive_mutex> lock(m_mutex);
+	unique_lock<recursive_mutex> lock(m_mutex);
 	LogIndenter li;
 
 	//Grab the analog waveform data
@@ -766,7 +766,7 @@ bool RigolOscilloscope::AcquireData()
 		}
 
 		//Set up the capture we're going to store our data into
-		AnalogWaveform* cap = new AnalogWaveform;
+		AnalogWaveform* cap = g_waveformPool.Allocate<AnalogWaveform>(npoints);
 		cap->m_timescale = fs_per_sample;
 		cap->m_triggerPhase = 0;
 		cap->m_startTimestamp = time(NULL);
@@ -852,19 +852,16 @@ bool RigolOscilloscope::AcquireData()
 	}
 
 	//Now that we have all of the pending waveforms, save them in sets across all channels
-	m_pendingWaveformsMutex.lock();
 	size_t num_pending = 1;	   //TODO: segmented capture support
+	vector<SequenceSet> sets(num_pending);
 	for(size_t i = 0; i < num_pending; i++)
 	{
-		SequenceSet s;
 		for(size_t j = 0; j < m_analogChannelCount; j++)
 		{
 			if(enabled[j])
-				s[m_channels[j]] = pending_waveforms[j][i];
+				sets[i][m_channels[j]] = pending_waveforms[j][i];
 		}
-		m_pendingWaveforms.push_back(s);
 	}
-	m_pendingWaveformsMutex.unlock();
 
 	//Clean up
 	delete[] temp_buf;
@@ -888,6 +885,11 @@ bool RigolOscilloscope::AcquireData()
 		m_triggerArmed = true;
 	}
 
+	//Hand off the waveforms without holding the lock, since the queue may have to wait for the consumer
+	lock.unlock();
+	for(auto& s : sets)
+		m_pendingWaveforms.Push(s);
+
 	//LogDebug("Acquisition done\n");
 
 	return true;
@@ -487,7 +487,7 @@ bool RohdeSchwarzOscilloscope::AcquireData()
 {
 	//LogDebug("Acquiring data\n");
 
-	lock_guard<recursive_mutex> lock(m_mutex);
+	unique_lock<recursive_mutex> lock(m_mutex);
 	LogIndenter li;
 
 	double xstart;
@@ -520,7 +520,7 @@ bool RohdeSchwarzOscilloscope::AcquireData()
 		float* temp_buf = new float[length];
 
 		//Set up the capture we're going to store our data into (no high res timer on R&S scopes)
-		AnalogWaveform* cap = new AnalogWaveform;
+		AnalogWaveform* cap = g_waveformPool.Allocate<AnalogWaveform>(length);
 		cap->m_timescale = fs_per_sample;
 		cap->m_triggerPhase = 0;
 		cap->m_startTimestamp = time(NULL);
@@ -570,19 +570,16 @@ bool RohdeSchwarzOscilloscope::AcquireData()
 		return false;
 	}
 	//Now that we have all of the pending waveforms, save them in sets across all channels
-	m_pendingWaveformsMutex.lock();
 	size_t num_pending = 1;	//TODO: segmented capture support
+	vector<SequenceSet> sets(num_pending);
 	for(size_t i=0; i<num_pending; i++)
 	{
-		SequenceSet s;
 		for(size_t j=0; j<m_analogChannelCount; j++)
 		{
 			if(IsChannelEnabled(j))
-				s[m_channels[j]] = pending_waveforms[j][i];
+				sets[i][m_channels[j]] = pending_waveforms[j][i];
 		}
-		m_pendingWaveforms.push_back(s);
 	}
-	m_pendingWaveformsMutex.unlock();
 
 	//TODO: support digital channels
 
@@ -593,6 +590,11 @@ bool RohdeSchwarzOscilloscope::AcquireData()
 		m_triggerArmed = true;
 	}
 
+	//Hand off the waveforms without holding the lock, since the queue may have to wait for the consumer
+	lock.unlock();
+	for(auto& s : sets)
+		m_pendingWaveforms.Push(s);
+
 	//LogDebug("Acquisition done\n");
 	return true;
 }
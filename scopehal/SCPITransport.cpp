@@ -39,7 +39,14 @@ using namespace std;
 
 SCPITransport::CreateMapType SCPITransport::m_createprocs;
 
+///@brief Maximum length of a compound message built by FlushCommandQueue()
+#define MAX_JOINED_MESSAGE_LENGTH 1024
+
+///@brief Maximum number of queries we send before reading the replies back
+#define MAX_QUERIES_IN_FLIGHT 32
+
 SCPITransport::SCPITransport()
+	: m_coalesceCommands(true)
 {
 }
 
@@ -81,25 +88,149 @@ SCPITransport* SCPITransport::CreateTransport(const string& transport, const str
 void SCPITransport::SendCommandQueued(const string& cmd)
 {
 	lock_guard<mutex> lock(m_queueMutex);
-	m_txQueue.push_back(cmd);
+	QueuedCommand c;
+	c.m_cmd = cmd;
+	c.m_endOnSemicolon = true;
+	m_txQueue.push_back(c);
 }
 
 /**
 	@brief Pushes all pending commands from SendCommandQueued() calls and blocks until they are all sent.
+
+	Replies to any pipelined queries in the queue are read back before returning.
  */
 bool SCPITransport::FlushCommandQueue()
+{
+	lock_guard<recursive_mutex> lock(m_netMutex);
+	return FlushCommandQueueUnlocked();
+}
+
+/**
+	@brief Actual implementation of FlushCommandQueue(). The caller must hold m_netMutex.
+
+	If the transport can have multiple commands in flight, everything in the queue is sent before any replies are
+	read (up to MAX_QUERIES_IN_FLIGHT queries at a time), so a batch of N queries costs one round trip rather than N.
+	Commands are also joined into compound messages ("A?;:B?") if coalescing is enabled, so the whole batch typically
+	goes out in a single send().
+ */
+bool SCPITransport::FlushCommandQueueUnlocked()
 {
 	//Grab the queue, then immediately release the mutex so we can do more queued sends
-	list<string> tmp;
+	list<QueuedCommand> tmp;
 	{
 		lock_guard<mutex> lock(m_queueMutex);
 		tmp = move(m_txQueue);
 		m_txQueue.clear();
 	}
 
-	lock_guard<recursive_mutex> lock(m_netMutex);
-	for(auto str : tmp)
-		SendCommand(str);
+	//No pipelining possible, one command at a time
+	if(!IsCommandBatchingSupported())
+	{
+		for(auto& c : tmp)
+		{
+			double start = GetTime();
+			SendCommand(c.m_cmd);
+			if(c.m_reply)
+			{
+				c.m_reply->m_reply = ReadReply(c.m_endOnSemicolon);
+				c.m_reply->m_done = true;
+			}
+			RecordLatency(c.m_cmd, GetTime() - start);
+		}
+		return true;
+	}
+
+	//Send commands in groups, reading the replies for each group once it's all been sent
+	vector<QueuedCommand> group;
+	size_t nqueries = 0;
+	for(auto& c : tmp)
+	{
+		group.push_back(c);
+		if(c.m_reply)
+			nqueries ++;
+
+		if(nqueries >= MAX_QUERIES_IN_FLIGHT)
+		{
+			SendCommandGroup(group);
+			group.clear();
+			nqueries = 0;
+		}
+	}
+	if(!group.empty())
+		SendCommandGroup(group);
+
+	return true;
+}
+
+/**
+	@brief Sends a group of commands back to back, then reads all of the replies
+ */
+void SCPITransport::SendCommandGroup(vector<QueuedCommand>& group)
+{
+	double start = GetTime();
+
+	//Build and send the messages
+	string msg;
+	for(auto& c : group)
+	{
+		if(!m_coalesceCommands || !CanJoinCommands(c))
+		{
+			if(!msg.empty())
+				SendCommand(msg);
+			msg.clear();
+			SendCommand(c.m_cmd);
+			continue;
+		}
+
+		//Start a new message if this one would get too big
+		if(!msg.empty() && (msg.length() + c.m_cmd.length() + 2 > MAX_JOINED_MESSAGE_LENGTH) )
+		{
+			SendCommand(msg);
+			msg.clear();
+		}
+
+		//Subsequent commands in a compound message are relative to the previous command's subsystem
+		//unless they start with a colon, so make every command absolute
+		if(!msg.empty())
+		{
+			if( (c.m_cmd[0] == ':') || (c.m_cmd[0] == '*') )
+				msg += ";";
+			else
+				msg += ";:";
+		}
+		msg += c.m_cmd;
+
+		//A reply that doesn't end at a semicolon runs to the end of the line, so nothing can come after it
+		if(c.m_reply && !c.m_endOnSemicolon)
+		{
+			SendCommand(msg);
+			msg.clear();
+		}
+	}
+	if(!msg.empty())
+		SendCommand(msg);
+
+	//Read the replies in order
+	for(auto& c : group)
+	{
+		if(c.m_reply)
+		{
+			c.m_reply->m_reply = ReadReply(c.m_endOnSemicolon);
+			c.m_reply->m_done = true;
+		}
+		RecordLatency(c.m_cmd, GetTime() - start);
+	}
+}
+
+/**
+	@brief Checks if a command can be part of a compound message
+ */
+bool SCPITransport::CanJoinCommands(const QueuedCommand& cmd)
+{
+	if(cmd.m_cmd.empty())
+		return false;
+	if(cmd.m_cmd.find('\n') != string::npos)
+		return false;
 	return true;
 }
 
@@ -110,8 +241,39 @@ bool SCPITransport::FlushCommandQueue()
  */
 string SCPITransport::SendCommandQueuedWithReply(string cmd, bool endOnSemicolon)
 {
-	FlushCommandQueue();
-	return SendCommandImmediateWithReply(cmd, endOnSemicolon);
+	return SendCommandQueuedWithReplyAsync(cmd, endOnSemicolon).get();
+}
+
+/**
+	@brief Pushes a query into the transmit FIFO and returns a future for the reply.
+
+	Nothing is sent until somebody calls FlushCommandQueue() or get() on one of the returned futures, at which point
+	the entire queue is sent and all outstanding replies are read. Issuing a batch of queries and then calling get()
+	on each of them thus costs one round trip instead of one per query.
+
+	The future must not outlive the transport.
+ */
+future<string> SCPITransport::SendCommandQueuedWithReplyAsync(string cmd, bool endOnSemicolon)
+{
+	auto reply = make_shared<PendingReply>();
+	reply->m_done = false;
+
+	{
+		lock_guard<mutex> lock(m_queueMutex);
+		QueuedCommand c;
+		c.m_cmd = cmd;
+		c.m_endOnSemicolon = endOnSemicolon;
+		c.m_reply = reply;
+		m_txQueue.push_back(c);
+	}
+
+	return async(launch::deferred, [this, reply]()
+		{
+			lock_guard<recursive_mutex> lock(m_netMutex);
+			if(!reply->m_done)
+				FlushCommandQueueUnlocked();
+			return reply->m_reply;
+		});
 }
 
 /**
@@ -122,8 +284,11 @@ string SCPITransport::SendCommandQueuedWithReply(string cmd, bool endOnSemicolon
 string SCPITransport::SendCommandImmediateWithReply(string cmd, bool endOnSemicolon)
 {
 	lock_guard<recursive_mutex> lock(m_netMutex);
+	double start = GetTime();
 	SendCommand(cmd);
-	return ReadReply(endOnSemicolon);
+	string ret = ReadReply(endOnSemicolon);
+	RecordLatency(cmd, GetTime() - start);
+	return ret;
 }
 
 /**
@@ -168,3 +333,91 @@ void SCPITransport::FlushRXBuffer(void)
 {
 	LogError("SCPITransport::FlushRXBuffer is unimplemented");
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Latency statistics
+
+SCPILatencyHistogram::SCPILatencyHistogram()
+	: m_count(0)
+	, m_total(0)
+	, m_min(0)
+	, m_max(0)
+{
+	for(size_t i=0; i<NUM_BUCKETS; i++)
+		m_buckets[i] = 0;
+}
+
+void SCPILatencyHistogram::AddSample(double seconds)
+{
+	if( (m_count == 0) || (seconds < m_min) )
+		m_min = seconds;
+	if( (m_count == 0) || (seconds > m_max) )
+		m_max = seconds;
+	m_count ++;
+	m_total += seconds;
+
+	size_t bucket = 0;
+	for(double us = seconds * 1e6; (us >= 2) && (bucket+1 < NUM_BUCKETS); us /= 2)
+		bucket ++;
+	m_buckets[bucket] ++;
+}
+
+/**
+	@brief Adds a latency measurement for a command
+ */
+void SCPITransport::RecordLatency(const string& cmd, double seconds)
+{
+	//Bin by header only, so "CH1:SCALE 1" and "CH1:SCALE 2" end up in the same place
+	string header = cmd.substr(0, cmd.find(' '));
+
+	lock_guard<mutex> lock(m_latencyMutex);
+	m_latencyHistograms[header].AddSample(seconds);
+}
+
+/**
+	@brief Returns a snapshot of the per-command latency histograms
+ */
+map<string, SCPILatencyHistogram> SCPITransport::GetLatencyHistograms()
+{
+	lock_guard<mutex> lock(m_latencyMutex);
+	return m_latencyHistograms;
+}
+
+void SCPITransport::ClearLatencyHistograms()
+{
+	lock_guard<mutex> lock(m_latencyMutex);
+	m_latencyHistograms.clear();
+}
+
+void SCPITransport::LogLatencyHistograms()
+{
+	auto hists = GetLatencyHistograms();
+
+	LogNotice("Command latency for %s:\n", GetConnectionString().c_str());
+	LogIndenter li;
+	for(auto it : hists)
+	{
+		auto& h = it.second;
+		LogNotice("%-30s %6lu calls, mean %9.1f us, min %9.1f us, max %9.1f us\n",
+			it.first.c_str(),
+			(unsigned long)h.m_count,
+			h.GetMean() * 1e6,
+			h.m_min * 1e6,
+			h.m_max * 1e6);
+
+		//Print the nonzero range of the histogram
+		size_t first = SCPILatencyHistogram::NUM_BUCKETS;
+		size_t last = 0;
+		for(size_t i=0; i<SCPILatencyHistogram::NUM_BUCKETS; i++)
+		{
+			if(h.m_buckets[i] == 0)
+				continue;
+			if(first == SCPILatencyHistogram::NUM_BUCKETS)
+				first = i;
+			last = i;
+		}
+		LogIndenter li2;
+		for(size_t i=first; i<=last; i++)
+			LogNotice("< %8lu us: %lu\n", 2UL << i, (unsigned long)h.m_buckets[i]);
+	}
+}
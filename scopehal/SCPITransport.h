@@ -36,6 +36,33 @@
 #ifndef SCPITransport_h
 #define SCPITransport_h
 
+#include <future>
+#include <memory>
+
+/**
+	@brief Log-scale histogram of command latencies
+
+	Bucket n counts commands that took between 2^n and 2^(n+1) microseconds (bucket 0 also holds anything faster).
+ */
+class SCPILatencyHistogram
+{
+public:
+	SCPILatencyHistogram();
+
+	void AddSample(double seconds);
+
+	double GetMean() const
+	{ return m_count ? (m_total / m_count) : 0; }
+
+	enum { NUM_BUCKETS = 24 };
+
+	uint64_t m_buckets[NUM_BUCKETS];
+	uint64_t m_count;
+	double m_total;
+	double m_min;
+	double m_max;
+};
+
 /**
 	@brief Abstraction of a transport layer for moving SCPI data between endpoints
  */
@@ -56,6 +83,26 @@ public:
 	void* SendCommandImmediateWithRawBlockReply(std::string cmd, size_t& len);
 	bool FlushCommandQueue();
 
+	//Pipelined command API
+	std::future<std::string> SendCommandQueuedWithReplyAsync(std::string cmd, bool endOnSemicolon = true);
+
+	/**
+		@brief Enables or disables joining of queued commands into a single message with semicolons
+
+		Only has any effect if IsCommandBatchingSupported() is true. Drivers for instruments whose parsers don't
+		handle compound messages properly should turn this off.
+	 */
+	void SetCommandCoalescingEnabled(bool enabled)
+	{ m_coalesceCommands = enabled; }
+
+	bool IsCommandCoalescingEnabled()
+	{ return m_coalesceCommands; }
+
+	//Latency statistics
+	std::map<std::string, SCPILatencyHistogram> GetLatencyHistograms();
+	void ClearLatencyHistograms();
+	void LogLatencyHistograms();
+
 	//Manual mutex locking for ReadRawData() etc
 	std::recursive_mutex& GetMutex()
 	{ return m_netMutex; }
@@ -83,10 +130,37 @@ protected:
 	typedef std::map< std::string, CreateProcType > CreateMapType;
 	static CreateMapType m_createprocs;
 
+	///@brief Reply to a pipelined query, filled in by FlushCommandQueue()
+	struct PendingReply
+	{
+		std::string m_reply;
+		bool m_done;
+	};
+
+	///@brief A queued command, plus a slot for its reply if it's a query
+	struct QueuedCommand
+	{
+		std::string m_cmd;
+		bool m_endOnSemicolon;
+		std::shared_ptr<PendingReply> m_reply;
+	};
+
+	bool FlushCommandQueueUnlocked();
+	void SendCommandGroup(std::vector<QueuedCommand>& group);
+	static bool CanJoinCommands(const QueuedCommand& cmd);
+	void RecordLatency(const std::string& cmd, double seconds);
+
 	//Queued commands waiting to be sent
 	std::mutex m_queueMutex;
 	std::recursive_mutex m_netMutex;
-	std::list<std::string> m_txQueue;
+	std::list<QueuedCommand> m_txQueue;
+
+	///@brief True if queued commands should be joined into compound messages
+	bool m_coalesceCommands;
+
+	///@brief Latency histograms, indexed by command header
+	std::map<std::string, SCPILatencyHistogram> m_latencyHistograms;
+	std::mutex m_latencyMutex;
 };
 
 #define TRANSPORT_INITPROC(T) \
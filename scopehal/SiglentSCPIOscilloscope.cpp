@@ -1038,7 +1038,7 @@ vector<WaveformBase*> SiglentSCPIOscilloscope::ProcessAnalogWaveform(const char*
 	for(size_t j = 0; j < num_sequences; j++)
 	{
 		//Set up the capture we're going to store our data into
-		AnalogWaveform* cap = new AnalogWaveform;
+		AnalogWaveform* cap = g_waveformPool.Allocate<AnalogWaveform>(num_per_segment);
 		cap->m_timescale = round(interval);
 
 		cap->m_triggerPhase = h_off_frac;
@@ -1149,11 +1149,11 @@ map<int, DigitalWaveform*> SiglentSCPIOscilloscope::ProcessDigitalWaveform(strin
 	tmp = data.substr(data.find("<BinaryData>") + 12);
 	tmp = tmp.substr(0, tmp.find("</BinaryData>"));
 
-	//Decode the base64
+	//Decode the base64 (in place, since we don't need the text afterwards)
 	base64_decodestate bstate;
 	base64_init_decodestate(&bstate);
-	unsigned char* block = new unsigned char[tmp.length()];	   //base64 is smaller than plaintext, leave room
-	base64_decode_block(tmp.c_str(), tmp.length(), (char*)block, &bstate);
+	base64_decode_inplace(&tmp[0], tmp.length(), &bstate);
+	unsigned char* block = reinterpret_cast<unsigned char*>(&tmp[0]);
 
 	//We have each channel's data from start to finish before the next (no interleaving).
 	//TODO: Multithread across waveforms
@@ -1162,7 +1162,7 @@ map<int, DigitalWaveform*> SiglentSCPIOscilloscope::ProcessDigitalWaveform(strin
 	{
 		if(enabledChannels[i])
 		{
-			DigitalWaveform* cap = new DigitalWaveform;
+			DigitalWaveform* cap = g_waveformPool.Allocate<DigitalWaveform>(num_samples);
 			cap->m_timescale = interval;
 			cap->m_densePacked = true;
 
@@ -1228,7 +1228,6 @@ map<int, DigitalWaveform*> SiglentSCPIOscilloscope::ProcessDigitalWaveform(strin
 		else
 			ret[m_digitalChannels[i]->GetIndex()] = NULL;
 	}
-	delete[] block;
 	return ret;
 }
 
@@ -1387,7 +1386,6 @@ bool SiglentSCPIOscilloscope::AcquireData()
 	// }
 
 	//Now that we have all of the pending waveforms, save them in sets across all channels
-	m_pendingWaveformsMutex.lock();
 	for(size_t i = 0; i < num_sequences; i++)
 	{
 		SequenceSet s;
@@ -1396,9 +1394,8 @@ bool SiglentSCPIOscilloscope::AcquireData()
 			if(pending_waveforms.find(j) != pending_waveforms.end())
 				s[m_channels[j]] = pending_waveforms[j][i];
 		}
-		m_pendingWaveforms.push_back(s);
+		m_pendingWaveforms.Push(s);
 	}
-	m_pendingWaveformsMutex.unlock();
 
 	double dt = GetTime() - start;
 	LogTrace("Waveform download and processing took %.3f ms\n", dt * 1000);
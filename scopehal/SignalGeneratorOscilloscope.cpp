@@ -133,9 +133,7 @@ bool SignalGeneratorOscilloscope::AcquireData()
 	SequenceSet s;
 	s[m_channels[0]] = waveform;
 
-	m_pendingWaveformsMutex.lock();
-	m_pendingWaveforms.push_back(s);
-	m_pendingWaveformsMutex.unlock();
+	m_pendingWaveforms.Push(s);
 
 	//Update channel voltage ranges
 	float lo = Filter::GetMinVoltage(waveform);
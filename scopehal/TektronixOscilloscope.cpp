@@ -1380,7 +1380,7 @@ bool TektronixOscilloscope::AcquireData()
 
 	map<int, vector<WaveformBase*> > pending_waveforms;
 
-	lock_guard<recursive_mutex> lock(m_transport->GetMutex());
+	unique_lock<recursive_mutex> lock(m_transport->GetMutex());
 
 	LogIndenter li;
 
@@ -1430,7 +1430,7 @@ bool TektronixOscilloscope::AcquireData()
 
 			//Set up the capture we're going to store our data into
 			//(no TDC data available on Tektronix scopes?)
-			AnalogWaveform* cap = new AnalogWaveform;
+			AnalogWaveform* cap = g_waveformPool.Allocate<AnalogWaveform>(length);
 			cap->m_timescale = fs_per_sample;
 			cap->m_triggerPhase = 0;
 			cap->m_startTimestamp = time(NULL);
@@ -1480,19 +1480,16 @@ bool TektronixOscilloscope::AcquireData()
 	}
 
 	//Now that we have all of the pending waveforms, save them in sets across all channels
-	m_pendingWaveformsMutex.lock();
 	size_t num_pending = 1;	//TODO: segmented capture support
+	vector<SequenceSet> sets(num_pending);
 	for(size_t i=0; i<num_pending; i++)
 	{
-		SequenceSet s;
 		for(size_t j=0; j<m_channels.size(); j++)
 		{
 			if(IsChannelEnabled(j))
-				s[m_channels[j]] = pending_waveforms[j][i];
+				sets[i][m_channels[j]] = pending_waveforms[j][i];
 		}
-		m_pendingWaveforms.push_back(s);
 	}
-	m_pendingWaveformsMutex.unlock();
 
 	//Re-arm the trigger if not in one-shot mode
 	if(!m_triggerOneShot)
@@ -1504,6 +1501,11 @@ bool TektronixOscilloscope::AcquireData()
 		m_triggerArmed = true;
 	}
 
+	//Hand off the waveforms without holding the lock, since the queue may have to wait for the consumer
+	lock.unlock();
+	for(auto& s : sets)
+		m_pendingWaveforms.Push(s);
+
 	//LogDebug("Acquisition done\n");
 	return true;
 }
@@ -1590,7 +1592,7 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 
 		//Set up the capture we're going to store our data into
 		//(no TDC data or fine timestamping available on Tektronix scopes?)
-		AnalogWaveform* cap = new AnalogWaveform;
+		AnalogWaveform* cap = g_waveformPool.Allocate<AnalogWaveform>(nsamples);
 		cap->m_densePacked = true;
 		cap->m_timescale = timebase;
 		cap->m_triggerPhase = 0;
@@ -1670,7 +1672,7 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 
 		//Set up the capture we're going to store our data into
 		//(no TDC data or fine timestamping available on Tektronix scopes?)
-		AnalogWaveform* cap = new AnalogWaveform;
+		AnalogWaveform* cap = g_waveformPool.Allocate<AnalogWaveform>(nsamples);
 		cap->m_timescale = hzbase;
 		cap->m_triggerPhase = 0;
 		cap->m_startTimestamp = time(NULL);
@@ -1768,7 +1770,7 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 		{
 			//Set up the capture we're going to store our data into
 			//(no TDC data or fine timestamping available on Tektronix scopes?)
-			DigitalWaveform* cap = new DigitalWaveform;
+			DigitalWaveform* cap = g_waveformPool.Allocate<DigitalWaveform>(msglen);
 			cap->m_timescale = timebase;
 			cap->m_triggerPhase = 0;
 			cap->m_startTimestamp = time(NULL);
@@ -2428,8 +2430,15 @@ void TektronixOscilloscope::PullPulseWidthTrigger()
 		case FAMILY_MSO5:
 		case FAMILY_MSO6:
 			{
+				//Pipeline all of the queries so we only pay for one round trip
+				auto source = m_transport->SendCommandQueuedWithReplyAsync("TRIG:A:PULSEW:SOU?");
+				auto highl = m_transport->SendCommandQueuedWithReplyAsync("TRIG:A:PULSEW:HIGHL?");
+				auto lowl = m_transport->SendCommandQueuedWithReplyAsync("TRIG:A:PULSEW:LOWL?");
+				auto pol = m_transport->SendCommandQueuedWithReplyAsync("TRIG:A:PULSEW:POL?");
+				auto whe = m_transport->SendCommandQueuedWithReplyAsync("TRIG:A:PULSEW:WHE?");
+
 				//Source channel
-				auto reply = m_transport->SendCommandQueuedWithReply("TRIG:A:PULSEW:SOU?");
+				auto reply = source.get();
 				et->SetInput(0, StreamDescriptor(GetChannelByHwName(reply), 0), true);
 
 				//TODO: TRIG:A:PULSEW:LOGICQUAL?
@@ -2438,18 +2447,18 @@ void TektronixOscilloscope::PullPulseWidthTrigger()
 				et->SetLevel(ReadTriggerLevelMSO56(GetChannelByHwName(reply)));
 
 				Unit fs(Unit::UNIT_FS);
-				et->SetUpperBound(fs.ParseString(m_transport->SendCommandQueuedWithReply("TRIG:A:PULSEW:HIGHL?")));
-				et->SetLowerBound(fs.ParseString(m_transport->SendCommandQueuedWithReply("TRIG:A:PULSEW:LOWL?")));
+				et->SetUpperBound(fs.ParseString(highl.get()));
+				et->SetLowerBound(fs.ParseString(lowl.get()));
 
 				//Edge slope
-				reply = Trim(m_transport->SendCommandQueuedWithReply("TRIG:A:PULSEW:POL?"));
+				reply = Trim(pol.get());
 				if(reply == "POS")
 					et->SetType(EdgeTrigger::EDGE_RISING);
 				else if(reply == "NEG")
 					et->SetType(EdgeTrigger::EDGE_FALLING);
 
 				//Condition
-				reply = Trim(m_transport->SendCommandQueuedWithReply("TRIG:A:PULSEW:WHE?"));
+				reply = Trim(whe.get());
 				if(reply == "LESS")
 					et->SetCondition(Trigger::CONDITION_LESS);
 				if(reply == "MORE")
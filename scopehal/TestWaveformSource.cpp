@@ -84,7 +84,7 @@ WaveformBase* TestWaveformSource::GenerateStep(
 	int64_t sampleperiod,
 	size_t depth)
 {
-	auto ret = new AnalogWaveform;
+	auto ret = g_waveformPool.Allocate<AnalogWaveform>(depth);
 	ret->m_timescale = sampleperiod;
 	ret->Resize(depth);
 
@@ -114,7 +114,7 @@ WaveformBase* TestWaveformSource::GenerateNoisySinewave(
 	size_t depth,
 	float noise_amplitude)
 {
-	auto ret = new AnalogWaveform;
+	auto ret = g_waveformPool.Allocate<AnalogWaveform>(depth);
 	ret->m_timescale = sampleperiod;
 	ret->Resize(depth);
 
@@ -150,7 +150,7 @@ WaveformBase* TestWaveformSource::GenerateNoisySinewaveMix(
 	size_t depth,
 	float noise_amplitude)
 {
-	auto ret = new AnalogWaveform;
+	auto ret = g_waveformPool.Allocate<AnalogWaveform>(depth);
 	ret->m_timescale = sampleperiod;
 	ret->Resize(depth);
 
@@ -185,7 +185,7 @@ WaveformBase* TestWaveformSource::GeneratePRBS31(
 	float noise_amplitude
 	)
 {
-	auto ret = new AnalogWaveform;
+	auto ret = g_waveformPool.Allocate<AnalogWaveform>(depth);
 	ret->m_timescale = sampleperiod;
 	ret->Resize(depth);
 
@@ -243,7 +243,7 @@ WaveformBase* TestWaveformSource::Generate8b10b(
 	bool lpf,
 	float noise_amplitude)
 {
-	auto ret = new AnalogWaveform;
+	auto ret = g_waveformPool.Allocate<AnalogWaveform>(depth);
 	ret->m_timescale = sampleperiod;
 	ret->Resize(depth);
 
@@ -85,6 +85,7 @@ public:
 		, m_startFemtoseconds(0)
 		, m_triggerPhase(0)
 		, m_densePacked(false)
+		, m_implicitTimestamps(false)
 	{}
 
 	//empty virtual destructor in case any derived classes need one
@@ -127,6 +128,16 @@ public:
 	 */
 	bool m_densePacked;
 
+	/**
+		@brief True if the waveform is dense packed and m_offsets / m_durations are not stored at all.
+
+		This saves 16 bytes of memory (and bandwidth) per sample. Code which may see such waveforms must use
+		GetOffset() / GetDuration() rather than indexing the vectors directly, or call MaterializeTimestamps() first.
+
+		Filters only receive waveforms with implicit timestamps if they override Filter::SupportsImplicitTimestamps().
+	 */
+	bool m_implicitTimestamps;
+
 	///@brief Start timestamps of each sample
 	std::vector<
 		EmptyConstructorWrapper<int64_t>,
@@ -139,6 +150,85 @@ public:
 		AlignedAllocator< EmptyConstructorWrapper<int64_t>, 64 >
 		> m_durations;
 
+	///@brief Gets the number of samples in the waveform
+	virtual size_t size() const
+	{ return m_offsets.size(); }
+
+	///@brief Gets the number of samples the waveform can hold without reallocating
+	virtual size_t capacity() const
+	{ return m_offsets.capacity(); }
+
+	///@brief Gets the number of bytes of sample and timestamp memory allocated by the waveform
+	virtual size_t GetAllocatedBytes() const
+	{ return (m_offsets.capacity() + m_durations.capacity()) * sizeof(int64_t); }
+
+	///@brief Gets the start time of a sample, in timebase units
+	int64_t GetOffset(size_t i)
+	{
+		if(m_densePacked)
+			return i;
+		return m_offsets[i];
+	}
+
+	///@brief Gets the duration of a sample, in timebase units
+	int64_t GetDuration(size_t i)
+	{
+		if(m_densePacked)
+			return 1;
+		return m_durations[i];
+	}
+
+	/**
+		@brief Switches the waveform to dense packed with implicit timestamps and frees the offset/duration arrays.
+	 */
+	void SetImplicitTimestamps()
+	{
+		m_densePacked = true;
+		m_implicitTimestamps = true;
+
+		m_offsets.clear();
+		m_offsets.shrink_to_fit();
+		m_durations.clear();
+		m_durations.shrink_to_fit();
+	}
+
+	/**
+		@brief Creates real offset/duration arrays for a waveform with implicit timestamps.
+
+		No-op if the timestamps are already stored.
+	 */
+	void MaterializeTimestamps()
+	{
+		if(!m_implicitTimestamps)
+			return;
+
+		m_implicitTimestamps = false;
+
+		size_t len = size();
+		m_offsets.resize(len);
+		m_durations.resize(len);
+		FillDenseTimestamps(0, len);
+	}
+
+	/**
+		@brief Fills timestamps [start, end) of a dense packed waveform with their (known) values.
+
+		No-op if timestamps are implicit.
+	 */
+	void FillDenseTimestamps(size_t start, size_t end)
+	{
+		if(m_implicitTimestamps || (start >= end) )
+			return;
+
+		int64_t* offs = reinterpret_cast<int64_t*>(&m_offsets[0]);
+		int64_t* durs = reinterpret_cast<int64_t*>(&m_durations[0]);
+		for(size_t i=start; i<end; i++)
+		{
+			offs[i] = i;
+			durs[i] = 1;
+		}
+	}
+
 	virtual void clear()
 	{
 		m_offsets.clear();
@@ -147,6 +237,9 @@ public:
 
 	virtual void Resize(size_t size)
 	{
+		if(m_implicitTimestamps)
+			return;
+
 		m_offsets.resize(size);
 		m_durations.resize(size);
 	}
@@ -158,6 +251,14 @@ public:
 	 */
 	void CopyTimestamps(const WaveformBase* rhs)
 	{
+		if(m_implicitTimestamps)
+			return;
+		if(rhs->m_implicitTimestamps)
+		{
+			FillDenseTimestamps(0, m_offsets.size());
+			return;
+		}
+
 		size_t len = sizeof(int64_t) * rhs->m_offsets.size();
 		memcpy((void*)&m_offsets[0], (void*)&rhs->m_offsets[0], len);
 		memcpy((void*)&m_durations[0], (void*)&rhs->m_durations[0], len);
@@ -175,10 +276,22 @@ public:
 	///@brief Sample data
 	std::vector< S, AlignedAllocator<S, 64> > m_samples;
 
+	virtual size_t size() const
+	{ return m_samples.size(); }
+
+	virtual size_t capacity() const
+	{ return m_samples.capacity(); }
+
+	virtual size_t GetAllocatedBytes() const
+	{ return WaveformBase::GetAllocatedBytes() + m_samples.capacity() * sizeof(S); }
+
 	virtual void Resize(size_t size)
 	{
-		m_offsets.resize(size);
-		m_durations.resize(size);
+		if(!m_implicitTimestamps)
+		{
+			m_offsets.resize(size);
+			m_durations.resize(size);
+		}
 		m_samples.resize(size);
 	}
 
@@ -0,0 +1,989 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of WaveformArchiveWriter and WaveformArchiveReader
+ */
+
+#include "scopehal.h"
+#include "WaveformArchive.h"
+#include <algorithm>
+
+using namespace std;
+
+static const char g_archiveMagic[8] = {'S', 'C', 'O', 'P', 'E', 'H', 'A', 'L'};
+static const char g_footerMagic[8] = {'S', 'H', 'W', 'A', 'I', 'N', 'D', 'X'};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Varint helpers
+
+static inline uint64_t ZigZagEncode(int64_t v)
+{
+	return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+static inline int64_t ZigZagDecode(uint64_t v)
+{
+	return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+static inline void PutVarint(vector<uint8_t>& out, uint64_t v)
+{
+	while(v >= 0x80)
+	{
+		out.push_back( (v & 0x7f) | 0x80);
+		v >>= 7;
+	}
+	out.push_back(v);
+}
+
+static inline bool GetVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v)
+{
+	v = 0;
+	for(int shift=0; shift<64; shift += 7)
+	{
+		if(p >= end)
+			return false;
+		uint8_t b = *(p++);
+		v |= static_cast<uint64_t>(b & 0x7f) << shift;
+		if(!(b & 0x80))
+			return true;
+	}
+	return false;
+}
+
+static inline void PutString(vector<uint8_t>& out, const string& s)
+{
+	uint32_t len = s.length();
+	out.insert(out.end(), (uint8_t*)&len, (uint8_t*)&len + sizeof(len));
+	out.insert(out.end(), s.begin(), s.end());
+}
+
+static inline bool GetString(const uint8_t*& p, const uint8_t* end, string& s)
+{
+	uint32_t len;
+	if(p + sizeof(len) > end)
+		return false;
+	memcpy(&len, p, sizeof(len));
+	p += sizeof(len);
+	if(len > (size_t)(end - p))
+		return false;
+	s.assign((const char*)p, len);
+	p += len;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Block compression
+
+/*
+	LZ4 block format: a series of sequences, each a token (literal length in the high nibble, match length - 4 in the
+	low nibble, 15 meaning "more length bytes follow"), the literals, then a 16-bit little endian match offset and any
+	extra match length bytes. The final sequence has only literals.
+
+	This is a greedy single-probe compressor. It's nowhere near as tight as zstd but runs at memory bandwidth, which is
+	what matters when streaming thousands of triggers to disk.
+ */
+
+static inline uint32_t Read32(const uint8_t* p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline void PutLength(vector<uint8_t>& out, size_t len)
+{
+	while(len >= 255)
+	{
+		out.push_back(255);
+		len -= 255;
+	}
+	out.push_back(len);
+}
+
+static void EmitSequence(vector<uint8_t>& out, const uint8_t* literals, size_t nliterals, size_t offset, size_t mlen)
+{
+	size_t mcode = mlen ? mlen - 4 : 0;
+	out.push_back( (min(nliterals, (size_t)15) << 4) | min(mcode, (size_t)15) );
+	if(nliterals >= 15)
+		PutLength(out, nliterals - 15);
+	out.insert(out.end(), literals, literals + nliterals);
+
+	if(mlen)
+	{
+		out.push_back(offset & 0xff);
+		out.push_back(offset >> 8);
+		if(mcode >= 15)
+			PutLength(out, mcode - 15);
+	}
+}
+
+/**
+	@brief Compresses a buffer in LZ4 block format
+ */
+void WaveformArchive::Compress(const uint8_t* in, size_t len, vector<uint8_t>& out)
+{
+	const int hashBits = 16;
+	const size_t lastLiterals = 5;		//the last 5 bytes are always literals
+	const size_t matchFindLimit = 12;	//and the last match must start at least 12 bytes from the end
+
+	out.clear();
+	out.reserve(len + len/255 + 16);
+
+	size_t anchor = 0;
+	if(len > matchFindLimit)
+	{
+		vector<uint32_t> table(1 << hashBits, 0);
+		size_t matchLimit = len - lastLiterals;
+
+		size_t ip = 1;
+		while(ip + matchFindLimit <= len)
+		{
+			uint32_t seq = Read32(in + ip);
+			uint32_t h = (seq * 2654435761U) >> (32 - hashBits);
+			size_t ref = table[h];
+			table[h] = ip;
+
+			if( (ip - ref > 65535) || (Read32(in + ref) != seq) )
+			{
+				//Skip faster through data that isn't compressing
+				ip += 1 + ( (ip - anchor) >> 6);
+				continue;
+			}
+
+			size_t mlen = 4;
+			while( (ip + mlen < matchLimit) && (in[ref + mlen] == in[ip + mlen]) )
+				mlen ++;
+
+			EmitSequence(out, in + anchor, ip - anchor, ip - ref, mlen);
+			ip += mlen;
+			anchor = ip;
+		}
+	}
+
+	EmitSequence(out, in + anchor, len - anchor, 0, 0);
+}
+
+/**
+	@brief Decompresses an LZ4 block, checking every length and offset against the buffer bounds
+
+	@return True if the block decoded to exactly outlen bytes
+ */
+bool WaveformArchive::Decompress(const uint8_t* in, size_t inlen, uint8_t* out, size_t outlen)
+{
+	size_t ip = 0;
+	size_t op = 0;
+	while(ip < inlen)
+	{
+		uint8_t token = in[ip++];
+
+		//Literals
+		size_t nliterals = token >> 4;
+		if(nliterals == 15)
+		{
+			uint8_t b;
+			do
+			{
+				if(ip >= inlen)
+					return false;
+				b = in[ip++];
+				nliterals += b;
+			} while(b == 255);
+		}
+		if( (nliterals > inlen - ip) || (nliterals > outlen - op) )
+			return false;
+		memcpy(out + op, in + ip, nliterals);
+		ip += nliterals;
+		op += nliterals;
+
+		//Last sequence has no match
+		if(ip == inlen)
+			break;
+
+		//Match
+		if(ip + 2 > inlen)
+			return false;
+		size_t offset = in[ip] | (in[ip+1] << 8);
+		ip += 2;
+		if( (offset == 0) || (offset > op) )
+			return false;
+
+		size_t mlen = token & 0xf;
+		if(mlen == 15)
+		{
+			uint8_t b;
+			do
+			{
+				if(ip >= inlen)
+					return false;
+				b = in[ip++];
+				mlen += b;
+			} while(b == 255);
+		}
+		mlen += 4;
+		if(mlen > outlen - op)
+			return false;
+
+		//Matches may overlap the bytes they produce, so copy forward a byte at a time in that case
+		const uint8_t* src = out + op - offset;
+		if(offset >= mlen)
+			memcpy(out + op, src, mlen);
+		else
+		{
+			for(size_t i=0; i<mlen; i++)
+				out[op + i] = src[i];
+		}
+		op += mlen;
+	}
+
+	return op == outlen;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Waveform encoding
+
+/**
+	@brief Serializes a waveform into the archive body format
+
+	@return False if the waveform type can't be archived
+ */
+bool WaveformArchive::EncodeWaveform(WaveformBase* wfm, bool compress, WaveformHeader& header, vector<uint8_t>& body)
+{
+	auto awfm = dynamic_cast<AnalogWaveform*>(wfm);
+	auto dwfm = dynamic_cast<DigitalWaveform*>(wfm);
+	auto pwfm = dynamic_cast<PackedDigitalWaveform*>(wfm);
+	if(!awfm && !dwfm && !pwfm)
+		return false;
+
+	size_t len = wfm->size();
+	header.m_format = awfm ? FORMAT_ANALOG : FORMAT_DIGITAL;
+	header.m_flags = 0;
+	header.m_reserved = 0;
+	header.m_timescale = wfm->m_timescale;
+	header.m_startTimestamp = wfm->m_startTimestamp;
+	header.m_startFemtoseconds = wfm->m_startFemtoseconds;
+	header.m_triggerPhase = wfm->m_triggerPhase;
+	header.m_numSamples = len;
+
+	size_t sampleBytes = awfm ? len * sizeof(float) : (len + 7) / 8;
+	vector<uint8_t> raw;
+	raw.reserve(sampleBytes + (wfm->m_densePacked ? 0 : 4*len) + 16);
+
+	//Timestamps
+	if(wfm->m_densePacked)
+		header.m_flags |= FLAG_DENSE_PACKED;
+	else
+	{
+		int64_t* offs = (int64_t*)&wfm->m_offsets[0];
+		int64_t* durs = (int64_t*)&wfm->m_durations[0];
+
+		int64_t prev = 0;
+		for(size_t i=0; i<len; i++)
+		{
+			PutVarint(raw, ZigZagEncode(offs[i] - prev));
+			prev = offs[i];
+		}
+
+		//Most sparse waveforms are RLE'd, with each sample lasting until the next, so only the last duration is needed
+		bool contiguous = true;
+		for(size_t i=0; i+1<len; i++)
+		{
+			if(durs[i] != offs[i+1] - offs[i])
+			{
+				contiguous = false;
+				break;
+			}
+		}
+		if(contiguous)
+		{
+			header.m_flags |= FLAG_CONTIGUOUS_DURATIONS;
+			if(len)
+				PutVarint(raw, ZigZagEncode(durs[len-1]));
+		}
+		else
+		{
+			for(size_t i=0; i<len; i++)
+				PutVarint(raw, ZigZagEncode(durs[i]));
+		}
+	}
+
+	//Samples
+	size_t base = raw.size();
+	raw.resize(base + sampleBytes);
+	uint8_t* out = &raw[base];
+	if(awfm)
+	{
+		//Shuffle into byte planes so that the slowly varying sign/exponent bytes end up next to each other
+		auto in = reinterpret_cast<const uint8_t*>(&awfm->m_samples[0]);
+		for(size_t i=0; i<len; i++)
+		{
+			for(size_t k=0; k<4; k++)
+				out[k*len + i] = in[i*4 + k];
+		}
+	}
+	else if(pwfm)
+		memcpy(out, &pwfm->m_words[0], sampleBytes);
+	else
+	{
+		memset(out, 0, sampleBytes);
+		for(size_t i=0; i<len; i++)
+		{
+			if(dwfm->m_samples[i])
+				out[i >> 3] |= (1 << (i & 7));
+		}
+	}
+	header.m_rawLength = raw.size();
+
+	//Only keep the compressed copy if it actually helped
+	if(compress)
+	{
+		Compress(raw.data(), raw.size(), body);
+		if(body.size() < raw.size())
+		{
+			header.m_flags |= FLAG_COMPRESSED;
+			return true;
+		}
+	}
+
+	body.swap(raw);
+	return true;
+}
+
+/**
+	@brief Deserializes a waveform from the archive body format
+
+	@return The waveform (allocated from the pool), or NULL if the record is malformed
+ */
+WaveformBase* WaveformArchive::DecodeWaveform(const WaveformHeader& header, const uint8_t* body, size_t bodylen)
+{
+	if( (header.m_format != FORMAT_ANALOG) && (header.m_format != FORMAT_DIGITAL) )
+		return NULL;
+	bool analog = (header.m_format == FORMAT_ANALOG);
+
+	//Sanity check the sizes before allocating anything.
+	//Each compressed sequence expands to at most 255 bytes per input byte, so that bounds the raw body size.
+	bool compressed = (header.m_flags & FLAG_COMPRESSED) != 0;
+	if(compressed && (bodylen > SIZE_MAX / 255) )
+		return NULL;
+	uint64_t maxRawLength = compressed ? bodylen * 255 : bodylen;
+	if(header.m_rawLength > maxRawLength)
+		return NULL;
+
+	//Every sample takes at least some space in the raw body, so that bounds the sample count (and keeps the size
+	//arithmetic below from overflowing)
+	uint64_t maxSamples = analog ? header.m_rawLength / sizeof(float) : header.m_rawLength * 8;
+	if(header.m_numSamples > maxSamples)
+		return NULL;
+	size_t len = header.m_numSamples;
+	size_t sampleBytes = analog ? len * sizeof(float) : (len + 7) / 8;
+
+	//Timestamps are at most 10 bytes per varint
+	if( (header.m_rawLength < sampleBytes) || (header.m_rawLength > sampleBytes + 20*len + 10) )
+		return NULL;
+
+	vector<uint8_t> tmp;
+	if(compressed)
+	{
+		tmp.resize(header.m_rawLength);
+		if(!Decompress(body, bodylen, tmp.data(), tmp.size()))
+			return NULL;
+		body = tmp.data();
+		bodylen = tmp.size();
+	}
+	else if(bodylen != header.m_rawLength)
+		return NULL;
+	const uint8_t* p = body;
+	const uint8_t* end = body + bodylen;
+
+	WaveformBase* wfm;
+	if(analog)
+		wfm = g_waveformPool.Allocate<AnalogWaveform>(len);
+	else
+		wfm = g_waveformPool.Allocate<DigitalWaveform>(len);
+	wfm->m_timescale = header.m_timescale;
+	wfm->m_startTimestamp = header.m_startTimestamp;
+	wfm->m_startFemtoseconds = header.m_startFemtoseconds;
+	wfm->m_triggerPhase = header.m_triggerPhase;
+	wfm->m_densePacked = (header.m_flags & FLAG_DENSE_PACKED) != 0;
+	wfm->Resize(len);
+
+	//Timestamps
+	if(wfm->m_densePacked)
+		wfm->FillDenseTimestamps(0, len);
+	else
+	{
+		int64_t* offs = (int64_t*)&wfm->m_offsets[0];
+		int64_t* durs = (int64_t*)&wfm->m_durations[0];
+
+		bool ok = true;
+		uint64_t v;
+		int64_t prev = 0;
+		for(size_t i=0; ok && (i<len); i++)
+		{
+			ok = GetVarint(p, end, v);
+			prev += ZigZagDecode(v);
+			offs[i] = prev;
+		}
+
+		if(header.m_flags & FLAG_CONTIGUOUS_DURATIONS)
+		{
+			for(size_t i=0; i+1<len; i++)
+				durs[i] = offs[i+1] - offs[i];
+			if(ok && len)
+			{
+				ok = GetVarint(p, end, v);
+				durs[len-1] = ZigZagDecode(v);
+			}
+		}
+		else
+		{
+			for(size_t i=0; ok && (i<len); i++)
+			{
+				ok = GetVarint(p, end, v);
+				durs[i] = ZigZagDecode(v);
+			}
+		}
+
+		if(!ok)
+		{
+			g_waveformPool.Release(wfm);
+			return NULL;
+		}
+	}
+
+	//Samples
+	if(sampleBytes != (size_t)(end - p))
+	{
+		g_waveformPool.Release(wfm);
+		return NULL;
+	}
+	if(analog)
+	{
+		auto out = reinterpret_cast<uint8_t*>(&static_cast<AnalogWaveform*>(wfm)->m_samples[0]);
+		for(size_t i=0; i<len; i++)
+		{
+			for(size_t k=0; k<4; k++)
+				out[i*4 + k] = p[k*len + i];
+		}
+	}
+	else
+	{
+		auto dwfm = static_cast<DigitalWaveform*>(wfm);
+		for(size_t i=0; i<len; i++)
+			dwfm->m_samples[i] = (p[i >> 3] >> (i & 7)) & 1;
+	}
+
+	return wfm;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// WaveformArchiveWriter
+
+WaveformArchiveWriter::WaveformArchiveWriter(const string& path, bool compress)
+	: m_compress(compress)
+	, m_fileOffset(0)
+	, m_nextTrigger(0)
+	, m_rawBytes(0)
+{
+	m_fp = fopen(path.c_str(), "wb");
+	if(!m_fp)
+	{
+		LogError("WaveformArchiveWriter: could not create \"%s\"\n", path.c_str());
+		return;
+	}
+
+	WaveformArchive::FileHeader header;
+	memcpy(header.m_magic, g_archiveMagic, sizeof(header.m_magic));
+	header.m_version = WaveformArchive::VERSION;
+	header.m_flags = 0;
+	if(1 != fwrite(&header, sizeof(header), 1, m_fp))
+	{
+		LogError("WaveformArchiveWriter: could not write to \"%s\"\n", path.c_str());
+		fclose(m_fp);
+		m_fp = NULL;
+		return;
+	}
+	m_fileOffset = sizeof(header);
+}
+
+WaveformArchiveWriter::~WaveformArchiveWriter()
+{
+	Close();
+}
+
+/**
+	@brief Writes the index and footer, then closes the file
+ */
+bool WaveformArchiveWriter::Close()
+{
+	if(!m_fp)
+		return false;
+
+	WaveformArchive::Footer footer;
+	footer.m_indexOffset = m_fileOffset;
+	memcpy(footer.m_magic, g_footerMagic, sizeof(footer.m_magic));
+
+	bool ok = WriteRecord(
+		WaveformArchive::RECORD_INDEX,
+		NULL,
+		0,
+		m_index.data(),
+		m_index.size() * sizeof(WaveformArchiveIndexEntry));
+	if(ok)
+		ok = (1 == fwrite(&footer, sizeof(footer), 1, m_fp));
+	if(0 != fclose(m_fp))
+		ok = false;
+	m_fp = NULL;
+
+	if(!ok)
+		LogError("WaveformArchiveWriter: failed to write index\n");
+	return ok;
+}
+
+/**
+	@brief Appends one record to the file
+ */
+bool WaveformArchiveWriter::WriteRecord(uint32_t type, const void* header, size_t headerLen, const void* body, size_t bodyLen)
+{
+	WaveformArchive::RecordHeader rh;
+	rh.m_type = type;
+	rh.m_reserved = 0;
+	rh.m_length = headerLen + bodyLen;
+
+	if(1 != fwrite(&rh, sizeof(rh), 1, m_fp))
+		return false;
+	if(headerLen && (1 != fwrite(header, headerLen, 1, m_fp)) )
+		return false;
+	if(bodyLen && (1 != fwrite(body, bodyLen, 1, m_fp)) )
+		return false;
+
+	m_fileOffset += sizeof(rh) + rh.m_length;
+	return true;
+}
+
+/**
+	@brief Gets the archive ID of a channel, writing a channel record the first time we see it
+ */
+uint32_t WaveformArchiveWriter::GetChannelID(OscilloscopeChannel* chan)
+{
+	auto it = m_channelIDs.find(chan);
+	if(it != m_channelIDs.end())
+		return it->second;
+
+	uint32_t id = m_channelIDs.size();
+	m_channelIDs[chan] = id;
+
+	vector<uint8_t> payload;
+	uint32_t fields[6] =
+	{
+		id,
+		static_cast<uint32_t>(chan->GetType()),
+		static_cast<uint32_t>(chan->GetXAxisUnits().GetType()),
+		static_cast<uint32_t>(chan->GetYAxisUnits().GetType()),
+		static_cast<uint32_t>(chan->GetWidth()),
+		static_cast<uint32_t>(chan->GetStreamCount())
+	};
+	payload.insert(payload.end(), (uint8_t*)fields, (uint8_t*)fields + sizeof(fields));
+	PutString(payload, chan->GetHwname());
+	PutString(payload, chan->m_displaycolor);
+	for(size_t i=0; i<chan->GetStreamCount(); i++)
+		PutString(payload, chan->GetStreamName(i));
+
+	WaveformArchiveIndexEntry entry;
+	entry.m_trigger = 0;
+	entry.m_channel = id;
+	entry.m_stream = 0;
+	entry.m_recordType = WaveformArchive::RECORD_CHANNEL;
+	entry.m_offset = m_fileOffset;
+	entry.m_length = payload.size();
+	if(WriteRecord(WaveformArchive::RECORD_CHANNEL, NULL, 0, payload.data(), payload.size()))
+		m_index.push_back(entry);
+
+	return id;
+}
+
+/**
+	@brief Appends the current waveform on every stream of every channel of a scope as a new trigger
+ */
+bool WaveformArchiveWriter::AddTrigger(Oscilloscope* scope)
+{
+	vector<Item> items;
+	for(size_t i=0; i<scope->GetChannelCount(); i++)
+	{
+		auto chan = scope->GetChannel(i);
+		for(size_t j=0; j<chan->GetStreamCount(); j++)
+		{
+			auto data = chan->GetData(j);
+			if(data)
+				items.push_back(Item{chan, j, data});
+		}
+	}
+	return WriteTrigger(items);
+}
+
+/**
+	@brief Appends a set of waveforms pulled from an oscilloscope's pending queue as a new trigger
+ */
+bool WaveformArchiveWriter::AddTrigger(const PendingWaveformQueue::SequenceSet& set)
+{
+	vector<Item> items;
+	for(auto it : set)
+		items.push_back(Item{it.first, 0, it.second});
+	return WriteTrigger(items);
+}
+
+bool WaveformArchiveWriter::WriteTrigger(const vector<Item>& items)
+{
+	if(!m_fp)
+		return false;
+
+	//Channel records have to be written before anything that refers to them
+	size_t count = items.size();
+	vector<WaveformArchive::WaveformHeader> headers(count);
+	for(size_t i=0; i<count; i++)
+	{
+		headers[i].m_trigger = m_nextTrigger;
+		headers[i].m_channel = GetChannelID(items[i].m_channel);
+		headers[i].m_stream = items[i].m_stream;
+	}
+
+	//Encode and compress all of the channels in parallel
+	vector< vector<uint8_t> > bodies(count);
+	vector<uint8_t> valid(count);
+	#pragma omp parallel for
+	for(size_t i=0; i<count; i++)
+		valid[i] = WaveformArchive::EncodeWaveform(items[i].m_waveform, m_compress, headers[i], bodies[i]);
+
+	//then write them out in order
+	for(size_t i=0; i<count; i++)
+	{
+		if(!valid[i])
+		{
+			LogWarning("WaveformArchiveWriter: skipping %s (waveform type not supported)\n",
+				items[i].m_channel->GetHwname().c_str());
+			continue;
+		}
+
+		WaveformArchiveIndexEntry entry;
+		entry.m_trigger = headers[i].m_trigger;
+		entry.m_channel = headers[i].m_channel;
+		entry.m_stream = headers[i].m_stream;
+		entry.m_recordType = WaveformArchive::RECORD_WAVEFORM;
+		entry.m_offset = m_fileOffset;
+		entry.m_length = sizeof(headers[i]) + bodies[i].size();
+
+		if(!WriteRecord(
+			WaveformArchive::RECORD_WAVEFORM,
+			&headers[i],
+			sizeof(headers[i]),
+			bodies[i].data(),
+			bodies[i].size()))
+		{
+			LogError("WaveformArchiveWriter: write failed\n");
+			return false;
+		}
+
+		m_index.push_back(entry);
+		m_rawBytes += headers[i].m_rawLength;
+	}
+
+	m_nextTrigger ++;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// WaveformArchiveReader
+
+WaveformArchiveReader::WaveformArchiveReader()
+{
+}
+
+WaveformArchiveReader::~WaveformArchiveReader()
+{
+}
+
+/**
+	@brief Opens an archive and loads its index. No waveform data is read.
+ */
+bool WaveformArchiveReader::Open(const string& path)
+{
+	m_channels.clear();
+	m_index.clear();
+	m_triggerStart.clear();
+
+	if(!m_file.Open(path))
+		return false;
+
+	WaveformArchive::FileHeader header;
+	if(m_file.GetSize() < sizeof(header))
+	{
+		LogError("WaveformArchiveReader: \"%s\" is too small to be a waveform archive\n", path.c_str());
+		return false;
+	}
+	memcpy(&header, m_file.GetData(), sizeof(header));
+	if(0 != memcmp(header.m_magic, g_archiveMagic, sizeof(header.m_magic)))
+	{
+		LogError("WaveformArchiveReader: \"%s\" is not a waveform archive\n", path.c_str());
+		return false;
+	}
+	if(header.m_version != WaveformArchive::VERSION)
+	{
+		LogError("WaveformArchiveReader: unsupported archive version %u\n", header.m_version);
+		return false;
+	}
+
+	if(!ReadIndex())
+	{
+		LogWarning("WaveformArchiveReader: no valid index (file was not closed cleanly?), scanning records\n");
+		m_channels.clear();
+		m_index.clear();
+		if(!ScanRecords())
+			return false;
+	}
+
+	if(!BuildTriggerTable())
+	{
+		LogError("WaveformArchiveReader: \"%s\" has a corrupted index\n", path.c_str());
+		return false;
+	}
+
+	LogTrace("Opened waveform archive \"%s\": %zu channels, %zu triggers\n",
+		path.c_str(), m_channels.size(), GetTriggerCount());
+	return true;
+}
+
+/**
+	@brief Loads the index pointed to by the footer
+ */
+bool WaveformArchiveReader::ReadIndex()
+{
+	const uint8_t* data = m_file.GetData();
+	size_t size = m_file.GetSize();
+
+	WaveformArchive::Footer footer;
+	WaveformArchive::RecordHeader rh;
+	if(size < sizeof(WaveformArchive::FileHeader) + sizeof(rh) + sizeof(footer))
+		return false;
+	memcpy(&footer, data + size - sizeof(footer), sizeof(footer));
+	if(0 != memcmp(footer.m_magic, g_footerMagic, sizeof(footer.m_magic)))
+		return false;
+	if(footer.m_indexOffset > size - sizeof(footer) - sizeof(rh))
+		return false;
+
+	memcpy(&rh, data + footer.m_indexOffset, sizeof(rh));
+	if( (rh.m_type != WaveformArchive::RECORD_INDEX) ||
+		(rh.m_length != size - sizeof(footer) - sizeof(rh) - footer.m_indexOffset) ||
+		(rh.m_length % sizeof(WaveformArchiveIndexEntry)) )
+	{
+		return false;
+	}
+
+	size_t count = rh.m_length / sizeof(WaveformArchiveIndexEntry);
+	const uint8_t* p = data + footer.m_indexOffset + sizeof(rh);
+	for(size_t i=0; i<count; i++)
+	{
+		WaveformArchiveIndexEntry entry;
+		memcpy(&entry, p + i*sizeof(entry), sizeof(entry));
+
+		if( (entry.m_offset > footer.m_indexOffset) ||
+			(entry.m_length + sizeof(rh) > footer.m_indexOffset - entry.m_offset) )
+		{
+			return false;
+		}
+
+		if(entry.m_recordType == WaveformArchive::RECORD_CHANNEL)
+		{
+			if(!ReadChannel(entry.m_offset, entry.m_length))
+				return false;
+		}
+		else if(entry.m_recordType == WaveformArchive::RECORD_WAVEFORM)
+			m_index.push_back(entry);
+	}
+
+	return true;
+}
+
+/**
+	@brief Rebuilds the index by walking every record header in the file
+ */
+bool WaveformArchiveReader::ScanRecords()
+{
+	const uint8_t* data = m_file.GetData();
+	size_t size = m_file.GetSize();
+
+	uint64_t offset = sizeof(WaveformArchive::FileHeader);
+	WaveformArchive::RecordHeader rh;
+	while(offset + sizeof(rh) <= size)
+	{
+		memcpy(&rh, data + offset, sizeof(rh));
+
+		//Stop at a truncated trailing record
+		if(rh.m_length > size - offset - sizeof(rh))
+			break;
+
+		if(rh.m_type == WaveformArchive::RECORD_CHANNEL)
+		{
+			if(!ReadChannel(offset, rh.m_length))
+				return false;
+		}
+		else if(rh.m_type == WaveformArchive::RECORD_WAVEFORM)
+		{
+			WaveformArchive::WaveformHeader wh;
+			if(rh.m_length < sizeof(wh))
+				return false;
+			memcpy(&wh, data + offset + sizeof(rh), sizeof(wh));
+
+			WaveformArchiveIndexEntry entry;
+			entry.m_trigger = wh.m_trigger;
+			entry.m_channel = wh.m_channel;
+			entry.m_stream = wh.m_stream;
+			entry.m_recordType = rh.m_type;
+			entry.m_offset = offset;
+			entry.m_length = rh.m_length;
+			m_index.push_back(entry);
+		}
+		else if(rh.m_type != WaveformArchive::RECORD_INDEX)
+		{
+			LogError("WaveformArchiveReader: unknown record type %08x at offset %zu\n", rh.m_type, (size_t)offset);
+			return false;
+		}
+
+		offset += sizeof(rh) + rh.m_length;
+	}
+
+	return true;
+}
+
+/**
+	@brief Parses a channel record
+ */
+bool WaveformArchiveReader::ReadChannel(uint64_t offset, uint64_t length)
+{
+	const uint8_t* p = m_file.GetData() + offset + sizeof(WaveformArchive::RecordHeader);
+	const uint8_t* end = p + length;
+
+	uint32_t fields[6];
+	if(length < sizeof(fields))
+		return false;
+	memcpy(fields, p, sizeof(fields));
+	p += sizeof(fields);
+
+	//IDs are assigned sequentially by the writer so this can't get big unless the file is corrupted
+	uint32_t id = fields[0];
+	if(id > m_channels.size())
+		return false;
+	if(id == m_channels.size())
+		m_channels.push_back(WaveformArchiveChannel());
+
+	auto& chan = m_channels[id];
+	chan.m_type = fields[1];
+	chan.m_xunit = fields[2];
+	chan.m_yunit = fields[3];
+	chan.m_width = fields[4];
+	if(!GetString(p, end, chan.m_hwname) || !GetString(p, end, chan.m_color))
+		return false;
+	//Each name has at least a length prefix, so don't trust a count that couldn't fit in the record
+	if(fields[5] > (size_t)(end - p) / sizeof(uint32_t))
+		return false;
+	chan.m_streamNames.resize(fields[5]);
+	for(auto& name : chan.m_streamNames)
+	{
+		if(!GetString(p, end, name))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+	@brief Sorts the index and finds where each trigger's waveforms start
+ */
+bool WaveformArchiveReader::BuildTriggerTable()
+{
+	stable_sort(m_index.begin(), m_index.end());
+
+	//Every waveform has to belong to a channel record we've seen
+	for(auto& entry : m_index)
+	{
+		if(entry.m_channel >= m_channels.size())
+			return false;
+	}
+
+	//Trigger numbers come straight from the file, so sanity check them before allocating a table entry per trigger.
+	//The writer numbers triggers sequentially and almost every trigger has at least one record, so there can't
+	//legitimately be more triggers than record headers would fit in the file.
+	size_t ntriggers = m_index.empty() ? 0 : m_index.back().m_trigger + 1;
+	if(ntriggers > m_file.GetSize() / sizeof(WaveformArchive::RecordHeader))
+		return false;
+	m_triggerStart.resize(ntriggers + 1);
+
+	size_t j = 0;
+	for(size_t i=0; i<=ntriggers; i++)
+	{
+		while( (j < m_index.size()) && (m_index[j].m_trigger < i) )
+			j++;
+		m_triggerStart[i] = j;
+	}
+
+	return true;
+}
+
+/**
+	@brief Decodes one waveform from the archive
+
+	@return A new waveform owned by the caller, or NULL if there is no such waveform or it couldn't be decoded
+ */
+WaveformBase* WaveformArchiveReader::LoadWaveform(size_t trigger, size_t channel, size_t stream)
+{
+	if(trigger >= GetTriggerCount())
+		return NULL;
+
+	for(size_t i=m_triggerStart[trigger]; i<m_triggerStart[trigger+1]; i++)
+	{
+		auto& entry = m_index[i];
+		if( (entry.m_channel != channel) || (entry.m_stream != stream) )
+			continue;
+
+		WaveformArchive::WaveformHeader wh;
+		if(entry.m_length < sizeof(wh))
+			return NULL;
+		const uint8_t* p = m_file.GetData() + entry.m_offset + sizeof(WaveformArchive::RecordHeader);
+		memcpy(&wh, p, sizeof(wh));
+
+		auto wfm = WaveformArchive::DecodeWaveform(wh, p + sizeof(wh), entry.m_length - sizeof(wh));
+		if(!wfm)
+			LogError("WaveformArchiveReader: corrupted waveform (trigger %zu, channel %zu)\n", trigger, channel);
+		return wfm;
+	}
+
+	return NULL;
+}
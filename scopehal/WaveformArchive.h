@@ -0,0 +1,258 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformArchiveWriter and WaveformArchiveReader
+ */
+
+#ifndef WaveformArchive_h
+#define WaveformArchive_h
+
+class Oscilloscope;
+
+/**
+	@brief Description of one channel stored in a waveform archive
+ */
+class WaveformArchiveChannel
+{
+public:
+	std::string m_hwname;
+	std::string m_color;
+	uint32_t m_type;
+	int32_t m_xunit;
+	int32_t m_yunit;
+	uint32_t m_width;
+	std::vector<std::string> m_streamNames;
+};
+
+/**
+	@brief Location of one record in a waveform archive
+ */
+class WaveformArchiveIndexEntry
+{
+public:
+	uint32_t m_trigger;
+	uint32_t m_channel;
+	uint32_t m_stream;
+	uint32_t m_recordType;
+	uint64_t m_offset;
+	uint64_t m_length;
+
+	bool operator<(const WaveformArchiveIndexEntry& rhs) const
+	{
+		if(m_trigger != rhs.m_trigger)
+			return m_trigger < rhs.m_trigger;
+		if(m_channel != rhs.m_channel)
+			return m_channel < rhs.m_channel;
+		return m_stream < rhs.m_stream;
+	}
+};
+
+/**
+	@brief Constants and on-disk structures shared by the archive reader and writer
+
+	An archive is a 16 byte file header followed by a sequence of records, each with a 16 byte record header:
+
+	* CHAN records describe a channel the first time it is seen.
+	* WFM records hold one waveform (one stream of one channel for one trigger).
+	* An INDX record, written on close, lists the location of every other record, and is followed by a 16 byte
+	  footer pointing back to it.
+
+	The reader only touches the footer and index when opening, so open time is independent of archive size. If the
+	writer never closed the file (crash, power loss, etc) the reader rebuilds the index by walking the record headers.
+
+	Waveform bodies are encoded as zigzag varint deltas of the offsets (omitted for dense packed waveforms), varint
+	durations (omitted if each sample lasts until the next one starts), then byte-plane shuffled float samples or
+	bit-packed digital samples. The body is then optionally compressed with an LZ4-compatible block compressor.
+ */
+class WaveformArchive
+{
+public:
+	enum RecordType
+	{
+		RECORD_CHANNEL	= 0x4e414843,	//"CHAN"
+		RECORD_WAVEFORM	= 0x204d4657,	//"WFM "
+		RECORD_INDEX	= 0x58444e49	//"INDX"
+	};
+
+	enum WaveformFormat
+	{
+		FORMAT_ANALOG	= 0,
+		FORMAT_DIGITAL	= 1
+	};
+
+	enum WaveformFlags
+	{
+		FLAG_DENSE_PACKED			= 0x01,
+		FLAG_CONTIGUOUS_DURATIONS	= 0x02,
+		FLAG_COMPRESSED				= 0x04
+	};
+
+	#pragma pack(push, 1)
+	struct FileHeader
+	{
+		char m_magic[8];		//"SCOPEHAL"
+		uint32_t m_version;
+		uint32_t m_flags;
+	};
+
+	struct RecordHeader
+	{
+		uint32_t m_type;
+		uint32_t m_reserved;
+		uint64_t m_length;		//bytes of payload following this header
+	};
+
+	struct WaveformHeader
+	{
+		uint32_t m_trigger;
+		uint32_t m_channel;
+		uint32_t m_stream;
+		uint32_t m_format;
+		uint32_t m_flags;
+		uint32_t m_reserved;
+		int64_t m_timescale;
+		int64_t m_startTimestamp;
+		int64_t m_startFemtoseconds;
+		int64_t m_triggerPhase;
+		uint64_t m_numSamples;
+		uint64_t m_rawLength;	//size of the body before compression
+	};
+
+	struct Footer
+	{
+		uint64_t m_indexOffset;
+		char m_magic[8];		//"SHWAINDX"
+	};
+	#pragma pack(pop)
+
+	static const uint32_t VERSION = 1;
+
+	static void Compress(const uint8_t* in, size_t len, std::vector<uint8_t>& out);
+	static bool Decompress(const uint8_t* in, size_t inlen, uint8_t* out, size_t outlen);
+
+	static bool EncodeWaveform(WaveformBase* wfm, bool compress, WaveformHeader& header, std::vector<uint8_t>& body);
+	static WaveformBase* DecodeWaveform(const WaveformHeader& header, const uint8_t* body, size_t len);
+};
+
+/**
+	@brief Appends waveforms from any Oscilloscope to a chunked binary archive
+ */
+class WaveformArchiveWriter
+{
+public:
+	WaveformArchiveWriter(const std::string& path, bool compress = true);
+	virtual ~WaveformArchiveWriter();
+
+	bool IsOpen()
+	{ return m_fp != NULL; }
+
+	bool AddTrigger(Oscilloscope* scope);
+	bool AddTrigger(const PendingWaveformQueue::SequenceSet& set);
+
+	bool Close();
+
+	///Number of triggers written so far
+	size_t GetTriggerCount()
+	{ return m_nextTrigger; }
+
+	///Total size of the waveform bodies written so far, before compression
+	uint64_t GetRawBytes()
+	{ return m_rawBytes; }
+
+	///Total number of bytes written to the archive
+	uint64_t GetFileBytes()
+	{ return m_fileOffset; }
+
+protected:
+	///One stream of one channel to be written
+	class Item
+	{
+	public:
+		OscilloscopeChannel* m_channel;
+		size_t m_stream;
+		WaveformBase* m_waveform;
+	};
+
+	bool WriteTrigger(const std::vector<Item>& items);
+	uint32_t GetChannelID(OscilloscopeChannel* chan);
+	bool WriteRecord(uint32_t type, const void* header, size_t headerLen, const void* body, size_t bodyLen);
+
+	FILE* m_fp;
+	bool m_compress;
+	uint64_t m_fileOffset;
+	uint32_t m_nextTrigger;
+	uint64_t m_rawBytes;
+
+	std::map<OscilloscopeChannel*, uint32_t> m_channelIDs;
+	std::vector<WaveformArchiveIndexEntry> m_index;
+};
+
+/**
+	@brief Random access to the waveforms in an archive created by WaveformArchiveWriter
+
+	The archive is memory mapped and only the records for the requested triggers are ever paged in.
+ */
+class WaveformArchiveReader
+{
+public:
+	WaveformArchiveReader();
+	virtual ~WaveformArchiveReader();
+
+	bool Open(const std::string& path);
+
+	const std::vector<WaveformArchiveChannel>& GetChannels()
+	{ return m_channels; }
+
+	///Number of triggers in the archive
+	size_t GetTriggerCount()
+	{ return m_triggerStart.empty() ? 0 : m_triggerStart.size() - 1; }
+
+	WaveformBase* LoadWaveform(size_t trigger, size_t channel, size_t stream);
+
+protected:
+	bool ReadIndex();
+	bool ScanRecords();
+	bool ReadChannel(uint64_t offset, uint64_t length);
+	bool BuildTriggerTable();
+
+	MappedFile m_file;
+
+	std::vector<WaveformArchiveChannel> m_channels;
+
+	///Waveform records, sorted by trigger/channel/stream
+	std::vector<WaveformArchiveIndexEntry> m_index;
+
+	///Index of the first entry in m_index for each trigger, plus one past the end
+	std::vector<size_t> m_triggerStart;
+};
+
+#endif
@@ -0,0 +1,259 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of WaveformPool
+ */
+
+#include "scopehal.h"
+#include "WaveformPool.h"
+
+using namespace std;
+
+WaveformPool g_waveformPool;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+WaveformPool::WaveformPool()
+	: m_maxBytes(1024LL * 1024LL * 1024LL)
+	, m_residentBytes(0)
+	, m_hits(0)
+	, m_misses(0)
+	, m_evictions(0)
+{
+}
+
+WaveformPool::~WaveformPool()
+{
+	Clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Allocation
+
+/**
+	@brief Returns true if the waveform is of a type which can be safely reused by the pool
+ */
+bool WaveformPool::IsPoolable(WaveformBase* wfm)
+{
+	//Exact type match only, derived classes may have extra state we don't know how to reset
+	auto& type = typeid(*wfm);
+	return
+		(type == typeid(AnalogWaveform)) ||
+		(type == typeid(DigitalWaveform)) ||
+		(type == typeid(DigitalBusWaveform)) ||
+		(type == typeid(PackedDigitalWaveform));
+}
+
+/**
+	@brief Removes an idle waveform of the requested type from the pool and resets it
+
+	@param type		Type of waveform
+	@param capacity	Expected number of samples, or zero if not known
+
+	@return The waveform, or NULL if there was nothing suitable in the pool
+ */
+WaveformBase* WaveformPool::Take(type_index type, size_t capacity)
+{
+	WaveformBase* wfm = NULL;
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+
+		//Look for the smallest waveform that's big enough. If we don't know how big it needs to be, take the smallest
+		//one of the type so a small output doesn't pin down a huge buffer.
+		auto best = m_idle.end();
+		for(auto it = m_idle.begin(); it != m_idle.end(); ++it)
+		{
+			if(it->m_type != type)
+				continue;
+			if(it->m_capacity < capacity)
+				continue;
+
+			if( (best == m_idle.end()) || (it->m_capacity < best->m_capacity) )
+				best = it;
+		}
+
+		//Don't hand out a buffer that's wildly bigger than needed, it's better to let it be evicted
+		if( (best != m_idle.end()) && (capacity != 0) && (best->m_capacity / MAX_OVERSIZE > capacity) )
+			best = m_idle.end();
+
+		if(best == m_idle.end())
+		{
+			m_misses ++;
+			return NULL;
+		}
+
+		wfm = best->m_wfm;
+		m_residentBytes -= best->m_bytes;
+		m_idle.erase(best);
+		m_hits ++;
+	}
+
+	ResetMetadata(wfm);
+	return wfm;
+}
+
+/**
+	@brief Resets a waveform's metadata to what its constructor would set, so it looks like a new waveform (but keeps
+	its memory)
+ */
+void WaveformPool::ResetMetadata(WaveformBase* wfm)
+{
+	wfm->clear();
+	wfm->m_timescale = 0;
+	wfm->m_startTimestamp = 0;
+	wfm->m_startFemtoseconds = 0;
+	wfm->m_triggerPhase = 0;
+	wfm->m_implicitTimestamps = false;
+
+	//Packed digital waveforms are always dense packed, everything else starts out sparse
+	wfm->m_densePacked = (typeid(*wfm) == typeid(PackedDigitalWaveform));
+}
+
+/**
+	@brief Returns a waveform to the pool once nobody is using it any more
+
+	The waveform is deleted if it's not of a poolable type, or is too big to fit in the memory budget.
+ */
+void WaveformPool::Release(WaveformBase* wfm)
+{
+	if(wfm == NULL)
+		return;
+
+	if(!IsPoolable(wfm))
+	{
+		delete wfm;
+		return;
+	}
+
+	Entry e(wfm);
+	if(e.m_bytes > m_maxBytes)
+	{
+		delete wfm;
+		m_evictions ++;
+		return;
+	}
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_idle.push_back(e);
+		m_residentBytes += e.m_bytes;
+	}
+
+	EvictIfNeeded();
+}
+
+/**
+	@brief Frees every idle waveform in the pool
+ */
+void WaveformPool::Clear()
+{
+	lock_guard<mutex> lock(m_mutex);
+	for(auto& e : m_idle)
+		delete e.m_wfm;
+	m_idle.clear();
+	m_residentBytes = 0;
+}
+
+void WaveformPool::SetMaxBytes(size_t bytes)
+{
+	m_maxBytes = bytes;
+	EvictIfNeeded();
+}
+
+/**
+	@brief Frees the longest-idle waveforms until we're within the memory budget
+ */
+void WaveformPool::EvictIfNeeded()
+{
+	vector<WaveformBase*> garbage;
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+		while( (m_residentBytes > m_maxBytes) && !m_idle.empty())
+		{
+			auto& e = m_idle.front();
+			garbage.push_back(e.m_wfm);
+			m_residentBytes -= e.m_bytes;
+			m_idle.pop_front();
+			m_evictions ++;
+		}
+	}
+
+	//Free the memory with no lock held
+	for(auto w : garbage)
+		delete w;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Statistics
+
+size_t WaveformPool::GetIdleCount()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_idle.size();
+}
+
+/**
+	@brief Gets the fraction of allocations satisfied by reusing a waveform
+ */
+float WaveformPool::GetReuseRate()
+{
+	uint64_t hits = m_hits;
+	uint64_t total = hits + m_misses;
+	if(total == 0)
+		return 0;
+	return hits * 1.0f / total;
+}
+
+void WaveformPool::ResetStatistics()
+{
+	m_hits = 0;
+	m_misses = 0;
+	m_evictions = 0;
+}
+
+void WaveformPool::LogStatistics()
+{
+	LogDebug("Waveform pool statistics:\n");
+	LogIndenter li;
+	LogDebug("Idle waveforms: %zu (%.2f MB of %.2f MB)\n",
+		GetIdleCount(),
+		m_residentBytes * 1e-6,
+		m_maxBytes * 1e-6);
+	LogDebug("Allocations:    %lu reused, %lu new (%.1f %% reuse)\n",
+		(unsigned long)m_hits,
+		(unsigned long)m_misses,
+		GetReuseRate() * 100);
+	LogDebug("Evictions:      %lu\n", (unsigned long)m_evictions);
+}
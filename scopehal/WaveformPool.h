@@ -0,0 +1,174 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformPool
+ */
+
+#ifndef WaveformPool_h
+#define WaveformPool_h
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <typeindex>
+
+#include "Waveform.h"
+
+/**
+	@brief Thread-safe pool of idle waveforms, so drivers and filters can reuse buffers rather than allocating (and
+	page faulting in) hundreds of MB of fresh memory on every trigger.
+
+	Waveforms come back to the pool when they're replaced in OscilloscopeChannel::SetData() or dropped from an
+	oscilloscope's pending queue, and go out again from Allocate(). Only plain waveform types with no state beyond
+	their sample vectors (see IsPoolable()) are kept. Anything else is simply deleted on release.
+
+	Allocate() takes the smallest idle waveform with at least the requested capacity, as long as it's no more than
+	MAX_OVERSIZE times bigger than needed. If the capacity isn't known, it takes the smallest idle waveform of the
+	type. Reused waveforms are empty and have default metadata, exactly like a newly constructed one, but keep their
+	allocated memory.
+
+	Idle memory is limited to a configurable budget. When the budget is exceeded, the waveforms which have been idle
+	longest are freed.
+ */
+class WaveformPool
+{
+public:
+	WaveformPool();
+	virtual ~WaveformPool();
+
+	///@brief Largest ratio of reused capacity to requested capacity
+	static const size_t MAX_OVERSIZE = 4;
+
+	/**
+		@brief Gets an empty waveform of type T, reusing an idle one if possible
+
+		@param capacity	Expected number of samples, or zero if not known. Filters should pass their output length (or
+						a reasonable estimate) so they get a buffer of about the right size.
+	 */
+	template<class T>
+	T* Allocate(size_t capacity = 0)
+	{
+		auto w = Take(std::type_index(typeid(T)), capacity);
+		if(w)
+			return static_cast<T*>(w);
+		return new T;
+	}
+
+	void Release(WaveformBase* wfm);
+
+	void Clear();
+
+	static bool IsPoolable(WaveformBase* wfm);
+
+	///Sets the maximum number of bytes of idle waveforms to keep
+	void SetMaxBytes(size_t bytes);
+
+	///Gets the maximum number of bytes of idle waveforms to keep
+	size_t GetMaxBytes()
+	{ return m_maxBytes; }
+
+	///Gets the number of bytes of idle waveforms currently in the pool
+	size_t GetResidentBytes()
+	{ return m_residentBytes; }
+
+	///Gets the number of idle waveforms currently in the pool
+	size_t GetIdleCount();
+
+	///Gets the number of allocations satisfied by reusing a waveform
+	uint64_t GetHitCount()
+	{ return m_hits; }
+
+	///Gets the number of allocations which had to create a new waveform
+	uint64_t GetMissCount()
+	{ return m_misses; }
+
+	///Gets the number of idle waveforms freed to stay within the memory budget
+	uint64_t GetEvictionCount()
+	{ return m_evictions; }
+
+	float GetReuseRate();
+
+	void ResetStatistics();
+	void LogStatistics();
+
+protected:
+	WaveformBase* Take(std::type_index type, size_t capacity);
+	static void ResetMetadata(WaveformBase* wfm);
+	void EvictIfNeeded();
+
+	/**
+		@brief A single idle waveform
+	 */
+	class Entry
+	{
+	public:
+		Entry(WaveformBase* wfm)
+		: m_wfm(wfm)
+		, m_type(typeid(*wfm))
+		, m_capacity(wfm->capacity())
+		, m_bytes(wfm->GetAllocatedBytes())
+		{}
+
+		///The waveform
+		WaveformBase* m_wfm;
+
+		///Type of the waveform
+		std::type_index m_type;
+
+		///Number of samples the waveform can hold without reallocating
+		size_t m_capacity;
+
+		///Memory allocated by the waveform
+		size_t m_bytes;
+	};
+
+	///Mutex protecting all of our state
+	std::mutex m_mutex;
+
+	///Idle waveforms, oldest first
+	std::list<Entry> m_idle;
+
+	///Maximum number of bytes to keep in the pool
+	std::atomic<size_t> m_maxBytes;
+
+	///Number of bytes in the pool
+	std::atomic<size_t> m_residentBytes;
+
+	//Statistics
+	std::atomic<uint64_t> m_hits;
+	std::atomic<uint64_t> m_misses;
+	std::atomic<uint64_t> m_evictions;
+};
+
+extern WaveformPool g_waveformPool;
+
+#endif
@@ -0,0 +1,275 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of ZeroCrossingCache
+ */
+
+#include "scopehal.h"
+#include "ZeroCrossingCache.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+ZeroCrossingCache::ZeroCrossingCache()
+	: m_generation(0)
+	, m_clock(0)
+	, m_maxBytes(1024LL * 1024LL * 1024LL)
+	, m_residentBytes(0)
+	, m_hits(0)
+	, m_misses(0)
+	, m_evictions(0)
+{
+}
+
+ZeroCrossingCache::~ZeroCrossingCache()
+{
+	for(auto& shard : m_shards)
+	{
+		for(auto it : shard.m_entries)
+			delete it.second;
+		shard.m_entries.clear();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Lookup
+
+/**
+	@brief Picks the shard responsible for a given key
+ */
+ZeroCrossingCache::Shard& ZeroCrossingCache::GetShard(const KeyType& key)
+{
+	uint32_t tbits;
+	memcpy(&tbits, &key.second, sizeof(tbits));
+
+	//Waveforms are heap allocated so the low bits of the pointer are mostly zero
+	uintptr_t h = reinterpret_cast<uintptr_t>(key.first) >> 6;
+	h ^= tbits * 0x9e3779b1;
+	h ^= (h >> 16);
+	return m_shards[h % NUM_SHARDS];
+}
+
+/**
+	@brief Gets the zero crossings of a waveform, computing them if they're not already in the cache
+
+	@param data			The waveform to look at
+	@param threshold	Threshold for the crossings
+	@param edges		Output edge list (any existing contents are overwritten)
+	@param proc			Function to call to find the edges on a cache miss
+ */
+void ZeroCrossingCache::Lookup(AnalogWaveform* data, float threshold, vector<int64_t>& edges, ComputeProcType proc)
+{
+	KeyType key(data, threshold);
+	auto& shard = GetShard(key);
+	uint64_t generation = m_generation;
+
+	unique_lock<mutex> lock(shard.m_mutex);
+
+	//Cache hit. The edges may still be being computed by another thread, if so wait for them.
+	auto it = shard.m_entries.find(key);
+	if( (it != shard.m_entries.end()) && (it->second->m_generation == generation) )
+	{
+		auto e = it->second;
+		e->m_refcount ++;
+		e->m_lastUse = ++m_clock;
+		m_hits ++;
+
+		while(!e->m_ready)
+			shard.m_readyEvent.wait(lock);
+
+		//Copy with no lock held. Our reference keeps the entry alive even if it's evicted in the meantime.
+		lock.unlock();
+		edges = e->m_edges;
+		lock.lock();
+
+		Release(e);
+		return;
+	}
+
+	//Cache miss. Throw out anything left over from a previous generation and add a placeholder for our result.
+	if(it != shard.m_entries.end())
+	{
+		Detach(it->second);
+		shard.m_entries.erase(it);
+	}
+	auto e = new Entry(generation);
+	e->m_lastUse = ++m_clock;
+	shard.m_entries[key] = e;
+	m_misses ++;
+
+	//Find the edges with no lock held. Nobody else touches m_edges until m_ready is set.
+	lock.unlock();
+	proc(data, threshold, e->m_edges);
+	edges = e->m_edges;
+	lock.lock();
+
+	e->m_ready = true;
+	e->m_bytes = e->m_edges.capacity() * sizeof(int64_t);
+	if(e->m_inMap)
+	{
+		//If the cache was cleared while we were working, the result is stale. Don't keep it around.
+		if(e->m_generation != m_generation)
+		{
+			shard.m_entries.erase(key);
+			e->m_inMap = false;
+		}
+		else
+			m_residentBytes += e->m_bytes;
+	}
+	shard.m_readyEvent.notify_all();
+	Release(e);
+	lock.unlock();
+
+	EvictIfNeeded();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Cache management
+
+/**
+	@brief Invalidates everything in the cache
+
+	Computations which are in flight at the time of the call complete normally (any threads waiting on them get the
+	result) but the results are not retained.
+ */
+void ZeroCrossingCache::Clear()
+{
+	m_generation ++;
+
+	for(auto& shard : m_shards)
+	{
+		lock_guard<mutex> lock(shard.m_mutex);
+		for(auto it = shard.m_entries.begin(); it != shard.m_entries.end(); )
+		{
+			//Entries still being computed are discarded by the computing thread when it's done
+			if(it->second->m_ready)
+			{
+				Detach(it->second);
+				it = shard.m_entries.erase(it);
+			}
+			else
+				++it;
+		}
+	}
+}
+
+/**
+	@brief Marks an entry as no longer being in the cache, and deletes it if nobody is using it
+
+	The shard lock must be held, and the caller is responsible for removing the entry from the shard's map.
+ */
+void ZeroCrossingCache::Detach(Entry* e)
+{
+	e->m_inMap = false;
+	if(e->m_ready)
+		m_residentBytes -= e->m_bytes;
+	if(e->m_refcount == 0)
+		delete e;
+}
+
+/**
+	@brief Drops a reference to an entry, deleting it if it's no longer in the cache and nobody is using it
+
+	The shard lock must be held.
+ */
+void ZeroCrossingCache::Release(Entry* e)
+{
+	e->m_refcount --;
+	if( (e->m_refcount == 0) && !e->m_inMap)
+		delete e;
+}
+
+/**
+	@brief Evicts least recently used entries until we're back under the memory budget
+ */
+void ZeroCrossingCache::EvictIfNeeded()
+{
+	if(m_residentBytes <= m_maxBytes)
+		return;
+
+	lock_guard<mutex> elock(m_evictionMutex);
+
+	//Snapshot every completed entry
+	class Candidate
+	{
+	public:
+		uint64_t m_lastUse;
+		size_t m_shard;
+		KeyType m_key;
+		Entry* m_entry;
+
+		bool operator<(const Candidate& rhs) const
+		{ return m_lastUse < rhs.m_lastUse; }
+	};
+	vector<Candidate> candidates;
+	for(size_t i=0; i<NUM_SHARDS; i++)
+	{
+		auto& shard = m_shards[i];
+		lock_guard<mutex> lock(shard.m_mutex);
+		for(auto it : shard.m_entries)
+		{
+			if(it.second->m_ready)
+				candidates.push_back(Candidate{it.second->m_lastUse, i, it.first, it.second});
+		}
+	}
+
+	//Evict oldest first. Entries may have been removed by other threads since the snapshot, so double check
+	//that each one is still present before touching it.
+	sort(candidates.begin(), candidates.end());
+	for(auto& c : candidates)
+	{
+		if(m_residentBytes <= m_maxBytes)
+			break;
+
+		auto& shard = m_shards[c.m_shard];
+		lock_guard<mutex> lock(shard.m_mutex);
+		auto it = shard.m_entries.find(c.m_key);
+		if( (it == shard.m_entries.end()) || (it->second != c.m_entry) )
+			continue;
+
+		Detach(it->second);
+		shard.m_entries.erase(it);
+		m_evictions ++;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Statistics
+
+void ZeroCrossingCache::ResetStatistics()
+{
+	m_hits = 0;
+	m_misses = 0;
+	m_evictions = 0;
+}
@@ -0,0 +1,190 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of ZeroCrossingCache
+ */
+
+#ifndef ZeroCrossingCache_h
+#define ZeroCrossingCache_h
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+#include "Waveform.h"
+
+/**
+	@brief Thread-safe cache of interpolated zero crossings, keyed by waveform and threshold
+
+	The cache is split into shards, each with its own lock, so filters looking up edges of unrelated waveforms
+	don't contend with each other. Locks are only held for the map lookup itself: edge lists are computed and copied
+	out with no lock held.
+
+	If several threads ask for the same edges at once, only the first one computes them. The others block until the
+	result is ready, then share it.
+
+	Every entry is tagged with the generation it was created in. Clear() simply moves to a new generation, so results
+	from a previous trigger are never returned even if a waveform object is reused (or a computation was still in
+	flight when the cache was cleared).
+
+	Resident memory is limited to a configurable budget. When the budget is exceeded, the least recently used entries
+	are evicted.
+ */
+class ZeroCrossingCache
+{
+public:
+	ZeroCrossingCache();
+	virtual ~ZeroCrossingCache();
+
+	///Function used to compute edges on a cache miss
+	typedef void (*ComputeProcType)(AnalogWaveform* data, float threshold, std::vector<int64_t>& edges);
+
+	void Lookup(AnalogWaveform* data, float threshold, std::vector<int64_t>& edges, ComputeProcType proc);
+
+	void Clear();
+
+	///Sets the maximum number of bytes of edge data to keep resident
+	void SetMaxBytes(size_t bytes)
+	{
+		m_maxBytes = bytes;
+		EvictIfNeeded();
+	}
+
+	///Gets the maximum number of bytes of edge data to keep resident
+	size_t GetMaxBytes()
+	{ return m_maxBytes; }
+
+	///Gets the number of bytes of edge data currently resident
+	size_t GetResidentBytes()
+	{ return m_residentBytes; }
+
+	///Gets the number of lookups satisfied from the cache (including ones that waited for another thread)
+	uint64_t GetHitCount()
+	{ return m_hits; }
+
+	///Gets the number of lookups which had to compute the edges
+	uint64_t GetMissCount()
+	{ return m_misses; }
+
+	///Gets the number of entries evicted to stay within the memory budget
+	uint64_t GetEvictionCount()
+	{ return m_evictions; }
+
+	void ResetStatistics();
+
+protected:
+
+	/**
+		@brief A single cached edge list
+	 */
+	class Entry
+	{
+	public:
+		Entry(uint64_t generation)
+		: m_generation(generation)
+		, m_lastUse(0)
+		, m_bytes(0)
+		, m_refcount(1)
+		, m_ready(false)
+		, m_inMap(true)
+		{}
+
+		///Generation the entry was created in
+		uint64_t m_generation;
+
+		///Value of the LRU clock the last time the entry was used
+		uint64_t m_lastUse;
+
+		///Size of the edge data
+		size_t m_bytes;
+
+		///Number of threads currently reading (or computing) the edges
+		size_t m_refcount;
+
+		///True once the edges have been computed
+		bool m_ready;
+
+		///True if the entry is still in the shard's map (false if it has been evicted or replaced)
+		bool m_inMap;
+
+		///The edges
+		std::vector<int64_t> m_edges;
+	};
+
+	typedef std::pair<WaveformBase*, float> KeyType;
+
+	/**
+		@brief One independently locked slice of the cache
+	 */
+	class Shard
+	{
+	public:
+		std::mutex m_mutex;
+
+		///Signaled when any entry in this shard finishes computing
+		std::condition_variable m_readyEvent;
+
+		std::map<KeyType, Entry*> m_entries;
+	};
+
+	Shard& GetShard(const KeyType& key);
+
+	void Detach(Entry* e);
+	void Release(Entry* e);
+	void EvictIfNeeded();
+
+	enum { NUM_SHARDS = 16 };
+	Shard m_shards[NUM_SHARDS];
+
+	///Current generation
+	std::atomic<uint64_t> m_generation;
+
+	///LRU clock, incremented on every access
+	std::atomic<uint64_t> m_clock;
+
+	///Memory budget
+	std::atomic<size_t> m_maxBytes;
+
+	///Memory in use by entries which are ready and still in a shard
+	std::atomic<size_t> m_residentBytes;
+
+	//Statistics
+	std::atomic<uint64_t> m_hits;
+	std::atomic<uint64_t> m_misses;
+	std::atomic<uint64_t> m_evictions;
+
+	///Prevents more than one thread from running an eviction pass at a time
+	std::mutex m_evictionMutex;
+};
+
+#endif
@@ -8,6 +8,8 @@ For details, see http://sourceforge.net/projects/libb64
 #ifndef BASE64_CDECODE_H
 #define BASE64_CDECODE_H
 
+#include <stddef.h>
+
 typedef enum
 {
 	step_a, step_b, step_c, step_d
@@ -23,6 +25,16 @@ void base64_init_decodestate(base64_decodestate* state_in);
 
 int base64_decode_value(char value_in);
 
+/*
+Decodes length_in characters of base64, skipping anything that isn't part of the alphabet.
+Returns the number of bytes written. plaintext_out needs room for (length_in * 3 / 4) + 1 bytes.
+Uses SSSE3/AVX2 where available. plaintext_out may equal code_in to decode in place.
+*/
 int base64_decode_block(const char* code_in, const int length_in, char* plaintext_out, base64_decodestate* state_in);
 
+/* Same as base64_decode_block(), overwriting the input with the decoded data */
+int base64_decode_inplace(char* buf, const int length_in, base64_decodestate* state_in);
+
+void base64_benchmark(size_t len = 64*1024*1024);
+
 #endif /* BASE64_CDECODE_H */
@@ -75,8 +75,11 @@ bool g_hasAvx512F = false;
 bool g_hasAvx512DQ = false;
 bool g_hasAvx512VL = false;
 bool g_hasAvx2 = false;
+bool g_hasSSSE3 = false;
 bool g_hasFMA = false;
+bool g_hasPCLMULQDQ = false;
 bool g_disableOpenCL = false;
+bool g_benchmarkCRC = false;
 
 vector<string> g_searchPaths;
 
@@ -118,7 +121,13 @@ void DetectCPUFeatures()
 	g_hasAvx512DQ = __builtin_cpu_supports("avx512dq");
 	g_hasAvx2 = __builtin_cpu_supports("avx2");
 	g_hasFMA = __builtin_cpu_supports("fma");
+	g_hasSSSE3 = __builtin_cpu_supports("ssse3");
+	g_hasPCLMULQDQ = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
 
+	if(g_hasSSSE3)
+		LogDebug("* SSSE3\n");
+	if(g_hasPCLMULQDQ)
+		LogDebug("* PCLMULQDQ\n");
 	if(g_hasAvx2)
 		LogDebug("* AVX2\n");
 	if(g_hasFMA)
@@ -137,6 +146,9 @@ void DetectCPUFeatures()
 		LogWarning("AVX2/AVX512 detected but disabled on MinGW64/GCC (see https://github.com/azonenberg/scopehal-apps/issues/295)\n");
 	}
 #endif
+	//The CRC engine picks its code path from the flags above, so benchmark it once they're final
+	if(g_benchmarkCRC)
+		LogCRCBenchmarks();
 }
 
 /**
@@ -342,6 +354,8 @@ void DetectGPUFeatures()
 
 void ScopehalStaticCleanup()
 {
+	g_waveformPool.Clear();
+
 	#ifdef HAVE_OPENCL
 	#ifdef HAVE_CLFFT
 	clfftTeardown();
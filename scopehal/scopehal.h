@@ -71,6 +71,9 @@
 #include "Unit.h"
 #include "Bijection.h"
 #include "IDTable.h"
+#include "MappedFile.h"
+#include "PcapngWriter.h"
+#include "CRC.h"
 
 #include "SCPITransport.h"
 #include "SCPISocketTransport.h"
@@ -82,6 +85,11 @@
 #include "SCPIDevice.h"
 
 #include "OscilloscopeChannel.h"
+#include "PackedDigitalWaveform.h"
+#include "BitstreamAligner.h"
+#include "WaveformPool.h"
+#include "PendingWaveformQueue.h"
+#include "WaveformArchive.h"
 #include "FlowGraphNode.h"
 #include "Trigger.h"
 
@@ -93,8 +101,10 @@
 #include "PowerSupply.h"
 
 #include "Statistic.h"
+#include "DecoderState.h"
 #include "FilterParameter.h"
 #include "Filter.h"
+#include "FilterGraphExecutor.h"
 #include "PeakDetectionFilter.h"
 #include "SpectrumChannel.h"
 
@@ -136,6 +146,8 @@ extern bool g_hasAvx512F;
 extern bool g_hasAvx512VL;
 extern bool g_hasAvx512DQ;
 extern bool g_hasAvx2;
+extern bool g_hasSSSE3;
+extern bool g_hasPCLMULQDQ;
 
 #define FS_PER_SECOND 1e15
 #define SECONDS_PER_FS 1e-15
@@ -152,6 +164,9 @@ extern std::vector<std::string> g_searchPaths;
 //Set true prior to calling DetectGPUFeatures() to force OpenCL to not be used
 extern bool g_disableOpenCL;
 
+//Set true prior to calling DetectCPUFeatures() to verify the CRC engine and log its throughput
+extern bool g_benchmarkCRC;
+
 #ifdef HAVE_OPENCL
 extern cl::Context* g_clContext;
 extern std::vector<cl::Device> g_contextDevices;
@@ -120,27 +120,28 @@ void AutocorrelationFilter::Refresh()
 
 	//Sanity check range
 	size_t range = m_parameters[m_maxDeltaName].GetIntVal();
-	if( len <= range)
+	if( (len <= range) || (range == 0) )
 	{
 		SetData(NULL, 0);
 		return;
 	}
 
 	//Set up the output waveform
-	auto cap = new AnalogWaveform;
-
-	size_t end = len - range;
-	for(size_t delta=1; delta <= range; delta ++)
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(range);
+	cap->Resize(range);
+	for(size_t i=0; i<range; i++)
 	{
-		double total = 0;
-		for(size_t i=0; i<end; i++)
-			total += din->m_samples[i] * din->m_samples[i+delta];
-
-		cap->m_samples.push_back(total / end);
-		cap->m_offsets.push_back(delta);
-		cap->m_durations.push_back(1);
+		cap->m_offsets[i] = i+1;
+		cap->m_durations[i] = 1;
 	}
 
+	auto samples = (const float*)&din->m_samples[0];
+	auto out = (float*)&cap->m_samples[0];
+	if(UseFFT(len, range))
+		DoAutocorrelationFFT(samples, len, range, out);
+	else
+		DoAutocorrelationDirect(samples, len, range, out);
+
 	//Calculate range of the output waveform
 	float x = GetMaxVoltage(cap);
 	float n = GetMinVoltage(cap);
@@ -154,3 +155,87 @@ void AutocorrelationFilter::Refresh()
 
 	SetData(cap, 0);
 }
+
+/**
+	@brief Decides whether the FFT path is cheaper than direct summation for a given problem size
+
+	Direct costs one MAC per sample per lag. The FFT path costs three real transforms of the padded length plus
+	a complex multiply per bin, which is a bit more than 10 * N log2 N flops with ffts in practice.
+ */
+bool AutocorrelationFilter::UseFFT(size_t len, size_t range)
+{
+	size_t npoints = next_pow2(len);
+	double directCost = (double)range * (len - range);
+	double fftCost = 10.0 * npoints * log2(npoints);
+	return fftCost < directCost;
+}
+
+/**
+	@brief Computes out[delta-1] = mean(x[i] * x[i+delta]) over i in [0, len-range) for delta in [1, range]
+ */
+void AutocorrelationFilter::DoAutocorrelationDirect(const float* samples, size_t len, size_t range, float* out)
+{
+	size_t end = len - range;
+
+	#pragma omp parallel for
+	for(size_t delta=1; delta <= range; delta ++)
+	{
+		double total = 0;
+		for(size_t i=0; i<end; i++)
+			total += samples[i] * samples[i+delta];
+
+		out[delta-1] = total / end;
+	}
+}
+
+/**
+	@brief Same result as DoAutocorrelationDirect, computed in the frequency domain (Wiener-Khinchin)
+
+	The sum is the cross-correlation of the first len-range samples against the whole signal. Zero padding both to
+	a power of two at least len long means no lag we care about wraps around the circular correlation.
+ */
+void AutocorrelationFilter::DoAutocorrelationFFT(const float* samples, size_t len, size_t range, float* out)
+{
+	size_t end = len - range;
+	size_t npoints = next_pow2(len);
+	size_t nouts = npoints/2 + 1;
+
+	if(m_fftPlan.GetSize() != npoints)
+	{
+		m_fftPlan.Resize(npoints);
+		m_timeBuf.resize(npoints);
+		m_signalFreq.resize(2*nouts);
+		m_truncatedFreq.resize(2*nouts);
+	}
+
+	float* tbuf = &m_timeBuf[0];
+	float* sig = &m_signalFreq[0];
+	float* trunc = &m_truncatedFreq[0];
+
+	//Spectrum of the whole signal
+	memcpy(tbuf, samples, len * sizeof(float));
+	memset(tbuf + len, 0, (npoints - len) * sizeof(float));
+	m_fftPlan.Forward(tbuf, sig);
+
+	//Spectrum of the truncated copy
+	memset(tbuf + end, 0, (len - end) * sizeof(float));
+	m_fftPlan.Forward(tbuf, trunc);
+
+	//Cross spectrum: conj(truncated) * signal
+	for(size_t i=0; i<nouts; i++)
+	{
+		float ar = trunc[i*2];
+		float ai = trunc[i*2 + 1];
+		float br = sig[i*2];
+		float bi = sig[i*2 + 1];
+
+		sig[i*2]		= ar*br + ai*bi;
+		sig[i*2 + 1]	= ar*bi - ai*br;
+	}
+
+	//Back to the lag domain, undoing the unnormalized reverse transform and averaging over the summed samples
+	m_fftPlan.Reverse(sig, tbuf);
+	float scale = 1.0f / ((double)npoints * end);
+	for(size_t delta=1; delta <= range; delta ++)
+		out[delta-1] = tbuf[delta] * scale;
+}
@@ -35,6 +35,8 @@
 #ifndef AutocorrelationFilter_h
 #define AutocorrelationFilter_h
 
+#include "FFTFilter.h"
+
 class AutocorrelationFilter : public Filter
 {
 public:
@@ -54,7 +56,17 @@ public:
 
 	PROTOCOL_DECODER_INITPROC(AutocorrelationFilter)
 
+	static bool UseFFT(size_t len, size_t range);
+
 protected:
+	void DoAutocorrelationDirect(const float* samples, size_t len, size_t range, float* out);
+	void DoAutocorrelationFFT(const float* samples, size_t len, size_t range, float* out);
+
+	RealFFTPlan m_fftPlan;
+	std::vector<float, AlignedAllocator<float, 64> > m_timeBuf;
+	std::vector<float, AlignedAllocator<float, 64> > m_signalFreq;
+	std::vector<float, AlignedAllocator<float, 64> > m_truncatedFreq;
+
 	double	m_range;
 	double	m_offset;
 	std::string m_maxDeltaName;
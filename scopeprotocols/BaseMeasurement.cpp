@@ -137,7 +137,7 @@ void BaseMeasurement::Refresh()
 	float global_base = fbin*m_range + vmin;
 
 	//Create the output
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>();
 
 	float last = vmin;
 	int64_t tfall = 0;
@@ -50,6 +50,9 @@ CANDecoder::CANDecoder(const string& color)
 
 	m_parameters[m_baudrateName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_BITRATE));
 	m_parameters[m_baudrateName].SetIntVal(250000);
+
+	CreateExportParameters(PcapngWriter::LINKTYPE_CAN_SOCKETCAN);
+	CreateStateCarryParameter();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -137,7 +140,13 @@ void CANDecoder::Refresh()
 	//LogDebug("Starting CAN decode\n");
 	//LogIndenter li;
 
-	Packet* pack = NULL;
+	size_t row = 0;
+	size_t colID = m_table.GetColumn("ID");
+	size_t colMode = m_table.GetColumn("Mode");
+	size_t colFormat = m_table.GetColumn("Format");
+	size_t colType = m_table.GetColumn("Type");
+	size_t colAck = m_table.GetColumn("Ack");
+	size_t colLen = m_table.GetColumn("Len");
 
 	size_t len = diff->m_samples.size();
 	int64_t tbitstart = 0;
@@ -154,12 +163,42 @@ void CANDecoder::Refresh()
 	bool fd_mode = false;
 	int frame_bytes_left = 0;
 	int32_t frame_id = 0;
-	char tmp[128];
 
 	// CRC (http://esd.cs.ucr.edu/webres/can20.pdf page 13)
-	const uint16_t crc_poly = 0x4599;
 	uint16_t crc = 0;
 
+	//If continuing from the last waveform, pick up where it left off. The bus is only followed across back-to-back
+	//waveforms since a gap could hide the start of a frame.
+	auto carried = TakeCarriedState(diff);
+	int64_t tcarried;
+	if(carried.HasInt("state") && carried.GetTime("tbitstart", diff, tcarried))
+	{
+		state = static_cast<decltype(state)>(carried.GetInt("state"));
+		vlast = carried.GetInt("vlast");
+		nbit = carried.GetInt("nbit");
+		sampled = carried.GetInt("sampled");
+		sampled_value = carried.GetInt("sampled_value");
+		last_sampled_value = carried.GetInt("last_sampled_value");
+		bits_since_toggle = carried.GetInt("bits_since_toggle");
+		current_field = carried.GetInt("current_field");
+		frame_is_rtr = carried.GetInt("frame_is_rtr");
+		extended_id = carried.GetInt("extended_id");
+		fd_mode = carried.GetInt("fd_mode");
+		frame_bytes_left = carried.GetInt("frame_bytes_left");
+		frame_id = carried.GetInt("frame_id");
+		crc = carried.GetInt("crc");
+
+		//The bit in progress keeps its true start time (which is negative) so it's sampled at the right point.
+		//Fields which started in the last waveform are shown from the start of this one.
+		tbitstart = tcarried / diff->m_timescale;
+		if(carried.GetTime("tblockstart", diff, tcarried))
+			tblockstart = max(tcarried, (int64_t)0) / diff->m_timescale;
+
+		//Frame still in progress? Continue its packet
+		if(carried.HasInt("row"))
+			row = m_table.RestoreRow(carried, 0);
+	}
+
 	for(size_t i = 0; i < len; i++)
 	{
 		bool v = diff->m_samples[i];
@@ -252,15 +291,8 @@ void CANDecoder::Refresh()
 				current_field |= 1;
 			nbit ++;
 
-			if (state != STATE_CRC){
-				uint16_t crc_bit_14 = (crc >> 14) & 0x1;
-				uint16_t crc_nxt = sampled_value ^ crc_bit_14;
-				crc = crc << 1;
-
-				if (crc_nxt){
-					crc = crc ^ crc_poly;
-				}
-			}
+			if (state != STATE_CRC)
+				crc = CRC15CAN::UpdateBit(crc, sampled_value);
 
 			switch(state)
 			{
@@ -275,10 +307,7 @@ void CANDecoder::Refresh()
 				case STATE_SOF:
 
 					//Start a new packet
-					pack = new Packet;
-					pack->m_offset = off * diff->m_timescale;
-					pack->m_len = 0;
-					m_packets.push_back(pack);
+					row = m_table.AddRow(off * diff->m_timescale);
 
 					cap->m_offsets.push_back(tblockstart);
 					cap->m_durations.push_back(off - tblockstart);
@@ -308,11 +337,10 @@ void CANDecoder::Refresh()
 
 						frame_id = current_field;
 
-						snprintf(tmp, sizeof(tmp), "%03x", frame_id);
-						pack->m_headers["ID"] = tmp;
-						pack->m_headers["Format"] = "Base";
-						pack->m_headers["Mode"] = "CAN";
-						pack->m_headers["Type"] = "Data";
+						m_table.SetHex(row, colID, frame_id, 3);
+						m_table.SetText(row, colFormat, "Base");
+						m_table.SetText(row, colMode, "CAN");
+						m_table.SetText(row, colType, "Data");
 					}
 
 					break;
@@ -326,7 +354,7 @@ void CANDecoder::Refresh()
 					cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_RTR, frame_is_rtr));
 
 					if(frame_is_rtr)
-						pack->m_headers["Type"] = "RTR";
+						m_table.SetText(row, colType, "RTR");
 
 					if(extended_id)
 						state = STATE_FD;
@@ -371,9 +399,8 @@ void CANDecoder::Refresh()
 						cap->m_durations.push_back(end - tblockstart);
 						cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_ID, frame_id));
 
-						snprintf(tmp, sizeof(tmp), "%08x", frame_id);
-						pack->m_headers["ID"] = tmp;
-						pack->m_headers["Format"] = "Ext";
+						m_table.SetHex(row, colID, frame_id, 8);
+						m_table.SetText(row, colFormat, "Ext");
 
 						state = STATE_RTR;
 					}
@@ -400,7 +427,7 @@ void CANDecoder::Refresh()
 
 					fd_mode = sampled_value;
 					if(fd_mode)
-						pack->m_headers["Mode"] = "CAN-FD";
+						m_table.SetText(row, colMode, "CAN-FD");
 
 					state = STATE_R0;
 					break;
@@ -440,7 +467,7 @@ void CANDecoder::Refresh()
 						cap->m_durations.push_back(end - tblockstart);
 						cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_DATA, current_field));
 
-						pack->m_data.push_back(current_field);
+						m_table.AppendData(row, current_field);
 
 						//Go to CRC after we've read all the data
 						frame_bytes_left --;
@@ -468,6 +495,24 @@ void CANDecoder::Refresh()
 						cap->m_durations.push_back(end - tblockstart);
 						cap->m_samples.push_back(CANSymbol(type, current_field));
 
+						//Export in Linux SocketCAN format: big endian ID and flags, length, FD flags, two reserved
+						//bytes, then the data (always 8 bytes for classic CAN)
+						uint32_t canid = frame_id;
+						if(extended_id)
+							canid |= 0x80000000;
+						if(frame_is_rtr)
+							canid |= 0x40000000;
+						size_t datalen = min(m_table.GetDataSize(row), (size_t)64);
+						uint8_t frame[72] = {0};
+						frame[0] = canid >> 24;
+						frame[1] = (canid >> 16) & 0xff;
+						frame[2] = (canid >> 8) & 0xff;
+						frame[3] = canid & 0xff;
+						frame[4] = datalen;
+						frame[5] = fd_mode ? 0x04 : 0;		//CANFD_FDF
+						memcpy(frame + 8, m_table.GetData(row), datalen);
+						ExportPacket(cap, m_table.GetOffset(row), frame, 8 + (fd_mode ? datalen : 8));
+
 						state = STATE_CRC_DELIM;
 					}
 
@@ -489,9 +534,9 @@ void CANDecoder::Refresh()
 					cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_ACK, sampled_value));
 
 					if(sampled_value)
-						pack->m_headers["Ack"] = "NAK";
+						m_table.SetText(row, colAck, "NAK");
 					else
-						pack->m_headers["Ack"] = "ACK";
+						m_table.SetText(row, colAck, "ACK");
 
 					state = STATE_ACK_DELIM;
 					break;
@@ -515,10 +560,9 @@ void CANDecoder::Refresh()
 					if(nbit == 7)
 					{
 						if(frame_is_rtr)
-							snprintf(tmp, sizeof(tmp), "%d", (int)frame_bytes_left);
+							m_table.SetDecimal(row, colLen, frame_bytes_left);
 						else
-							snprintf(tmp, sizeof(tmp), "%d", (int)pack->m_data.size());
-						pack->m_headers["Len"] = tmp;
+							m_table.SetDecimal(row, colLen, m_table.GetDataSize(row));
 
 						cap->m_offsets.push_back(tblockstart);
 						cap->m_durations.push_back(end - tblockstart);
@@ -539,6 +583,33 @@ void CANDecoder::Refresh()
 		}
 	}
 
+	//Save the state machine for the next waveform
+	DecoderState next;
+	if( (state != STATE_WAIT_FOR_IDLE) && (len != 0) )
+	{
+		next.SetInt("state", state);
+		next.SetInt("vlast", vlast);
+		next.SetInt("nbit", nbit);
+		next.SetInt("sampled", sampled);
+		next.SetInt("sampled_value", sampled_value);
+		next.SetInt("last_sampled_value", last_sampled_value);
+		next.SetInt("bits_since_toggle", bits_since_toggle);
+		next.SetInt("current_field", current_field);
+		next.SetInt("frame_is_rtr", frame_is_rtr);
+		next.SetInt("extended_id", extended_id);
+		next.SetInt("fd_mode", fd_mode);
+		next.SetInt("frame_bytes_left", frame_bytes_left);
+		next.SetInt("frame_id", frame_id);
+		next.SetInt("crc", crc);
+		next.SetTime("tbitstart", diff, tbitstart * diff->m_timescale);
+		next.SetTime("tblockstart", diff, tblockstart * diff->m_timescale);
+
+		//The packet is only created once the SOF bit ends
+		if( (state > STATE_SOF) && (state <= STATE_EOF) )
+			m_table.SaveRow(row, next);
+	}
+	CarryState(diff, next);
+
 	SetData(cap, 0);
 }
 
@@ -143,7 +143,7 @@ void DCDMeasurement::Refresh()
 	float falling_avg = falling_sum / falling_count;
 	float dcd = fabs(rising_avg - falling_avg);
 
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(1);
 	cap->m_offsets.push_back(0);
 	cap->m_durations.push_back(1);
 	cap->m_samples.push_back(dcd);
@@ -110,7 +110,7 @@ void DPhyHSClockRecoveryFilter::Refresh()
 	auto data = dynamic_cast<DPhySymbolWaveform*>(GetInputWaveform(1));
 
 	//Create the output waveform and copy our timescales
-	auto cap = new DigitalWaveform;
+	auto cap = g_waveformPool.Allocate<DigitalWaveform>(clk->m_samples.size());
 	cap->m_startTimestamp = clk->m_startTimestamp;
 	cap->m_startFemtoseconds = clk->m_startFemtoseconds;
 	cap->m_triggerPhase = clk->m_triggerPhase;
@@ -137,7 +137,7 @@ void DeskewFilter::Refresh()
 	int64_t toff = round(offset / din->m_timescale);
 
 	//Shift all of our samples
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(len);
 	cap->Resize(len);
 	float* out = (float*)__builtin_assume_aligned(&cap->m_samples[0], 16);
 	float* a = (float*)__builtin_assume_aligned(&din->m_samples[0], 16);
@@ -122,8 +122,8 @@ void DownconvertFilter::Refresh()
 	double lo_rad_per_sample = lo_cycles_per_sample * 2 * M_PI;
 
 	//Do the actual mixing
-	auto cap_i = new AnalogWaveform;
-	auto cap_q = new AnalogWaveform;
+	auto cap_i = g_waveformPool.Allocate<AnalogWaveform>(len);
+	auto cap_q = g_waveformPool.Allocate<AnalogWaveform>(len);
 	cap_i->Resize(len);
 	cap_q->Resize(len);
 	for(size_t i=0; i<len; i++)
@@ -84,6 +84,11 @@ bool DownsampleFilter::NeedsConfig()
 	return true;
 }
 
+bool DownsampleFilter::SupportsImplicitTimestamps()
+{
+	return true;
+}
+
 void DownsampleFilter::SetDefaultName()
 {
 	char hwname[256];
@@ -135,13 +140,27 @@ void DownsampleFilter::Refresh()
 
 	//Do the actual downsampling.
 	//For now, assume uniform sample rate
-	auto cap = new AnalogWaveform;
-	cap->Resize(outlen);
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(outlen);
+	bool dense = din->m_densePacked;
+	if(dense)
+	{
+		//Dense packed input gives dense packed output, so skip the timestamps if we can
+		if(UseImplicitTimestampOutput())
+			cap->SetImplicitTimestamps();
+		cap->m_densePacked = true;
+		cap->Resize(outlen);
+		cap->FillDenseTimestamps(0, outlen);
+	}
+	else
+		cap->Resize(outlen);
 	for(size_t i=0; i<outlen; i++)
 	{
 		//Copy timestamps
-		cap->m_offsets[i]	= din->m_offsets[i*factor] / factor;
-		cap->m_durations[i]	= din->m_durations[i*factor] / factor;
+		if(!dense)
+		{
+			cap->m_offsets[i]	= din->GetOffset(i*factor) / factor;
+			cap->m_durations[i]	= din->GetDuration(i*factor) / factor;
+		}
 
 		//Do the convolution
 		float conv = 0;
@@ -136,8 +136,8 @@ void DramClockFilter::Refresh()
 	FindZeroCrossings(clk, clkedges);
 
 	//Create output waveforms
-	auto rdclk = new DigitalWaveform;
-	auto wrclk = new DigitalWaveform;
+	auto rdclk = g_waveformPool.Allocate<DigitalWaveform>(edges.size());
+	auto wrclk = g_waveformPool.Allocate<DigitalWaveform>(edges.size());
 	rdclk->m_timescale 			= 1;
 	wrclk->m_timescale 			= 1;
 	SetData(rdclk, 0);
@@ -113,7 +113,7 @@ void DramRefreshActivateMeasurement::Refresh()
 	auto din = dynamic_cast<SDRAMWaveform*>(GetInputWaveform(0));
 
 	//Create the output
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>();
 
 	//Measure delay from refreshing a bank until an activation to the same bank
 	int64_t lastRef[8] = {0, 0, 0, 0, 0, 0, 0, 0};
@@ -137,7 +137,7 @@ void DutyCycleMeasurement::Refresh()
 	}
 
 	//Create the output
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(edges.size() / 2);
 
 	//Figure out edge polarity
 	bool initial_polarity = (din->m_samples[0] > midpoint);
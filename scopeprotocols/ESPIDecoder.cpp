@@ -208,7 +208,16 @@ void ESPIDecoder::Refresh()
 	} txn_state = TXN_STATE_IDLE;
 
 	ESPISymbol::ESpiCommand current_cmd = ESPISymbol::COMMAND_RESET;
-	Packet* pack = NULL;
+	size_t row = 0;
+	bool packet_open = false;
+	string vwire_info;
+	size_t colCommand = m_table.GetColumn("Command");
+	size_t colAddress = m_table.GetColumn("Address");
+	size_t colLen = m_table.GetColumn("Len");
+	size_t colTag = m_table.GetColumn("Tag");
+	size_t colInfo = m_table.GetColumn("Info");
+	size_t colResponse = m_table.GetColumn("Response");
+	size_t colStatus = m_table.GetColumn("Status");
 
 	enum
 	{
@@ -366,10 +375,10 @@ void ESPIDecoder::Refresh()
 		//TODO: error if a byte is truncated
 		if( (link_state != LINK_STATE_DESELECTED) && cur_cs)
 		{
-			if(pack)
+			if(packet_open)
 			{
-				pack->m_len = (timestamp * clk->m_timescale) + clk->m_triggerPhase - pack->m_offset;
-				pack = NULL;
+				m_table.SetEnd(row, (timestamp * clk->m_timescale) + clk->m_triggerPhase);
+				packet_open = false;
 			}
 
 			bytestart = timestamp;
@@ -392,19 +401,18 @@ void ESPIDecoder::Refresh()
 				case TXN_STATE_OPCODE:
 
 					//Create a new packet
-					pack = new Packet;
-					pack->m_len = 0;
-					m_packets.push_back(pack);
+					row = m_table.AddRow(bytestart * clk->m_timescale + clk->m_triggerPhase);
+					packet_open = true;
+					vwire_info = "";
 
 					current_cmd = (ESPISymbol::ESpiCommand)current_byte;
 
 					//Add symbol for packet type
 					tstart = timestamp;
-					pack->m_offset = bytestart * clk->m_timescale + clk->m_triggerPhase;
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_COMMAND_TYPE, current_byte));
-					pack->m_headers["Command"] = GetText(cap->m_samples.size()-1);
+					m_table.SetText(row, colCommand, GetText(cap->m_samples.size()-1));
 
 					//Decide what to do based on the opcode
 					count = 0;
@@ -416,7 +424,7 @@ void ESPIDecoder::Refresh()
 						//Expect a 16 bit address
 						case ESPISymbol::COMMAND_GET_CONFIGURATION:
 						case ESPISymbol::COMMAND_SET_CONFIGURATION:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_CONTROL]);
 							txn_state = TXN_STATE_CONFIG_ADDRESS;
 							break;
 
@@ -427,55 +435,55 @@ void ESPIDecoder::Refresh()
 
 						//Expect an OOB message
 						case ESPISymbol::COMMAND_PUT_OOB:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							txn_state = TXN_STATE_SMBUS_TYPE;
 							break;
 
 						//Expect a virtual wire write packet
 						case ESPISymbol::COMMAND_PUT_VWIRE:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_WRITE]);
 							txn_state = TXN_STATE_VWIRE_COUNT;
 							break;
 
 						//Expect a 16-bit address followed by 1-4 bytes of data
 						case ESPISymbol::COMMAND_PUT_IOWR_SHORT_x1:
 							payload_len = 1;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_WRITE]);
 							txn_state = TXN_STATE_IOWR_ADDR;
 							break;
 						case ESPISymbol::COMMAND_PUT_IOWR_SHORT_x2:
 							payload_len = 2;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_WRITE]);
 							txn_state = TXN_STATE_IOWR_ADDR;
 							break;
 						case ESPISymbol::COMMAND_PUT_IOWR_SHORT_x4:
 							payload_len = 4;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_WRITE]);
 							txn_state = TXN_STATE_IOWR_ADDR;
 							break;
 
 						//Expect a 16 bit address
 						case ESPISymbol::COMMAND_PUT_IORD_SHORT_x1:
-							pack->m_headers["Len"] = "1";
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							m_table.SetDecimal(row, colLen, 1);
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							txn_state = TXN_STATE_IORD_ADDR;
 							break;
 
 						case ESPISymbol::COMMAND_PUT_IORD_SHORT_x2:
-							pack->m_headers["Len"] = "2";
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							m_table.SetDecimal(row, colLen, 2);
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							txn_state = TXN_STATE_IORD_ADDR;
 							break;
 
 						case ESPISymbol::COMMAND_PUT_IORD_SHORT_x4:
-							pack->m_headers["Len"] = "4";
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							m_table.SetDecimal(row, colLen, 4);
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							txn_state = TXN_STATE_IORD_ADDR;
 							break;
 
 						//No arguments
 						case ESPISymbol::COMMAND_GET_STATUS:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_STATUS];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_STATUS]);
 							txn_state = TXN_STATE_COMMAND_CRC8;
 							break;
 						case ESPISymbol::COMMAND_GET_FLASH_NP:
@@ -483,28 +491,28 @@ void ESPIDecoder::Refresh()
 							txn_state = TXN_STATE_COMMAND_CRC8;
 							break;
 						case ESPISymbol::COMMAND_GET_VWIRE:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							txn_state = TXN_STATE_COMMAND_CRC8;
 							break;
 						case ESPISymbol::COMMAND_GET_OOB:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_WRITE]);
 							txn_state = TXN_STATE_COMMAND_CRC8;
 							break;
 						case ESPISymbol::COMMAND_RESET:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_COMMAND];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_COMMAND]);
 							txn_state = TXN_STATE_COMMAND_CRC8;
 							break;
 
 						//TODO
 						case ESPISymbol::COMMAND_PUT_PC:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_WRITE]);
 							txn_state = TXN_STATE_IDLE;
 							break;
 
 						//Unknown
 						default:
 							txn_state = TXN_STATE_IDLE;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 							break;
 					}
 
@@ -519,7 +527,7 @@ void ESPIDecoder::Refresh()
 					else
 					{
 						cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_COMMAND_CRC_BAD, current_byte));
-						pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+						m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					}
 
 					//Expect a response after a 2-cycle bus turnaround
@@ -555,7 +563,7 @@ void ESPIDecoder::Refresh()
 					{
 						cap->m_durations.push_back(timestamp - tstart);
 						cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_CAPS_ADDR, addr));
-						pack->m_headers["Address"] = GetText(cap->m_samples.size()-1);
+						m_table.SetText(row, colAddress, GetText(cap->m_samples.size()-1));
 
 						if(current_cmd == ESPISymbol::COMMAND_SET_CONFIGURATION)
 						{
@@ -580,7 +588,7 @@ void ESPIDecoder::Refresh()
 
 					//Save data
 					data |= current_byte << ( (count & 3) * 8);
-					pack->m_data.push_back(current_byte);
+					m_table.AppendData(row, current_byte);
 					count ++;
 
 					//Add data
@@ -595,17 +603,17 @@ void ESPIDecoder::Refresh()
 								{
 									case 0x10:
 										cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_CH0_CAPS_WR, data));
-										pack->m_headers["Info"] = Trim(GetText(cap->m_samples.size()-1));
+										m_table.SetText(row, colInfo, Trim(GetText(cap->m_samples.size()-1)));
 										break;
 
 									case 0x20:
 										cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_CH1_CAPS_WR, data));
-										pack->m_headers["Info"] = Trim(GetText(cap->m_samples.size()-1));
+										m_table.SetText(row, colInfo, Trim(GetText(cap->m_samples.size()-1)));
 										break;
 
 									case 0x30:
 										cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_CH2_CAPS_WR, data));
-										pack->m_headers["Info"] = Trim(GetText(cap->m_samples.size()-1));
+										m_table.SetText(row, colInfo, Trim(GetText(cap->m_samples.size()-1)));
 										break;
 
 									default:
@@ -656,7 +664,7 @@ void ESPIDecoder::Refresh()
 						if(completion_type != ESPISymbol::COMPLETION_NONE)
 							LogWarning("Appended completions not implemented yet\n");
 
-						pack->m_headers["Response"] = GetText(cap->m_samples.size()-1);
+						m_table.SetText(row, colResponse, GetText(cap->m_samples.size()-1));
 
 						count = 0;
 						data = 0;
@@ -704,7 +712,7 @@ void ESPIDecoder::Refresh()
 					data |= current_byte << ( (count & 3) * 8);
 					count ++;
 
-					pack->m_data.push_back(current_byte);
+					m_table.AppendData(row, current_byte);
 
 					//TODO: different commands have different lengths for reply data
 					if(count == 4)
@@ -718,22 +726,22 @@ void ESPIDecoder::Refresh()
 								{
 									case 0x8:
 										cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_GENERAL_CAPS, data));
-										pack->m_headers["Info"] = Trim(GetText(cap->m_samples.size()-1));
+										m_table.SetText(row, colInfo, Trim(GetText(cap->m_samples.size()-1)));
 										break;
 
 									case 0x10:
 										cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_CH0_CAPS_RD, data));
-										pack->m_headers["Info"] = Trim(GetText(cap->m_samples.size()-1));
+										m_table.SetText(row, colInfo, Trim(GetText(cap->m_samples.size()-1)));
 										break;
 
 									case 0x20:
 										cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_CH1_CAPS_RD, data));
-										pack->m_headers["Info"] = Trim(GetText(cap->m_samples.size()-1));
+										m_table.SetText(row, colInfo, Trim(GetText(cap->m_samples.size()-1)));
 										break;
 
 									case 0x30:
 										cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_CH2_CAPS_RD, data));
-										pack->m_headers["Info"] = Trim(GetText(cap->m_samples.size()-1));
+										m_table.SetText(row, colInfo, Trim(GetText(cap->m_samples.size()-1)));
 										break;
 
 									default:
@@ -789,7 +797,7 @@ void ESPIDecoder::Refresh()
 							stmp += "NP_AVAIL ";
 						if(data & 0x0010)
 							stmp += "PC_AVAIL ";
-						pack->m_headers["Status"] = stmp;
+						m_table.SetText(row, colStatus, stmp);
 
 						txn_state = TXN_STATE_RESPONSE_CRC8;
 					}
@@ -806,7 +814,7 @@ void ESPIDecoder::Refresh()
 					{
 						LogDebug("Invalid response CRC (got %02x, expected %02x)\n", current_byte, crc);
 						cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_RESPONSE_CRC_BAD, current_byte));
-						pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+						m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					}
 
 					//Done with the packet
@@ -856,7 +864,7 @@ void ESPIDecoder::Refresh()
 						else
 							stmp += " low\n";
 
-						pack->m_headers["Info"] += stmp;
+						vwire_info += stmp;
 					}
 
 					//Indexes 2-7 are "system events".
@@ -930,28 +938,28 @@ void ESPIDecoder::Refresh()
 								break;
 						}
 
-						pack->m_headers["Info"] += stmp;
+						vwire_info += stmp;
 					}
 
 					//Indexes 8-73 are reserved
 					else if(addr <= 63)
-						pack->m_headers["Info"] += "Reserved index\n";
+						vwire_info += "Reserved index\n";
 
 					//64-127 platform specific
 					else if(addr <= 127)
 					{
 						snprintf(tmp, sizeof(tmp), "Platform specific %02lx:%02x\n", addr, current_byte);
-						pack->m_headers["Info"] += tmp;
+						vwire_info += tmp;
 					}
 
 					//128-255 GPIO expander TODO
 					else
-						pack->m_headers["Info"] += "GPIO expander decode not implemented\n";
+						vwire_info += "GPIO expander decode not implemented\n";
 
 					if(count == 0)
 					{
 						//Remove trailing newline
-						pack->m_headers["Info"] = Trim(pack->m_headers["Info"]);
+						m_table.SetText(row, colInfo, Trim(vwire_info));
 
 						if(current_cmd == ESPISymbol::COMMAND_PUT_VWIRE)
 							txn_state = TXN_STATE_COMMAND_CRC8;
@@ -971,7 +979,7 @@ void ESPIDecoder::Refresh()
 				// Flash channel
 
 				case TXN_STATE_FLASH_TYPE:
-					pack->m_data.push_back(current_byte);
+					m_table.AppendData(row, current_byte);
 
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
@@ -983,43 +991,43 @@ void ESPIDecoder::Refresh()
 					switch(cycle_type)
 					{
 						case ESPISymbol::CYCLE_ERASE:
-							pack->m_headers["Info"] = "Erase";
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							m_table.SetText(row, colInfo, "Erase");
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_WRITE]);
 							break;
 
 						case ESPISymbol::CYCLE_READ:
-							pack->m_headers["Info"] = "Read";
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							m_table.SetText(row, colInfo, "Read");
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							break;
 
 						case ESPISymbol::CYCLE_WRITE:
-							pack->m_headers["Info"] = "Write";
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							m_table.SetText(row, colInfo, "Write");
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_WRITE]);
 							break;
 
 						case ESPISymbol::CYCLE_SUCCESS_DATA_FIRST:
 						case ESPISymbol::CYCLE_SUCCESS_DATA_MIDDLE:
 						case ESPISymbol::CYCLE_SUCCESS_DATA_LAST:
 						case ESPISymbol::CYCLE_SUCCESS_DATA_ONLY:
-							pack->m_headers["Info"] = "Read Data";
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							m_table.SetText(row, colInfo, "Read Data");
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							break;
 
 						default:
-							pack->m_headers["Info"] = "Unknown flash op";
+							m_table.SetText(row, colInfo, "Unknown flash op");
 							break;
 					}
 
 					break;	//end TXN_STATE_FLASH_TYPE
 
 				case TXN_STATE_FLASH_TAG_LENHI:
-					pack->m_data.push_back(current_byte);
+					m_table.AppendData(row, current_byte);
 
 					//Tag is high 4 bits
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_REQUEST_TAG, current_byte >> 4));
-					pack->m_headers["Tag"] = to_string(current_byte >> 4);
+					m_table.SetDecimal(row, colTag, current_byte >> 4);
 
 					//Low 4 bits of this byte are the high length bits
 					data = current_byte & 0xf;
@@ -1028,7 +1036,7 @@ void ESPIDecoder::Refresh()
 					break;	//end TXN_STATE_FLASH_TAG_LENHI
 
 				case TXN_STATE_FLASH_LENLO:
-					pack->m_data.push_back(current_byte);
+					m_table.AppendData(row, current_byte);
 
 					//Save the rest of the length
 					cap->m_offsets.push_back(bytestart);
@@ -1036,7 +1044,7 @@ void ESPIDecoder::Refresh()
 					payload_len = current_byte | data;
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_REQUEST_LEN, payload_len));
 
-					pack->m_headers["Len"] = to_string(payload_len);
+					m_table.SetDecimal(row, colLen, payload_len);
 
 					//Get ready to read the address or data
 					count = 0;
@@ -1044,7 +1052,7 @@ void ESPIDecoder::Refresh()
 
 					if(cycle_type >= ESPISymbol::CYCLE_SUCCESS_NODATA)
 					{
-						pack->m_data.clear();
+						m_table.TruncateData(row, 0);
 						txn_state = TXN_STATE_FLASH_DATA;
 					}
 					else
@@ -1073,8 +1081,7 @@ void ESPIDecoder::Refresh()
 
 						//Don't report free space in the protocol analyzer
 						//to save column space
-						snprintf(tmp, sizeof(tmp), "%08lx", data);
-						pack->m_headers["Address"] = tmp;
+						m_table.SetHex(row, colAddress, data, 8);
 
 						count = 0;
 						data = 0;
@@ -1082,7 +1089,7 @@ void ESPIDecoder::Refresh()
 						//Write requests are followed by data
 						if(cycle_type == ESPISymbol::CYCLE_WRITE)
 						{
-							pack->m_data.clear();
+							m_table.TruncateData(row, 0);
 							txn_state = TXN_STATE_FLASH_DATA;
 						}
 
@@ -1095,7 +1102,7 @@ void ESPIDecoder::Refresh()
 
 				case TXN_STATE_FLASH_DATA:
 
-					pack->m_data.push_back(current_byte);
+					m_table.AppendData(row, current_byte);
 
 					//Save the data byte
 					cap->m_offsets.push_back(bytestart);
@@ -1138,7 +1145,7 @@ void ESPIDecoder::Refresh()
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_REQUEST_TAG, current_byte >> 4));
-					pack->m_headers["Tag"] = to_string(current_byte >> 4);
+					m_table.SetDecimal(row, colTag, current_byte >> 4);
 
 					//Low 4 bits of this byte are the high length bits
 					data = current_byte & 0xf;
@@ -1154,7 +1161,7 @@ void ESPIDecoder::Refresh()
 					payload_len = current_byte | data;
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_REQUEST_LEN, payload_len));
 
-					pack->m_headers["Len"] = to_string(payload_len);
+					m_table.SetDecimal(row, colLen, payload_len);
 
 					txn_state = TXN_STATE_SMBUS_ADDR;
 
@@ -1162,15 +1169,14 @@ void ESPIDecoder::Refresh()
 
 				case TXN_STATE_SMBUS_ADDR:
 
-					pack->m_data.clear();
+					m_table.TruncateData(row, 0);
 
 					//Save the SMBus address
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_SMBUS_REQUEST_ADDR, current_byte));
 
-					snprintf(tmp, sizeof(tmp), "%02x", current_byte);
-					pack->m_headers["Address"] = tmp;
+					m_table.SetHex(row, colAddress, current_byte, 2);
 
 					//Get ready to read the packet data
 					//We already read the first byte of the SMBus packet (the slave address)
@@ -1185,7 +1191,7 @@ void ESPIDecoder::Refresh()
 				case TXN_STATE_SMBUS_DATA:
 
 					//Save the data byte
-					pack->m_data.push_back(current_byte);
+					m_table.AppendData(row, current_byte);
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_SMBUS_REQUEST_DATA, current_byte));
@@ -1230,10 +1236,9 @@ void ESPIDecoder::Refresh()
 						cap->m_durations.push_back(timestamp - tstart);
 						cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_IO_ADDR, addr));
 
-						snprintf(tmp, sizeof(tmp), "%04lx", addr);
-						pack->m_headers["Address"] = tmp;
+						m_table.SetHex(row, colAddress, addr, 4);
 
-						pack->m_headers["Len"] = to_string(payload_len);
+						m_table.SetDecimal(row, colLen, payload_len);
 
 						count = 0;
 						txn_state = TXN_STATE_IOWR_DATA;
@@ -1244,7 +1249,7 @@ void ESPIDecoder::Refresh()
 				case TXN_STATE_IOWR_DATA:
 
 					//Save the data byte
-					pack->m_data.push_back(current_byte);
+					m_table.AppendData(row, current_byte);
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_SMBUS_REQUEST_DATA, current_byte));
@@ -1279,8 +1284,7 @@ void ESPIDecoder::Refresh()
 						cap->m_durations.push_back(timestamp - tstart);
 						cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_IO_ADDR, addr));
 
-						snprintf(tmp, sizeof(tmp), "%04lx", addr);
-						pack->m_headers["Address"] = tmp;
+						m_table.SetHex(row, colAddress, addr, 4);
 
 						count = 0;
 						txn_state = TXN_STATE_COMMAND_CRC8;
@@ -1300,20 +1304,20 @@ void ESPIDecoder::Refresh()
 					switch(current_byte)
 					{
 						case ESPISymbol::CYCLE_SUCCESS_NODATA:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_STATUS];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_STATUS]);
 							break;
 
 						case ESPISymbol::CYCLE_SUCCESS_DATA_MIDDLE:
 						case ESPISymbol::CYCLE_SUCCESS_DATA_FIRST:
 						case ESPISymbol::CYCLE_SUCCESS_DATA_LAST:
 						case ESPISymbol::CYCLE_SUCCESS_DATA_ONLY:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							break;
 
 						case ESPISymbol::CYCLE_FAIL_LAST:
 						case ESPISymbol::CYCLE_FAIL_ONLY:
 						default:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 							break;
 					}
 
@@ -1327,7 +1331,7 @@ void ESPIDecoder::Refresh()
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_REQUEST_TAG, current_byte >> 4));
-					pack->m_headers["Tag"] = to_string(current_byte >> 4);
+					m_table.SetDecimal(row, colTag, current_byte >> 4);
 
 					//Low 4 bits of this byte are the high length bits
 					data = current_byte & 0xf;
@@ -1343,7 +1347,7 @@ void ESPIDecoder::Refresh()
 					payload_len = current_byte | data;
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_REQUEST_LEN, payload_len));
 
-					pack->m_headers["Len"] = to_string(payload_len);
+					m_table.SetDecimal(row, colLen, payload_len);
 
 					if(payload_len == 0)
 						txn_state = TXN_STATE_STATUS;
@@ -1355,7 +1359,7 @@ void ESPIDecoder::Refresh()
 				case TXN_STATE_COMPLETION_DATA:
 
 					//Save the data byte
-					pack->m_data.push_back(current_byte);
+					m_table.AppendData(row, current_byte);
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_COMPLETION_DATA, current_byte));
@@ -1402,19 +1406,7 @@ void ESPIDecoder::Refresh()
 uint8_t ESPIDecoder::UpdateCRC8(uint8_t crc, uint8_t data)
 {
 	//CRC runs MSB first using polynomial x^8 + x^2 + x + 1
-	for(int i=7; i>=0; i--)
-	{
-		//Shift CRC left and save the high bit
-		uint8_t hi = crc >> 7;
-		crc = (crc << 1);
-
-		//Mix in the new data bit
-		hi ^= ( (data >> i) & 1);
-		if(hi)
-			crc ^= 0x7;
-	}
-
-	return crc;
+	return CRC8ESPI::UpdateByte(crc, data);
 }
 
 Gdk::Color ESPIDecoder::GetColor(int i)
@@ -2118,15 +2110,15 @@ Packet* ESPIDecoder::CreateMergedHeader(Packet* pack, size_t i)
 	ret->m_offset = pack->m_offset;
 	ret->m_len = pack->m_len;			//TODO: extend?
 
-	Packet* first = m_packets[i];
+	Packet* first = GetPacket(i);
 
 	//Fetching commands requested by the peripheral
 	if(first->m_headers["Command"] == "Get Status")
 	{
 		//Look up the second packet in the string
-		if(i+1 < m_packets.size())
+		if(i+1 < GetPacketCount())
 		{
-			Packet* second = m_packets[i+1];
+			Packet* second = GetPacket(i+1);
 
 			ret->m_headers["Address"] = second->m_headers["Address"];
 			ret->m_headers["Len"] = second->m_headers["Len"];
@@ -2153,9 +2145,9 @@ Packet* ESPIDecoder::CreateMergedHeader(Packet* pack, size_t i)
 
 				//Append any flash completions we find
 				//TODO: handle out-of-order here
-				for(size_t j=i+2; j<m_packets.size(); j++)
+				for(size_t j=i+2; j<GetPacketCount(); j++)
 				{
-					Packet* p = m_packets[j];
+					Packet* p = GetPacket(j);
 					if(p->m_headers["Command"] != "Put Flash Completion")
 						break;
 					if(p->m_headers["Tag"] != second->m_headers["Tag"])
@@ -2198,9 +2190,9 @@ Packet* ESPIDecoder::CreateMergedHeader(Packet* pack, size_t i)
 			ret->m_data.push_back(b);
 
 		//Get status from completions
-		for(size_t j=i+1; j<m_packets.size(); j++)
+		for(size_t j=i+1; j<GetPacketCount(); j++)
 		{
-			Packet* p = m_packets[j];
+			Packet* p = GetPacket(j);
 
 			if(p->m_headers["Command"] == "Get Posted Completion")
 				ret->m_headers["Response"] = p->m_headers["Response"];
@@ -2220,9 +2212,9 @@ Packet* ESPIDecoder::CreateMergedHeader(Packet* pack, size_t i)
 		ret->m_headers["Len"] = first->m_headers["Len"];
 
 		//Get status and data from completions
-		for(size_t j=i+1; j<m_packets.size(); j++)
+		for(size_t j=i+1; j<GetPacketCount(); j++)
 		{
-			Packet* p = m_packets[j];
+			Packet* p = GetPacket(j);
 
 			if(p->m_headers["Command"] == "Get Posted Completion")
 				ret->m_headers["Response"] = p->m_headers["Response"];
@@ -2247,9 +2239,9 @@ Packet* ESPIDecoder::CreateMergedHeader(Packet* pack, size_t i)
 
 		//Get status and data from completions
 		size_t ilast = i;
-		for(size_t j=i+1; j<m_packets.size(); j++)
+		for(size_t j=i+1; j<GetPacketCount(); j++)
 		{
-			Packet* p = m_packets[j];
+			Packet* p = GetPacket(j);
 
 			if( (p->m_headers["Command"] == "Get Configuration") &&
 				(p->m_headers["Address"] == first->m_headers["Address"]) )
@@ -2260,7 +2252,7 @@ Packet* ESPIDecoder::CreateMergedHeader(Packet* pack, size_t i)
 				break;
 		}
 
-		Packet* last = m_packets[ilast];
+		Packet* last = GetPacket(ilast);
 		ret->m_headers["Len"] = to_string(ilast - i);
 		ret->m_headers["Info"] = last->m_headers["Info"];
 		ret->m_headers["Response"] = last->m_headers["Response"];
@@ -111,73 +111,46 @@ void Ethernet64b66bDecoder::Refresh()
 	DigitalWaveform data;
 	SampleOnAnyEdges(din, clkin, data);
 
-	//Look at each phase and figure out block alignment
-	size_t end = data.m_offsets.size() - 66;
-	size_t best_offset = 0;
-	size_t best_errors = end;
-	for(size_t offset=0; offset < 66; offset ++)
+	//Pack the sampled bits one per bit so we can work on a whole block (or 64 alignments) at a time
+	size_t len = data.m_samples.size();
+	if(len <= 66)
 	{
-		size_t errors = 0;
-		for(size_t i=offset; i<end; i+= 66)
-		{
-			if(data.m_samples[i] == data.m_samples[i+1])
-				errors ++;
-		}
-
-		if(errors < best_errors)
-		{
-			best_offset = offset;
-			best_errors = errors;
-		}
+		SetData(cap, 0);
+		return;
 	}
+	PackedDigitalWaveform packed;
+	packed.PackBytes(reinterpret_cast<const uint8_t*>(&data.m_samples[0]), len);
 
+	//Look at each phase and figure out block alignment.
+	//A valid sync header is always 01 or 10, so pick the phase with the most transitions in the header position.
+	//Every phase is checked over the same number of blocks so the counts are directly comparable.
+	size_t end = len - 66;
+	static const uint64_t sync_headers[2] = { 0x1, 0x2 };
+	size_t best_offset = BitstreamAligner::FindBestPhase(packed, sync_headers, 2, 2, 66, end / 66);
 
 	//Decode the actual data
 	bool first		= true;
-	uint64_t lfsr	= 0;
+	uint64_t prev	= 0;
 
 	for(size_t i=best_offset; i<end; i += 66)
 	{
 		//Extract the header bits
 		uint8_t header =
-			(data.m_samples[i] ? 2 : 0) |
-			(data.m_samples[i+1] ? 1 : 0);
-
-		//Extract the data bits and descramble them.
-		uint64_t codeword = 0;
-		for(size_t j=0; j<64; j++)
-		{
-			bool b = data.m_samples[i + 2 + j];
-
-			codeword >>= 1;
-			if(b ^ ( (lfsr >> 38) & 1) ^ ( (lfsr >> 57) & 1) )
-				codeword |= 0x8000000000000000L;
-
-			lfsr = (lfsr << 1) | b;
-		}
+			(packed.GetSample(i) ? 2 : 0) |
+			(packed.GetSample(i+1) ? 1 : 0);
+
+		//Extract the data bits (first bit in the LSB) and descramble them.
+		//The x^58 + x^39 + 1 self-synchronizing scrambler XORs each bit with the ones 39 and 58 bits before it,
+		//so we can do all 64 at once by shifting in the tail of the previous block.
+		uint64_t scrambled = packed.GetBits(i+2);
+		uint64_t codeword =
+			scrambled ^
+			( (scrambled << 39) | (prev >> 25) ) ^
+			( (scrambled << 58) | (prev >> 6) );
+		prev = scrambled;
 
 		//Need to swap bit/byte ordering around a bunch.
-		uint64_t bytes[8] =
-		{
-			(codeword >> 56) & 0xff,
-			(codeword >> 48) & 0xff,
-			(codeword >> 40) & 0xff,
-			(codeword >> 32) & 0xff,
-			(codeword >> 24) & 0xff,
-			(codeword >> 16) & 0xff,
-			(codeword >> 8) & 0xff,
-			(codeword >> 0) & 0xff,
-		};
-
-		codeword =
-			(bytes[7] << 56) |
-			(bytes[6] << 48) |
-			(bytes[5] << 40) |
-			(bytes[4] << 32) |
-			(bytes[3] << 24) |
-			(bytes[2] << 16) |
-			(bytes[1] << 8) |
-			bytes[0];
+		codeword = __builtin_bswap64(codeword);
 
 		//Just prime the scrambler, we can't decode yet
 		if(first)
@@ -47,6 +47,7 @@ EthernetGMIIDecoder::EthernetGMIIDecoder(const string& color)
 	CreateInput("clk");
 	CreateInput("en");
 	CreateInput("er");
+	CreateStateCarryParameter();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -128,36 +129,79 @@ void EthernetGMIIDecoder::Refresh()
 	size_t len = den.m_samples.size();
 	len = min(len, der.m_samples.size());
 	len = min(len, ddata.m_samples.size());
+
+	//Set of recovered bytes and timestamps
+	vector<uint8_t> bytes;
+	vector<uint64_t> starts;
+	vector<uint64_t> ends;
+
+	//If continuing from the last waveform, pick up the frame which was still in progress when it ended.
+	//Those bytes really happened before this waveform started, so they're moved forward to its start. The shift is
+	//taken back out of the timestamp when the frame is exported.
+	size_t ncarried = 0;
+	int64_t carriedShift = 0;
+	auto state = TakeCarriedState(data);
+	int64_t carriedStart;
+	if(state.GetTime("start", data, carriedStart))
+	{
+		bytes = state.GetBytes("frame");
+		int64_t period = state.GetInt("period");
+		ncarried = bytes.size();
+		carriedShift = max(-carriedStart, (int64_t)0);
+		for(size_t i=0; i<ncarried; i++)
+		{
+			starts.push_back(carriedStart + carriedShift + i*period);
+			ends.push_back(starts[i] + period);
+		}
+	}
+
 	for(size_t i=0; i < len; i++)
 	{
+		//End of a frame, crunch the data
 		if(!den.m_samples[i])
-			continue;
-
-		//Set of recovered bytes and timestamps
-		vector<uint8_t> bytes;
-		vector<uint64_t> starts;
-		vector<uint64_t> ends;
-
-		//TODO: handle error signal (ignored for now)
-		while( (i < len) && (den.m_samples[i]) )
 		{
-			//Convert bits to bytes
-			uint8_t dval = 0;
-			for(size_t j=0; j<8; j++)
+			if(!bytes.empty())
 			{
-				if(ddata.m_samples[i][j])
-					dval |= (1 << j);
+				BytesToFrames(bytes, starts, ends, cap, ncarried, carriedShift);
+				bytes.clear();
+				starts.clear();
+				ends.clear();
+				ncarried = 0;
+				carriedShift = 0;
 			}
+			continue;
+		}
 
-			bytes.push_back(dval);
-			starts.push_back(ddata.m_offsets[i]);
-			ends.push_back(ddata.m_offsets[i] + ddata.m_durations[i]);
-			i++;
+		//TODO: handle error signal (ignored for now)
+
+		//Convert bits to bytes
+		uint8_t dval = 0;
+		for(size_t j=0; j<8; j++)
+		{
+			if(ddata.m_samples[i][j])
+				dval |= (1 << j);
 		}
 
-		//Crunch the data
-		BytesToFrames(bytes, starts, ends, cap);
+		bytes.push_back(dval);
+		starts.push_back(ddata.m_offsets[i]);
+		ends.push_back(ddata.m_offsets[i] + ddata.m_durations[i]);
+	}
+
+	//If a frame is still running at the end of the waveform, finish it in the next one if we can.
+	//It hasn't been decoded yet, so save its real start time and byte period to place the bytes again.
+	DecoderState next;
+	if(!bytes.empty())
+	{
+		if(IsStateCarryEnabled())
+		{
+			next.SetBytes("frame", bytes);
+			next.SetTime("start", data, (int64_t)starts[0] - carriedShift);
+			next.SetInt("period", ends.back() - starts.back());
+		}
+		else
+			BytesToFrames(bytes, starts, ends, cap, ncarried, carriedShift);
 	}
+	CarryState(data, next);
 
 	SetData(cap, 0);
 }
@@ -41,23 +41,11 @@ EthernetProtocolDecoder::EthernetProtocolDecoder(const string& color)
 	//Set up channels
 	CreateInput("din");
 
-	//Add parameter for the file name
-	m_outfile = "PCAP Output";
-	m_parameters[m_outfile] = FilterParameter(FilterParameter::TYPE_FILENAME, Unit(Unit::UNIT_COUNTS));
-	m_parameters[m_outfile].m_fileFilterMask = "*.pcap";
-	m_parameters[m_outfile].m_fileFilterName = "PCAP files (*.pcap)";
-	m_parameters[m_outfile].m_fileIsOutput = true;
-
-	m_fpOut = NULL;
+	CreateExportParameters(PcapngWriter::LINKTYPE_ETHERNET);
 }
 
 EthernetProtocolDecoder::~EthernetProtocolDecoder()
 {
-	if(m_fpOut)
-	{
-		fclose(m_fpOut);
-		m_fpOut = NULL;
-	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -96,51 +84,39 @@ vector<string> EthernetProtocolDecoder::GetHeaders()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual protocol decoding
 
+/**
+	@brief Decodes one frame
+
+	@param bytes		The frame, starting with the preamble
+	@param starts		Start time of each byte (femtoseconds)
+	@param ends			End time of each byte (femtoseconds)
+	@param cap			Waveform to add the decoded segments to
+	@param ncarried		Number of bytes at the start of the frame which were carried over from the previous waveform
+	@param carriedShift	How far (in femtoseconds) the carried bytes were moved forward to fit in this waveform. This
+						is taken back out of the timestamp when exporting the frame.
+ */
 void EthernetProtocolDecoder::BytesToFrames(
 		vector<uint8_t>& bytes,
 		vector<uint64_t>& starts,
 		vector<uint64_t>& ends,
-		EthernetWaveform* cap)
+		EthernetWaveform* cap,
+		size_t ncarried,
+		int64_t carriedShift)
 {
-	//Look up the file name, if any
-	auto fname = m_parameters[m_outfile].GetFileName();
-	if(m_cachedOutputFname != fname)
-	{
-		m_cachedOutputFname = fname;
-		if(m_fpOut)
-			fclose(m_fpOut);
-		m_fpOut = fopen(fname.c_str(), "wb");
-
-		//TODO: error logging if valid filename we can't open
-		//TODO: pull in libpcap headers and just write a pcap_hdr_s instead?
-		if(m_fpOut)
-		{
-			uint32_t magic = 0xa1b2c3d4;				//timestamps in sec+us
-			fwrite(&magic, sizeof(magic), 1, m_fpOut);
-			uint16_t major = 2;
-			uint16_t minor = 4;
-			fwrite(&major, sizeof(major), 1, m_fpOut);
-			fwrite(&minor, sizeof(minor), 1, m_fpOut);
-
-			int32_t reserved = 0;
-			fwrite(&reserved, sizeof(reserved), 1, m_fpOut);
-			fwrite(&reserved, sizeof(reserved), 1, m_fpOut);
-
-			uint32_t max_packet = 65535;
-			fwrite(&max_packet, sizeof(max_packet), 1, m_fpOut);
-
-			uint32_t network_type = 1;
-			fwrite(&network_type, sizeof(network_type), 1, m_fpOut);
-		}
-	}
+	//Column IDs for the packet table
+	size_t colDst = m_table.GetColumn("Dest MAC");
+	size_t colSrc = m_table.GetColumn("Src MAC");
+	size_t colVlan = m_table.GetColumn("VLAN");
+	size_t colType = m_table.GetColumn("Ethertype");
 
-	Packet* pack = new Packet;
+	size_t row = m_table.AddRow(0);
 
 	EthernetFrameSegment segment;
 	segment.m_type = EthernetFrameSegment::TYPE_INVALID;
 	size_t start = 0;
 	size_t len = bytes.size();
 	size_t crcstart = 0;
+	int64_t framestart = 0;
 	uint32_t crc_expected = 0;
 	uint32_t crc_actual = 0;
 	for(size_t i=0; i<len; i++)
@@ -164,7 +140,7 @@ void EthernetProtocolDecoder::BytesToFrames(
 					segment.m_data.push_back(0x55);
 
 					//Start a new packet
-					pack->m_offset = starts[i];
+					m_table.SetOffset(row, starts[i]);
 				}
 				break;
 
@@ -192,35 +168,9 @@ void EthernetProtocolDecoder::BytesToFrames(
 					segment.m_data.clear();
 
 					crcstart = i+1;
-
-					//Save to the PCAP file, if open
-					if(m_fpOut)
-					{
-						//Calculate the start time of the packet
-						time_t tstart = cap->m_startTimestamp;
-						int64_t fs = cap->m_startFemtoseconds + start;
-						if(fs >= FS_PER_SECOND)
-						{
-							tstart += (fs / FS_PER_SECOND);
-							fs %= (int64_t)FS_PER_SECOND;
-						}
-
-						//Convert timestamp to PCAP format: 32-bit sec + us
-						uint32_t sec = tstart;
-						uint32_t us = fs / 1000000000;
-						fwrite(&sec, sizeof(sec), 1, m_fpOut);
-						fwrite(&us, sizeof(us), 1, m_fpOut);
-
-						//Length of the packet (not including preamble or SFD, which we truncate)
-						//Write twice: captured length and actual length
-						uint32_t packet_len = bytes.size() - (i+1);
-						fwrite(&packet_len, sizeof(packet_len), 1, m_fpOut);
-						fwrite(&packet_len, sizeof(packet_len), 1, m_fpOut);
-
-						//Write the actual packet data
-						fwrite(&bytes[i+1], packet_len, 1, m_fpOut);
-						fflush(m_fpOut);
-					}
+					framestart = start;
+					if(i < ncarried)
+						framestart -= carriedShift;
 				}
 
 				//No SFD, just add the preamble byte
@@ -253,16 +203,7 @@ void EthernetProtocolDecoder::BytesToFrames(
 					cap->m_durations.push_back( (ends[i] - start) / cap->m_timescale );
 					cap->m_samples.push_back(segment);
 
-					//Format the content for display
-					char tmp[64];
-					snprintf(tmp, sizeof(tmp), "%02x:%02x:%02x:%02x:%02x:%02x",
-						segment.m_data[0],
-						segment.m_data[1],
-						segment.m_data[2],
-						segment.m_data[3],
-						segment.m_data[4],
-						segment.m_data[5]);
-					pack->m_headers["Dest MAC"] = tmp;
+					m_table.SetMAC(row, colDst, &segment.m_data[0]);
 
 					//Reset for next block of the frame
 					segment.m_type = EthernetFrameSegment::TYPE_SRC_MAC;
@@ -289,16 +230,7 @@ void EthernetProtocolDecoder::BytesToFrames(
 					cap->m_durations.push_back( (ends[i] - start) / cap->m_timescale);
 					cap->m_samples.push_back(segment);
 
-					//Format the content for display
-					char tmp[64];
-					snprintf(tmp, sizeof(tmp),"%02x:%02x:%02x:%02x:%02x:%02x",
-						segment.m_data[0],
-						segment.m_data[1],
-						segment.m_data[2],
-						segment.m_data[3],
-						segment.m_data[4],
-						segment.m_data[5]);
-					pack->m_headers["Src MAC"] = tmp;
+					m_table.SetMAC(row, colSrc, &segment.m_data[0]);
 
 					//Reset for next block of the frame
 					segment.m_type = EthernetFrameSegment::TYPE_ETHERTYPE;
@@ -338,58 +270,54 @@ void EthernetProtocolDecoder::BytesToFrames(
 					if(ethertype < 1500)
 					{
 						//Default to unknown LLC
-						pack->m_headers["Ethertype"] = "LLC";
-						pack->m_displayBackgroundColor = Gdk::Color("#33a02c");
-						pack->m_displayForegroundColor = Gdk::Color("#000000");
+						m_table.SetText(row, colType, "LLC");
+						m_table.SetBackgroundColor(row, Gdk::Color("#33a02c"));
+						m_table.SetForegroundColor(row, Gdk::Color("#000000"));
 
 						//Look up the LLC LSAP address to see what it is
 						if( (i+1) < bytes.size() )
 						{
 							if(bytes[i+1] == 0x42)
 							{
-								pack->m_headers["Ethertype"] = "STP";
-								pack->m_displayBackgroundColor = Gdk::Color("#fdbf6f");
-								pack->m_displayForegroundColor = Gdk::Color("#000000");
+								m_table.SetText(row, colType, "STP");
+								m_table.SetBackgroundColor(row, Gdk::Color("#fdbf6f"));
+								m_table.SetForegroundColor(row, Gdk::Color("#000000"));
 							}
 						}
 					}
 					else
 					{
-						char tmp[64];
 						switch(ethertype)
 						{
 							case 0x0800:
-								pack->m_headers["Ethertype"] = "IPv4";
-								pack->m_displayBackgroundColor = Gdk::Color("#a6cee3");
-								pack->m_displayForegroundColor = Gdk::Color("#000000");
+								m_table.SetText(row, colType, "IPv4");
+								m_table.SetBackgroundColor(row, Gdk::Color("#a6cee3"));
+								m_table.SetForegroundColor(row, Gdk::Color("#000000"));
 								break;
 
 							case 0x0806:
-								pack->m_headers["Ethertype"] = "ARP";
-								pack->m_displayBackgroundColor = Gdk::Color("#ffff99");
-								pack->m_displayForegroundColor = Gdk::Color("#000000");
+								m_table.SetText(row, colType, "ARP");
+								m_table.SetBackgroundColor(row, Gdk::Color("#ffff99"));
+								m_table.SetForegroundColor(row, Gdk::Color("#000000"));
 								break;
 
 							//TODO: decoder inner ethertype too?
 							case 0x8100:
-								pack->m_headers["Ethertype"] = "802.1q";
-								pack->m_displayBackgroundColor = Gdk::Color("#b2df8a");
-								pack->m_displayForegroundColor = Gdk::Color("#000000");
+								m_table.SetText(row, colType, "802.1q");
+								m_table.SetBackgroundColor(row, Gdk::Color("#b2df8a"));
+								m_table.SetForegroundColor(row, Gdk::Color("#000000"));
 								break;
 
 							case 0x86DD:
-								pack->m_headers["Ethertype"] = "IPv6";
-								pack->m_displayBackgroundColor = Gdk::Color("#1f78b4");
-								pack->m_displayForegroundColor = Gdk::Color("#ffffff");
+								m_table.SetText(row, colType, "IPv6");
+								m_table.SetBackgroundColor(row, Gdk::Color("#1f78b4"));
+								m_table.SetForegroundColor(row, Gdk::Color("#ffffff"));
 								break;
 
 							default:
-								snprintf(tmp, sizeof(tmp), "%02x%02x",
-								segment.m_data[0],
-								segment.m_data[1]);
-								pack->m_headers["Ethertype"] = tmp;
-								pack->m_displayBackgroundColor = Gdk::Color("#fb9a99");
-								pack->m_displayForegroundColor = Gdk::Color("#000000");
+								m_table.SetHex(row, colType, ethertype, 4);
+								m_table.SetBackgroundColor(row, Gdk::Color("#fb9a99"));
+								m_table.SetForegroundColor(row, Gdk::Color("#000000"));
 								break;
 						}
 					}
@@ -429,10 +357,7 @@ void EthernetProtocolDecoder::BytesToFrames(
 					segment.m_type = EthernetFrameSegment::TYPE_ETHERTYPE;
 					segment.m_data.clear();
 
-					//Format the content for display
-					char tmp[64];
-					snprintf(tmp, sizeof(tmp),"%d", tag & 0xfff);
-					pack->m_headers["VLAN"] = tmp;
+					m_table.SetDecimal(row, colVlan, tag & 0xfff);
 				}
 
 				break;
@@ -456,7 +381,7 @@ void EthernetProtocolDecoder::BytesToFrames(
 					segment.m_type = EthernetFrameSegment::TYPE_FCS_GOOD;
 				}
 				else
-					pack->m_data.push_back(bytes[i]);
+					m_table.AppendData(row, bytes[i]);
 				break;
 
 			case EthernetFrameSegment::TYPE_FCS_GOOD:
@@ -481,15 +406,17 @@ void EthernetProtocolDecoder::BytesToFrames(
 					if(crc_actual != crc_expected)
 					{
 						segment.m_type = EthernetFrameSegment::TYPE_FCS_BAD;
-						pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
-						pack->m_displayForegroundColor = Gdk::Color("#ffffff");
+						m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
+						m_table.SetForegroundColor(row, Gdk::Color("#ffffff"));
 					}
 
 					cap->m_durations.push_back( (ends[i] - start)/ cap->m_timescale);
 					cap->m_samples.push_back(segment);
 
-					pack->m_len = ends[i] - pack->m_offset;
-					m_packets.push_back(pack);
+					m_table.SetEnd(row, ends[i]);
+
+					//Export the frame from the destination MAC through the FCS (preamble and SFD are truncated)
+					ExportPacket(cap, framestart, &bytes[crcstart], i+1 - crcstart);
 					return;
 				}
 
@@ -501,7 +428,7 @@ void EthernetProtocolDecoder::BytesToFrames(
 	}
 
 	//If we get here it wasn't a valid frame
-	delete pack;
+	m_table.RemoveLastRow();
 }
 
 Gdk::Color EthernetProtocolDecoder::GetColor(int i)
@@ -95,11 +95,9 @@ protected:
 		std::vector<uint8_t>& bytes,
 		std::vector<uint64_t>& starts,
 		std::vector<uint64_t>& ends,
-		EthernetWaveform* cap);
-
-	std::string m_outfile;
-	std::string m_cachedOutputFname;
-	FILE* m_fpOut;
+		EthernetWaveform* cap,
+		size_t ncarried = 0,
+		int64_t carriedShift = 0);
 };
 
 #endif
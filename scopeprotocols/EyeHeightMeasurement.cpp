@@ -132,7 +132,7 @@ void EyeHeightMeasurement::Refresh()
 	auto din = dynamic_cast<EyeWaveform*>(GetInputWaveform(0));
 
 	//Create the output
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(din->GetWidth());
 
 	//Make sure times are in the right order
 	float tstart = m_parameters[m_startname].GetFloatVal();
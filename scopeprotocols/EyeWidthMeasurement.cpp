@@ -128,7 +128,7 @@ void EyeWidthMeasurement::Refresh()
 	auto din = dynamic_cast<EyeWaveform*>(GetInputWaveform(0));
 
 	//Create the output
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(din->GetHeight());
 
 	//Make sure voltages are in the right order
 	float vstart = m_parameters[m_startname].GetFloatVal();
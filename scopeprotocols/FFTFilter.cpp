@@ -35,6 +35,58 @@
 
 using namespace std;
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// RealFFTPlan
+
+RealFFTPlan::RealFFTPlan()
+	: m_npoints(0)
+	, m_forwardPlan(NULL)
+	, m_reversePlan(NULL)
+{
+}
+
+RealFFTPlan::~RealFFTPlan()
+{
+	Clear();
+}
+
+void RealFFTPlan::Clear()
+{
+	if(m_forwardPlan)
+		ffts_free(m_forwardPlan);
+	if(m_reversePlan)
+		ffts_free(m_reversePlan);
+	m_forwardPlan = NULL;
+	m_reversePlan = NULL;
+	m_npoints = 0;
+}
+
+/**
+	@brief Changes the transform size. Existing plans are kept if the size is unchanged.
+ */
+void RealFFTPlan::Resize(size_t npoints)
+{
+	if(npoints == m_npoints)
+		return;
+
+	Clear();
+	m_npoints = npoints;
+}
+
+void RealFFTPlan::Forward(const float* in, float* out)
+{
+	if(!m_forwardPlan)
+		m_forwardPlan = ffts_init_1d_real(m_npoints, FFTS_FORWARD);
+	ffts_execute(m_forwardPlan, in, out);
+}
+
+void RealFFTPlan::Reverse(const float* in, float* out)
+{
+	if(!m_reversePlan)
+		m_reversePlan = ffts_init_1d_real(m_npoints, FFTS_BACKWARD);
+	ffts_execute(m_reversePlan, in, out);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -50,7 +102,6 @@ FFTFilter::FFTFilter(const string& color)
 
 	m_cachedNumPoints = 0;
 	m_cachedNumPointsFFT = 0;
-	m_plan = NULL;
 
 	//Default config
 	m_range = 70;
@@ -150,9 +201,6 @@ FFTFilter::FFTFilter(const string& color)
 
 FFTFilter::~FFTFilter()
 {
-	if(m_plan)
-		ffts_free(m_plan);
-
 	#ifdef HAVE_CLFFT
 		if(m_clfftPlan != 0)
 			clfftDestroyPlan(&m_clfftPlan);
@@ -245,17 +293,12 @@ void FFTFilter::ReallocateBuffers(size_t npoints_raw, size_t npoints, size_t nou
 	{
 		m_cachedNumPointsFFT = npoints;
 
-		if(m_plan)
-		{
-			ffts_free(m_plan);
-
-			#ifdef HAVE_CLFFT
-				if(m_clfftPlan != 0)
-					clfftDestroyPlan(&m_clfftPlan);
-			#endif
-		}
+		m_plan.Resize(npoints);
 
-		m_plan = ffts_init_1d_real(npoints, FFTS_FORWARD);
+		#ifdef HAVE_CLFFT
+			if(m_clfftPlan != 0)
+				clfftDestroyPlan(&m_clfftPlan);
+		#endif
 
 		#ifdef HAVE_CLFFT
 
@@ -334,7 +377,7 @@ void FFTFilter::DoRefresh(
 	AnalogWaveform* cap = dynamic_cast<AnalogWaveform*>(GetData(0));
 	if(cap == NULL)
 	{
-		cap = new AnalogWaveform;
+		cap = g_waveformPool.Allocate<AnalogWaveform>(nouts);
 		SetData(cap, 0);
 	}
 	cap->m_startTimestamp = din->m_startTimestamp;
@@ -444,15 +487,15 @@ void FFTFilter::DoRefresh(
 		memset(&m_rdinbuf[m_cachedNumPoints], 0, (npoints - m_cachedNumPoints) * sizeof(float));
 
 		//Calculate the FFT
-		ffts_execute(m_plan, &m_rdinbuf[0], &m_rdoutbuf[0]);
+		m_plan.Forward(&m_rdinbuf[0], &m_rdoutbuf[0]);
 
 		//Normalize magnitudes
 		if(log_output)
 		{
 			if(g_hasAvx2)
-				NormalizeOutputLogAVX2(cap, nouts, scale);
+				NormalizeOutputLogAVX2(&m_rdoutbuf[0], (float*)&cap->m_samples[0], nouts, scale);
 			else
-				NormalizeOutputLog(cap, nouts, scale);
+				NormalizeOutputLog(&m_rdoutbuf[0], (float*)&cap->m_samples[0], nouts, scale);
 		}
 		else
 		{
@@ -476,19 +519,19 @@ void FFTFilter::DoRefresh(
 /**
 	@brief Normalize FFT output and convert to dBm (unoptimized C++ implementation)
  */
-void FFTFilter::NormalizeOutputLog(AnalogWaveform* cap, size_t nouts, float scale)
+void FFTFilter::NormalizeOutputLog(const float* in, float* out, size_t nouts, float scale)
 {
 	//assume constant 50 ohms for now
 	const float impedance = 50;
 	for(size_t i=0; i<nouts; i++)
 	{
-		float real = m_rdoutbuf[i*2];
-		float imag = m_rdoutbuf[i*2 + 1];
+		float real = in[i*2];
+		float imag = in[i*2 + 1];
 
 		float voltage = sqrtf(real*real + imag*imag) * scale;
 
 		//Convert to dBm
-		cap->m_samples[i] = (10 * log10(voltage*voltage / impedance) + 30);
+		out[i] = (10 * log10(voltage*voltage / impedance) + 30);
 	}
 }
 
@@ -510,7 +553,7 @@ void FFTFilter::NormalizeOutputLinear(AnalogWaveform* cap, size_t nouts, float s
 	@brief Normalize FFT output and convert to dBm (optimized AVX2 implementation)
  */
 __attribute__((target("avx2")))
-void FFTFilter::NormalizeOutputLogAVX2(AnalogWaveform* cap, size_t nouts, float scale)
+void FFTFilter::NormalizeOutputLogAVX2(const float* in, float* out, size_t nouts, float scale)
 {
 	size_t end = nouts - (nouts % 8);
 
@@ -529,8 +572,8 @@ void FFTFilter::NormalizeOutputLogAVX2(AnalogWaveform* cap, size_t nouts, float
 	__m256 const_10 = {10, 10, 10, 10, 10, 10, 10, 10 };
 	__m256 const_30 = {30, 30, 30, 30, 30, 30, 30, 30 };
 
-	float* pout = (float*)&cap->m_samples[0];
-	float* pin = &m_rdoutbuf[0];
+	float* pout = out;
+	const float* pin = in;
 
 	//Vectorized processing (8 samples per iteration)
 	for(size_t k=0; k<end; k += 8)
@@ -579,8 +622,8 @@ void FFTFilter::NormalizeOutputLogAVX2(AnalogWaveform* cap, size_t nouts, float
 	//Get any extras we didn't get in the SIMD loop
 	for(size_t k=end; k<nouts; k++)
 	{
-		float real = m_rdoutbuf[k*2];
-		float imag = m_rdoutbuf[k*2 + 1];
+		float real = in[k*2];
+		float imag = in[k*2 + 1];
 
 		float voltage = sqrtf(real*real + imag*imag) * scale;
 
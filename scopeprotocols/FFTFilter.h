@@ -41,6 +41,38 @@
 #include <clFFT.h>
 #endif
 
+/**
+	@brief A real-input FFT of a fixed size, with forward and reverse plans created on first use
+
+	The forward transform takes npoints real samples and produces npoints/2 + 1 interleaved complex bins. The reverse
+	transform goes the other way and is not normalized (the output is scaled by npoints).
+
+	ffts plans carry internal scratch state, so one instance must not be executed from more than one thread at a time.
+ */
+class RealFFTPlan
+{
+public:
+	RealFFTPlan();
+	~RealFFTPlan();
+
+	RealFFTPlan(const RealFFTPlan&) = delete;
+	RealFFTPlan& operator=(const RealFFTPlan&) = delete;
+
+	void Resize(size_t npoints);
+	void Clear();
+
+	size_t GetSize() const
+	{ return m_npoints; }
+
+	void Forward(const float* in, float* out);
+	void Reverse(const float* in, float* out);
+
+protected:
+	size_t m_npoints;
+	ffts_plan_t* m_forwardPlan;
+	ffts_plan_t* m_reversePlan;
+};
+
 class FFTFilter : public PeakDetectionFilter
 {
 public:
@@ -79,11 +111,13 @@ public:
 	static void BlackmanHarrisWindow(const float* data, size_t len, float* out);
 	static void BlackmanHarrisWindowAVX2(const float* data, size_t len, float* out);
 
+	//Convert interleaved complex FFT output to dBm (in and out must be 32-byte aligned for the AVX2 version)
+	static void NormalizeOutputLog(const float* in, float* out, size_t nouts, float scale);
+	static void NormalizeOutputLogAVX2(const float* in, float* out, size_t nouts, float scale);
+
 	PROTOCOL_DECODER_INITPROC(FFTFilter)
 
 protected:
-	void NormalizeOutputLog(AnalogWaveform* cap, size_t nouts, float scale);
-	void NormalizeOutputLogAVX2(AnalogWaveform* cap, size_t nouts, float scale);
 	void NormalizeOutputLinear(AnalogWaveform* cap, size_t nouts, float scale);
 	void NormalizeOutputLinearAVX2(AnalogWaveform* cap, size_t nouts, float scale);
 
@@ -98,7 +132,7 @@ protected:
 	size_t m_cachedNumPointsFFT;
 	std::vector<float, AlignedAllocator<float, 64> > m_rdinbuf;
 	std::vector<float, AlignedAllocator<float, 64> > m_rdoutbuf;
-	ffts_plan_t* m_plan;
+	RealFFTPlan m_plan;
 
 	float m_range;
 	float m_offset;
@@ -30,9 +30,13 @@
 #include "scopeprotocols.h"
 #include "FIRFilter.h"
 #include <immintrin.h>
+#include <omp.h>
 
 using namespace std;
 
+size_t FIRFilter::s_fftCrossover = 0;
+once_flag FIRFilter::s_fftCrossoverFlag;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -154,6 +158,11 @@ bool FIRFilter::NeedsConfig()
 	return true;
 }
 
+bool FIRFilter::SupportsImplicitTimestamps()
+{
+	return true;
+}
+
 double FIRFilter::GetVoltageRange()
 {
 	return m_range;
@@ -212,6 +221,13 @@ void FIRFilter::Refresh()
 		filterlen = (atten / 22) * (sample_hz / (fhi - flo) );
 	filterlen |= 1;	//force length to be odd
 
+	//Need at least one full filter length of input to produce any output
+	if(din->m_samples.size() <= filterlen)
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
 	//Create the filter coefficients (TODO: cache this)
 	vector<float> coeffs;
 	coeffs.resize(filterlen);
@@ -257,6 +273,22 @@ void FIRFilter::DoFilterKernel(
 	else
 	#endif
 
+	if(coefficients.size() >= GetFFTCrossover())
+		DoFilterKernelFFT(coefficients, din, cap, vmin, vmax, m_fftState);
+	else
+		DoFilterKernelDirect(coefficients, din, cap, vmin, vmax);
+}
+
+/**
+	@brief Direct-form convolution on the CPU, using the best instruction set available
+ */
+void FIRFilter::DoFilterKernelDirect(
+	vector<float>& coefficients,
+	AnalogWaveform* din,
+	AnalogWaveform* cap,
+	float& vmin,
+	float& vmax)
+{
 	if(g_hasAvx512F)
 		DoFilterKernelAVX512F(coefficients, din, cap, vmin, vmax);
 	else if(g_hasAvx2)
@@ -375,6 +407,8 @@ void FIRFilter::DoFilterKernelAVX2(
 	float& vmin,
 	float& vmax)
 {
+	vmin = FLT_MAX;
+	vmax = -FLT_MAX;
 	__m256 vmin_x8 = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
 	__m256 vmax_x8 = { -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
 
@@ -494,7 +528,7 @@ void FIRFilter::DoFilterKernelAVX2(
 	}
 
 	//Catch any stragglers
-	for(; i<end_rounded; i++)
+	for(; i<end; i++)
 	{
 		float v = 0;
 		for(size_t j=0; j<filterlen; j++)
@@ -518,6 +552,8 @@ void FIRFilter::DoFilterKernelAVX512F(
 	float& vmin,
 	float& vmax)
 {
+	vmin = FLT_MAX;
+	vmax = -FLT_MAX;
 	__m512 vmin_x16 = _mm512_set1_ps(FLT_MAX);
 	__m512 vmax_x16 = _mm512_set1_ps(-FLT_MAX);
 
@@ -598,7 +634,7 @@ void FIRFilter::DoFilterKernelAVX512F(
 	}
 
 	//Catch any stragglers
-	for(; i<end_rounded; i++)
+	for(; i<end; i++)
 	{
 		float v = 0;
 		for(size_t j=0; j<filterlen; j++)
@@ -611,6 +647,240 @@ void FIRFilter::DoFilterKernelAVX512F(
 	}
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FFT convolution
+
+FIRFilter::FFTState::FFTState()
+	: m_npoints(0)
+{
+}
+
+FIRFilter::FFTState::~FFTState()
+{
+	Clear();
+}
+
+void FIRFilter::FFTState::Clear()
+{
+	for(auto p : m_forwardPlans)
+		ffts_free(p);
+	for(auto p : m_reversePlans)
+		ffts_free(p);
+	m_forwardPlans.clear();
+	m_reversePlans.clear();
+	m_timeBufs.clear();
+	m_freqBufs.clear();
+	m_kernelFreq.clear();
+	m_cachedCoefficients.clear();
+	m_npoints = 0;
+}
+
+/**
+	@brief Creates plans and buffers for the given FFT size, and transforms the filter kernel if it has changed
+ */
+void FIRFilter::FFTState::Setup(const vector<float>& coefficients, size_t npoints, size_t nthreads)
+{
+	size_t nouts = npoints/2 + 1;
+
+	if( (npoints != m_npoints) || (nthreads > m_forwardPlans.size()) )
+	{
+		Clear();
+		m_npoints = npoints;
+
+		m_forwardPlans.resize(nthreads);
+		m_reversePlans.resize(nthreads);
+		m_timeBufs.resize(nthreads);
+		m_freqBufs.resize(nthreads);
+		for(size_t i=0; i<nthreads; i++)
+		{
+			m_forwardPlans[i] = ffts_init_1d_real(npoints, FFTS_FORWARD);
+			m_reversePlans[i] = ffts_init_1d_real(npoints, FFTS_BACKWARD);
+			m_timeBufs[i].resize(npoints);
+			m_freqBufs[i].resize(2*nouts);
+		}
+	}
+
+	if(coefficients == m_cachedCoefficients)
+		return;
+	m_cachedCoefficients = coefficients;
+
+	//The filter is a correlation (out[i] = sum in[i+j] * coeff[j]), so convolve with the reversed kernel.
+	//Fold the 1/N normalization of the inverse FFT into the kernel while we're at it.
+	size_t filterlen = coefficients.size();
+	float* tbuf = &m_timeBufs[0][0];
+	for(size_t i=0; i<filterlen; i++)
+		tbuf[i] = coefficients[filterlen - 1 - i];
+	memset(tbuf + filterlen, 0, (npoints - filterlen) * sizeof(float));
+
+	m_kernelFreq.resize(2*nouts);
+	ffts_execute(m_forwardPlans[0], tbuf, &m_kernelFreq[0]);
+
+	float scale = 1.0f / npoints;
+	for(auto& f : m_kernelFreq)
+		f *= scale;
+}
+
+/**
+	@brief Picks the FFT block size for a given kernel length
+
+	About 8x the kernel length keeps most of each block as useful output without making the FFTs needlessly large.
+ */
+size_t FIRFilter::GetFFTSize(size_t filterlen)
+{
+	size_t npoints = 1;
+	while(npoints < filterlen)
+		npoints <<= 1;
+	return max((size_t)1024, npoints * 8);
+}
+
+/**
+	@brief FIR filter using overlap-save FFT convolution
+
+	Produces the same output samples, with the same alignment to the input, as the direct form kernels (to within
+	float rounding), but at a cost per sample that scales with log(taps) rather than taps.
+
+	Blocks are independent so they're processed in parallel.
+ */
+void FIRFilter::DoFilterKernelFFT(
+	vector<float>& coefficients,
+	AnalogWaveform* din,
+	AnalogWaveform* cap,
+	float& vmin,
+	float& vmax,
+	FFTState& state)
+{
+	size_t len = din->m_samples.size();
+	size_t filterlen = coefficients.size();
+	size_t end = len - filterlen;
+
+	//Each block of npoints input samples yields (npoints - filterlen + 1) outputs free of circular wraparound
+	size_t npoints = GetFFTSize(filterlen);
+	size_t nouts = npoints/2 + 1;
+	size_t step = npoints - filterlen + 1;
+	size_t nblocks = (end + step - 1) / step;
+
+	size_t nthreads = omp_get_max_threads();
+	state.Setup(coefficients, npoints, nthreads);
+
+	const float* pin = (const float*)&din->m_samples[0];
+	float* pout = (float*)&cap->m_samples[0];
+	const float* kernel = &state.m_kernelFreq[0];
+
+	vector<float> mins(nthreads, FLT_MAX);
+	vector<float> maxs(nthreads, -FLT_MAX);
+
+	#pragma omp parallel for
+	for(size_t block=0; block<nblocks; block++)
+	{
+		size_t tid = omp_get_thread_num();
+		float* tbuf = &state.m_timeBufs[tid][0];
+		float* fbuf = &state.m_freqBufs[tid][0];
+
+		//Copy the input, then fill any extra space at the end of the waveform with zeroes
+		size_t base = block * step;
+		size_t navail = min(npoints, len - base);
+		memcpy(tbuf, pin + base, navail * sizeof(float));
+		memset(tbuf + navail, 0, (npoints - navail) * sizeof(float));
+
+		ffts_execute(state.m_forwardPlans[tid], tbuf, fbuf);
+
+		//Complex multiply by the kernel spectrum
+		for(size_t i=0; i<nouts; i++)
+		{
+			float ar = fbuf[i*2];
+			float ai = fbuf[i*2 + 1];
+			float br = kernel[i*2];
+			float bi = kernel[i*2 + 1];
+			fbuf[i*2]		= ar*br - ai*bi;
+			fbuf[i*2 + 1]	= ar*bi + ai*br;
+		}
+
+		ffts_execute(state.m_reversePlans[tid], fbuf, tbuf);
+
+		//The first filterlen-1 points are corrupted by wraparound, the rest are our output
+		size_t count = min(step, end - base);
+		const float* src = tbuf + filterlen - 1;
+		float bmin = mins[tid];
+		float bmax = maxs[tid];
+		for(size_t i=0; i<count; i++)
+		{
+			float v = src[i];
+			bmin = min(bmin, v);
+			bmax = max(bmax, v);
+		}
+		memcpy(pout + base, src, count * sizeof(float));
+		mins[tid] = bmin;
+		maxs[tid] = bmax;
+	}
+
+	vmin = FLT_MAX;
+	vmax = -FLT_MAX;
+	for(size_t i=0; i<nthreads; i++)
+	{
+		vmin = min(vmin, mins[i]);
+		vmax = max(vmax, maxs[i]);
+	}
+}
+
+/**
+	@brief Gets the number of taps at and above which the FFT kernel is used instead of the direct form.
+
+	Measured the first time it's needed (normally from ScopeProtocolStaticInit()).
+ */
+size_t FIRFilter::GetFFTCrossover()
+{
+	call_once(s_fftCrossoverFlag, []{ s_fftCrossover = MeasureFFTCrossover(); });
+	return s_fftCrossover;
+}
+
+/**
+	@brief Benchmarks the direct form and FFT kernels on this machine to find the tap count where FFT starts winning
+ */
+size_t FIRFilter::MeasureFFTCrossover()
+{
+	const size_t len = 65536;
+	const size_t maxtaps = 1023;
+
+	AnalogWaveform din;
+	AnalogWaveform cap;
+	din.Resize(len);
+	cap.Resize(len);
+	for(size_t i=0; i<len; i++)
+		din.m_samples[i] = sinf(i * 0.01f) + (rand() & 0xff) / 1024.0f;
+
+	FFTState state;
+	size_t crossover = 0;
+	for(size_t taps = 15; taps <= maxtaps; taps = taps*2 + 1)
+	{
+		vector<float> coeffs(taps, 1.0f / taps);
+		float vmin;
+		float vmax;
+
+		double start = GetTime();
+		DoFilterKernelDirect(coeffs, &din, &cap, vmin, vmax);
+		double tdirect = GetTime() - start;
+
+		//Run once to create the plans, then time the second pass
+		DoFilterKernelFFT(coeffs, &din, &cap, vmin, vmax, state);
+		start = GetTime();
+		DoFilterKernelFFT(coeffs, &din, &cap, vmin, vmax, state);
+		double tfft = GetTime() - start;
+
+		if(tfft < tdirect)
+		{
+			crossover = taps;
+			break;
+		}
+	}
+
+	//Direct form still won at the biggest size we tried, but FFT will eventually
+	if(crossover == 0)
+		crossover = maxtaps*2 + 1;
+
+	LogDebug("FIR filter: using FFT convolution for %zu taps and up\n", crossover);
+	return crossover;
+}
+
 /**
 	@brief Calculates FIR coefficients
 
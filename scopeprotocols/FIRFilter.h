@@ -35,6 +35,9 @@
 #ifndef FIRFilter_h
 #define FIRFilter_h
 
+#include <ffts.h>
+#include <mutex>
+
 /**
 	@brief Performs an arbitrary FIR filter with tap delay equal to the sample rate
  */
@@ -47,6 +50,7 @@ public:
 
 	virtual bool NeedsConfig();
 	virtual bool IsOverlay();
+	virtual bool SupportsImplicitTimestamps();
 
 	virtual void ClearSweeps();
 
@@ -67,6 +71,8 @@ public:
 		float& vmin,
 		float& vmax);
 
+	static size_t GetFFTCrossover();
+
 	enum FilterType
 	{
 		FILTER_TYPE_LOWPASS,
@@ -86,7 +92,14 @@ protected:
 
 	static float Bessel(float x);
 
-	void DoFilterKernelGeneric(
+	static void DoFilterKernelDirect(
+		std::vector<float>& coefficients,
+		AnalogWaveform* din,
+		AnalogWaveform* cap,
+		float& vmin,
+		float& vmax);
+
+	static void DoFilterKernelGeneric(
 		std::vector<float>& coefficients,
 		AnalogWaveform* din,
 		AnalogWaveform* cap,
@@ -102,20 +115,61 @@ protected:
 		float& vmax);
 #endif
 
-	void DoFilterKernelAVX2(
+	static void DoFilterKernelAVX2(
 		std::vector<float>& coefficients,
 		AnalogWaveform* din,
 		AnalogWaveform* cap,
 		float& vmin,
 		float& vmax);
 
-	void DoFilterKernelAVX512F(
+	static void DoFilterKernelAVX512F(
 		std::vector<float>& coefficients,
 		AnalogWaveform* din,
 		AnalogWaveform* cap,
 		float& vmin,
 		float& vmax);
 
+	/**
+		@brief Plans, buffers, and kernel spectrum for the overlap-save FFT convolution
+
+		Each thread gets its own plans and buffers since ffts plans have internal scratch space.
+	 */
+	class FFTState
+	{
+	public:
+		FFTState();
+		~FFTState();
+
+		void Setup(const std::vector<float>& coefficients, size_t npoints, size_t nthreads);
+		void Clear();
+
+		size_t m_npoints;
+		std::vector<ffts_plan_t*> m_forwardPlans;
+		std::vector<ffts_plan_t*> m_reversePlans;
+		std::vector< std::vector<float, AlignedAllocator<float, 64> > > m_timeBufs;
+		std::vector< std::vector<float, AlignedAllocator<float, 64> > > m_freqBufs;
+
+		///FFT of the time-reversed, zero padded coefficients, pre-scaled by 1/npoints
+		std::vector<float, AlignedAllocator<float, 64> > m_kernelFreq;
+		std::vector<float> m_cachedCoefficients;
+	};
+
+	static void DoFilterKernelFFT(
+		std::vector<float>& coefficients,
+		AnalogWaveform* din,
+		AnalogWaveform* cap,
+		float& vmin,
+		float& vmax,
+		FFTState& state);
+
+	static size_t GetFFTSize(size_t filterlen);
+	static size_t MeasureFFTCrossover();
+
+	FFTState m_fftState;
+
+	static size_t s_fftCrossover;
+	static std::once_flag s_fftCrossoverFlag;
+
 	float m_min;
 	float m_max;
 	float m_range;
@@ -138,7 +138,7 @@ void FrequencyMeasurement::Refresh()
 	}
 
 	//Create the output
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(edges.size() / 2);
 
 	double rmin = FLT_MAX;
 	double rmax = 0;
@@ -134,7 +134,7 @@ void HorizontalBathtub::Refresh()
 	double fs_per_pixel = fs_per_width / din->GetWidth();
 
 	//Create the output
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(din->GetWidth());
 
 	//Extract the single scanline we're interested in
 	//TODO: support a range of voltages
@@ -48,6 +48,8 @@ I2CDecoder::I2CDecoder(const string& color)
 	//Set up channels
 	CreateInput("sda");
 	CreateInput("scl");
+
+	CreateStateCarryParameter();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -122,6 +124,20 @@ void I2CDecoder::Refresh()
 	bool				last_was_start	= 0;
 	size_t len = sda->m_samples.size();
 	len = min(len, scl->m_samples.size());
+
+	//If continuing from the last waveform, pick up where it left off.
+	//A symbol which started in the last waveform is shown from the start of this one.
+	auto carried = TakeCarriedState(sda);
+	if(carried.HasInt("current_type"))
+	{
+		last_scl = carried.GetInt("last_scl");
+		last_sda = carried.GetInt("last_sda");
+		current_type = static_cast<I2CSymbol::stype>(carried.GetInt("current_type"));
+		current_byte = carried.GetInt("current_byte");
+		bitcount = carried.GetInt("bitcount");
+		last_was_start = carried.GetInt("last_was_start");
+	}
+
 	for(size_t i=0; i<len; i++)
 	{
 		bool cur_sda = sda->m_samples[i];
@@ -227,6 +243,19 @@ void I2CDecoder::Refresh()
 		last_scl = cur_scl;
 	}
 
+	//Save the bus state for the next waveform
+	DecoderState next;
+	if(len)
+	{
+		next.SetInt("last_scl", last_scl);
+		next.SetInt("last_sda", last_sda);
+		next.SetInt("current_type", current_type);
+		next.SetInt("current_byte", current_byte);
+		next.SetInt("bitcount", bitcount);
+		next.SetInt("last_was_start", last_was_start);
+	}
+	CarryState(sda, next);
+
 	SetData(cap, 0);
 }
 
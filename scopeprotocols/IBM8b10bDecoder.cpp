@@ -122,85 +122,32 @@ void IBM8b10bDecoder::Refresh()
 	DigitalWaveform data;
 	SampleOnAnyEdges(din, clkin, data);
 
-	//Look for commas in the data stream
-	//TODO: make this more efficient?
-	size_t max_commas = 0;
-	size_t max_offset = 0;
-	for(size_t offset=0; offset < 10; offset ++)
+	//Pack the sampled bits one per bit so we can look at a whole symbol (or 64 comma positions) at a time
+	size_t len = data.m_samples.size();
+	if(len < 20)
 	{
-		size_t num_commas = 0;
-		size_t dlen = data.m_samples.size() - 20;
-		for(size_t i=0; i<dlen; i += 10)
-		{
-			/*
-			//Check if we have a comma (five identical bits) anywhere in the data stream
-			//Commas are always at positions 2...6 within the symbol (left-right bit ordering)
-			bool comma = true;
-			for(int j=3; j<=6; j++)
-			{
-				if(data.m_samples[i+offset+j] != data.m_samples[i+offset+2])
-				{
-					comma = false;
-					break;
-				}
-			}
-			*/
-
-			//Look for K28.5 symbols only.
-			bool comma = false;
-			if(	!data.m_samples[i+offset+0] &&
-				!data.m_samples[i+offset+1] &&
-				data.m_samples[i+offset+2] &&
-				data.m_samples[i+offset+3] &&
-				data.m_samples[i+offset+4] &&
-				data.m_samples[i+offset+5] &&
-				data.m_samples[i+offset+6] &&
-				!data.m_samples[i+offset+7] &&
-				data.m_samples[i+offset+8] &&
-				!data.m_samples[i+offset+9])
-			{
-				comma = true;
-			}
-			if(	data.m_samples[i+offset+0] &&
-				data.m_samples[i+offset+1] &&
-				!data.m_samples[i+offset+2] &&
-				!data.m_samples[i+offset+3] &&
-				!data.m_samples[i+offset+4] &&
-				!data.m_samples[i+offset+5] &&
-				!data.m_samples[i+offset+6] &&
-				data.m_samples[i+offset+7] &&
-				!data.m_samples[i+offset+8] &&
-				data.m_samples[i+offset+9])
-			{
-				comma = true;
-			}
-
-			if(comma)
-				num_commas ++;
-		}
-		if(num_commas > max_commas)
-		{
-			max_commas = num_commas;
-			max_offset = offset;
-		}
-		//LogTrace("Found %zu commas at offset %zu\n", num_commas, offset);
+		SetData(cap, 0);
+		return;
 	}
+	PackedDigitalWaveform packed;
+	packed.PackBytes(reinterpret_cast<const uint8_t*>(&data.m_samples[0]), len);
+
+	//Look for K28.5 symbols (either disparity) in the data stream and lock to the phase with the most of them.
+	//Patterns are LSB first, so bit 0 is the leftmost bit of the symbol (0011111010 / 1100000101).
+	static const uint64_t commas[2] = { 0x17c, 0x283 };
+	size_t max_offset = BitstreamAligner::FindBestPhase(packed, commas, 2, 10, 10, (len - 20 + 9) / 10);
 
 	//Decode the actual data
 	bool first = true;
 	int last_disp = -1;
-	size_t dlen = data.m_samples.size() - 11;
+	size_t dlen = len - 11;
 	for(size_t i=max_offset; i<dlen; i+= 10)
 	{
-		//5b/6b decode
+		//Grab the whole symbol at once and flip it to left-right bit ordering (abcdei fghj)
+		uint32_t code10 = BitstreamAligner::ReverseBits(packed.GetBits(i, 10), 10);
 
-		uint8_t code6 =
-			(data.m_samples[i+0] ? 32 : 0) |
-			(data.m_samples[i+1] ? 16 : 0) |
-			(data.m_samples[i+2] ? 8 : 0) |
-			(data.m_samples[i+3] ? 4 : 0) |
-			(data.m_samples[i+4] ? 2 : 0) |
-			(data.m_samples[i+5] ? 1 : 0);
+		//5b/6b decode
+		uint8_t code6 = code10 >> 4;
 
 		static const int code5_table[64] =
 		{
@@ -256,11 +203,7 @@ void IBM8b10bDecoder::Refresh()
 		bool ctl5 = ctl5_table[code6];
 
 		//3b/4b decode
-		uint8_t code4 =
-			(data.m_samples[i+6] ? 8 : 0) |
-			(data.m_samples[i+7] ? 4 : 0) |
-			(data.m_samples[i+8] ? 2 : 0) |
-			(data.m_samples[i+9] ? 1 : 0);
+		uint8_t code4 = code10 & 0xf;
 
 		static const bool err3_ctl_table[16] =
 		{
@@ -144,7 +144,7 @@ void ISIMeasurement::Refresh()
 
 	float isi = max(rising_pp, falling_pp);
 
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(1);
 	cap->m_offsets.push_back(0);
 	cap->m_durations.push_back(1);
 	cap->m_samples.push_back(isi);
@@ -143,19 +143,34 @@ void JtagDecoder::Refresh()
 		return;
 	}
 
-	//Get the input data
-	auto tdi = GetDigitalInputWaveform(0);
-	auto tdo = GetDigitalInputWaveform(1);
-	auto tms = GetDigitalInputWaveform(2);
-	auto tck = GetDigitalInputWaveform(3);
-
-	//Sample the data stream at each clock edge
+	//Sample the data stream at each clock edge.
+	//If everything came from a scope in packed mode, work on the packed data directly rather than unpacking.
 	DigitalWaveform dtdi;
 	DigitalWaveform dtdo;
 	DigitalWaveform dtms;
-	SampleOnRisingEdges(tdi, tck, dtdi);
-	SampleOnRisingEdges(tdo, tck, dtdo);
-	SampleOnRisingEdges(tms, tck, dtms);
+	WaveformBase* tck;
+	auto ptdi = GetPackedDigitalInputWaveform(0);
+	auto ptdo = GetPackedDigitalInputWaveform(1);
+	auto ptms = GetPackedDigitalInputWaveform(2);
+	auto ptck = GetPackedDigitalInputWaveform(3);
+	if(ptdi && ptdo && ptms && ptck)
+	{
+		SampleOnRisingEdges(ptdi, ptck, dtdi);
+		SampleOnRisingEdges(ptdo, ptck, dtdo);
+		SampleOnRisingEdges(ptms, ptck, dtms);
+		tck = ptck;
+	}
+	else
+	{
+		auto tdi = GetDigitalInputWaveform(0);
+		auto tdo = GetDigitalInputWaveform(1);
+		auto tms = GetDigitalInputWaveform(2);
+		auto utck = GetDigitalInputWaveform(3);
+		SampleOnRisingEdges(tdi, utck, dtdi);
+		SampleOnRisingEdges(tdo, utck, dtdo);
+		SampleOnRisingEdges(tms, utck, dtms);
+		tck = utck;
+	}
 
 	//Create the capture
 	auto cap = new JtagWaveform;
@@ -121,7 +121,7 @@ void MagnitudeFilter::Refresh()
 	m_yAxisUnit = m_inputs[0].m_channel->GetYAxisUnits();
 
 	//Set up the output waveform
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(len);
 	cap->Resize(len);
 	cap->CopyTimestamps(a);
 
@@ -28,6 +28,7 @@
 ***********************************************************************************************************************/
 
 #include "scopeprotocols.h"
+#include <omp.h>
 
 using namespace std;
 
@@ -44,6 +45,13 @@ MovingAverageFilter::MovingAverageFilter(const string& color)
 	m_parameters[m_depthname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_SAMPLEDEPTH));
 	m_parameters[m_depthname].SetFloatVal(0);
 
+	m_modename = "Mode";
+	m_parameters[m_modename] = FilterParameter(FilterParameter::TYPE_ENUM, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_modename].AddEnumValue("Average", MODE_AVERAGE);
+	m_parameters[m_modename].AddEnumValue("Minimum", MODE_MINIMUM);
+	m_parameters[m_modename].AddEnumValue("Maximum", MODE_MAXIMUM);
+	m_parameters[m_modename].SetIntVal(MODE_AVERAGE);
+
 	m_range = 1;
 	m_offset = 0;
 	m_min = FLT_MAX;
@@ -96,8 +104,24 @@ bool MovingAverageFilter::NeedsConfig()
 
 void MovingAverageFilter::SetDefaultName()
 {
+	const char* prefix = "MovingAvg";
+	switch(m_parameters[m_modename].GetIntVal())
+	{
+		case MODE_MINIMUM:
+			prefix = "MovingMin";
+			break;
+
+		case MODE_MAXIMUM:
+			prefix = "MovingMax";
+			break;
+
+		default:
+			break;
+	}
+
 	char hwname[256];
-	snprintf(hwname, sizeof(hwname), "MovingAvg(%s, %s)",
+	snprintf(hwname, sizeof(hwname), "%s(%s, %s)",
+		prefix,
 		GetInputDisplayName(0).c_str(),
 		m_parameters[m_depthname].ToString().c_str());
 	m_hwname = hwname;
@@ -127,7 +151,7 @@ void MovingAverageFilter::Refresh()
 	auto din = GetAnalogInputWaveform(0);
 	size_t len = din->m_samples.size();
 	size_t depth = m_parameters[m_depthname].GetIntVal();
-	if(len < depth)
+	if( (len <= depth) || (depth == 0) )
 	{
 		SetData(NULL, 0);
 		return;
@@ -136,27 +160,39 @@ void MovingAverageFilter::Refresh()
 	m_xAxisUnit = m_inputs[0].m_channel->GetXAxisUnits();
 	m_yAxisUnit = m_inputs[0].m_channel->GetYAxisUnits();
 
-	//Do the average
-	auto cap = new AnalogWaveform;
+	//Each output sample is centered on the window it summarizes
 	size_t nsamples = len - depth;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(nsamples);
 	size_t off = depth/2;
 	cap->Resize(nsamples);
+	memcpy(&cap->m_offsets[0], &din->m_offsets[off], nsamples * sizeof(int64_t));
+	memcpy(&cap->m_durations[0], &din->m_durations[off], nsamples * sizeof(int64_t));
+
+	//Do the average (or min/max)
+	const float* pin = (const float*)&din->m_samples[0];
+	float* pout = (float*)&cap->m_samples[0];
+	switch(m_parameters[m_modename].GetIntVal())
+	{
+		case MODE_MINIMUM:
+			SlidingExtreme(pin, pout, nsamples, depth, false);
+			break;
+
+		case MODE_MAXIMUM:
+			SlidingExtreme(pin, pout, nsamples, depth, true);
+			break;
+
+		case MODE_AVERAGE:
+		default:
+			RunningAverage(pin, pout, nsamples, depth);
+			break;
+	}
+
 	float vmin = FLT_MAX;
 	float vmax = -FLT_MAX;
-	//#pragma omp parallel for
 	for(size_t i=0; i<nsamples; i++)
 	{
-		float v = 0;
-		for(size_t j=0; j<depth; j++)
-			v += din->m_samples[i+j];
-		v /= depth;
-
-		vmin = min(vmin, v);
-		vmax = max(vmax, v);
-
-		cap->m_offsets[i] = din->m_offsets[i+off];
-		cap->m_durations[i] = din->m_durations[i+off];
-		cap->m_samples[i] = v;
+		vmin = min(vmin, pout[i]);
+		vmax = max(vmax, pout[i]);
 	}
 	SetData(cap, 0);
 
@@ -171,3 +207,135 @@ void MovingAverageFilter::Refresh()
 	cap->m_startTimestamp = din->m_startTimestamp;
 	cap->m_startFemtoseconds = din->m_startFemtoseconds;
 }
+
+/**
+	@brief Splits a sliding window computation into one chunk of outputs per thread
+
+	Each chunk reads depth-1 input samples past its end, so chunks overlap on the input side but not the output.
+ */
+template<class F>
+static void ForEachChunk(size_t nout, size_t depth, F func)
+{
+	//Don't bother spinning up threads for small jobs, or when each chunk would mostly be overlap
+	size_t nthreads = omp_get_max_threads();
+	size_t minChunk = max((size_t)65536, depth * 4);
+	nthreads = max((size_t)1, min(nthreads, nout / minChunk));
+
+	#pragma omp parallel for num_threads(nthreads)
+	for(size_t i=0; i<nthreads; i++)
+		func(nout * i / nthreads, nout * (i+1) / nthreads);
+}
+
+/**
+	@brief Computes out[i] = mean(in[i ... i+depth-1]) for i in [0, nout)
+
+	Uses a running sum so cost is independent of depth.
+ */
+void MovingAverageFilter::RunningAverage(const float* in, float* out, size_t nout, size_t depth)
+{
+	ForEachChunk(nout, depth, [&](size_t start, size_t end)
+		{ RunningAverageChunk(in, out, start, end, depth); });
+}
+
+/**
+	@brief Running sum over one chunk of outputs.
+
+	The sum is kept in double precision with Kahan compensation. Adding and subtracting the same samples still drifts
+	over many millions of steps, so it's recomputed from scratch every so often (often enough to bound the error,
+	rarely enough that the resync cost is no more than the sliding cost).
+ */
+void MovingAverageFilter::RunningAverageChunk(const float* in, float* out, size_t start, size_t end, size_t depth)
+{
+	size_t resyncInterval = max((size_t)65536, depth);
+	double scale = 1.0 / depth;
+
+	double sum = 0;
+	double comp = 0;
+	size_t nextResync = start;
+	for(size_t i=start; i<end; i++)
+	{
+		if(i == nextResync)
+		{
+			sum = 0;
+			comp = 0;
+			for(size_t j=0; j<depth; j++)
+			{
+				double y = in[i+j] - comp;
+				double t = sum + y;
+				comp = (t - sum) - y;
+				sum = t;
+			}
+			nextResync = i + resyncInterval;
+		}
+		else
+		{
+			//Slide the window: add the newest sample and drop the oldest
+			double y = ( (double)in[i+depth-1] - (double)in[i-1]) - comp;
+			double t = sum + y;
+			comp = (t - sum) - y;
+			sum = t;
+		}
+
+		out[i] = sum * scale;
+	}
+}
+
+/**
+	@brief Computes out[i] = min or max of in[i ... i+depth-1] for i in [0, nout)
+
+	Uses a monotonic deque of candidate indexes so each input sample is pushed and popped at most once.
+ */
+void MovingAverageFilter::SlidingExtreme(const float* in, float* out, size_t nout, size_t depth, bool findMax)
+{
+	ForEachChunk(nout, depth, [&](size_t start, size_t end)
+		{ SlidingExtremeChunk(in, out, start, end, depth, findMax); });
+}
+
+void MovingAverageFilter::SlidingExtremeChunk(
+	const float* in,
+	float* out,
+	size_t start,
+	size_t end,
+	size_t depth,
+	bool findMax)
+{
+	if(start >= end)
+		return;
+
+	//The deque holds at most depth+1 entries (a full window plus the new sample, before the oldest is expired),
+	//so a power-of-two ring buffer that size never overflows
+	size_t ringsize = 1;
+	while(ringsize < depth + 1)
+		ringsize <<= 1;
+	size_t mask = ringsize - 1;
+	vector<size_t> ring(ringsize);
+	size_t head = 0;
+	size_t tail = 0;
+
+	size_t last = end + depth - 1;
+	for(size_t j=start; j<last; j++)
+	{
+		//Anything no better than the new sample can never be the answer again
+		float v = in[j];
+		if(findMax)
+		{
+			while( (tail != head) && (in[ring[(tail-1) & mask]] <= v) )
+				tail --;
+		}
+		else
+		{
+			while( (tail != head) && (in[ring[(tail-1) & mask]] >= v) )
+				tail --;
+		}
+		ring[(tail++) & mask] = j;
+
+		//Once the window is full, expire the oldest candidate if it fell off the left edge
+		if(j + 1 >= start + depth)
+		{
+			size_t i = j + 1 - depth;
+			if(ring[head & mask] < i)
+				head ++;
+			out[i] = in[ring[head & mask]];
+		}
+	}
+}
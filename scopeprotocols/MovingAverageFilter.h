@@ -56,8 +56,22 @@ public:
 
 	PROTOCOL_DECODER_INITPROC(MovingAverageFilter)
 
+	enum Mode
+	{
+		MODE_AVERAGE,
+		MODE_MINIMUM,
+		MODE_MAXIMUM
+	};
+
+	static void RunningAverage(const float* in, float* out, size_t nout, size_t depth);
+	static void SlidingExtreme(const float* in, float* out, size_t nout, size_t depth, bool findMax);
+
 protected:
+	static void RunningAverageChunk(const float* in, float* out, size_t start, size_t end, size_t depth);
+	static void SlidingExtremeChunk(const float* in, float* out, size_t start, size_t end, size_t depth, bool findMax);
+
 	std::string m_depthname;
+	std::string m_modename;
 
 	float m_min;
 	float m_max;
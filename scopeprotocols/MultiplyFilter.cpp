@@ -89,6 +89,11 @@ bool MultiplyFilter::NeedsConfig()
 	return true;
 }
 
+bool MultiplyFilter::SupportsImplicitTimestamps()
+{
+	return true;
+}
+
 void MultiplyFilter::SetDefaultName()
 {
 	char hwname[256];
@@ -119,7 +119,7 @@ void OvershootMeasurement::Refresh()
 	float midpoint = (top+base)/2;
 
 	//Create the output
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>();
 
 	float 		fmax = -FLT_MAX;
 	float		fmin =  FLT_MAX;
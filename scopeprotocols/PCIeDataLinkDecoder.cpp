@@ -131,7 +131,13 @@ void PCIeDataLinkDecoder::Refresh()
 	uint8_t dllp_type = 0;
 	uint8_t dllp_data[3] = {0};
 
-	Packet* pack = NULL;
+	size_t row = 0;
+	size_t colType = m_table.GetColumn("Type");
+	size_t colVC = m_table.GetColumn("VC");
+	size_t colSeq = m_table.GetColumn("Seq");
+	size_t colHdrFC = m_table.GetColumn("HdrFC");
+	size_t colDataFC = m_table.GetColumn("DataFC");
+	size_t colLength = m_table.GetColumn("Length");
 
 	for(size_t i=0; i<len; i++)
 	{
@@ -179,10 +185,7 @@ void PCIeDataLinkDecoder::Refresh()
 				else
 				{
 					//Initial packet creation
-					pack = new Packet;
-					m_packets.push_back(pack);
-					pack->m_offset = off * cap->m_timescale;
-					pack->m_len = 0;
+					row = m_table.AddRow(off * cap->m_timescale);
 
 					dllp_type = sym.m_data;
 
@@ -191,7 +194,7 @@ void PCIeDataLinkDecoder::Refresh()
 					{
 						case PCIeDataLinkSymbol::DLLP_TYPE_ACK:
 						case PCIeDataLinkSymbol::DLLP_TYPE_NAK:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_STATUS];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_STATUS]);
 							break;
 
 						case PCIeDataLinkSymbol::DLLP_TYPE_PM_ENTER_L1:
@@ -199,11 +202,11 @@ void PCIeDataLinkDecoder::Refresh()
 						case PCIeDataLinkSymbol::DLLP_TYPE_PM_ACTIVE_STATE_REQUEST_L1:
 						case PCIeDataLinkSymbol::DLLP_TYPE_PM_REQUEST_ACK:
 						case PCIeDataLinkSymbol::DLLP_TYPE_VENDOR_SPECIFIC:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_COMMAND];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_COMMAND]);
 							break;
 
 						default:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_CONTROL]);
 							break;
 					}
 
@@ -221,7 +224,7 @@ void PCIeDataLinkDecoder::Refresh()
 							cap->m_durations.push_back(dur);
 							cap->m_samples.push_back(
 								PCIeDataLinkSymbol(PCIeDataLinkSymbol::TYPE_DLLP_TYPE, sym.m_data));
-							pack->m_headers["Type"] = GetText(cap->m_samples.size() - 1);
+							m_table.SetText(row, colType, GetText(cap->m_samples.size() - 1));
 							break;
 
 						//Split flow control into two symbols: type and VC
@@ -232,18 +235,18 @@ void PCIeDataLinkDecoder::Refresh()
 							cap->m_durations.push_back(halfdur);
 							cap->m_samples.push_back(
 								PCIeDataLinkSymbol(PCIeDataLinkSymbol::TYPE_DLLP_TYPE, dllp_type));
-							pack->m_headers["Type"] = GetText(cap->m_samples.size() - 1);
+							m_table.SetText(row, colType, GetText(cap->m_samples.size() - 1));
 
 							cap->m_offsets.push_back(off + halfdur);
 							cap->m_durations.push_back(dur - halfdur);
 							cap->m_samples.push_back(
 								PCIeDataLinkSymbol(PCIeDataLinkSymbol::TYPE_DLLP_VC, sym.m_data & 0xf));
 
-							pack->m_headers["VC"] = to_string(sym.m_data & 0xf);
+							m_table.SetDecimal(row, colVC, sym.m_data & 0xf);
 							break;
 					}
 
-					pack->m_data.push_back(sym.m_data);
+					m_table.AppendData(row, sym.m_data);
 					state = STATE_DLLP_DATA1;
 				}
 				break;	//end STATE_DLLP_TYPE
@@ -286,7 +289,7 @@ void PCIeDataLinkDecoder::Refresh()
 							break;
 					}
 
-					pack->m_data.push_back(sym.m_data);
+					m_table.AppendData(row, sym.m_data);
 					state = STATE_DLLP_DATA2;
 				}
 
@@ -332,7 +335,7 @@ void PCIeDataLinkDecoder::Refresh()
 							break;
 					}
 
-					pack->m_data.push_back(sym.m_data);
+					m_table.AppendData(row, sym.m_data);
 					state = STATE_DLLP_DATA3;
 				}
 
@@ -367,7 +370,7 @@ void PCIeDataLinkDecoder::Refresh()
 							cap->m_samples[ilast].m_data = (cap->m_samples[ilast].m_data << 8) | sym.m_data;
 							cap->m_durations[ilast] = end - cap->m_offsets[ilast];
 
-							pack->m_headers["Seq"] = to_string(cap->m_samples[ilast].m_data);
+							m_table.SetDecimal(row, colSeq, cap->m_samples[ilast].m_data);
 							break;
 
 						//Make a new symbol if vendor specific
@@ -387,7 +390,7 @@ void PCIeDataLinkDecoder::Refresh()
 									((cap->m_samples[ilast].m_data & 0xc0) >> 6);
 								cap->m_samples[ilast-1].m_type = PCIeDataLinkSymbol::TYPE_DLLP_HEADER_CREDITS;
 
-								pack->m_headers["HdrFC"] = to_string(cap->m_samples[ilast-1].m_data);
+								m_table.SetDecimal(row, colHdrFC, cap->m_samples[ilast-1].m_data);
 
 								//Extract the data credit count and put in the second data word
 								//then extend the second word to span both bytes
@@ -396,12 +399,12 @@ void PCIeDataLinkDecoder::Refresh()
 								cap->m_durations[ilast] = end - cap->m_offsets[ilast];
 								cap->m_samples[ilast].m_type = PCIeDataLinkSymbol::TYPE_DLLP_DATA_CREDITS;
 
-								pack->m_headers["DataFC"] = to_string(cap->m_samples[ilast].m_data);
+								m_table.SetDecimal(row, colDataFC, cap->m_samples[ilast].m_data);
 							}
 							break;
 					}
 
-					pack->m_data.push_back(sym.m_data);
+					m_table.AppendData(row, sym.m_data);
 					state = STATE_DLLP_CRC1;
 				}
 
@@ -451,8 +454,8 @@ void PCIeDataLinkDecoder::Refresh()
 					state = STATE_END;
 
 					//Finalize the packet
-					pack->m_headers["Length"] = "4";
-					pack->m_len = (end * cap->m_timescale) - pack->m_offset;
+					m_table.SetDecimal(row, colLength, 4);
+					m_table.SetEnd(row, end * cap->m_timescale);
 				}
 
 				break;	//end STATE_DLLP_CRC2
@@ -478,12 +481,9 @@ void PCIeDataLinkDecoder::Refresh()
 				else
 				{
 					//Initial packet creation
-					pack = new Packet;
-					m_packets.push_back(pack);
-					pack->m_offset = off * cap->m_timescale;
-					pack->m_len = 0;
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
-					pack->m_headers["Type"] = "TLP";
+					row = m_table.AddRow(off * cap->m_timescale);
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_WRITE]);
+					m_table.SetText(row, colType, "TLP");
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
@@ -491,7 +491,7 @@ void PCIeDataLinkDecoder::Refresh()
 						PCIeDataLinkSymbol::TYPE_TLP_SEQUENCE, sym.m_data));
 
 					//Sequence number is covered by the LCRC so it's considered part of the TLP data
-					pack->m_data.push_back(sym.m_data);
+					m_table.AppendData(row, sym.m_data);
 
 					state = STATE_TLP_SEQUENCE_LO;
 				}
@@ -511,9 +511,9 @@ void PCIeDataLinkDecoder::Refresh()
 					cap->m_samples[ilast].m_data = (cap->m_samples[ilast].m_data << 8) | sym.m_data;
 					cap->m_durations[ilast] = end - cap->m_offsets[ilast];
 
-					pack->m_headers["Seq"] = to_string(cap->m_samples[ilast].m_data);
+					m_table.SetDecimal(row, colSeq, cap->m_samples[ilast].m_data);
 
-					pack->m_data.push_back(sym.m_data);
+					m_table.AppendData(row, sym.m_data);
 
 					state = STATE_TLP_DATA;
 				}
@@ -525,7 +525,7 @@ void PCIeDataLinkDecoder::Refresh()
 				if(sym.m_type == PCIeLogicalSymbol::TYPE_END)
 				{
 					//If the TLP has less than 4 bytes of payload, abort
-					if(pack->m_data.size() < 4)
+					if(m_table.GetDataSize(row) < 4)
 						cap->m_samples[ilast].m_type = PCIeDataLinkSymbol::TYPE_ERROR;
 
 					//Nope. We at least have enough data for the link layer to process it.
@@ -543,26 +543,26 @@ void PCIeDataLinkDecoder::Refresh()
 						cap->m_durations[ilast] = off - cap->m_offsets[ilast];
 
 						//Extract the CRC value from the packet data
-						size_t base = pack->m_data.size() - 4;
+						size_t base = m_table.GetDataSize(row) - 4;
 						uint32_t crc_expected = 0;
 						for(size_t j=0; j<4; j++)
-							crc_expected = (crc_expected << 8) | pack->m_data[base + j];
-						pack->m_data.resize(base);
+							crc_expected = (crc_expected << 8) | m_table.GetDataByte(row, base + j);
+						m_table.TruncateData(row, base);
 						cap->m_samples[ilast].m_data = crc_expected;
 
 						//Validate the CRC
-						uint32_t crc_calculated = CalculateTlpCRC(pack);
+						uint32_t crc_calculated = CalculateTlpCRC(m_table.GetData(row), base);
 						if(crc_expected == crc_calculated)
 							cap->m_samples[ilast].m_type = PCIeDataLinkSymbol::TYPE_TLP_CRC_OK;
 						else
 						{
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 							cap->m_samples[ilast].m_type = PCIeDataLinkSymbol::TYPE_TLP_CRC_BAD;
 						}
 
 						//Calculate the new packet length
-						pack->m_headers["Length"] = to_string(pack->m_data.size());
-						pack->m_len = end * cap->m_timescale - pack->m_offset;
+						m_table.SetDecimal(row, colLength, base);
+						m_table.SetEnd(row, end * cap->m_timescale);
 					}
 
 					state = STATE_IDLE;
@@ -583,7 +583,7 @@ void PCIeDataLinkDecoder::Refresh()
 					cap->m_samples.push_back(PCIeDataLinkSymbol(
 						PCIeDataLinkSymbol::TYPE_TLP_DATA, sym.m_data));
 
-					pack->m_data.push_back(sym.m_data);
+					m_table.AppendData(row, sym.m_data);
 				}
 
 				break;
@@ -605,29 +605,15 @@ void PCIeDataLinkDecoder::Refresh()
 
 	Based on the reference LFSR design in the PCIe Base Spec v2.0, figure 3-11, but optimized for software calculation.
 
-	Since swapping bits in a byte is expensive, we reverse the direction of the LFSR which does a free bitwise reversal
-	of the entire 16-bit CRC. Then all we have to do is swap bytes on the output.
+	Since swapping bits in a byte is expensive, we run the LFSR in reverse (as a reflected CRC) which does a free bitwise
+	reversal of the entire 16-bit CRC. Then all we have to do is swap bytes on the output.
  */
 uint16_t PCIeDataLinkDecoder::CalculateDllpCRC(uint8_t type, uint8_t* data)
 {
 	uint8_t crc_in[4] = { type, data[0], data[1], data[2] };
 
-	uint16_t poly = 0xd008;
-	uint16_t crc = 0xffff;
-
-	for(int n=0; n<4; n++)
-	{
-		uint8_t d = crc_in[n];
-		for(int i=0; i<8; i++)
-		{
-			bool b = ( crc ^ (d >> i) ) & 1;
-			crc >>= 1;
-			if(b)
-				crc ^= poly;
-		}
-	}
-
-	return ~( (crc << 8) | ( (crc >> 8) & 0xff) );
+	uint16_t crc = CRC16PCIeDLLP::Calculate(crc_in, 4);
+	return (crc << 8) | (crc >> 8);
 }
 
 /**
@@ -635,13 +621,12 @@ uint16_t PCIeDataLinkDecoder::CalculateDllpCRC(uint8_t type, uint8_t* data)
 
 	Uses the standard CRC-32 polynomial used by Ethernet etc.
  */
-uint32_t PCIeDataLinkDecoder::CalculateTlpCRC(Packet* pack)
+uint32_t PCIeDataLinkDecoder::CalculateTlpCRC(const uint8_t* data, size_t len)
 {
-	auto len = pack->m_data.size();
 	if(len == 0)
 		return 0xffffffff;
 	else
-		return CRC32(pack->m_data, 0, len - 1);
+		return CRC32(data, len);
 }
 
 Gdk::Color PCIeDataLinkDecoder::GetColor(int i)
@@ -130,7 +130,7 @@ public:
 
 protected:
 	uint16_t CalculateDllpCRC(uint8_t type, uint8_t* data);
-	uint32_t CalculateTlpCRC(Packet* pack);
+	uint32_t CalculateTlpCRC(const uint8_t* data, size_t len);
 };
 
 #endif
@@ -137,7 +137,20 @@ void PCIeTransportDecoder::Refresh()
 
 	size_t len = data->m_samples.size();
 
-	Packet* pack = NULL;
+	size_t row = 0;
+	size_t colSeq = m_table.GetColumn("Seq");
+	size_t colTC = m_table.GetColumn("TC");
+	size_t colType = m_table.GetColumn("Type");
+	size_t colAddr = m_table.GetColumn("Addr");
+	size_t colFlags = m_table.GetColumn("Flags");
+	size_t colRequester = m_table.GetColumn("Requester");
+	size_t colCompleter = m_table.GetColumn("Completer");
+	size_t colTag = m_table.GetColumn("Tag");
+	size_t colFirst = m_table.GetColumn("First");
+	size_t colLast = m_table.GetColumn("Last");
+	size_t colStatus = m_table.GetColumn("Status");
+	size_t colCount = m_table.GetColumn("Count");
+	size_t colLength = m_table.GetColumn("Length");
 
 	enum TLPFormat
 	{
@@ -197,11 +210,8 @@ void PCIeTransportDecoder::Refresh()
 				if(sym.m_type == PCIeDataLinkSymbol::TYPE_TLP_SEQUENCE)
 				{
 					//Create the packet
-					pack = new Packet;
-					m_packets.push_back(pack);
-					pack->m_offset = off * cap->m_timescale;
-					pack->m_len = 0;
-					pack->m_headers["Seq"] = to_string(sym.m_data);
+					row = m_table.AddRow(off * cap->m_timescale);
+					m_table.SetDecimal(row, colSeq, sym.m_data);
 
 					state = STATE_HEADER_0;
 				}
@@ -218,7 +228,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 
@@ -232,19 +242,19 @@ void PCIeTransportDecoder::Refresh()
 					//Type is a bit complicated, because it depends on both type and format fields
 					//PCIe 2.0 base spec table 2-3
 					type = PCIeTransportSymbol::TYPE_INVALID;
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					switch(sym.m_data & 0x1f)
 					{
 						case 0:
 							if(!has_data)
 							{
 								type = PCIeTransportSymbol::TYPE_MEM_RD;
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+								m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							}
 							else
 							{
 								type = PCIeTransportSymbol::TYPE_MEM_WR;
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+								m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_WRITE]);
 							}
 							break;
 
@@ -252,7 +262,7 @@ void PCIeTransportDecoder::Refresh()
 							if(!has_data)
 							{
 								type = PCIeTransportSymbol::TYPE_MEM_RD_LK;
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+								m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							}
 							break;
 
@@ -260,12 +270,12 @@ void PCIeTransportDecoder::Refresh()
 							if(tlp_format == TLP_FORMAT_3W_NODATA)
 							{
 								type = PCIeTransportSymbol::TYPE_IO_RD;
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
+								m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_CONTROL]);
 							}
 							else if(tlp_format == TLP_FORMAT_3W_DATA)
 							{
 								type = PCIeTransportSymbol::TYPE_IO_WR;
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
+								m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_CONTROL]);
 							}
 							break;
 
@@ -275,12 +285,12 @@ void PCIeTransportDecoder::Refresh()
 							if(tlp_format == TLP_FORMAT_3W_NODATA)
 							{
 								type = PCIeTransportSymbol::TYPE_CFG_RD_0;
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
+								m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_CONTROL]);
 							}
 							else if(tlp_format == TLP_FORMAT_3W_DATA)
 							{
 								type = PCIeTransportSymbol::TYPE_CFG_WR_0;
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
+								m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_CONTROL]);
 							}
 							break;
 
@@ -288,12 +298,12 @@ void PCIeTransportDecoder::Refresh()
 							if(tlp_format == TLP_FORMAT_3W_NODATA)
 							{
 								type = PCIeTransportSymbol::TYPE_CFG_RD_1;
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
+								m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_CONTROL]);
 							}
 							else if(tlp_format == TLP_FORMAT_3W_DATA)
 							{
 								type = PCIeTransportSymbol::TYPE_CFG_WR_1;
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
+								m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_CONTROL]);
 							}
 							break;
 
@@ -303,12 +313,12 @@ void PCIeTransportDecoder::Refresh()
 							if(tlp_format == TLP_FORMAT_3W_NODATA)
 							{
 								type = PCIeTransportSymbol::TYPE_COMPLETION;
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_STATUS];
+								m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_STATUS]);
 							}
 							else if(tlp_format == TLP_FORMAT_3W_DATA)
 							{
 								type = PCIeTransportSymbol::TYPE_COMPLETION_DATA;
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+								m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							}
 							break;
 
@@ -316,12 +326,12 @@ void PCIeTransportDecoder::Refresh()
 							if(tlp_format == TLP_FORMAT_3W_NODATA)
 							{
 								type = PCIeTransportSymbol::TYPE_COMPLETION_LOCKED_ERROR;
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_STATUS];
+								m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_STATUS]);
 							}
 							else if(tlp_format == TLP_FORMAT_3W_DATA)
 							{
 								type = PCIeTransportSymbol::TYPE_COMPLETION_LOCKED_DATA;
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+								m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							}
 							break;
 					}
@@ -333,7 +343,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_TLP_TYPE, type));
 
-					pack->m_headers["Type"] = GetText(cap->m_samples.size()-1);
+					m_table.SetText(row, colType, GetText(cap->m_samples.size()-1));
 
 					state = STATE_HEADER_1;
 				}
@@ -348,7 +358,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 
@@ -360,7 +370,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_TRAFFIC_CLASS, traffic_class));
 
-					pack->m_headers["TC"] = to_string(traffic_class);
+					m_table.SetDecimal(row, colTC, traffic_class);
 
 					state = STATE_HEADER_2;
 				}
@@ -378,7 +388,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 
@@ -392,7 +402,7 @@ void PCIeTransportDecoder::Refresh()
 					packet_len = (sym.m_data & 3) << 8;
 
 					if(poisoned)
-						pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+						m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
@@ -407,7 +417,7 @@ void PCIeTransportDecoder::Refresh()
 						flags += "RLX ";
 					if(no_snoop)
 						flags += "NS";
-					pack->m_headers["Flags"] = flags;
+					m_table.SetText(row, colFlags, flags);
 
 					state = STATE_HEADER_3;
 				}
@@ -422,7 +432,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 
@@ -438,7 +448,7 @@ void PCIeTransportDecoder::Refresh()
 					if(!has_data)
 						packet_len = 0;
 					else
-						pack->m_headers["Length"] = to_string(packet_len * 4);
+						m_table.SetDecimal(row, colLength, packet_len * 4);
 
 					//Add the length symbol
 					cap->m_offsets.push_back(off);
@@ -486,7 +496,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 				else
@@ -507,7 +517,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 				else
@@ -517,7 +527,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_durations[ilast] = end - cap->m_offsets[ilast];
 					cap->m_samples[ilast].m_data = requester_id;
 
-					pack->m_headers["Requester"] = FormatID(requester_id);
+					m_table.SetText(row, colRequester, FormatID(requester_id));
 
 					state = STATE_MEMORY_3;
 				}
@@ -529,7 +539,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 				else
@@ -540,7 +550,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_TAG, tag));
 
-					pack->m_headers["Tag"] = to_string(tag);
+					m_table.SetDecimal(row, colTag, tag);
 
 					state = STATE_BYTE_ENABLES;
 				}
@@ -553,7 +563,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 				else
@@ -578,8 +588,8 @@ void PCIeTransportDecoder::Refresh()
 							last += to_string(j);
 					}
 
-					pack->m_headers["First"] = first;
-					pack->m_headers["Last"] = first;
+					m_table.SetText(row, colFirst, first);
+					m_table.SetText(row, colLast, first);
 
 					state = STATE_ADDRESS_0;
 					nbyte = 0;
@@ -596,7 +606,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 				else
@@ -622,8 +632,7 @@ void PCIeTransportDecoder::Refresh()
 							state = STATE_ADDRESS_1;
 						else
 						{
-							snprintf(tmp, sizeof(tmp), "%08lx", mem_addr);
-							pack->m_headers["Addr"] = tmp;
+							m_table.SetHex(row, colAddr, mem_addr, 8);
 
 							nbyte = 0;
 							state = STATE_DATA;
@@ -640,7 +649,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 				else
@@ -654,8 +663,7 @@ void PCIeTransportDecoder::Refresh()
 						cap->m_samples[ilast].m_data = mem_addr;
 						cap->m_samples[ilast].m_type = PCIeTransportSymbol::TYPE_ADDRESS_X64;
 
-						snprintf(tmp, sizeof(tmp), "%016lx", mem_addr);
-						pack->m_headers["Addr"] = tmp;
+						m_table.SetHex(row, colAddr, mem_addr, 16);
 
 						nbyte = 0;
 						state = STATE_DATA;
@@ -674,7 +682,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 				else
@@ -698,7 +706,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 				else
@@ -709,7 +717,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_durations[ilast] = end - cap->m_offsets[ilast];
 					cap->m_samples[ilast].m_data = completer_id;
 
-					pack->m_headers["Completer"] = FormatID(completer_id);
+					m_table.SetText(row, colCompleter, FormatID(completer_id));
 
 					state = STATE_COMPLETION_2;
 				}
@@ -724,7 +732,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 				else
@@ -740,23 +748,23 @@ void PCIeTransportDecoder::Refresh()
 					switch(completion_status)
 					{
 						case 0:
-							pack->m_headers["Status"] = "SC";
+							m_table.SetText(row, colStatus, "SC");
 							break;
 
 						case 1:
-							pack->m_headers["Status"] = "UR";
+							m_table.SetText(row, colStatus, "UR");
 							break;
 
 						case 2:
-							pack->m_headers["Status"] = "CRS";
+							m_table.SetText(row, colStatus, "CRS");
 							break;
 
 						case 4:
-							pack->m_headers["Status"] = "CA";
+							m_table.SetText(row, colStatus, "CA");
 							break;
 
 						default:
-							pack->m_headers["Status"] = "Invalid";
+							m_table.SetText(row, colStatus, "Invalid");
 							break;
 					}
 
@@ -773,7 +781,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 				else
@@ -785,7 +793,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_BYTE_COUNT, byte_count));
 
-					pack->m_headers["Count"] = to_string(byte_count);
+					m_table.SetDecimal(row, colCount, byte_count);
 
 					state = STATE_COMPLETION_4;
 				}
@@ -798,7 +806,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 				else
@@ -820,7 +828,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 				else
@@ -830,7 +838,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_durations[ilast] = end - cap->m_offsets[ilast];
 					cap->m_samples[ilast].m_data = requester_id;
 
-					pack->m_headers["Requester"] = FormatID(requester_id);
+					m_table.SetText(row, colRequester, FormatID(requester_id));
 
 					state = STATE_COMPLETION_6;
 				}
@@ -842,7 +850,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 				else
@@ -853,7 +861,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_TAG, tag));
 
-					pack->m_headers["Tag"] = to_string(tag);
+					m_table.SetDecimal(row, colTag, tag);
 
 					state = STATE_COMPLETION_7;
 				}
@@ -865,7 +873,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 				else
@@ -878,7 +886,7 @@ void PCIeTransportDecoder::Refresh()
 						sym.m_data & 0x7f));
 
 					snprintf(tmp, sizeof(tmp), "   ...%02x", sym.m_data & 0x7f);
-					pack->m_headers["Addr"] = tmp;
+					m_table.SetText(row, colAddr, tmp);
 				}
 				break;	//end STATE_COMPLETION_7
 
@@ -888,7 +896,7 @@ void PCIeTransportDecoder::Refresh()
 			case STATE_DATA:
 
 				//Update packet length
-				pack->m_len = (end * cap->m_timescale) - pack->m_offset;
+				m_table.SetEnd(row, end * cap->m_timescale);
 
 				if(sym.m_type == PCIeDataLinkSymbol::TYPE_TLP_CRC_OK)
 				{
@@ -902,7 +910,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_ERROR));
-					pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+					m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 					state = STATE_IDLE;
 				}
 
@@ -913,7 +921,7 @@ void PCIeTransportDecoder::Refresh()
 					cap->m_durations.push_back(dur);
 					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_DATA, sym.m_data));
 
-					pack->m_data.push_back(sym.m_data);
+					m_table.AppendData(row, sym.m_data);
 				}
 
 				break;
@@ -128,7 +128,7 @@ void PRBSGeneratorFilter::Refresh()
 	DigitalWaveform* dat = dynamic_cast<DigitalWaveform*>(GetData(0));
 	if(!dat)
 	{
-		dat = new DigitalWaveform;
+		dat = g_waveformPool.Allocate<DigitalWaveform>(depth);
 		SetData(dat, 0);
 	}
 	dat->m_timescale = samplePeriod;
@@ -141,7 +141,7 @@ void PRBSGeneratorFilter::Refresh()
 	DigitalWaveform* clk = dynamic_cast<DigitalWaveform*>(GetData(1));
 	if(!clk)
 	{
-		clk = new DigitalWaveform;
+		clk = g_waveformPool.Allocate<DigitalWaveform>(depth);
 		SetData(clk, 1);
 	}
 	clk->m_timescale = samplePeriod;
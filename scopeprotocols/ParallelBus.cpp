@@ -134,7 +134,7 @@ void ParallelBus::Refresh()
 
 	//Merge all of our samples
 	//TODO: handle variable sample rates etc
-	auto cap = new DigitalBusWaveform;
+	auto cap = g_waveformPool.Allocate<DigitalBusWaveform>(len);
 	cap->Resize(len);
 	cap->CopyTimestamps(inputs[0]);
 	#pragma omp parallel for
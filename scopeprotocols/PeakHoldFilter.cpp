@@ -29,6 +29,7 @@
 
 #include "../scopehal/scopehal.h"
 #include "PeakHoldFilter.h"
+#include "MovingAverageFilter.h"
 
 using namespace std;
 
@@ -41,6 +42,11 @@ PeakHoldFilter::PeakHoldFilter(const string& color)
 	//Set up channels
 	CreateInput("din");
 
+	//Optional sliding window envelope applied to each waveform before holding
+	m_windowname = "Window";
+	m_parameters[m_windowname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_SAMPLEDEPTH));
+	m_parameters[m_windowname].SetIntVal(0);
+
 	//Copy input unit
 }
 
@@ -90,7 +96,14 @@ bool PeakHoldFilter::NeedsConfig()
 void PeakHoldFilter::SetDefaultName()
 {
 	char hwname[256];
-	snprintf(hwname, sizeof(hwname), "PeakHold(%s)", GetInputDisplayName(0).c_str());
+	if(m_parameters[m_windowname].GetIntVal() > 1)
+	{
+		snprintf(hwname, sizeof(hwname), "PeakHold(%s, %s)",
+			GetInputDisplayName(0).c_str(),
+			m_parameters[m_windowname].ToString().c_str());
+	}
+	else
+		snprintf(hwname, sizeof(hwname), "PeakHold(%s)", GetInputDisplayName(0).c_str());
 	m_hwname = hwname;
 	m_displayname = m_hwname;
 }
@@ -118,40 +131,78 @@ void PeakHoldFilter::Refresh()
 
 	auto din = GetAnalogInputWaveform(0);
 
-	//Create waveform if we don't have one already
+	//If windowing, each output sample is the max of the window centered on it (same alignment as MovingAverageFilter)
 	size_t len = din->m_samples.size();
+	size_t window = m_parameters[m_windowname].GetIntVal();
+	size_t outlen = len;
+	size_t off = 0;
+	if(window > 1)
+	{
+		if(len <= window)
+		{
+			SetData(NULL, 0);
+			return;
+		}
+		outlen = len - window;
+		off = window / 2;
+	}
+
+	//Create waveform if we don't have one already
 	auto cap = dynamic_cast<AnalogWaveform*>(GetData(0));
 	bool first = false;
 	if(cap == NULL)
 	{
-		cap = new AnalogWaveform;
-		cap->Resize(len);
+		cap = g_waveformPool.Allocate<AnalogWaveform>(outlen);
+		cap->Resize(outlen);
 		SetData(cap, 0);
 		first = true;
 	}
 
 	//If sample size changed, clear it out
-	if(cap->m_samples.size() != len)
+	if(cap->m_samples.size() != outlen)
 	{
-		cap->Resize(len);
+		cap->Resize(outlen);
 		first = true;
 	}
 
 	//Copy timestamps from the input
-	cap->CopyTimestamps(din);
+	if(window > 1)
+	{
+		memcpy(&cap->m_offsets[0], &din->m_offsets[off], outlen * sizeof(int64_t));
+		memcpy(&cap->m_durations[0], &din->m_durations[off], outlen * sizeof(int64_t));
+	}
+	else
+		cap->CopyTimestamps(din);
+
+	float* pout = (float*)&cap->m_samples[0];
+	const float* pin = (const float*)&din->m_samples[0];
 
-	//First waveform just copies the input
+	//First waveform just copies the input (or its envelope)
 	if(first)
 	{
-		for(size_t i=0; i<len; i++)
-			cap->m_samples[i] = din->m_samples[i];
+		if(window > 1)
+			MovingAverageFilter::SlidingExtreme(pin, pout, outlen, window, true);
+		else
+		{
+			for(size_t i=0; i<len; i++)
+				pout[i] = pin[i];
+		}
 	}
 
 	//otherwise actually do peak holding
 	else
 	{
-		for(size_t i=0; i<len; i++)
-			cap->m_samples[i] = max((float)cap->m_samples[i], (float)din->m_samples[i]);
+		vector<float> envelope;
+		if(window > 1)
+		{
+			envelope.resize(outlen);
+			MovingAverageFilter::SlidingExtreme(pin, &envelope[0], outlen, window, true);
+			pin = &envelope[0];
+		}
+
+		#pragma omp parallel for
+		for(size_t i=0; i<outlen; i++)
+			pout[i] = max(pout[i], pin[i]);
 	}
 
 	FindPeaks(cap);
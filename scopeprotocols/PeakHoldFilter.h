@@ -58,6 +58,7 @@ public:
 	PROTOCOL_DECODER_INITPROC(PeakHoldFilter)
 
 protected:
+	std::string m_windowname;
 };
 
 #endif
@@ -125,7 +125,7 @@ void PeriodMeasurement::Refresh()
 	}
 
 	//Create the output
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(edges.size() / 2);
 
 	int64_t rmin = LONG_MAX;
 	int64_t rmax = 0;
@@ -155,7 +155,7 @@ void QuadratureDecoder::Refresh()
 	int64_t debounce_samples = debounce_fs / a->m_timescale;
 
 	//Create the output waveform
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>();
 	cap->m_timescale = a->m_timescale;
 	cap->m_startTimestamp = a->m_startTimestamp;
 	cap->m_startFemtoseconds = a->m_startFemtoseconds;
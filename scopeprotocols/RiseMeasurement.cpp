@@ -136,7 +136,7 @@ void RiseMeasurement::Refresh()
 	float vend = base + m_parameters[m_endname].GetFloatVal()*delta;
 
 	//Create the output
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>();
 
 	float last = 1e20;
 	double tedge = 0;
@@ -48,6 +48,8 @@ SPIDecoder::SPIDecoder(const string& color)
 	CreateInput("clk");
 	CreateInput("cs#");
 	CreateInput("data");
+
+	CreateStateCarryParameter();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -136,6 +138,21 @@ void SPIDecoder::Refresh()
 
 	int64_t timestamp	= 0;
 
+	//If continuing from the last waveform, pick up where it left off (possibly partway through a byte)
+	auto carried = TakeCarriedState(clk);
+	if(carried.HasInt("state"))
+	{
+		state = static_cast<decltype(state)>(carried.GetInt("state"));
+		current_byte = carried.GetInt("current_byte");
+		bitcount = carried.GetInt("bitcount");
+		first = carried.GetInt("first");
+
+		//The byte (or select event) in progress started in the last waveform, show it from the start of this one
+		int64_t tstart;
+		if(carried.GetTime("bytestart", clk, tstart))
+			bytestart = max(tstart, (int64_t)0) / clk->m_timescale;
+	}
+
 	size_t clklen = clk->m_samples.size();
 	size_t cslen = csn->m_samples.size();
 	size_t datalen = data->m_samples.size();
@@ -263,6 +280,18 @@ void SPIDecoder::Refresh()
 		AdvanceToTimestamp(data, idata, datalen, timestamp);
 	}
 
+	//Save the state machine for the next waveform
+	DecoderState next;
+	if(state != STATE_IDLE)
+	{
+		next.SetInt("state", state);
+		next.SetInt("current_byte", current_byte);
+		next.SetInt("bitcount", bitcount);
+		next.SetInt("first", first);
+		next.SetTime("bytestart", clk, bytestart * clk->m_timescale);
+	}
+	CarryState(clk, next);
+
 	SetData(cap, 0);
 }
 
@@ -199,7 +199,11 @@ void SPIFlashDecoder::Refresh()
 	int64_t addr_start;
 	SPIFlashSymbol::FlashType data_type = SPIFlashSymbol::TYPE_DATA;
 	SPIFlashSymbol::FlashType addr_type = SPIFlashSymbol::TYPE_ADDRESS;
-	Packet* pack = NULL;
+	size_t row = 0;
+	size_t colOp = m_table.GetColumn("Op");
+	size_t colAddress = m_table.GetColumn("Address");
+	size_t colInfo = m_table.GetColumn("Info");
+	size_t colLen = m_table.GetColumn("Len");
 	for(size_t iin = 0; iin+1 < len; iin ++)
 	{
 		//Figure out what the incoming packet is
@@ -221,10 +225,7 @@ void SPIFlashDecoder::Refresh()
 				else
 				{
 					//Create the packet
-					pack = new Packet;
-					pack->m_offset = din->m_offsets[iin] * din->m_timescale + din->m_triggerPhase;
-					pack->m_len = 0;
-					m_packets.push_back(pack);
+					row = m_table.AddRow(din->m_offsets[iin] * din->m_timescale + din->m_triggerPhase);
 
 					//Parse the command
 					switch(s.m_data)
@@ -250,7 +251,7 @@ void SPIFlashDecoder::Refresh()
 							else
 								state = STATE_WRITE_DATA;
 
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_CONTROL]);
 							break;
 
 						//x1 program
@@ -273,7 +274,7 @@ void SPIFlashDecoder::Refresh()
 									break;
 							}
 
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_COMMAND];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_COMMAND]);
 							break;
 
 						//Slow read (no dummy clocks)
@@ -296,7 +297,7 @@ void SPIFlashDecoder::Refresh()
 									break;
 							}
 
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							break;
 
 						//Clear write enable flag
@@ -304,14 +305,14 @@ void SPIFlashDecoder::Refresh()
 							current_cmd = SPIFlashSymbol::CMD_WRITE_DISABLE;
 							state = STATE_IDLE;
 
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_CONTROL]);
 							break;
 
 						//Read status register 1
 						case 0x05:
 							current_cmd = SPIFlashSymbol::CMD_READ_STATUS_REGISTER_1;
 							state = STATE_READ_DATA;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_STATUS];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_STATUS]);
 							break;
 
 						//Set write enable flag
@@ -319,7 +320,7 @@ void SPIFlashDecoder::Refresh()
 							current_cmd = SPIFlashSymbol::CMD_WRITE_ENABLE;
 							state = STATE_IDLE;
 
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_CONTROL]);
 							break;
 
 						//Fast read (with dummy clocks)
@@ -343,7 +344,7 @@ void SPIFlashDecoder::Refresh()
 									break;
 							}
 
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							break;
 
 						//Read the status register
@@ -364,7 +365,7 @@ void SPIFlashDecoder::Refresh()
 							else
 								state = STATE_READ_DATA;
 
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_STATUS];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_STATUS]);
 							break;
 
 						case 0x13:
@@ -377,7 +378,7 @@ void SPIFlashDecoder::Refresh()
 								address_bytes_left = 2;
 								addr = 0;
 
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_COMMAND];
+								m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_COMMAND]);
 							}
 
 							//Normal Winbond flashes use this as read data like 0x03, but with a 32-bit address
@@ -388,7 +389,7 @@ void SPIFlashDecoder::Refresh()
 								addr = 0;
 								addr_start = din->m_offsets[iin+1];
 								address_bytes_left = 4;
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+								m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							}
 
 							break;
@@ -397,7 +398,7 @@ void SPIFlashDecoder::Refresh()
 						case 0x15:
 							current_cmd = SPIFlashSymbol::CMD_READ_STATUS_REGISTER_3;
 							state = STATE_READ_DATA;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_STATUS];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_STATUS]);
 							break;
 
 						//Quad input page program
@@ -420,7 +421,7 @@ void SPIFlashDecoder::Refresh()
 									break;
 							}
 
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_WRITE]);
 							break;
 
 						//0x3b 1-1-2 fast read
@@ -429,7 +430,7 @@ void SPIFlashDecoder::Refresh()
 						case 0x35:
 							current_cmd = SPIFlashSymbol::CMD_READ_STATUS_REGISTER_2;
 							state = STATE_READ_DATA;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_STATUS];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_STATUS]);
 							break;
 
 						//Read SFDP
@@ -439,7 +440,7 @@ void SPIFlashDecoder::Refresh()
 							addr = 0;
 							addr_start = din->m_offsets[iin+1];
 							address_bytes_left = 3;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_CONTROL]);
 							break;
 
 						//1-1-4 fast read
@@ -462,13 +463,13 @@ void SPIFlashDecoder::Refresh()
 									break;
 							}
 
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							break;
 
 						case 0x66:
 							current_cmd = SPIFlashSymbol::CMD_ENABLE_RESET;
 							state = STATE_IDLE;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_COMMAND];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_COMMAND]);
 							break;
 
 						//1-1-4 fast read with 32-bit address regardless of mode register
@@ -478,7 +479,7 @@ void SPIFlashDecoder::Refresh()
 							addr = 0;
 							addr_start = din->m_offsets[iin+1];
 							address_bytes_left = 4;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							break;
 
 						//Read the IDCODE
@@ -500,7 +501,7 @@ void SPIFlashDecoder::Refresh()
 							}
 
 							data_type = SPIFlashSymbol::TYPE_VENDOR_ID;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_STATUS];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_STATUS]);
 							break;
 
 						//Release from power down
@@ -508,7 +509,7 @@ void SPIFlashDecoder::Refresh()
 						case 0xab:
 							current_cmd = SPIFlashSymbol::CMD_RELEASE_PD;
 							state = STATE_IDLE;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_COMMAND];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_COMMAND]);
 							break;
 
 						//0xbb 1-2-2 fast read
@@ -518,7 +519,7 @@ void SPIFlashDecoder::Refresh()
 							current_cmd = SPIFlashSymbol::CMD_ADDR_32BIT;
 							state = STATE_IDLE;
 							num_address_bytes = 4;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_COMMAND];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_COMMAND]);
 							break;
 
 						//Erase a block (size is device dependent)
@@ -542,7 +543,7 @@ void SPIFlashDecoder::Refresh()
 									break;
 							}
 
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_COMMAND];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_COMMAND]);
 							break;
 
 						//Enter 3-byte address mode
@@ -550,7 +551,7 @@ void SPIFlashDecoder::Refresh()
 							current_cmd = SPIFlashSymbol::CMD_ADDR_24BIT;
 							state = STATE_IDLE;
 							num_address_bytes = 3;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_COMMAND];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_COMMAND]);
 							break;
 
 						//1-4-4 fast read
@@ -573,7 +574,7 @@ void SPIFlashDecoder::Refresh()
 									break;
 							}
 
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 							break;
 
 						//Reset should occur by itself, ignore any data after that
@@ -586,7 +587,7 @@ void SPIFlashDecoder::Refresh()
 							//TODO: only some models do this? or depends on nonvolatile SFR?
 							num_address_bytes = 3;
 
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_COMMAND];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_COMMAND]);
 							break;
 
 						////////////////////////////////////////////////////////////////////////////////////////////////
@@ -599,7 +600,7 @@ void SPIFlashDecoder::Refresh()
 							address_bytes_left = 2;
 							addr = 0;
 
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_COMMAND];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_COMMAND]);
 							break;
 
 						//0x0c fast read with 4 byte address
@@ -618,7 +619,7 @@ void SPIFlashDecoder::Refresh()
 							current_cmd = SPIFlashSymbol::CMD_UNKNOWN;
 							state = STATE_IDLE;
 
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+							m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 							break;
 					}
 
@@ -627,7 +628,7 @@ void SPIFlashDecoder::Refresh()
 					cap->m_durations.push_back(din->m_durations[iin]);
 					cap->m_samples.push_back(SPIFlashSymbol(SPIFlashSymbol::TYPE_COMMAND, current_cmd, 0));
 
-					pack->m_headers["Op"] = GetText(cap->m_samples.size() - 1);
+					m_table.SetText(row, colOp, GetText(cap->m_samples.size() - 1));
 				}
 				break;
 
@@ -716,11 +717,7 @@ void SPIFlashDecoder::Refresh()
 				cap->m_samples.push_back(SPIFlashSymbol(
 					SPIFlashSymbol::TYPE_ADDRESS, SPIFlashSymbol::CMD_UNKNOWN, addr));
 
-				{
-					char tmp[128] = "";
-					snprintf(tmp, sizeof(tmp), "%x", addr);
-					pack->m_headers["Address"] = tmp;
-				}
+				m_table.SetHex(row, colAddress, addr, 0);
 
 				//Dummy clocks before read data
 				switch(flashtype)
@@ -845,13 +842,9 @@ void SPIFlashDecoder::Refresh()
 							addr_type, SPIFlashSymbol::CMD_UNKNOWN, addr));
 
 						if(addr_type == SPIFlashSymbol::TYPE_ADDRESS)
-						{
-							char tmp[128] = "";
-							snprintf(tmp, sizeof(tmp), "%x", addr);
-							pack->m_headers["Address"] = tmp;
-						}
+							m_table.SetHex(row, colAddress, addr, 0);
 						else
-							pack->m_headers["Address"] = GetText(cap->m_samples.size() - 1);
+							m_table.SetText(row, colAddress, GetText(cap->m_samples.size() - 1));
 					}
 				}
 
@@ -867,13 +860,13 @@ void SPIFlashDecoder::Refresh()
 						//If ID code, crack both
 						if(data_type == SPIFlashSymbol::TYPE_PART_ID)
 						{
-							pack->m_headers["Info"] +=
+							m_table.SetText(row, colInfo,
 								GetText(cap->m_samples.size()-2) +
 								" " +
-								GetText(cap->m_samples.size()-1);
+								GetText(cap->m_samples.size()-1));
 						}
 						else
-							pack->m_headers["Info"] = GetText(cap->m_samples.size()-1);
+							m_table.SetText(row, colInfo, GetText(cap->m_samples.size()-1));
 					}
 
 					//Only write to the output for actual flash data!
@@ -881,7 +874,7 @@ void SPIFlashDecoder::Refresh()
 					if(current_cmd != SPIFlashSymbol::CMD_READ_SFDP)
 					{
 						if(m_fpOut)
-							fwrite(&pack->m_data[0], 1, pack->m_data.size(), m_fpOut);
+							fwrite(m_table.GetData(row), 1, m_table.GetDataSize(row), m_fpOut);
 					}
 
 					state = STATE_IDLE;
@@ -907,12 +900,10 @@ void SPIFlashDecoder::Refresh()
 					}
 
 					//Extend the packet
-					pack->m_data.push_back(dout->m_samples[iin].m_data);
-					pack->m_len = (dout->m_offsets[iin] + dout->m_durations[iin])*dout->m_timescale +
-						dout->m_triggerPhase - pack->m_offset;
-					char tmp[128];
-					snprintf(tmp, sizeof(tmp), "%zu", pack->m_data.size());
-					pack->m_headers["Len"] = tmp;
+					m_table.AppendData(row, dout->m_samples[iin].m_data);
+					m_table.SetEnd(row, (dout->m_offsets[iin] + dout->m_durations[iin])*dout->m_timescale +
+						dout->m_triggerPhase);
+					m_table.SetDecimal(row, colLen, m_table.GetDataSize(row));
 
 					//If reading multibyte special value (vendor ID etc), handle that
 					switch(data_type)
@@ -960,12 +951,10 @@ void SPIFlashDecoder::Refresh()
 						data_type, SPIFlashSymbol::CMD_UNKNOWN, dquad->m_samples[iquad].m_data));
 
 					//Extend the packet
-					pack->m_data.push_back(dquad->m_samples[iquad].m_data);
-					pack->m_len = (dquad->m_offsets[iquad] + dquad->m_durations[iquad])*dquad->m_timescale +
-						dquad->m_triggerPhase - pack->m_offset;
-					char tmp[128];
-					snprintf(tmp, sizeof(tmp), "%zu", pack->m_data.size());
-					pack->m_headers["Len"] = tmp;
+					m_table.AppendData(row, dquad->m_samples[iquad].m_data);
+					m_table.SetEnd(row, (dquad->m_offsets[iquad] + dquad->m_durations[iquad])*dquad->m_timescale +
+						dquad->m_triggerPhase);
+					m_table.SetDecimal(row, colLen, m_table.GetDataSize(row));
 
 					iquad ++;
 				}
@@ -981,7 +970,7 @@ void SPIFlashDecoder::Refresh()
 				iin --;
 
 				if(m_fpOut)
-					fwrite(&pack->m_data[0], 1, pack->m_data.size(), m_fpOut);
+					fwrite(m_table.GetData(row), 1, m_table.GetDataSize(row), m_fpOut);
 
 				state = STATE_IDLE;
 				break;
@@ -994,7 +983,7 @@ void SPIFlashDecoder::Refresh()
 
 					//At the end of a write command, crack status registers if needed
 					if(data_type != SPIFlashSymbol::TYPE_DATA)
-						pack->m_headers["Info"] = GetText(cap->m_samples.size()-1);
+						m_table.SetText(row, colInfo, GetText(cap->m_samples.size()-1));
 				}
 				else
 				{
@@ -1004,12 +993,10 @@ void SPIFlashDecoder::Refresh()
 						data_type, SPIFlashSymbol::CMD_UNKNOWN, din->m_samples[iin].m_data));
 
 					//Extend the packet
-					pack->m_data.push_back(din->m_samples[iin].m_data);
-					pack->m_len = (din->m_offsets[iin] + din->m_durations[iin]) * din->m_timescale +
-						din->m_triggerPhase - pack->m_offset;
-					char tmp[128];
-					snprintf(tmp, sizeof(tmp), "%zu", pack->m_data.size());
-					pack->m_headers["Len"] = tmp;
+					m_table.AppendData(row, din->m_samples[iin].m_data);
+					m_table.SetEnd(row, (din->m_offsets[iin] + din->m_durations[iin]) * din->m_timescale +
+						din->m_triggerPhase);
+					m_table.SetDecimal(row, colLen, m_table.GetDataSize(row));
 				}
 				break;
 		}
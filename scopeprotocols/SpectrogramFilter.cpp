@@ -32,7 +32,7 @@
 #include "SpectrogramFilter.h"
 #include <immintrin.h>
 #include "../scopehal/avx_mathfun.h"
-#include "FFTFilter.h"
+#include <omp.h>
 
 using namespace std;
 
@@ -67,17 +67,22 @@ SpectrogramFilter::SpectrogramFilter(const string& color)
 	, m_fftLengthName("FFT length")
 	, m_rangeMinName("Range Min")
 	, m_rangeMaxName("Range Max")
+	, m_overlapName("Overlap")
 {
 	m_yAxisUnit = Unit(Unit::UNIT_HZ);
 
 	//Set up channels
 	CreateInput("din");
-	m_plan = NULL;
 
 	//Default config
 	m_range = 1e9;
 	m_offset = -5e8;
 	m_cachedFFTLength = 0;
+	m_cachedWindow = -1;
+	m_cachedHop = 0;
+	m_cachedBinHz = 0;
+	m_cachedRangeMin = 0;
+	m_cachedRangeMax = 0;
 
 	m_parameters[m_windowName] = FilterParameter(FilterParameter::TYPE_ENUM, Unit(Unit::UNIT_COUNTS));
 	m_parameters[m_windowName].AddEnumValue("Blackman-Harris", FFTFilter::WINDOW_BLACKMAN_HARRIS);
@@ -103,12 +108,24 @@ SpectrogramFilter::SpectrogramFilter(const string& color)
 
 	m_parameters[m_rangeMinName] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_DBM));
 	m_parameters[m_rangeMinName].SetFloatVal(-50);
+
+	m_parameters[m_overlapName] = FilterParameter(FilterParameter::TYPE_ENUM, Unit(Unit::UNIT_PERCENT));
+	m_parameters[m_overlapName].AddEnumValue("None", 0);
+	m_parameters[m_overlapName].AddEnumValue("50%", 50);
+	m_parameters[m_overlapName].AddEnumValue("75%", 75);
+	m_parameters[m_overlapName].SetIntVal(0);
 }
 
 SpectrogramFilter::~SpectrogramFilter()
 {
-	if(m_plan)
-		ffts_free(m_plan);
+	ClearThreadState();
+}
+
+void SpectrogramFilter::ClearThreadState()
+{
+	for(auto t : m_threadState)
+		delete t;
+	m_threadState.clear();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -175,14 +192,37 @@ void SpectrogramFilter::SetDefaultName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
-void SpectrogramFilter::ReallocateBuffers(size_t fftlen)
+void SpectrogramFilter::ReallocateBuffers(size_t fftlen, size_t nthreads)
 {
+	if(fftlen != m_cachedFFTLength)
+		ClearThreadState();
 	m_cachedFFTLength = fftlen;
-	ffts_free(m_plan);
-	m_plan = ffts_init_1d_real(fftlen, FFTS_FORWARD);
 
-	m_rdinbuf.resize(fftlen);
-	m_rdoutbuf.resize(fftlen + 2);
+	while(m_threadState.size() < nthreads)
+	{
+		auto t = new ThreadState;
+		t->m_plan.Resize(fftlen);
+		t->m_rdinbuf.resize(fftlen);
+		t->m_rdoutbuf.resize(fftlen + 2);
+		t->m_dbmbuf.resize(fftlen/2 + 1);
+		m_threadState.push_back(t);
+	}
+}
+
+/**
+	@brief Fingerprints one block of input so we can tell whether its column needs to be recomputed
+ */
+uint64_t SpectrogramFilter::HashBlock(const float* samples, size_t len)
+{
+	//FNV-1a over 32-bit words rather than bytes
+	auto words = reinterpret_cast<const uint32_t*>(samples);
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for(size_t i=0; i<len; i++)
+	{
+		hash ^= words[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
 }
 
 void SpectrogramFilter::Refresh()
@@ -196,12 +236,18 @@ void SpectrogramFilter::Refresh()
 	auto din = GetAnalogInputWaveform(0);
 
 	//Figure out how many FFTs to do
-	//For now, consecutive blocks and not a sliding window
 	size_t inlen = din->m_samples.size();
 	size_t fftlen = m_parameters[m_fftLengthName].GetIntVal();
-	if(fftlen != m_cachedFFTLength)
-		ReallocateBuffers(fftlen);
-	size_t nblocks = inlen / fftlen;
+	if( (inlen < fftlen) || (inlen < 2) )
+	{
+		SetData(NULL, 0);
+		return;
+	}
+	size_t hop = fftlen * (100 - m_parameters[m_overlapName].GetIntVal()) / 100;
+	size_t nblocks = (inlen - fftlen) / hop + 1;
+
+	size_t nthreads = omp_get_max_threads();
+	ReallocateBuffers(fftlen, nthreads);
 
 	//Figure out range of the FFTs
 	double fs_per_sample = din->m_timescale * (din->m_offsets[1] - din->m_offsets[0]);
@@ -216,48 +262,105 @@ void SpectrogramFilter::Refresh()
 	LogTrace("FFT range is DC to %s\n", hz.PrettyPrint(fmax).c_str());
 	LogTrace("%s per bin\n", hz.PrettyPrint(bin_hz).c_str());
 
-	//Create the output
+	//Precompute the window function once rather than evaluating it for every block
+	auto window = static_cast<FFTFilter::WindowFunction>(m_parameters[m_windowName].GetIntVal());
+	if( (m_windowCoeffs.size() != fftlen) || (m_cachedWindow != window) )
+	{
+		FloatBuffer ones(fftlen, 1.0f);
+		m_windowCoeffs.resize(fftlen);
+		FFTFilter::ApplyWindow(&ones[0], fftlen, &m_windowCoeffs[0], window);
+		m_cachedWindow = window;
+		m_columnHashes.clear();
+	}
+
+	//Anything that changes how a column is rendered invalidates all of them
+	float minscale = m_parameters[m_rangeMinName].GetFloatVal();
+	float fullscale = m_parameters[m_rangeMaxName].GetFloatVal();
+	float range = fullscale - minscale;
+	if( (hop != m_cachedHop) || (bin_hz != m_cachedBinHz) ||
+		(minscale != m_cachedRangeMin) || (fullscale != m_cachedRangeMax) )
+	{
+		m_cachedHop = hop;
+		m_cachedBinHz = bin_hz;
+		m_cachedRangeMin = minscale;
+		m_cachedRangeMax = fullscale;
+		m_columnHashes.clear();
+	}
+
+	//If the previous output is still around, any column whose input didn't change can be copied instead of
+	//recomputed (typically the head of a waveform that has been appended to)
+	auto samples = (const float*)&din->m_samples[0];
 	size_t nouts = fftlen/2 + 1;
+	vector<uint64_t> hashes(nblocks);
+	#pragma omp parallel for
+	for(size_t block=0; block<nblocks; block++)
+		hashes[block] = HashBlock(samples + block*hop, fftlen);
+
+	auto old = dynamic_cast<SpectrogramWaveform*>(GetData(0));
+	size_t oldWidth = 0;
+	const float* olddata = NULL;
+	if(old && (old->GetHeight() == nouts))
+	{
+		oldWidth = min(old->GetWidth(), m_columnHashes.size());
+		olddata = old->GetData();
+	}
+
+	//Create the output
 	auto cap = new SpectrogramWaveform(
 		nblocks,
 		nouts,
 		fmax,
 		din->m_offsets[0] * din->m_timescale,
-		fs_per_sample * nblocks * fftlen
+		fs_per_sample * nblocks * hop
 		);
 	cap->m_startTimestamp = din->m_startTimestamp;
 	cap->m_startFemtoseconds = din->m_startFemtoseconds;
 	cap->m_triggerPhase = 0;
 	cap->m_timescale = bin_hz;
 	cap->m_densePacked = true;
-	SetData(cap, 0);
 
-	//Run the FFTs
-	auto window = static_cast<FFTFilter::WindowFunction>(m_parameters[m_windowName].GetIntVal());
+	//Run the FFTs. Blocks are split into one contiguous run per thread so threads mostly write different cache lines.
 	auto data = cap->GetData();
-	const float impedance = 50;
-	float minscale = m_parameters[m_rangeMinName].GetFloatVal();
-	float fullscale = m_parameters[m_rangeMaxName].GetFloatVal();
-	float range = fullscale - minscale;
+	size_t nreused = 0;
+	#pragma omp parallel for reduction(+:nreused)
 	for(size_t block=0; block<nblocks; block++)
 	{
+		if( (block < oldWidth) && (m_columnHashes[block] == hashes[block]) )
+		{
+			for(size_t i=0; i<nouts; i++)
+				data[i*nblocks + block] = olddata[i*oldWidth + block];
+			nreused ++;
+			continue;
+		}
+
+		auto state = m_threadState[omp_get_thread_num()];
+		float* inbuf = &state->m_rdinbuf[0];
+		float* outbuf = &state->m_rdoutbuf[0];
+		float* dbm = &state->m_dbmbuf[0];
+
 		//Grab the input and apply the window function
-		FFTFilter::ApplyWindow((float*)&din->m_samples[block*fftlen], fftlen, &m_rdinbuf[0], window);
+		const float* src = samples + block*hop;
+		for(size_t i=0; i<fftlen; i++)
+			inbuf[i] = src[i] * m_windowCoeffs[i];
 
 		//Do the actual FFT
-		ffts_execute(m_plan, &m_rdinbuf[0], &m_rdoutbuf[0]);
+		state->m_plan.Forward(inbuf, outbuf);
 
-		//TODO: figure out if there's any way to vectorize this
+		//Convert to dBm, then map onto the display range
+		if(g_hasAvx2)
+			FFTFilter::NormalizeOutputLogAVX2(outbuf, dbm, nouts, scale);
+		else
+			FFTFilter::NormalizeOutputLog(outbuf, dbm, nouts, scale);
 		for(size_t i=0; i<nouts; i++)
 		{
-			float real = m_rdoutbuf[i*2 + 0];
-			float imag = m_rdoutbuf[i*2 + 1];
-			float voltage = sqrtf(real*real + imag*imag) * scale;
-			float dbm = (10 * log10(voltage*voltage / impedance) + 30);
-			if(dbm < minscale)
+			if(dbm[i] < minscale)
 				data[i*nblocks + block] = 0;
 			else
-				data[i*nblocks + block] = (dbm - minscale) / range;
+				data[i*nblocks + block] = (dbm[i] - minscale) / range;
 		}
 	}
+	LogTrace("Reused %zu of %zu columns\n", nreused, nblocks);
+
+	m_columnHashes.swap(hashes);
+	SetData(cap, 0);
 }
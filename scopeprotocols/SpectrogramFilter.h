@@ -35,7 +35,7 @@
 #ifndef SpectrogramFilter_h
 #define SpectrogramFilter_h
 
-#include <ffts.h>
+#include "FFTFilter.h"
 
 class SpectrogramWaveform : public WaveformBase
 {
@@ -99,14 +99,40 @@ public:
 	PROTOCOL_DECODER_INITPROC(SpectrogramFilter)
 
 protected:
-	void ReallocateBuffers(size_t fftlen);
+	void ReallocateBuffers(size_t fftlen, size_t nthreads);
+	void ClearThreadState();
 
-	std::vector<float, AlignedAllocator<float, 64> > m_rdinbuf;
-	std::vector<float, AlignedAllocator<float, 64> > m_rdoutbuf;
+	static uint64_t HashBlock(const float* samples, size_t len);
+
+	typedef std::vector<float, AlignedAllocator<float, 64> > FloatBuffer;
+
+	/**
+		@brief Plan and scratch buffers for one worker thread
+	 */
+	class ThreadState
+	{
+	public:
+		RealFFTPlan m_plan;
+		FloatBuffer m_rdinbuf;
+		FloatBuffer m_rdoutbuf;
+		FloatBuffer m_dbmbuf;
+	};
+
+	std::vector<ThreadState*> m_threadState;
 
 	size_t m_cachedFFTLength;
 
-	ffts_plan_t* m_plan;
+	///Window function coefficients, computed once per FFT length / window type
+	FloatBuffer m_windowCoeffs;
+	int m_cachedWindow;
+
+	///Hash of the input samples behind each column of the last output, used to skip unchanged columns
+	std::vector<uint64_t> m_columnHashes;
+	size_t m_cachedHop;
+	double m_cachedBinHz;
+	float m_cachedRangeMin;
+	float m_cachedRangeMax;
+
 	float m_range;
 	float m_offset;
 
@@ -114,6 +140,7 @@ protected:
 	std::string m_fftLengthName;
 	std::string m_rangeMinName;
 	std::string m_rangeMaxName;
+	std::string m_overlapName;
 };
 
 #endif
@@ -122,7 +122,7 @@ void StepGeneratorFilter::Refresh()
 	AnalogWaveform* cap = dynamic_cast<AnalogWaveform*>(GetData(0));
 	if(!cap)
 	{
-		cap = new AnalogWaveform;
+		cap = g_waveformPool.Allocate<AnalogWaveform>(depth);
 		SetData(cap, 0);
 	}
 	cap->m_timescale = samplePeriod;
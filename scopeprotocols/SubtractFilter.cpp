@@ -88,6 +88,11 @@ bool SubtractFilter::NeedsConfig()
 	return true;
 }
 
+bool SubtractFilter::SupportsImplicitTimestamps()
+{
+	return true;
+}
+
 double SubtractFilter::GetOffset()
 {
 	double v1 = m_inputs[0].m_channel->GetVoltageRange();
@@ -138,9 +138,6 @@ void TIEMeasurement::Refresh()
 	auto golden = GetDigitalInputWaveform(1);
 	size_t len = min(clk->m_offsets.size(), golden->m_offsets.size());
 
-	//Create the output
-	auto cap = new AnalogWaveform;
-
 	//Timestamps of the edges
 	vector<int64_t> edges;
 	if(clk_analog)
@@ -148,6 +145,9 @@ void TIEMeasurement::Refresh()
 	else
 		FindZeroCrossings(clk_digital, edges);
 
+	//Create the output
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(edges.size());
+
 	//Ignore edges before things have stabilized
 	int64_t skip_time = m_parameters[m_skipname].GetIntVal();
 
@@ -116,49 +116,43 @@ void TMDSDecoder::Refresh()
 	DigitalWaveform sampdata;
 	SampleOnAnyEdges(din, clkin, sampdata);
 
+	//Pack the sampled bits one per bit so we can look at a whole symbol (or 64 alignments) at a time
+	size_t len = sampdata.m_samples.size();
+	if(len < 20)
+	{
+		SetData(cap, 0);
+		return;
+	}
+	PackedDigitalWaveform packed;
+	packed.PackBytes(reinterpret_cast<const uint8_t*>(&sampdata.m_samples[0]), len);
+
 	/*
 		Look for preamble data. We need this to synchronize. (HDMI 1.4 spec section 5.4.2)
 
-		TMDS sends the LSB first.
-		Since element 0 of a C++ array is leftmost, this table has bit ordering mirrored from the spec.
+		TMDS sends the LSB first, which is also how PackedDigitalWaveform stores it, so these are the codes
+		straight from the spec.
 	 */
-	static const bool control_codes[4][10] =
+	static const uint64_t control_codes[4] = { 0x354, 0x0ab, 0x154, 0x2ab };
+
+	//Histogram of each control code at each of the ten possible symbol phases
+	size_t nsymbols = (len - 20 + 9) / 10;
+	vector<size_t> num_preambles[4];
+	for(size_t j=0; j<4; j++)
 	{
-		{ 0, 0, 1, 0, 1, 0, 1, 0, 1, 1 },
-		{ 1, 1, 0, 1, 0, 1, 0, 1, 0, 0 },
-		{ 0, 0, 1, 0, 1, 0, 1, 0, 1, 0 },
-		{ 1, 1, 0, 1, 0, 1, 0, 1, 0, 1 }
-	};
+		PackedDigitalWaveform matches;
+		BitstreamAligner::FindPatterns(packed, &control_codes[j], 1, 10, matches);
+		BitstreamAligner::CountByPhase(matches, 10, nsymbols, num_preambles[j]);
+	}
 
 	size_t max_preambles = 0;
 	size_t max_offset = 0;
 	for(size_t offset=0; offset < 10; offset ++)
 	{
-		size_t num_preambles[4] = {0};
-		for(size_t i=0; i<sampdata.m_samples.size() - 20; i += 10)
-		{
-			//Look for control code "j" at phase "offset", position "i" within the data stream
-			for(size_t j=0; j<4; j++)
-			{
-				bool match = true;
-				for(size_t k=0; k<10; k++)
-				{
-					if(sampdata.m_samples[i+offset+k] != control_codes[j][k])
-						match = false;
-				}
-				if(match)
-				{
-					num_preambles[j] ++;
-					break;
-				}
-			}
-		}
-
 		for(size_t j=0; j<4; j++)
 		{
-			if(num_preambles[j] > max_preambles)
+			if(num_preambles[j][offset] > max_preambles)
 			{
-				max_preambles = num_preambles[j];
+				max_preambles = num_preambles[j][offset];
 				max_offset = offset;
 			}
 		}
@@ -167,11 +161,11 @@ void TMDSDecoder::Refresh()
 	int lane = m_parameters[m_lanename].GetIntVal();
 
 	//HDMI Video guard band (HDMI 1.4 spec 5.2.2.1)
-	static const bool video_guard[3][10] =
+	static const uint64_t video_guard[3] =
 	{
-		{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 1 },
-		{ 1, 1, 0, 0, 1, 1, 0, 0, 1, 0 },		//also used for data guard band, 5.2.3.3
-		{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 1 },
+		0x2cc,
+		0x133,		//also used for data guard band, 5.2.3.3
+		0x2cc
 	};
 
 	//TODO: TERC4 (5.4.3)
@@ -184,28 +178,23 @@ void TMDSDecoder::Refresh()
 	} last_symbol_type = TYPE_DATA;
 
 	//Decode the actual data
-	size_t sampmax = sampdata.m_samples.size()-11;
+	size_t sampmax = len - 11;
 	for(size_t i=max_offset; i<sampmax; i+= 10)
 	{
-		bool match = true;
+		uint64_t code = packed.GetBits(i, 10);
 
 		//Check for control codes at any point in the sequence
+		bool match = false;
 		for(size_t j=0; j<4; j++)
 		{
-			match = true;
-			for(size_t k=0; k<10; k++)
-			{
-				if(sampdata.m_samples[i+k] != control_codes[j][k])
-					match = false;
-			}
-
-			if(match)
+			if(code == control_codes[j])
 			{
 				cap->m_offsets.push_back(sampdata.m_offsets[i]);
 				cap->m_durations.push_back(sampdata.m_offsets[i+10] - sampdata.m_offsets[i]);
 				cap->m_samples.push_back(TMDSSymbol(TMDSSymbol::TMDS_TYPE_CONTROL, j));
 
 				last_symbol_type = TYPE_PREAMBLE;
+				match = true;
 				break;
 			}
 		}
@@ -216,14 +205,7 @@ void TMDSDecoder::Refresh()
 		//Check for HDMI video/control leading guard band
 		if( (last_symbol_type == TYPE_PREAMBLE) || (last_symbol_type == TYPE_GUARD) )
 		{
-			match = true;
-			for(size_t k=0; k<10; k++)
-			{
-				if(sampdata.m_samples[i+k] != video_guard[lane][k])
-					match = false;
-			}
-
-			if(match)
+			if(code == video_guard[lane])
 			{
 				cap->m_offsets.push_back(sampdata.m_offsets[i]);
 				cap->m_durations.push_back(sampdata.m_offsets[i+10] - sampdata.m_offsets[i]);
@@ -233,21 +215,10 @@ void TMDSDecoder::Refresh()
 			}
 		}
 
-		if(match)
-			continue;
-
 		//Whatever is left is assumed to be video data
-		bool d9 = sampdata.m_samples[i+9];
-		bool d8 = sampdata.m_samples[i+8];
-
-		uint8_t d = sampdata.m_samples[i+0] |
-					(sampdata.m_samples[i+1] << 1) |
-					(sampdata.m_samples[i+2] << 2) |
-					(sampdata.m_samples[i+3] << 3) |
-					(sampdata.m_samples[i+4] << 4) |
-					(sampdata.m_samples[i+5] << 5) |
-					(sampdata.m_samples[i+6] << 6) |
-					(sampdata.m_samples[i+7] << 7);
+		bool d9 = (code >> 9) & 1;
+		bool d8 = (code >> 8) & 1;
+		uint8_t d = code & 0xff;
 
 		if(d9)
 			d ^= 0xff;
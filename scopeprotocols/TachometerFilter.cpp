@@ -128,7 +128,7 @@ void TachometerFilter::Refresh()
 	}
 
 	//Create the output
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(edges.size() / 2);
 
 	int64_t pulses_per_rev = m_parameters[m_ticksname].GetIntVal();
 	float pulses_to_rpm = 60.0f / pulses_per_rev;
@@ -138,7 +138,7 @@ void TopMeasurement::Refresh()
 	float global_top = fbin*m_range + min;
 
 	//Create the output
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>();
 
 	float last = min;
 	int64_t tedge = 0;
@@ -50,6 +50,8 @@ UARTDecoder::UARTDecoder(const string& color)
 	m_baudname = "Baud rate";
 	m_parameters[m_baudname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_BITRATE));
 	m_parameters[m_baudname].SetIntVal(115200);
+
+	CreateStateCarryParameter();
 }
 
 UARTDecoder::~UARTDecoder()
@@ -134,29 +136,77 @@ void UARTDecoder::Refresh()
 	int64_t tlast = 0;
 	Packet* pack = NULL;
 	size_t len = din->m_samples.size();
+
+	//Where we are in the byte framing. If continuing from the last waveform, we may already know the line is idle
+	//or be partway through a byte.
+	enum
+	{
+		PHASE_UNKNOWN,
+		PHASE_IDLE,
+		PHASE_BYTE
+	};
+	auto carried = TakeCarriedState(din, INT64_MAX);
+	int phase = carried.GetInt("phase", PHASE_UNKNOWN);
+	int ibit = 0;
+	unsigned char dval = 0;
+	int64_t tstart = 0;
+	if(phase == PHASE_IDLE)
+	{
+		int64_t gap;
+
+		//The line may have started a byte while we weren't looking, so only trust the idle state if the gap
+		//was less than a bit period
+		if(!GetCarriedGap(carried, din, gap) || (gap > ibitper) )
+			phase = PHASE_UNKNOWN;
+	}
+	else if(phase == PHASE_BYTE)
+	{
+		//Can only resume if the next sample point is within this waveform (otherwise bits were lost in between)
+		int64_t tnext;
+		int64_t tbytestart;
+		if(carried.GetTime("next", din, tnext) && (tnext >= 0) && carried.GetTime("start", din, tbytestart))
+		{
+			next_value = tnext / din->m_timescale;
+			tstart = max(tbytestart, (int64_t)0) / din->m_timescale;
+			ibit = carried.GetInt("ibit");
+			dval = carried.GetInt("dval");
+		}
+		else
+			phase = PHASE_UNKNOWN;
+	}
+
 	while(isample < len)
 	{
-		//Wait for signal to go high (idle state)
-		while( (isample < len) && !din->m_samples[isample])
-			isample ++;
-		if(isample >= len)
-			break;
+		if(phase != PHASE_BYTE)
+		{
+			//Wait for signal to go high (idle state)
+			if(phase == PHASE_UNKNOWN)
+			{
+				while( (isample < len) && !din->m_samples[isample])
+					isample ++;
+				if(isample >= len)
+					break;
+				phase = PHASE_IDLE;
+			}
 
-		//Wait for a falling edge (start bit)
-		while( (isample < len) && din->m_samples[isample])
-			isample ++;
-		if(isample >= len)
-			break;
+			//Wait for a falling edge (start bit)
+			while( (isample < len) && din->m_samples[isample])
+				isample ++;
+			if(isample >= len)
+				break;
 
-		//Time of the start bit
-		int64_t tstart = din->m_offsets[isample];
+			//Time of the start bit
+			tstart = din->m_offsets[isample];
 
-		//The next data bit should be measured 1.5 bit periods after the falling edge
-		next_value = tstart + scaledbitper + scaledbitper/2;
+			//The next data bit should be measured 1.5 bit periods after the falling edge
+			next_value = tstart + scaledbitper + scaledbitper/2;
+			ibit = 0;
+			dval = 0;
+		}
+		phase = PHASE_BYTE;
 
 		//Read eight data bits
-		unsigned char dval = 0;
-		for(int ibit=0; ibit<8; ibit++)
+		for(; ibit<8; ibit++)
 		{
 			//Find the sample of interest
 			while( (isample < len) && ((din->m_offsets[isample] + din->m_durations[isample]) < next_value))
@@ -180,6 +230,7 @@ void UARTDecoder::Refresh()
 			isample ++;
 		if(isample >= len)
 			break;
+		phase = PHASE_UNKNOWN;
 
 		//Save the sample
 		int64_t tend = next_value + (scaledbitper/2);
@@ -218,6 +269,19 @@ void UARTDecoder::Refresh()
 		FinishPacket(pack);
 	}
 
+	//Save a byte in progress (or just the fact that the line is idle) for the next waveform
+	DecoderState state;
+	if(phase != PHASE_UNKNOWN)
+		state.SetInt("phase", phase);
+	if(phase == PHASE_BYTE)
+	{
+		state.SetInt("ibit", ibit);
+		state.SetInt("dval", dval);
+		state.SetTime("next", din, next_value * din->m_timescale);
+		state.SetTime("start", din, tstart * din->m_timescale);
+	}
+	CarryState(din, state);
+
 	SetData(cap, 0);
 }
 
@@ -41,6 +41,8 @@ USB2PacketDecoder::USB2PacketDecoder(const string& color)
 {
 	//Set up channels
 	CreateInput("PCS");
+
+	CreateExportParameters(PcapngWriter::LINKTYPE_USB_2_0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -126,6 +128,10 @@ void USB2PacketDecoder::Refresh()
 	cap->m_startTimestamp = din->m_startTimestamp;
 	cap->m_startFemtoseconds = din->m_startFemtoseconds;
 
+	//Packets are exported as they're decoded, before FindPackets() gets to ClearPackets(), so pick up parameter
+	//changes here
+	UpdateExport();
+
 	enum
 	{
 		STATE_IDLE,
@@ -144,11 +150,30 @@ void USB2PacketDecoder::Refresh()
 	uint8_t crc5_in[2] = {0};
 	uint8_t packet_crc5;
 	vector<uint8_t> packet_data;
+	vector<uint8_t> raw_packet;
+	int64_t raw_start = 0;
+	bool in_packet = false;
 	for(size_t i=0; i<len; i++)
 	{
 		auto& sin = din->m_samples[i];
 		int64_t halfdur = din->m_durations[i]/2;
 
+		//Collect the raw bytes of each packet (PID through CRC) for export
+		if(sin.m_type == USB2PCSSymbol::TYPE_SYNC)
+		{
+			raw_packet.clear();
+			raw_start = din->m_offsets[i] * din->m_timescale;
+			in_packet = true;
+		}
+		else if( (sin.m_type == USB2PCSSymbol::TYPE_DATA) && in_packet)
+			raw_packet.push_back(sin.m_data);
+		else if(sin.m_type == USB2PCSSymbol::TYPE_EOP)
+		{
+			if(in_packet && !raw_packet.empty())
+				ExportPacket(cap, raw_start, &raw_packet[0], raw_packet.size());
+			in_packet = false;
+		}
+
 		switch(state)
 		{
 			case STATE_IDLE:
@@ -371,52 +396,18 @@ void USB2PacketDecoder::Refresh()
  */
 uint16_t USB2PacketDecoder::CalculateCRC16(const std::vector<uint8_t>& data)
 {
-	uint16_t poly = 0xa001;
-	uint16_t crc = 0xffff;
-
-	for(size_t n=0; n<data.size(); n++)
-	{
-		uint8_t d = data[n];
-
-		for(int i=0; i<8; i++)
-		{
-			bool b = ( crc ^ (d >> i) ) & 1;
-			crc >>= 1;
-			if(b)
-				crc ^= poly;
-		}
-	}
-
-	return ~( (crc << 8) | ( (crc >> 8) & 0xff) );
+	uint16_t crc = CRC16USB::Calculate(data);
+	return (crc << 8) | (crc >> 8);
 }
 
 /**
-	@brief Table based CRC5 implementation
+	@brief Checks the CRC5 of a token packet
 
-	Ref: "A Fast Compact CRC5 Checker For Microcontrollers", Michael Joost
+	Running the 11 data bits and 5 CRC bits through the register leaves a fixed residue if the CRC is good.
  */
 bool USB2PacketDecoder::VerifyCRC5(uint8_t* data)
 {
-	const uint8_t table4[16] =
-	{
-		0x00, 0x0e, 0x1c, 0x12, 0x11, 0x1f, 0x0d, 0x03,
-		0x0b, 0x05, 0x17, 0x19, 0x1a, 0x14, 0x06, 0x08
-	};
-
-	const uint8_t table0[16] =
-	{
-		0x00, 0x16, 0x05, 0x13, 0x0a, 0x1c, 0x0f, 0x19,
-		0x14, 0x02, 0x11, 0x07, 0x1e, 0x08, 0x1b, 0x0d
-	};
-
-	uint8_t crc = 0x1f;
-	for(int i=0; i<2; i++)
-	{
-		uint8_t b = data[i] ^ crc;
-		crc = table4[b & 0xf] ^ table0[(b >> 4) & 0xf];
-	}
-
-	return (crc == 6);
+	return CRC5USB::Update(CRC5USB::Start(), data, 2) == 6;
 }
 
 void USB2PacketDecoder::FindPackets(USB2PacketWaveform* cap)
@@ -482,18 +473,16 @@ void USB2PacketDecoder::DecodeSof(USB2PacketWaveform* cap, size_t istart, size_t
 		return;
 
 	//Make the packet
-	Packet* pack = new Packet;
-	pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
-	pack->m_headers["Type"] = "SOF";
+	size_t row = m_table.AddRow(cap->m_offsets[istart] * cap->m_timescale);
+	m_table.SetText(row, m_table.GetColumn("Type"), "SOF");
 	char tmp[128];
 	snprintf(tmp, sizeof(tmp), "Sequence = %u", snframe.m_data);
-	pack->m_headers["Details"] = tmp;
-	pack->m_len = ((cap->m_offsets[icrc] + cap->m_durations[icrc]) * cap->m_timescale) - pack->m_offset;
-	m_packets.push_back(pack);
+	m_table.SetText(row, m_table.GetColumn("Details"), tmp);
+	m_table.SetEnd(row, (cap->m_offsets[icrc] + cap->m_durations[icrc]) * cap->m_timescale);
 
-	pack->m_headers["Device"] = "--";
-	pack->m_headers["Endpoint"] = "--";
-	pack->m_headers["Length"] = "2";
+	m_table.SetText(row, m_table.GetColumn("Device"), "--");
+	m_table.SetText(row, m_table.GetColumn("Endpoint"), "--");
+	m_table.SetDecimal(row, m_table.GetColumn("Length"), 2);
 }
 
 void USB2PacketDecoder::DecodeSetup(USB2PacketWaveform* cap, size_t istart, size_t& i)
@@ -577,16 +566,12 @@ void USB2PacketDecoder::DecodeSetup(USB2PacketWaveform* cap, size_t istart, size
 	}
 
 	//Make the packet
-	Packet* pack = new Packet;
-	pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
-	pack->m_headers["Type"] = "SETUP";
-	pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
-	char tmp[256];
-	snprintf(tmp, sizeof(tmp), "%d", saddr.m_data);
-	pack->m_headers["Device"] = tmp;
-	snprintf(tmp, sizeof(tmp), "%d", sendp.m_data);
-	pack->m_headers["Endpoint"] = tmp;
-	pack->m_headers["Length"] = "8";	//constant
+	size_t row = m_table.AddRow(cap->m_offsets[istart] * cap->m_timescale);
+	m_table.SetText(row, m_table.GetColumn("Type"), "SETUP");
+	m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_CONTROL]);
+	m_table.SetDecimal(row, m_table.GetColumn("Device"), saddr.m_data);
+	m_table.SetDecimal(row, m_table.GetColumn("Endpoint"), sendp.m_data);
+	m_table.SetDecimal(row, m_table.GetColumn("Length"), 8);	//constant
 
 	//Decode setup details
 	uint8_t bmRequestType = data[0];
@@ -631,6 +616,7 @@ void USB2PacketDecoder::DecodeSetup(USB2PacketWaveform* cap, size_t istart, size
 			sdest = "reserved";
 			break;
 	}
+	char tmp[256];
 	snprintf(
 		tmp,
 		sizeof(tmp),
@@ -643,11 +629,10 @@ void USB2PacketDecoder::DecodeSetup(USB2PacketWaveform* cap, size_t istart, size
 		wIndex,
 		wLength,
 		ack.c_str());
-	pack->m_headers["Details"] = tmp;
+	m_table.SetText(row, m_table.GetColumn("Details"), tmp);
 
 	//Done
-	pack->m_len = ((cap->m_offsets[idcrc] + cap->m_durations[idcrc]) * cap->m_timescale) - pack->m_offset;
-	m_packets.push_back(pack);
+	m_table.SetEnd(row, (cap->m_offsets[idcrc] + cap->m_durations[idcrc]) * cap->m_timescale);
 }
 
 void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_t& i)
@@ -687,7 +672,11 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 		return;
 	}
 
-	char tmp[256];
+	size_t colType = m_table.GetColumn("Type");
+	size_t colDevice = m_table.GetColumn("Device");
+	size_t colEndpoint = m_table.GetColumn("Endpoint");
+	size_t colLength = m_table.GetColumn("Length");
+	size_t colDetails = m_table.GetColumn("Details");
 
 	//Look for the DATA packet after the IN/OUT
 	auto sdatpid = cap->m_samples[i];
@@ -708,26 +697,22 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 		i++;
 
 		//Add a line for the aborted transaction
-		Packet* pack = new Packet;
-		pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
+		size_t row = m_table.AddRow(cap->m_offsets[istart] * cap->m_timescale);
 		if( (cap->m_samples[istart].m_data & 0xf) == USB2PacketSymbol::PID_IN)
 		{
-			pack->m_headers["Type"] = "IN";
-			pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+			m_table.SetText(row, colType, "IN");
+			m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 		}
 		else
 		{
-			pack->m_headers["Type"] = "OUT";
-			pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+			m_table.SetText(row, colType, "OUT");
+			m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_WRITE]);
 		}
-		snprintf(tmp, sizeof(tmp), "%d", saddr.m_data);
-		pack->m_headers["Device"] = tmp;
-		snprintf(tmp, sizeof(tmp), "%d", sendp.m_data);
-		pack->m_headers["Endpoint"] = tmp;
-		pack->m_headers["Details"] = "NAK";
-		m_packets.push_back(pack);
+		m_table.SetDecimal(row, colDevice, saddr.m_data);
+		m_table.SetDecimal(row, colEndpoint, sendp.m_data);
+		m_table.SetText(row, colDetails, "NAK");
 
-		pack->m_len = ((cap->m_offsets[i] + cap->m_durations[i]) * cap->m_timescale) - pack->m_offset;
+		m_table.SetEnd(row, (cap->m_offsets[i] + cap->m_durations[i]) * cap->m_timescale);
 
 		return;
 	}
@@ -739,31 +724,26 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 		LogError("Not data PID (%x, i=%zu)\n", sdatpid.m_data, i);
 
 		//DEBUG
-		Packet* pack = new Packet;
-		pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
-		pack->m_headers["Details"] = "ERROR";
-		pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
-		m_packets.push_back(pack);
+		size_t row = m_table.AddRow(cap->m_offsets[istart] * cap->m_timescale);
+		m_table.SetText(row, colDetails, "ERROR");
+		m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 		return;
 	}
 
 	//Create the new packet
-	Packet* pack = new Packet;
-	pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
+	size_t row = m_table.AddRow(cap->m_offsets[istart] * cap->m_timescale);
 	if( (cap->m_samples[istart].m_data & 0xf) == USB2PacketSymbol::PID_IN)
 	{
-		pack->m_headers["Type"] = "IN";
-		pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+		m_table.SetText(row, colType, "IN");
+		m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 	}
 	else
 	{
-		pack->m_headers["Type"] = "OUT";
-		pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+		m_table.SetText(row, colType, "OUT");
+		m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_DATA_WRITE]);
 	}
-	snprintf(tmp, sizeof(tmp), "%d", saddr.m_data);
-	pack->m_headers["Device"] = tmp;
-	snprintf(tmp, sizeof(tmp), "%d", sendp.m_data);
-	pack->m_headers["Endpoint"] = tmp;
+	m_table.SetDecimal(row, colDevice, saddr.m_data);
+	m_table.SetDecimal(row, colEndpoint, sendp.m_data);
 
 	//Read the data
 	while(i < cap->m_samples.size())
@@ -772,7 +752,7 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 
 		//Keep adding data
 		if(s.m_type == USB2PacketSymbol::TYPE_DATA)
-			pack->m_data.push_back(s.m_data);
+			m_table.AppendData(row, s.m_data);
 
 		//Next should be a CRC16
 		else if(s.m_type == USB2PacketSymbol::TYPE_CRC16_GOOD)
@@ -783,7 +763,7 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 		else if(s.m_type == USB2PacketSymbol::TYPE_CRC16_BAD)
 		{
 			i++;
-			pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+			m_table.SetBackgroundColor(row, m_backgroundColors[PROTO_COLOR_ERROR]);
 			break;
 		}
 
@@ -794,6 +774,7 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 	if(i >= cap->m_samples.size())
 	{
 		LogDebug("Truncated ACK\n");
+		m_table.RemoveLastRow();
 		return;
 	}
 	string ack = "";
@@ -815,23 +796,12 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 		ack = "Not a PID";
 	}
 
-	pack->m_len = ((cap->m_offsets[i] + cap->m_durations[i]) * cap->m_timescale) - pack->m_offset;
+	m_table.SetEnd(row, (cap->m_offsets[i] + cap->m_durations[i]) * cap->m_timescale);
 	i++;
 
-	//Format the data
-	string details = "";
-	for(auto b : pack->m_data)
-	{
-		snprintf(tmp, sizeof(tmp), "%02x ", b);
-		details += tmp;
-	}
-	details += ack;
-	pack->m_headers["Details"] = details;
-
-	snprintf(tmp, sizeof(tmp), "%zu", pack->m_data.size());
-	pack->m_headers["Length"] = tmp;
-
-	m_packets.push_back(pack);
+	//Data is formatted when displayed
+	m_table.SetHexDump(row, colDetails, ack);
+	m_table.SetDecimal(row, colLength, m_table.GetDataSize(row));
 }
 
 Gdk::Color USB2PacketDecoder::GetColor(int i)
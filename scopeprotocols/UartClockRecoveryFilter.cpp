@@ -117,13 +117,6 @@ void UartClockRecoveryFilter::Refresh()
 	int64_t baud = m_parameters[m_baudname].GetIntVal();
 	int64_t fs = static_cast<int64_t>(FS_PER_SECOND / baud);
 
-	//Create the output waveform and copy our timescales
-	auto cap = new DigitalWaveform;
-	cap->m_startTimestamp = din->m_startTimestamp;
-	cap->m_startFemtoseconds = din->m_startFemtoseconds;
-	cap->m_triggerPhase = 0;
-	cap->m_timescale = 1;		//recovered clock time scale is single femtoseconds
-
 	//Timestamps of the edges
 	vector<int64_t> edges;
 
@@ -131,6 +124,13 @@ void UartClockRecoveryFilter::Refresh()
 	const float threshold = m_parameters[m_threshname].GetFloatVal();
 	FindZeroCrossings(din, threshold, edges);
 
+	//Create the output waveform and copy our timescales
+	auto cap = g_waveformPool.Allocate<DigitalWaveform>(edges.size());
+	cap->m_startTimestamp = din->m_startTimestamp;
+	cap->m_startFemtoseconds = din->m_startFemtoseconds;
+	cap->m_triggerPhase = 0;
+	cap->m_timescale = 1;		//recovered clock time scale is single femtoseconds
+
 	//Actual DLL logic
 	size_t nedge = 0;
 	int64_t bcenter = 0;
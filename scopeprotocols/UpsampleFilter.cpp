@@ -34,6 +34,8 @@
 
 #include "../scopehal/scopehal.h"
 #include "UpsampleFilter.h"
+#include <immintrin.h>
+#include <omp.h>
 
 using namespace std;
 
@@ -65,6 +67,8 @@ float blackman(float x, float width)
 
 UpsampleFilter::UpsampleFilter(const string& color)
 	: Filter(OscilloscopeChannel::CHANNEL_TYPE_ANALOG, color, CAT_MATH)
+	, m_phaseStride(0)
+	, m_cachedFactor(0)
 {
 	//Set up channels
 	CreateInput("din");
@@ -115,6 +119,11 @@ bool UpsampleFilter::NeedsConfig()
 	return true;
 }
 
+bool UpsampleFilter::SupportsImplicitTimestamps()
+{
+	return true;
+}
+
 double UpsampleFilter::GetOffset()
 {
 	auto chan = m_inputs[0].m_channel;
@@ -147,68 +156,271 @@ void UpsampleFilter::Refresh()
 
 	//Get the input data
 	auto din = GetAnalogInputWaveform(0);
-
-	//Configuration parameters that eventually have to be user specified
 	size_t upsample_factor = m_parameters[m_factorname].GetIntVal();
-	size_t window = 5;
-	size_t kernel = window*upsample_factor;
+	if(upsample_factor == 0)
+	{
+		SetData(NULL, 0);
+		return;
+	}
+	UpdateKernel(upsample_factor);
+
+	//The filter assumes uniformly spaced input, so put sparse waveforms onto a grid first
+	const float* samples;
+	size_t len;
+	int64_t step = 1;
+	int64_t start = 0;
+	if(din->m_densePacked)
+	{
+		samples = (const float*)&din->m_samples[0];
+		len = din->m_samples.size();
+	}
+	else
+	{
+		ResampleToUniformGrid(din, m_uniformSamples, step);
+		samples = &m_uniformSamples[0];
+		len = m_uniformSamples.size();
+		start = din->m_offsets[0];
+	}
+	if(len <= m_window)
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
+	//Create the output and configure it
+	size_t outlen = len * upsample_factor;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(outlen);
 
-	//Create the interpolation filter
-	float frac_kernel = kernel * 1.0f / upsample_factor;
+	//Output is dense packed, so skip the timestamps if we can
+	if(UseImplicitTimestampOutput())
+		cap->SetImplicitTimestamps();
+	cap->m_densePacked = true;
+	cap->Resize(outlen);
+	cap->FillDenseTimestamps(0, outlen);
+
+	//Logically, we upsample by inserting zeroes, then convolve with the sinc filter.
+	//Only one in every upsample_factor taps lands on a real sample, so each output phase is a short FIR of its own.
+	//The last few input samples don't have a full window after them, so those outputs stay zero.
+	size_t imax = len - m_window;
+	float* pout = (float*)&cap->m_samples[0];
+	memset(pout + imax*upsample_factor, 0, (outlen - imax*upsample_factor) * sizeof(float));
+
+	size_t nthreads = max((size_t)1, min((size_t)omp_get_max_threads(), imax / 4096));
+	const float* coeffs = &m_phaseCoeffs[0];
+	#pragma omp parallel for num_threads(nthreads)
+	for(size_t n=0; n<nthreads; n++)
+	{
+		size_t istart = imax * n / nthreads;
+		size_t iend = imax * (n+1) / nthreads;
+
+		if(g_hasAvx512F)
+			UpsampleKernelAVX512F(samples, pout, istart, iend, coeffs, upsample_factor, m_phaseStride);
+		else if(g_hasAvx2)
+			UpsampleKernelAVX2(samples, pout, istart, iend, coeffs, upsample_factor, m_phaseStride);
+		else
+			UpsampleKernel(samples, pout, istart, iend, coeffs, upsample_factor, m_phaseStride);
+	}
+
+	//Copy our time scales from the input, and correct for the upsampling
+	cap->m_timescale = din->m_timescale * step / upsample_factor;
+	cap->m_triggerPhase = din->m_triggerPhase + start * din->m_timescale;
+	cap->m_startTimestamp = din->m_startTimestamp;
+	cap->m_startFemtoseconds = din->m_startFemtoseconds;
+
+	SetData(cap, 0);
+}
+
+/**
+	@brief Rebuilds the polyphase coefficient table if the upsampling factor changed
+ */
+void UpsampleFilter::UpdateKernel(size_t factor)
+{
+	if(factor == m_cachedFactor)
+		return;
+	m_cachedFactor = factor;
+
+	//Windowed sinc, sampled at the output rate
+	size_t kernel = m_window*factor;
+	float frac_kernel = kernel * 1.0f / factor;
 	vector<float> filter;
 	for(size_t i=0; i<kernel; i++)
 	{
-		float frac = i*1.0f / upsample_factor;
+		float frac = i*1.0f / factor;
 		filter.push_back(sinc(frac, frac_kernel) * blackman(frac, frac_kernel));
 	}
 
-	//Create the output and configure it
-	auto cap = new AnalogWaveform;
-
-	//TODO: make this work on not-dense-packed waveforms
+	//Split into phases. Phase 0 uses taps 0, factor, 2*factor... against in[i ... i+window-1].
+	//Phase j > 0 uses taps factor-j, 2*factor-j... against in[i+1 ... i+window].
+	m_phaseStride = (factor + 15) & ~15;
+	m_phaseCoeffs.resize(m_taps * m_phaseStride);
+	for(size_t i=0; i<m_phaseCoeffs.size(); i++)
+		m_phaseCoeffs[i] = 0;
+	for(size_t t=0; t<m_window; t++)
+	{
+		m_phaseCoeffs[t*m_phaseStride] = filter[t*factor];
+		for(size_t j=1; j<factor; j++)
+			m_phaseCoeffs[(t+1)*m_phaseStride + j] = filter[(factor - j) + t*factor];
+	}
+}
 
-	//Fill out the input with samples
+/**
+	@brief Linearly interpolates a sparse waveform onto a uniform grid
+
+	The grid pitch is the smallest spacing between adjacent samples, unless that would make the grid unreasonably
+	large compared to the input, in which case it's coarsened. On return, out[k] is the value at offset
+	din->m_offsets[0] + k*step.
+ */
+void UpsampleFilter::ResampleToUniformGrid(
+	AnalogWaveform* din,
+	vector<float, AlignedAllocator<float, 64> >& out,
+	int64_t& step)
+{
 	size_t len = din->m_samples.size();
-	for(size_t i=0; i < len; i++)
+	auto offsets = (const int64_t*)&din->m_offsets[0];
+	auto samples = (const float*)&din->m_samples[0];
+	if(len < 2)
 	{
-		for(size_t j=0; j<upsample_factor; j++)
-		{
-			cap->m_offsets.push_back(i * upsample_factor + j);
-			cap->m_durations.push_back(1);
-			cap->m_samples.push_back(0);
-		}
+		out.resize(len);
+		if(len)
+			out[0] = samples[0];
+		step = 1;
+		return;
 	}
 
-	//Logically, we upsample by inserting zeroes, then convolve with the sinc filter.
-	//Optimization: don't actually waste time multiplying by zero
-	//TODO: vectorize this instead of multithreading
-	size_t imax = len - window;
-	#pragma omp parallel for
-	for(size_t i=0; i < imax; i++)
+	int64_t span = offsets[len-1] - offsets[0];
+	step = span;
+	for(size_t i=1; i<len; i++)
+	{
+		int64_t delta = offsets[i] - offsets[i-1];
+		if(delta > 0)
+			step = min(step, delta);
+	}
+	step = max(step, span / (int64_t)(16 * len));
+	step = max(step, (int64_t)1);
+
+	size_t outlen = span / step + 1;
+	out.resize(outlen);
+	float* pout = &out[0];
+
+	//Each thread starts with a binary search for the first input sample it needs, then walks forward
+	size_t nthreads = max((size_t)1, min((size_t)omp_get_max_threads(), outlen / 65536));
+	#pragma omp parallel for num_threads(nthreads)
+	for(size_t n=0; n<nthreads; n++)
 	{
-		size_t offset = i * upsample_factor;
-		for(size_t j=0; j<upsample_factor; j++)
+		size_t kstart = outlen * n / nthreads;
+		size_t kend = outlen * (n+1) / nthreads;
+
+		int64_t t = offsets[0] + kstart*step;
+		size_t i = upper_bound(offsets, offsets + len, t) - offsets;
+		if(i > 0)
+			i--;
+		i = min(i, len-2);
+
+		for(size_t k=kstart; k<kend; k++, t += step)
 		{
-			size_t start = 0;
-			size_t sstart = 0;
-			if(j > 0)
+			while( (i+2 < len) && (offsets[i+1] <= t) )
+				i++;
+
+			int64_t t0 = offsets[i];
+			int64_t t1 = offsets[i+1];
+			if(t1 <= t0)
+				pout[k] = samples[i+1];
+			else
 			{
-				sstart = 1;
-				start = upsample_factor - j;
+				float frac = (float)(t - t0) / (t1 - t0);
+				frac = max(0.0f, min(1.0f, frac));
+				pout[k] = samples[i] + (samples[i+1] - samples[i]) * frac;
 			}
+		}
+	}
+}
 
+void UpsampleFilter::UpsampleKernel(
+	const float* in, float* out, size_t istart, size_t iend, const float* coeffs, size_t factor, size_t stride)
+{
+	for(size_t i=istart; i<iend; i++)
+	{
+		float* pout = out + i*factor;
+		for(size_t j=0; j<factor; j++)
+		{
 			float f = 0;
-			for(size_t k = start; k<kernel; k += upsample_factor, sstart ++)
-				f += filter[k] * din->m_samples[i + sstart];
+			for(size_t t=0; t<m_taps; t++)
+				f += coeffs[t*stride + j] * in[i + t];
+			pout[j] = f;
+		}
+	}
+}
+
+/**
+	@brief Vectorized across phases: each input position produces one contiguous run of factor outputs
+ */
+__attribute__((target("avx2")))
+void UpsampleFilter::UpsampleKernelAVX2(
+	const float* in, float* out, size_t istart, size_t iend, const float* coeffs, size_t factor, size_t stride)
+{
+	size_t vend = factor - (factor % 8);
+
+	//Mask for the last partial vector of each output run, so we never write into a neighboring run
+	int32_t lanes[8];
+	for(size_t j=0; j<8; j++)
+		lanes[j] = (j < (factor % 8)) ? -1 : 0;
+	__m256i tailmask = _mm256_loadu_si256((__m256i*)lanes);
+
+	for(size_t i=istart; i<iend; i++)
+	{
+		float* pout = out + i*factor;
+
+		__m256 x[m_taps];
+		for(size_t t=0; t<m_taps; t++)
+			x[t] = _mm256_set1_ps(in[i + t]);
+
+		for(size_t j=0; j<vend; j += 8)
+		{
+			__m256 acc = _mm256_mul_ps(_mm256_load_ps(coeffs + j), x[0]);
+			for(size_t t=1; t<m_taps; t++)
+				acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_load_ps(coeffs + t*stride + j), x[t]));
+			_mm256_storeu_ps(pout + j, acc);
+		}
 
-			cap->m_samples[offset + j] = f;
+		if(vend < factor)
+		{
+			__m256 acc = _mm256_mul_ps(_mm256_load_ps(coeffs + vend), x[0]);
+			for(size_t t=1; t<m_taps; t++)
+				acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_load_ps(coeffs + t*stride + vend), x[t]));
+			_mm256_maskstore_ps(pout + vend, tailmask, acc);
 		}
 	}
+}
 
-	//Copy our time scales from the input, and correct for the upsampling
-	cap->m_timescale = din->m_timescale / upsample_factor;
-	cap->m_startTimestamp = din->m_startTimestamp;
-	cap->m_startFemtoseconds = din->m_startFemtoseconds;
+__attribute__((target("avx512f")))
+void UpsampleFilter::UpsampleKernelAVX512F(
+	const float* in, float* out, size_t istart, size_t iend, const float* coeffs, size_t factor, size_t stride)
+{
+	size_t vend = factor - (factor % 16);
+	__mmask16 tailmask = (1 << (factor % 16)) - 1;
 
-	SetData(cap, 0);
+	for(size_t i=istart; i<iend; i++)
+	{
+		float* pout = out + i*factor;
+
+		__m512 x[m_taps];
+		for(size_t t=0; t<m_taps; t++)
+			x[t] = _mm512_set1_ps(in[i + t]);
+
+		for(size_t j=0; j<vend; j += 16)
+		{
+			__m512 acc = _mm512_mul_ps(_mm512_load_ps(coeffs + j), x[0]);
+			for(size_t t=1; t<m_taps; t++)
+				acc = _mm512_fmadd_ps(_mm512_load_ps(coeffs + t*stride + j), x[t], acc);
+			_mm512_storeu_ps(pout + j, acc);
+		}
+
+		if(vend < factor)
+		{
+			__m512 acc = _mm512_mul_ps(_mm512_load_ps(coeffs + vend), x[0]);
+			for(size_t t=1; t<m_taps; t++)
+				acc = _mm512_fmadd_ps(_mm512_load_ps(coeffs + t*stride + vend), x[t], acc);
+			_mm512_mask_storeu_ps(pout + vend, tailmask, acc);
+		}
+	}
 }
@@ -44,6 +44,7 @@ public:
 
 	virtual bool NeedsConfig();
 	virtual bool IsOverlay();
+	virtual bool SupportsImplicitTimestamps();
 
 	virtual double GetOffset();
 	virtual double GetVoltageRange();
@@ -56,6 +57,39 @@ public:
 	PROTOCOL_DECODER_INITPROC(UpsampleFilter)
 
 protected:
+	void UpdateKernel(size_t factor);
+
+	static void ResampleToUniformGrid(
+		AnalogWaveform* din,
+		std::vector<float, AlignedAllocator<float, 64> >& out,
+		int64_t& step);
+
+	static void UpsampleKernel(
+		const float* in, float* out, size_t istart, size_t iend, const float* coeffs, size_t factor, size_t stride);
+	static void UpsampleKernelAVX2(
+		const float* in, float* out, size_t istart, size_t iend, const float* coeffs, size_t factor, size_t stride);
+	static void UpsampleKernelAVX512F(
+		const float* in, float* out, size_t istart, size_t iend, const float* coeffs, size_t factor, size_t stride);
+
+	///Width of the interpolation window, in input samples
+	static const size_t m_window = 5;
+
+	///Number of input samples each output depends on (one extra since phases other than 0 are shifted by a sample)
+	static const size_t m_taps = m_window + 1;
+
+	/**
+		@brief Polyphase filter coefficients, stored tap-major
+
+		Output sample i*factor + j is the sum over t of m_phaseCoeffs[t*m_phaseStride + j] * in[i + t]. Each row is
+		zero padded to a multiple of 16 so vector loads past the last phase are harmless.
+	 */
+	std::vector<float, AlignedAllocator<float, 64> > m_phaseCoeffs;
+	size_t m_phaseStride;
+	size_t m_cachedFactor;
+
+	///Scratch buffer for sparse inputs resampled onto a uniform grid
+	std::vector<float, AlignedAllocator<float, 64> > m_uniformSamples;
+
 	std::string m_factorname;
 };
 
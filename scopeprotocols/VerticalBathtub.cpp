@@ -131,7 +131,7 @@ void VerticalBathtub::Refresh()
 		return;
 
 	//Create the output
-	auto cap = new AnalogWaveform;
+	auto cap = g_waveformPool.Allocate<AnalogWaveform>(eye->GetHeight());
 	cap->m_timescale = eye->m_timescale;
 	cap->m_startTimestamp = eye->m_startTimestamp;
 	cap->m_startFemtoseconds = eye->m_startFemtoseconds;
@@ -30,6 +30,7 @@
 #include "../scopehal/scopehal.h"
 #include "Waterfall.h"
 #include "FFTFilter.h"
+#include <immintrin.h>
 
 using namespace std;
 
@@ -39,19 +40,57 @@ using namespace std;
 WaterfallWaveform::WaterfallWaveform(size_t width, size_t height)
 	: m_width(width)
 	, m_height(height)
+	, m_head(0)
+	, m_outdata(NULL)
+	, m_outdataStale(true)
 {
 	size_t npix = width*height;
-	m_outdata = new float[npix];
+	m_ringdata = new float[npix];
 	for(size_t i=0; i<npix; i++)
-		m_outdata[i] = 0;
+		m_ringdata[i] = 0;
 }
 
 WaterfallWaveform::~WaterfallWaveform()
 {
+	delete[] m_ringdata;
 	delete[] m_outdata;
+	m_ringdata = NULL;
 	m_outdata = NULL;
 }
 
+/**
+	@brief Returns the image as one contiguous block, oldest row first
+
+	The ring is unrolled into a separate buffer the first time this is called after an update, so repeated calls
+	with no new data are free.
+ */
+float* WaterfallWaveform::GetData()
+{
+	if(!m_outdata)
+		m_outdata = new float[m_width*m_height];
+
+	if(m_outdataStale)
+	{
+		size_t headrows = m_height - m_head;
+		memcpy(m_outdata, m_ringdata + m_head*m_width, headrows * m_width * sizeof(float));
+		memcpy(m_outdata + headrows*m_width, m_ringdata, m_head * m_width * sizeof(float));
+		m_outdataStale = false;
+	}
+
+	return m_outdata;
+}
+
+/**
+	@brief Drops the oldest row and returns a pointer to the newest one, for the caller to overwrite
+ */
+float* WaterfallWaveform::AdvanceRow()
+{
+	float* row = m_ringdata + m_head*m_width;
+	m_head = (m_head + 1) % m_height;
+	m_outdataStale = true;
+	return row;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -147,44 +186,78 @@ void Waterfall::Refresh()
 	if(cap == NULL)
 		cap = new WaterfallWaveform(m_width, m_height);
 	cap->m_timescale = din->m_timescale;
-	float* data = cap->GetData();
-
-	//Move the whole waterfall down by one row
-	for(size_t y=0; y < m_height-1 ; y++)
-	{
-		for(size_t x=0; x<m_width; x++)
-			data[y*m_width + x] = data[(y+1)*m_width + x];
-	}
 
-	//Zero the new row
-	float* prow = data + (m_height-1)*m_width;
-	for(size_t x=0; x<m_width; x++)
-		prow[x] = 0;
+	//Recycle the oldest row as the newest, rather than moving the whole image
+	float* prow = cap->AdvanceRow();
 
-	//Add the new data
+	//Figure out which bins are visible
 	double hz_per_bin = din->m_timescale;
 	double bins_per_pixel = 1.0f / (m_pixelsPerHz  * hz_per_bin);
 	double bin_offset = m_offsetHz / hz_per_bin;
 	float vmin = 1.0 / 255.0;
 	float vrange = m_inputs[0].m_channel->GetVoltageRange();	//db from min to max scale
 	float vfs = vrange/2 - m_inputs[0].m_channel->GetOffset();
-	for(size_t x=0; x<m_width; x++)
+	double firstbin = max(0.0, floor(bin_offset));
+	double lastbin = min((double)inlen - 1, floor(bins_per_pixel*m_width + bin_offset));
+	if(firstbin > lastbin)
 	{
-		//Look up the frequency bin(s) for this position
-		size_t leftbin = static_cast<size_t>(floor(bins_per_pixel*x + bin_offset));
-		size_t rightbin = static_cast<size_t>(floor(bins_per_pixel*(x+1) + bin_offset));
+		for(size_t x=0; x<m_width; x++)
+			prow[x] = vmin;
+		SetData(cap, 0);
+		return;
+	}
 
-		for(size_t nbin=leftbin; (nbin <= rightbin) && (nbin < inlen); nbin ++)
-		{
-			//Brightness is normalized amplitude, scaled by bins per pixel
-			float v = 1 - ( (din->m_samples[nbin] - vfs) / -vrange);
-			float vscale = v / bins_per_pixel;
+	//Brightness of each visible bin is normalized amplitude, scaled by bins per pixel
+	//(1 - (v - vfs) / -vrange) / bins_per_pixel, folded into a single multiply-add
+	size_t binbase = firstbin;
+	size_t nbins = lastbin - firstbin + 1;
+	float scale = 1.0 / (vrange * bins_per_pixel);
+	float offset = (1 - vfs / vrange) / bins_per_pixel;
+	m_binBrightness.resize(nbins);
+	if(g_hasAvx2)
+		ScaleBinsAVX2((float*)&din->m_samples[binbase], &m_binBrightness[0], nbins, scale, offset);
+	else
+		ScaleBins((float*)&din->m_samples[binbase], &m_binBrightness[0], nbins, scale, offset);
 
-			prow[x] += vscale;
-		}
+	//Sum the bin(s) for each pixel
+	const float* brightness = &m_binBrightness[0];
+	size_t binend = binbase + nbins;
+	for(size_t x=0; x<m_width; x++)
+	{
+		double left = floor(bins_per_pixel*x + bin_offset);
+		double right = floor(bins_per_pixel*(x+1) + bin_offset);
+		size_t leftbin = max(left, firstbin);
+		size_t rightbin = max(min(right + 1, (double)binend), firstbin);
 
-		prow[x] = max(prow[x], vmin);
+		float v = 0;
+		for(size_t nbin=leftbin; nbin < rightbin; nbin ++)
+			v += brightness[nbin - binbase];
+		prow[x] = max(v, vmin);
 	}
 
 	SetData(cap, 0);
 }
+
+void Waterfall::ScaleBins(const float* in, float* out, size_t len, float scale, float offset)
+{
+	for(size_t i=0; i<len; i++)
+		out[i] = in[i]*scale + offset;
+}
+
+__attribute__((target("avx2")))
+void Waterfall::ScaleBinsAVX2(const float* in, float* out, size_t len, float scale, float offset)
+{
+	size_t end = len - (len % 8);
+
+	__m256 vscale = _mm256_set1_ps(scale);
+	__m256 voffset = _mm256_set1_ps(offset);
+	for(size_t i=0; i<end; i += 8)
+	{
+		__m256 v = _mm256_loadu_ps(in + i);
+		v = _mm256_add_ps(_mm256_mul_ps(v, vscale), voffset);
+		_mm256_store_ps(out + i, v);
+	}
+
+	for(size_t i=end; i<len; i++)
+		out[i] = in[i]*scale + offset;
+}
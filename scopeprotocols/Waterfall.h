@@ -45,14 +45,38 @@ public:
 	WaterfallWaveform(const WaterfallWaveform&) =delete;
 	WaterfallWaveform& operator=(const WaterfallWaveform&) =delete;
 
-	float* GetData()
-	{ return m_outdata; }
+	float* GetData();
+
+	size_t GetWidth()
+	{ return m_width; }
+
+	size_t GetHeight()
+	{ return m_height; }
+
+	/**
+		@brief Raw circular row storage, for consumers that can handle the wraparound themselves
+
+		Row GetHeadRow() is the oldest line; rows continue from there, wrapping from m_height-1 back to 0.
+	 */
+	float* GetRingData()
+	{ return m_ringdata; }
+
+	size_t GetHeadRow()
+	{ return m_head; }
+
+	float* AdvanceRow();
 
 protected:
 	size_t m_width;
 	size_t m_height;
 
+	///Ring buffer of rows, m_head is the oldest
+	float* m_ringdata;
+	size_t m_head;
+
+	///Linearized copy of the ring (oldest row first), rebuilt only when GetData() is called after a change
 	float* m_outdata;
+	bool m_outdataStale;
 };
 
 class Waterfall : public Filter
@@ -103,6 +127,11 @@ public:
 	PROTOCOL_DECODER_INITPROC(Waterfall)
 
 protected:
+	static void ScaleBins(const float* in, float* out, size_t len, float scale, float offset);
+	static void ScaleBinsAVX2(const float* in, float* out, size_t len, float scale, float offset);
+
+	std::vector<float, AlignedAllocator<float, 64> > m_binBrightness;
+
 	double m_pixelsPerHz;
 	double m_offsetHz;
 
@@ -29,6 +29,7 @@
 
 #include "../scopehal/scopehal.h"
 #include <complex>
+#include <omp.h>
 #include "WindowedAutocorrelationFilter.h"
 
 using namespace std;
@@ -150,7 +151,7 @@ void WindowedAutocorrelationFilter::Refresh()
 
 	//We need meaningful data, bail if it's too short
 	auto len = min(din_i->m_samples.size(), din_q->m_samples.size());
-	if(len < period_samples)
+	if( (len <= 2*period_samples) || (window_samples == 0) )
 	{
 		SetData(NULL, 0);
 		return;
@@ -159,28 +160,25 @@ void WindowedAutocorrelationFilter::Refresh()
 	//Set up the output waveform
 	auto cap = SetupOutputWaveform(din_i, 0, 0, 2*period_samples);
 
+	//Each output is a sum over a window of per-sample products, so slide the window rather than re-summing it.
+	//Split into one chunk of outputs per thread; each chunk re-primes its own window.
 	size_t end = len - 2*period_samples;
+	auto pi = (const float*)&din_i->m_samples[0];
+	auto pq = (const float*)&din_q->m_samples[0];
+	auto pout = (float*)&cap->m_samples[0];
+	size_t nthreads = omp_get_max_threads();
+	nthreads = max((size_t)1, min(nthreads, end / max((size_t)65536, window_samples * 4)));
+
+	#pragma omp parallel for num_threads(nthreads)
+	for(size_t i=0; i<nthreads; i++)
+		SlidingCorrelation(pi, pq, pout, end * i / nthreads, end * (i+1) / nthreads, window_samples, period_samples);
+
 	float vmax = -FLT_MAX;
 	float vmin = FLT_MAX;
 	for(size_t i=0; i < end; i ++)
 	{
-		complex<float> total = 0;
-		for(size_t j=0; j<window_samples; j++)
-		{
-			size_t first = i + j;
-			size_t second = first + period_samples;
-
-			complex<float> a(din_i->m_samples[first], din_q->m_samples[first]);
-			complex<float> b(din_i->m_samples[second], din_q->m_samples[second]);
-
-			total += a*b;
-		}
-
-		float v = abs(total) / window_samples;
-		vmax = max(vmax, v);
-		vmin = min(vmin, v);
-
-		cap->m_samples[i] = v;
+		vmax = max(vmax, pout[i]);
+		vmin = min(vmin, pout[i]);
 	}
 
 	//Calculate bounds
@@ -189,3 +187,47 @@ void WindowedAutocorrelationFilter::Refresh()
 	m_range = (m_max - m_min) * 1.05;
 	m_offset = ( (m_max - m_min)/2 + m_min );
 }
+
+/**
+	@brief Sliding window product of the complex signal a = I + jQ with itself delayed by one period
+
+	Computes out[i] = |sum(a[i+j] * a[i+j+period])| / window over j in [0, window), for i in [start, end).
+
+	The running sum is kept in double precision and re-summed from scratch every so often so rounding error from
+	adding and removing terms can't build up over very long captures.
+ */
+void WindowedAutocorrelationFilter::SlidingCorrelation(
+	const float* samples_i,
+	const float* samples_q,
+	float* out,
+	size_t start,
+	size_t end,
+	size_t window,
+	size_t period)
+{
+	auto product = [&](size_t k)
+	{
+		complex<double> a(samples_i[k], samples_q[k]);
+		complex<double> b(samples_i[k + period], samples_q[k + period]);
+		return a*b;
+	};
+
+	size_t resyncInterval = max((size_t)65536, window);
+	double scale = 1.0 / window;
+	complex<double> total = 0;
+	size_t nextResync = start;
+	for(size_t i=start; i<end; i++)
+	{
+		if(i == nextResync)
+		{
+			total = 0;
+			for(size_t j=0; j<window; j++)
+				total += product(i+j);
+			nextResync = i + resyncInterval;
+		}
+		else
+			total += product(i + window - 1) - product(i - 1);
+
+		out[i] = abs(total) * scale;
+	}
+}
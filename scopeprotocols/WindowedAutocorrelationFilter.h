@@ -57,6 +57,15 @@ public:
 	PROTOCOL_DECODER_INITPROC(WindowedAutocorrelationFilter)
 
 protected:
+	static void SlidingCorrelation(
+		const float* samples_i,
+		const float* samples_q,
+		float* out,
+		size_t start,
+		size_t end,
+		size_t window,
+		size_t period);
+
 	double	m_range;
 	double	m_offset;
 	float m_min;
@@ -157,4 +157,7 @@ void ScopeProtocolStaticInit()
 	AddStatisticClass(AverageStatistic);
 	AddStatisticClass(MaximumStatistic);
 	AddStatisticClass(MinimumStatistic);
+
+	//Benchmark the FIR filter kernels now rather than stalling the first filter refresh
+	FIRFilter::GetFFTCrossover();
 }